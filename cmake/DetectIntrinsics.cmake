@@ -34,3 +34,67 @@ check_c_source_compiles("
 if( LIBAKRYPT_HAVE_BUILTIN_CLMULEPI64 )
     set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DLIBAKRYPT_HAVE_BUILTIN_CLMULEPI64" )
 endif()
+
+# -------------------------------------------------------------------------------------------------- #
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  #include <emmintrin.h>
+  int main( void ) {
+
+   __m128i a = _mm_set_epi64x( 1, 2 ), b = _mm_set_epi64x( 3, 4 );
+   a = _mm_xor_si128( a, b );
+
+  return _mm_cvtsi128_si32( a );
+ }" LIBAKRYPT_HAVE_BUILTIN_XOR_SI128 )
+
+if( LIBAKRYPT_HAVE_BUILTIN_XOR_SI128 )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DLIBAKRYPT_HAVE_BUILTIN_XOR_SI128" )
+endif()
+
+# -------------------------------------------------------------------------------------------------- #
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  #include <tmmintrin.h>
+  int main( void ) {
+
+   __m128i a = _mm_set_epi64x( 1, 2 ), b = _mm_set_epi64x( 3, 4 );
+   a = _mm_shuffle_epi8( a, b );
+
+  return _mm_extract_epi16( a, 7 );
+ }" LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8 )
+
+if( LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8 )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DLIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8" )
+endif()
+
+# -------------------------------------------------------------------------------------------------- #
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  #include <immintrin.h>
+  __attribute__(( target( \"avx2\" )))
+  static int xor_si256( void ) {
+   __m256i a = _mm256_set_epi64x( 1, 2, 3, 4 ), b = _mm256_set_epi64x( 5, 6, 7, 8 );
+   a = _mm256_xor_si256( a, b );
+   return ( int )_mm256_extract_epi64( a, 3 );
+  }
+  int main( void ) {
+
+  return xor_si256();
+ }" LIBAKRYPT_HAVE_BUILTIN_AVX2 )
+
+if( LIBAKRYPT_HAVE_BUILTIN_AVX2 )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DLIBAKRYPT_HAVE_BUILTIN_AVX2" )
+endif()
+
+# -------------------------------------------------------------------------------------------------- #
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  int main( void ) {
+
+   __builtin_cpu_init();
+   return __builtin_cpu_supports( \"ssse3\" ) ? 0 : 1;
+ }" LIBAKRYPT_HAVE_BUILTIN_CPU_SUPPORTS )
+
+if( LIBAKRYPT_HAVE_BUILTIN_CPU_SUPPORTS )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DLIBAKRYPT_HAVE_BUILTIN_CPU_SUPPORTS" )
+endif()
@@ -58,6 +58,11 @@ else()
     endif()
 
   else()
+    # многопоточные режимы шифрования требуют явной компоновки с библиотекой pthread
+    find_library( LIBAKRYPT_PTHREAD pthread )
+    if( LIBAKRYPT_PTHREAD )
+      set( LIBAKRYPT_LIBS ${LIBAKRYPT_LIBS} pthread )
+    endif()
     set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DLIBAKRYPT_HAVE_PTHREAD" )
   endif()
 endif()
@@ -18,6 +18,88 @@
 #else
  #error Library cannot be compiled without string.h header
 #endif
+#ifdef LIBAKRYPT_HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+ #include <pthread.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция уничтожает неиспользованную гамму, хранящуюся в резервуаре контекста ключа.
+    \details Функция вызывается при смене ключа или синхропосылки, а также при уничтожении
+    контекста. Значение счетчика во внутреннем буффере соответствует первому неиспользованному
+    блоку гаммы и поэтому функцией не изменяется.                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_ctr_reservoir_clean( ak_bckey bkey )
+{
+  if( bkey->reservoir_count > 0 ) {
+    ak_ptr_context_wipe( bkey->reservoir + bkey->reservoir_offset,
+                                                  bkey->reservoir_count, &bkey->key.generator );
+    ak_ptr_context_wipe( bkey->reservoir + bkey->reservoir_size + bkey->reservoir_offset,
+                                                  bkey->reservoir_count, &bkey->key.generator );
+  }
+  bkey->reservoir_offset = bkey->reservoir_count = 0;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Смена маски неиспользованной гаммы, хранящейся в резервуаре контекста ключа.
+    \details Новая случайная последовательность складывается как с маскированной гаммой,
+    так и с маской, поэтому значение гаммы не изменяется. Поскольку маска меняется при каждом
+    использовании ключа, последовательность вырабатывается не генератором ключа (который
+    вырабатывает по одному октету за обращение), а линейным сравнением по модулю \f$ 2^{64} \f$
+    с теми же константами, начальное значение которого вырабатывается генератором ключа.
+    Неиспользованная гамма всегда занимает целое число 64-х битных слов.                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_ctr_reservoir_remask( ak_bckey bkey )
+{
+  size_t idx = 0;
+  ak_uint64 x = 0;
+  int error = ak_error_ok;
+  ak_uint64 *gamma = ( ak_uint64 *)( bkey->reservoir + bkey->reservoir_offset ),
+            *mask = gamma + ( bkey->reservoir_size >> 3 );
+
+  if( bkey->reservoir_count == 0 ) return ak_error_ok;
+  if(( error = ak_random_context_random( &bkey->key.generator, &x, sizeof( x ))) != ak_error_ok )
+    return ak_error_message( error, __func__ , "wrong generation a random mask for keystream" );
+  for( idx = 0; idx < ( bkey->reservoir_count >> 3 ); idx++ ) {
+     x = x*125643267795740073LL + 506098983240188723LL;
+     gamma[idx] ^= x;
+     mask[idx] ^= x;
+  }
+  x = 0;
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция маскирования ключа, для которого выделен резервуар гаммы.
+    \details Функция вызывает исходную функцию маскирования ключа и меняет маску гаммы,
+    поэтому маска гаммы меняется при каждом перемаскировании ключа, в том числе
+    в функциях, не использующих резервуар.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_set_mask_reservoir( ak_skey skey )
+{
+  int error = ak_error_ok;
+  ak_bckey bkey = ( ak_bckey ) skey; /* секретный ключ является первым полем структуры bckey */
+
+  if(( error = bkey->reservoir_set_mask( skey )) != ak_error_ok ) return error;
+ return ak_bckey_context_ctr_reservoir_remask( bkey );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция уничтожает резервуар гаммы и восстанавливает исходную функцию
+    маскирования ключа.                                                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_ctr_reservoir_free( ak_bckey bkey )
+{
+  if( bkey->reservoir == NULL ) return;
+  ak_bckey_context_ctr_reservoir_clean( bkey );
+  free( bkey->reservoir );
+  bkey->reservoir = NULL;
+  bkey->reservoir_size = 0;
+  bkey->key.set_mask = bkey->reservoir_set_mask;
+  bkey->reservoir_set_mask = NULL;
+}
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция устанавливает параметры алгоритма блочного шифрования, передаваемые в качестве
@@ -26,6 +108,8 @@
 
     - bkey.encrypt -- алгоритм зашифрования одного блока
     - bkey.decrypt -- алгоритм расшифрования одного блока
+    - bkey.encrypt_blocks -- алгоритм зашифрования нескольких последовательных блоков
+    - bkey.decrypt_blocks -- алгоритм расшифрования нескольких последовательных блоков
     - bkey.shedule_keys -- алгоритм развертки ключа и генерации раундовых ключей
     - bkey.delete_keys -- функция удаления раундовых ключей
 
@@ -61,10 +145,18 @@
     return ak_error_message( error, __func__, "wrong creation of secret key" );
 
   memset( bkey->ivector, 0, sizeof( bkey->ivector ));
+ /* до установки синхропосылки режим гаммирования не может использовать внутреннее значение */
+  bkey->key.flags |= ak_key_flag_not_ctr;
   bkey->bsize =         blocksize;
   bkey->ivector_size =  0;
+  bkey->reservoir =     NULL;
+  bkey->reservoir_size = bkey->reservoir_offset = bkey->reservoir_count = 0;
+  bkey->reservoir_set_mask = NULL;
   bkey->encrypt =       NULL;
   bkey->decrypt =       NULL;
+  bkey->encrypt_blocks = NULL;
+  bkey->decrypt_blocks = NULL;
+  bkey->mac_blocks =    NULL;
   bkey->schedule_keys = NULL;
   bkey->delete_keys =   NULL;
 
@@ -91,6 +183,8 @@
                                                           &bkey->key.generator )) != ak_error_ok )
     ak_error_message( error, __func__, "incorrect wiping of internal buffer" );
   bkey->ivector_size = 0;
+ /* уничтожаем заранее выработанную гамму */
+  ak_bckey_context_ctr_reservoir_free( bkey );
 
  /* уничтожаем секретный ключ */
   if(( error = ak_skey_context_destroy( &bkey->key )) != ak_error_ok )
@@ -99,6 +193,9 @@
   bkey->bsize =            0;
   bkey->encrypt =       NULL;
   bkey->decrypt =       NULL;
+  bkey->encrypt_blocks = NULL;
+  bkey->decrypt_blocks = NULL;
+  bkey->mac_blocks =    NULL;
   bkey->schedule_keys = NULL;
   bkey->delete_keys =   NULL;
 
@@ -179,6 +276,8 @@
                                                                 "using null pointer to key data" );
   if( size != bkey->key.key_size ) return ak_error_message( ak_error_wrong_length, __func__,
                                        "using a constant value for secret key with wrong length" );
+ /* гамма, выработанная на предыдущем значении ключа, больше не используется */
+  ak_bckey_context_ctr_reservoir_clean( bkey );
  /* присваиваем ключевой буффер */
   if(( error = ak_skey_context_set_key( &bkey->key, keyptr, size )) != ak_error_ok )
     return ak_error_message( error, __func__ , "incorrect assigning of fixed key data" );
@@ -228,6 +327,8 @@
                                                         "using null pointer to secret key context" );
   if( generator == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
                                                           "using null pointer to random generator" );
+ /* гамма, выработанная на предыдущем значении ключа, больше не используется */
+  ak_bckey_context_ctr_reservoir_clean( bkey );
  /* присваиваем ключевой буффер */
   if(( error = ak_skey_context_set_key_random( &bkey->key, generator )) != ak_error_ok )
     return ak_error_message( error, __func__ , "incorrect assigning of random key data" );
@@ -284,6 +385,8 @@
  /* проверяем входные данные */
   if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                         "using null pointer to secret key context" );
+ /* гамма, выработанная на предыдущем значении ключа, больше не используется */
+  ak_bckey_context_ctr_reservoir_clean( bkey );
  /* присваиваем ключевой буффер */
   if(( error = ak_skey_context_set_key_from_password( &bkey->key,
                                                 pass, pass_size, salt, salt_size )) != ak_error_ok )
@@ -315,21 +418,17 @@
 /* ----------------------------------------------------------------------------------------------- */
 /*                             теперь реализация режимов шифрования                                */
 /* ----------------------------------------------------------------------------------------------- */
-/*! @param bkey Контекст ключа алгоритма блочного шифрования.
-    @param in Указатель на область памяти, где хранятся входные (зашифровываемые) данные
-    @param out Указатель на область памяти, куда помещаются зашифрованные данные
-    (этот указатель может совпадать с in)
-    @param size Размер зашировываемых данных (в байтах). Для режима простой замены
-    длина зашифровываемых данных должна быть кратна длине блока.
+/*! \brief Функция выполняет проверки, предваряющие шифрование в режиме простой замены,
+    и уменьшает ресурс ключа на количество обрабатываемых блоков.
 
-    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
-    возвращается ak_error_ok (ноль)                                                                */
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param size Размер обрабатываемых данных (в байтах).
+    @return В случае успеха возвращается \ref ak_error_ok (ноль), в противном случае
+    возвращается код ошибки.                                                                       */
 /* ----------------------------------------------------------------------------------------------- */
- int ak_bckey_context_encrypt_ecb( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size )
+ static int ak_bckey_context_ecb_prepare( ak_bckey bkey, size_t size )
 {
   size_t blocks = 0;
-  int error = ak_error_ok;
-  ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
 
  /* выполняем проверку размера входных данных */
   if( size%bkey->bsize != 0 )
@@ -347,23 +446,36 @@
                                                    __func__ , "low resource of block cipher key" );
    else bkey->key.resource.value.counter -= blocks;
 
- /* теперь приступаем к зашифрованию данных */
-  switch( bkey->bsize ) {
-    case  8: /* шифр с длиной блока 64 бита */
-      do {
-        bkey->encrypt( &bkey->key, inptr++, outptr++ );
-      } while( --blocks > 0 );
-    break;
-
-    case 16: /* шифр с длиной блока 128 бит */
-      do {
-        bkey->encrypt( &bkey->key, inptr, outptr );
-        inptr+=2; outptr+=2;
-      } while( --blocks > 0 );
-    break;
-    default: return ak_error_message( ak_error_wrong_block_cipher,
+ /* все блоки независимы и обрабатываются многоблочными функциями,
+    которые определены для алгоритмов с длиной блока 64 и 128 бит */
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 ))
+    return ak_error_message( ak_error_wrong_block_cipher,
                                           __func__ , "incorrect block size of block cipher key" );
-  }
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на область памяти, где хранятся входные (зашифровываемые) данные
+    @param out Указатель на область памяти, куда помещаются зашифрованные данные
+    (этот указатель может совпадать с in)
+    @param size Размер зашировываемых данных (в байтах). Для режима простой замены
+    длина зашифровываемых данных должна быть кратна длине блока.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается ak_error_ok (ноль)                                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_encrypt_ecb( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size )
+{
+  int error = ak_error_ok;
+
+ /* проверяем ключ и уменьшаем его ресурс */
+  if(( error = ak_bckey_context_ecb_prepare( bkey, size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of ecb mode" );
+
+ /* теперь приступаем к зашифрованию данных:
+    все блоки независимы, поэтому обрабатываются многоблочной функцией за один вызов */
+  bkey->encrypt_blocks( &bkey->key, in, out, size/bkey->bsize );
  /* перемаскируем ключ */
   if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of secret key" );
@@ -384,50 +496,337 @@
 /* ----------------------------------------------------------------------------------------------- */
  int ak_bckey_context_decrypt_ecb( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size )
 {
-  size_t blocks = 0;
   int error = ak_error_ok;
-  ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
 
- /* выполняем проверку размера входных данных */
-  if( size%bkey->bsize != 0 )
-    return ak_error_message( ak_error_wrong_block_cipher_length,
-                            __func__ , "the length of input data is not divided by block length" );
+ /* проверяем ключ и уменьшаем его ресурс */
+  if(( error = ak_bckey_context_ecb_prepare( bkey, size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of ecb mode" );
+
+ /* теперь приступаем к расшифрованию данных:
+    все блоки независимы, поэтому обрабатываются многоблочной функцией за один вызов */
+  bkey->decrypt_blocks( &bkey->key, in, out, size/bkey->bsize );
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return ak_error_ok;
+}
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция выполняет проверки, предваряющие шифрование в режиме гаммирования.
+
+    Функция проверяет целостность ключа, уменьшает его ресурс и, если синхропосылка задана,
+    помещает ее во внутренний буффер контекста. Функция используется как в последовательной,
+    так и в многопоточной реализациях режима гаммирования, что гарантирует одинаковое
+    изменение состояния контекста ключа.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param blocks Количество обрабатываемых блоков (с учетом последнего неполного блока).
+    @param iv Указатель на синхропосылку или NULL.
+    @param iv_size Длина синхропосылки в байтах.
+    @param oc Флаг использования формата, совместимого с openssl.
+    @return В случае успеха возвращается \ref ak_error_ok (ноль), в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_ctr_prepare( ak_bckey bkey, ak_int64 blocks,
+                                                   ak_pointer iv, size_t iv_size, const int oc )
+{
+ /* заранее выработанная гамма используется только функцией ak_bckey_context_ctr() */
+  ak_bckey_context_ctr_reservoir_clean( bkey );
  /* проверяем целостность ключа */
   if( bkey->key.check_icode( &bkey->key ) != ak_true )
-    return ak_error_message( ak_error_wrong_key_icode,
-                                        __func__, "incorrect integrity code of secret key value" );
+    return ak_error_message( ak_error_wrong_key_icode, __func__,
+                                                   "incorrect integrity code of secret key value" );
  /* уменьшаем значение ресурса ключа */
-  blocks = size/bkey->bsize;
-  if( bkey->key.resource.value.counter < (ssize_t) blocks )
+  if( bkey->key.resource.value.counter < blocks )
     return ak_error_message( ak_error_low_key_resource,
-                                                   __func__ , "low resource of block cipher key" );
+                                                    __func__ , "low resource of block cipher key" );
    else bkey->key.resource.value.counter -= blocks;
 
- /* теперь приступаем к расшифрованию данных */
-  switch( bkey->bsize ) {
-    case  8: /* шифр с длиной блока 64 бита */
-      do {
-        bkey->decrypt( &bkey->key, inptr++, outptr++ );
-      } while( --blocks > 0 );
-    break;
+ /* выбираем, как вычислять синхропосылку проверяем флаг
+    флаг опускается при вызове функции с заданным значением синхропосылки и
+    всегда поднимается при обработке данных, не кратных длине блока */
+  if(( iv == NULL ) || ( iv_size == 0 )) { /* запрос на использование внутреннего значения */
 
-    case 16: /* шифр с длиной блока 128 бит */
-      do {
-        bkey->decrypt( &bkey->key, inptr, outptr );
-        inptr+=2; outptr+=2;
-      } while( --blocks > 0 );
-    break;
-    default: return ak_error_message( ak_error_wrong_block_cipher,
-                                          __func__ , "incorrect block size of block cipher key" );
-  }
- /* перемаскируем ключ */
-  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
-    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+    if( bkey->key.flags&ak_key_flag_not_ctr )
+      return ak_error_message( ak_error_wrong_block_cipher_function, __func__ ,
+                                           "function call with undefined value of initial vector" );
+  } else {
+    /* данное значение определяет в точности поовину блока */
+     size_t halfsize = bkey->bsize >> 1 ;
+
+    /* проверяем длину синхропосылки (если меньше половины блока, то плохо)
+        если больше, то нормально - лишнее простое не используется */
+     if( iv_size < halfsize )
+       return ak_error_message( ak_error_wrong_iv_length, __func__,
+                                                              "incorrect length of initial value" );
+    /* помещаем во внутренний буффер значение синхропосылки */
+     memset( bkey->ivector, 0, ( bkey->ivector_size = bkey->bsize ));
+    /* слишком большое значение iv_size может привести к выходу за границы памяти,
+                                                       выделенной под переменную ivector */
+     memcpy( bkey->ivector + halfsize*((unsigned int)(1-oc)), iv, ak_min( halfsize, iv_size ));
+
+    /* опускаем значение флага: синхропосылка установлена */
+     bkey->key.flags &= ~ak_key_flag_not_ctr;
+    }
 
  return ak_error_ok;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция возвращает значение счетчика, хранящегося во внутреннем буффере
+    контекста ключа алгоритма блочного шифрования.
+    \details Для алгоритма с длиной блока 128 бит возвращается младшая половина счетчика,
+    для алгоритма с длиной блока 64 бита - весь счетчик.                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline ak_uint64 ak_bckey_context_ctr_get_counter( ak_bckey bkey, const int oc )
+{
+  const int idx = ( bkey->bsize == 16 ) ? oc : 0;
+ #ifdef LIBAKRYPT_LITTLE_ENDIAN
+  return oc ? bswap_64( ((ak_uint64 *)bkey->ivector)[idx] ) : ((ak_uint64 *)bkey->ivector)[idx];
+ #else
+  return oc ? ((ak_uint64 *)bkey->ivector)[idx] : bswap_64( ((ak_uint64 *)bkey->ivector)[idx] );
+ #endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция помещает значение счетчика во внутренний буффер
+    контекста ключа алгоритма блочного шифрования.                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_bckey_context_ctr_set_counter( ak_bckey bkey,
+                                                                   ak_uint64 x, const int oc )
+{
+  const int idx = ( bkey->bsize == 16 ) ? oc : 0;
+ #ifdef LIBAKRYPT_LITTLE_ENDIAN
+  ((ak_uint64 *)bkey->ivector)[idx] = oc ? bswap_64( x ) : x;
+ #else
+  ((ak_uint64 *)bkey->ivector)[idx] = oc ? x : bswap_64( x );
+ #endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования заданного количества полных блоков для алгоритма
+    с длиной блока 128 бит.
+
+    Гамма вырабатывается из значений счетчика `x`, `x+1`, ..., старшая половина блока
+    счетчика берется из внутреннего буффера контекста ключа, который функцией не изменяется.
+    Это позволяет одновременно вызывать функцию для непересекающихся фрагментов данных.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param inptr Указатель на входные данные.
+    @param outptr Указатель на выходные данные (может совпадать с `inptr`).
+    @param blocks Количество обрабатываемых блоков.
+    @param x Значение счетчика для первого блока.
+    @param oc Флаг использования формата, совместимого с openssl.                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_ctr_blocks128( ak_bckey bkey, ak_uint64 *inptr,
+                               ak_uint64 *outptr, ak_int64 blocks, ak_uint64 x, const int oc )
+{
+  ak_uint64 counters[2*ak_bckey_context_buffer_blocks];
+
+  while( blocks > 0 ) {
+     ak_int64 idx = 0, count = ak_min( blocks, ak_bckey_context_buffer_blocks );
+
+    /* формируем последовательность значений счетчика,
+       за элементарное сложение с единицей приходится платить одним разворотом */
+     for( idx = 0; idx < count; idx++ ) {
+        counters[2*idx+1-oc] = ((ak_uint64 *)bkey->ivector)[1-oc];
+       #ifdef LIBAKRYPT_LITTLE_ENDIAN
+        counters[2*idx+oc] = oc ? bswap_64( x ) : x;
+       #else
+        counters[2*idx+oc] = oc ? x : bswap_64( x );
+       #endif
+        x++;                   /* здесь мы не учитываем знак переноса
+                                  потому что объем данных на одном ключе не должен
+                                  превышать 2^64 блоков (контролируется через ресурс ключа) */
+     }
+    /* вырабатываем гамму за один вызов многоблочной функции и накладываем ее на данные */
+     bkey->encrypt_blocks( &bkey->key, counters, counters, (size_t) count );
+     for( idx = 0; idx < 2*count; idx++ ) outptr[idx] = inptr[idx] ^ counters[idx];
+     outptr += 2*count; inptr += 2*count;
+     blocks -= count;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования заданного количества полных блоков для алгоритма
+    с длиной блока 64 бита.
+
+    Гамма вырабатывается из значений счетчика `x`, `x+1`, ..., где счетчик занимает весь блок.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param inptr Указатель на входные данные.
+    @param outptr Указатель на выходные данные (может совпадать с `inptr`).
+    @param blocks Количество обрабатываемых блоков.
+    @param x Значение счетчика для первого блока.
+    @param oc Флаг использования формата, совместимого с openssl.                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_ctr_blocks64( ak_bckey bkey, ak_uint64 *inptr,
+                               ak_uint64 *outptr, ak_int64 blocks, ak_uint64 x, const int oc )
+{
+  ak_uint64 counters[2*ak_bckey_context_buffer_blocks];
+
+  while( blocks > 0 ) {
+     ak_int64 idx = 0, count = ak_min( blocks, 2*ak_bckey_context_buffer_blocks );
+
+     for( idx = 0; idx < count; idx++, x++ ) {
+       #ifdef LIBAKRYPT_LITTLE_ENDIAN
+        counters[idx] = oc ? bswap_64( x ) : x;
+       #else
+        counters[idx] = oc ? x : bswap_64( x );
+       #endif
+     }
+     bkey->encrypt_blocks( &bkey->key, counters, counters, (size_t) count );
+     for( idx = 0; idx < count; idx++ ) outptr[idx] = inptr[idx] ^ counters[idx];
+     outptr += count; inptr += count;
+     blocks -= count;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования последнего неполного блока данных.
+
+    Согласно ГОСТ Р 34.13-2015 неполный блок длины `tail` октетов складывается со старшими
+    `tail` октетами зашифрованного значения счетчика. При хранении блоков в формате little endian
+    это октеты с номерами от `bsize - tail` до `bsize - 1`, которые используются в порядке
+    возрастания номеров; в формате openssl - октеты с номерами от `0` до `tail - 1`.
+    Тем самым в обоих форматах используются одни и те же октеты гаммы.
+
+    Ранее использовались октеты с номерами `bsize - tail - i`, то есть младшие октеты гаммы
+    в обратном порядке. Такой вариант не совпадал с форматом openssl и реализацией gost-engine,
+    а при `tail > bsize/2` приводил к чтению за границей зашифрованного счетчика.
+
+    После обработки неполного блока дальнейшее использование внутреннего значения
+    синхропосылки запрещается.                                                                     */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_ctr_tail( ak_bckey bkey, ak_uint8 *inptr,
+                                                  ak_uint8 *outptr, ak_int64 tail, const int oc )
+{
+  ak_int64 i = 0;
+  ak_uint64 yaout[2];
+
+  bkey->encrypt( &bkey->key, bkey->ivector, yaout );
+  for( i = 0; i < tail; i++ ) /* теперь мы гаммируем tail байт, используя для этого
+                                 старшие байты (most significant bytes) зашифрованного счетчика */
+     if( oc ) outptr[i] = inptr[i]^( (ak_uint8 *)yaout)[i];
+      else outptr[i] = inptr[i]^( (ak_uint8 *)yaout)[bkey->bsize - (size_t)tail + (size_t)i];
+
+ /* запрещаем дальнейшее использование функции на данном значении синхропосылки,
+                                         поскольку обрабатываемые данные не кратны длине блока. */
+  memset( bkey->ivector, 0, sizeof( bkey->ivector ));
+  bkey->key.flags |= ak_key_flag_not_ctr;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция преобразует значение счетчика к формату, используемому при хранении
+    во внутреннем буффере контекста ключа.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline ak_uint64 ak_bckey_context_ctr_encode( ak_uint64 x, const int oc )
+{
+ #ifdef LIBAKRYPT_LITTLE_ENDIAN
+  return oc ? bswap_64( x ) : x;
+ #else
+  return oc ? x : bswap_64( x );
+ #endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования полных блоков, принадлежащих последовательности секторов.
+
+    Блок с номером `j` сектора с номером `n` зашифровывается на значении счетчика, которое
+    получается из значения, установленного функцией ak_bckey_context_ctr_prepare(), следующим
+    образом: к младшей половине счетчика прибавляется `j`, а синхропосылка складывается
+    по модулю два с номером сектора (для алгоритма с длиной блока 64 бита учитываются
+    младшие 32 бита номера). Значения счетчиков для блоков, принадлежащих различным секторам,
+    вычисляются независимо, поэтому гамма для нескольких коротких секторов вырабатывается
+    одним вызовом многоблочной функции.
+
+    Внутренний буффер контекста ключа функцией не изменяется, что позволяет одновременно
+    вызывать функцию для непересекающихся фрагментов данных.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param inptr Указатель на входные данные.
+    @param outptr Указатель на выходные данные (может совпадать с `inptr`).
+    @param blocks Общее количество обрабатываемых блоков.
+    @param n Номер сектора, которому принадлежит первый блок.
+    @param j Номер первого блока в секторе.
+    @param per Количество блоков в секторе; нулевое значение означает, что данные
+    не разбиваются на секторы.
+    @param oc Флаг использования формата, совместимого с openssl.                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_ctr_sectors_blocks( ak_bckey bkey, ak_uint64 *inptr,
+          ak_uint64 *outptr, ak_uint64 blocks, ak_uint64 n, ak_uint64 j, const ak_uint64 per,
+                                                                                   const int oc )
+{
+  ak_uint64 counters[2*ak_bckey_context_buffer_blocks];
+  const size_t words = bkey->bsize >> 3, batch = 2*ak_bckey_context_buffer_blocks/words;
+  const ak_uint64 x = ak_bckey_context_ctr_get_counter( bkey, oc ),
+                 iv = ((ak_uint64 *)bkey->ivector)[1-oc];
+
+  while( blocks > 0 ) {
+     size_t idx = 0, count = ( size_t ) ak_min( blocks, ( ak_uint64 ) batch );
+
+     for( idx = 0; idx < count; idx++ ) {
+        if( words == 2 ) {
+          counters[2*idx+1-oc] = iv ^ ak_bckey_context_ctr_encode( n, oc );
+          counters[2*idx+oc] = ak_bckey_context_ctr_encode( x + j, oc );
+        } else counters[idx] = ak_bckey_context_ctr_encode(( x + j ) ^ ( n << 32 ), oc );
+        if( ++j == per ) { j = 0; n++; }
+     }
+     bkey->encrypt_blocks( &bkey->key, counters, counters, count );
+     for( idx = 0; idx < words*count; idx++ ) outptr[idx] = inptr[idx] ^ counters[idx];
+     outptr += words*count; inptr += words*count;
+     blocks -= count;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования данных с использованием заранее выработанной гаммы.
+
+    Из резервуара берется гамма для полных блоков данных; если после этого остается только
+    неполный блок, а резервуар не пуст, то для него также используется гамма из резервуара,
+    после чего, как и в функции ak_bckey_context_ctr_tail(), дальнейшее использование
+    внутреннего значения синхропосылки запрещается. Использованная гамма сразу же обнуляется.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param inptr Указатель на входные данные.
+    @param outptr Указатель на выходные данные (может совпадать с `inptr`).
+    @param size Размер данных (в октетах).
+    @param oc Флаг использования формата, совместимого с openssl.
+    @return Количество обработанных октетов. Если обработаны не все данные, то возвращаемое
+    значение кратно длине блока, а резервуар пуст.                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static size_t ak_bckey_context_ctr_reservoir_use( ak_bckey bkey, ak_uint8 *inptr,
+                                                ak_uint8 *outptr, size_t size, const int oc )
+{
+  size_t i = 0, tail = 0, done = ak_min( size - size%bkey->bsize, bkey->reservoir_count );
+  ak_uint8 *gamma = bkey->reservoir + bkey->reservoir_offset,
+           *mask = gamma + bkey->reservoir_size;
+
+ /* маска снимается только с используемых октетов гаммы */
+  for( i = 0; i < done; i++ ) outptr[i] = inptr[i]^gamma[i]^mask[i];
+  memset( gamma, 0, done );
+  memset( mask, 0, done );
+  bkey->reservoir_offset += done;
+  bkey->reservoir_count -= done;
+  ak_bckey_context_ctr_set_counter( bkey,
+                    ak_bckey_context_ctr_get_counter( bkey, oc ) + done/bkey->bsize, oc );
+
+ /* последний неполный блок гаммируется так же, как в функции ak_bckey_context_ctr_tail() */
+  if((( tail = size - done ) > 0 ) && ( tail < bkey->bsize ) && ( bkey->reservoir_count > 0 )) {
+    gamma += done; mask += done;
+    for( i = 0; i < tail; i++ ) {
+       size_t j = oc ? i : bkey->bsize - tail + i;
+       outptr[done+i] = inptr[done+i]^gamma[j]^mask[j];
+    }
+    ak_bckey_context_ctr_reservoir_clean( bkey );
+    memset( bkey->ivector, 0, sizeof( bkey->ivector ));
+    bkey->key.flags |= ak_key_flag_not_ctr;
+    done = size;
+  }
+ return done;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! В режиме гаммирования операцией шифрования является сложение открытого текста по модулю два
     с последовательностью, вырабатываемой блочным шифром, поэтому для зашифрования и расшифрования
@@ -461,6 +860,12 @@
  зашифровывать данные в случае, когда они поступают фрагментами, например из сети, или когда хранение
  данных полностью в оперативной памяти нецелесообразно (например, шифрование больших файлов).
 
+ Если для ключа выделен резервуар (см. ak_bckey_context_set_ctr_reservoir()) и в нем содержится
+ гамма, выработанная функцией ak_bckey_context_ctr_reservoir_fill(), то при продолжении шифрования
+ (то есть при вызове функции без синхропосылки) в первую очередь используется эта гамма. Если
+ гаммы в резервуаре достаточно, то данные обрабатываются без обращения к алгоритму блочного
+ шифрования. Задание новой синхропосылки уничтожает содержимое резервуара.
+
     @param bkey Контекст ключа алгоритма блочного шифрования, на котором происходит
     зашифрование или расшифрование информации.
     @param in Указатель на область памяти, где хранятся входные (открытые) данные.
@@ -480,126 +885,55 @@
  int ak_bckey_context_ctr( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
                                                                      ak_pointer iv, size_t iv_size )
 {
-  ak_int64 blocks = (ak_int64)( size/bkey->bsize ),
-             tail = (ak_int64)( size%bkey->bsize );
-  ak_uint64 x, yaout[2], *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
+  ak_int64 blocks = 0, tail = 0;
+  ak_uint64 x, *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
   int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
 
   if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
                                                 "wrong value for \"openssl_compability\" option" );
- /* проверяем целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
-    return ak_error_message( ak_error_wrong_key_icode, __func__,
-                                                   "incorrect integrity code of secret key value" );
- /* уменьшаем значение ресурса ключа */
-  if( bkey->key.resource.value.counter < ( blocks + ( tail > 0 )))
-    return ak_error_message( ak_error_low_key_resource,
-                                                    __func__ , "low resource of block cipher key" );
-   else bkey->key.resource.value.counter -= ( blocks + ( tail > 0 ));
-
- /* выбираем, как вычислять синхропосылку проверяем флаг
-    флаг поднимается при вызове функции с заданным значением синхропосылки и
-    всегда опускается при обработке данных, не кратных длина блока */
-  if(( iv == NULL ) || ( iv_size == 0 )) { /* запрос на использование внутреннего значения */
-
-    if( bkey->key.flags&ak_key_flag_not_ctr )
-      return ak_error_message( ak_error_wrong_block_cipher_function, __func__ ,
-                                           "function call with undefined value of initial vector" );
-  } else {
-    /* данное значение определяет в точности поовину блока */
-     size_t halfsize = bkey->bsize >> 1 ;
-
-    /* проверяем длину синхропосылки (если меньше половины блока, то плохо)
-        если больше, то нормально - лишнее простое не используется */
-     if( iv_size < halfsize )
-       return ak_error_message( ak_error_wrong_iv_length, __func__,
-                                                              "incorrect length of initial value" );
-    /* помещаем во внутренний буффер значение синхропосылки */
-     memset( bkey->ivector, 0, ( bkey->ivector_size = bkey->bsize ));
-    /* слишком большое значение iv_size может привести к выходу за границы памяти,
-                                                       выделенной под переменную ivector */
-     memcpy( bkey->ivector + halfsize*((unsigned int)(1-oc)), iv, ak_min( halfsize, iv_size ));
+ /* в первую очередь используем заранее выработанную гамму */
+  if((( iv == NULL ) || ( iv_size == 0 )) && ( bkey->reservoir_count > 0 )) {
+    size_t done = 0;
 
-    /* поднимаем значение флага: синхропосылка установлена */
-     bkey->key.flags = ( bkey->key.flags&( ~ak_key_flag_not_ctr ))^ak_key_flag_not_ctr;
+    if( bkey->key.check_icode( &bkey->key ) != ak_true )
+      return ak_error_message( ak_error_wrong_key_icode, __func__,
+                                                   "incorrect integrity code of secret key value" );
+    if(( done = ak_bckey_context_ctr_reservoir_use( bkey, in, out, size, oc )) == size ) {
+     /* перемаскируем ключ и гамму */
+      if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+        ak_error_message( error, __func__ , "wrong remasking of secret key" );
+      return error;
     }
-
-
- /*
-  *
-  *
-  *
-
-    не работает 64х битный шифр, от слова совсем
-
-  *
-  *
-  *
-  */
-
+    inptr += done >> 3; outptr += done >> 3;
+    size -= done;
+  }
+  blocks = (ak_int64)( size/bkey->bsize );
+  tail = (ak_int64)( size%bkey->bsize );
+ /* проверяем ключ, уменьшаем его ресурс и устанавливаем синхропосылку */
+  if(( error = ak_bckey_context_ctr_prepare( bkey,
+                                         blocks + ( tail > 0 ), iv, iv_size, oc )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of counter mode" );
 
  /* обработка основного массива данных (кратного длине блока) */
+  x = ak_bckey_context_ctr_get_counter( bkey, oc );
   switch( bkey->bsize ) {
     case  8: /* шифр с длиной блока 64 бита */
-      while( blocks > 0 ) {
-        #ifndef LIBAKRYPT_LITTLE_ENDIAN
-          ak_uint64 tmp = bswap_64( ((ak_uint64 *)bkey->ivector)[0] );
-        #endif
-          bkey->encrypt( &bkey->key, bkey->ivector, yaout );
-          *outptr = *inptr ^ yaout[0];
-          outptr++; inptr++;
-        #ifdef LIBAKRYPT_LITTLE_ENDIAN
-          ((ak_uint64 *)bkey->ivector)[0]++;
-        #else
-          ((ak_uint64 *)bkey->ivector)[0] = bswap_64( ++tmp );
-        #endif
-        --blocks;
-      }
+      ak_bckey_context_ctr_blocks64( bkey, inptr, outptr, blocks, x, oc );
+      inptr += blocks; outptr += blocks;
     break;
 
     case 16: /* шифр с длиной блока 128 бит */
-     #ifndef LIBAKRYPT_LITTLE_ENDIAN
-      x = bswap_64( ((ak_uint64 *)bkey->ivector)[oc] );
-     #else
-      x = ((ak_uint64 *)bkey->ivector)[oc];
-     #endif
-
-      while( blocks > 0 ) {
-          bkey->encrypt( &bkey->key, bkey->ivector, yaout );
-          *outptr = *inptr ^ yaout[0]; outptr++; inptr++;
-          *outptr = *inptr ^ yaout[1]; outptr++; inptr++;
-
-       /* за элементарное сложение с единицей приходится платить одним разворотом */
-        #ifdef LIBAKRYPT_LITTLE_ENDIAN
-         ((ak_uint64 *)bkey->ivector)[oc] = oc ? bswap_64(++x) : ++x;
-        #else
-          ((ak_uint64 *)bkey->ivector)[oc] = oc ? ++x : bswap_64( ++x );
-        #endif                    /* здесь мы не учитываем знак переноса
-                                     потому что объем данных на одном ключе не должен
-                                     превышать 2^64 блоков (контролируется через ресурс ключа) */
-        --blocks;
-      }
+      ak_bckey_context_ctr_blocks128( bkey, inptr, outptr, blocks, x, oc );
+      inptr += 2*blocks; outptr += 2*blocks;
     break;
 
     default: return ak_error_message( ak_error_wrong_block_cipher,
                                           __func__ , "incorrect block size of block cipher key" );
   }
+  ak_bckey_context_ctr_set_counter( bkey, x + (ak_uint64)blocks, oc );
 
  /* обрабатываем хвост сообщения */
-  if( tail ) {
-    int i;
-    bkey->encrypt( &bkey->key, bkey->ivector, yaout );
-    for( i = 0; i < tail; i++ ) /* теперь мы гаммируем tail байт, используя для этого
-                                   старшие байты (most significant bytes) зашифрованного счетчика */
-       if( oc ) ( (ak_uint8*)outptr )[i] = ( (ak_uint8*)inptr )[i]^( (ak_uint8 *)yaout)[i];
-        else ( (ak_uint8*)outptr )[i] =
-           ( (ak_uint8*)inptr )[i]^( (ak_uint8 *)yaout)[bkey->bsize - (size_t)(tail+i)];
-
-   /* запрещаем дальнейшее использование функции на данном значении синхропосылки,
-                                           поскольку обрабатываемые данные не кратны длине блока. */
-    memset( bkey->ivector, 0, sizeof( bkey->ivector ));
-    bkey->key.flags = bkey->key.flags&( ~ak_key_flag_not_ctr );
-  }
+  if( tail ) ak_bckey_context_ctr_tail( bkey, (ak_uint8 *)inptr, (ak_uint8 *)outptr, tail, oc );
 
  /* перемаскируем ключ */
   if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
@@ -608,39 +942,755 @@
  return error;
 }
 
- int ak_bckey_context_encrypt_cbc( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
-                                    ak_pointer iv, size_t iv_size )
- {
-   ak_int64 blocks = 0;
-   ak_uint64 yaout[2], z = iv_size / bkey->bsize;
-   ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out, *ivector = (ak_uint64 *)bkey->ivector;
-   int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция предназначена для приложений, для которых важно время обработки коротких сообщений:
+    гамма режима гаммирования может быть выработана заранее, например, в промежутках между
+    поступлением сетевых пакетов, функцией ak_bckey_context_ctr_reservoir_fill(), после чего
+    функция ak_bckey_context_ctr() лишь складывает данные с готовой гаммой.
 
-   if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
-                                                 "wrong value for \"openssl_compability\" option" );
+    Ранее выделенный резервуар освобождается вместе с содержащейся в нем гаммой; значение
+    счетчика при этом не изменяется, так что шифрование может быть продолжено.
 
-  /* выполняем проверку размера входных данных */
-   if( size%bkey->bsize != 0 )
-     return ak_error_message( ak_error_wrong_block_cipher_length,
-                             __func__ , "the length of input data is not divided by block length" );
+    Гамма хранится в резервуаре в маскированном виде, аналогично значению ключа. Маска гаммы
+    меняется при каждом перемаскировании ключа и снимается только с используемых октетов.
 
-  /* проверяем целостность ключа */
-   if( bkey->key.check_icode( &bkey->key ) != ak_true )
-     return ak_error_message( ak_error_wrong_key_icode,
-                                         __func__, "incorrect integrity code of secret key value" );
-  /* уменьшаем значение ресурса ключа */
-   blocks = (ak_int64 ) (size/bkey->bsize);
-   if( bkey->key.resource.value.counter < blocks )
-     return ak_error_message( ak_error_low_key_resource,
-                                                    __func__ , "low resource of block cipher key" );
-    else bkey->key.resource.value.counter -= blocks;
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param size Размер резервуара (в октетах); округляется вниз до величины, кратной длине блока.
+    Нулевое значение означает освобождение резервуара.
+    @return В случае успеха возвращается \ref ak_error_ok (ноль), в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_set_ctr_reservoir( ak_bckey bkey, const size_t size )
+{
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                   "using null pointer to block cipher key" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+               ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher key" );
+  ak_bckey_context_ctr_reservoir_free( bkey );
+  if( size < bkey->bsize ) return ak_error_ok;
+
+ /* резервуар содержит маскированную гамму и ее маску */
+  if(( bkey->reservoir = malloc( 2*( size - size%bkey->bsize ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                                    "incorrect memory allocation for reservoir" );
+  memset( bkey->reservoir, 0, 2*( bkey->reservoir_size = size - size%bkey->bsize ));
+ /* при каждом перемаскировании ключа меняется и маска гаммы */
+  bkey->reservoir_set_mask = bkey->key.set_mask;
+  bkey->key.set_mask = ak_bckey_context_set_mask_reservoir;
+ return ak_error_ok;
+}
 
-     /* проверяем длину синхропосылки (если меньше  блока, то плохо) */
-      if( iv_size < bkey->bsize || iv_size%bkey->bsize != 0 )
-        return ak_error_message( ak_error_wrong_iv_length, __func__,
-                                                               "incorrect length of initial value" );
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вырабатывает гамму режима гаммирования и помещает ее в резервуар, выделенный
+    функцией ak_bckey_context_set_ctr_reservoir(). Если синхропосылка задана, то ранее
+    выработанная гамма уничтожается и резервуар заполняется гаммой, соответствующей новой
+    синхропосылке (значение синхропосылки интерпретируется так же, как в функции
+    ak_bckey_context_ctr()). Если синхропосылка не задана, то неиспользованная гамма
+    сохраняется, а резервуар дополняется гаммой, вырабатываемой от внутреннего значения счетчика.
+
+    Ресурс ключа уменьшается в момент выработки гаммы, то есть учитывает каждое обращение
+    к алгоритму блочного шифрования; использование гаммы из резервуара ресурс не уменьшает.
+    Объем вырабатываемой гаммы ограничивается оставшимся ресурсом ключа. Гамма, уничтоженная
+    до использования (при смене синхропосылки или ключа), будет выработана заново при
+    последующем шифровании.
+
+    Синхропосылка, значение счетчика и ресурс ключа изменяются так, что результат шифрования
+    функцией ak_bckey_context_ctr() не зависит от того, использовался ли резервуар.
 
-     memcpy(bkey->ivector, iv, iv_size);
+\code
+  ak_bckey_context_set_ctr_reservoir( &key, 4096 );
+  ak_bckey_context_ctr_reservoir_fill( &key, iv, 8 );   // вне критического пути
+  ak_bckey_context_ctr( &key, in, out, 64, NULL, 0 );    // только сложение с гаммой
+  ak_bckey_context_ctr_reservoir_fill( &key, NULL, 0 );  // пополнение резервуара
+\endcode
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param iv Указатель на синхропосылку или NULL.
+    @param iv_size Длина синхропосылки (в октетах).
+    @return В случае успеха возвращается \ref ak_error_ok (ноль), в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_ctr_reservoir_fill( ak_bckey bkey, ak_pointer iv, size_t iv_size )
+{
+  ak_int64 blocks = 0;
+  ak_uint64 *ptr = NULL;
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                   "using null pointer to block cipher key" );
+  if( bkey->reservoir == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                        "using key without keystream reservoir" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+               ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher key" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+
+  if(( iv != NULL ) && ( iv_size > 0 )) {
+   /* новая синхропосылка: проверяем ключ, уменьшаем его ресурс и уничтожаем старую гамму */
+    blocks = (ak_int64)( bkey->reservoir_size/bkey->bsize );
+    if( bkey->key.resource.value.counter < blocks )
+      blocks = ak_max( bkey->key.resource.value.counter, 0 );
+    if(( error = ak_bckey_context_ctr_prepare( bkey, blocks, iv, iv_size, oc )) != ak_error_ok )
+      return ak_error_message( error, __func__, "incorrect initialization of counter mode" );
+  } else {
+   /* продолжение: неиспользованная гамма переносится в начало резервуара */
+    if( bkey->key.flags&ak_key_flag_not_ctr )
+      return ak_error_message( ak_error_wrong_block_cipher_function, __func__ ,
+                                           "function call with undefined value of initial vector" );
+    if( bkey->key.check_icode( &bkey->key ) != ak_true )
+      return ak_error_message( ak_error_wrong_key_icode, __func__,
+                                                   "incorrect integrity code of secret key value" );
+    if( bkey->reservoir_offset > 0 ) {
+      memmove( bkey->reservoir, bkey->reservoir + bkey->reservoir_offset, bkey->reservoir_count );
+      memmove( bkey->reservoir + bkey->reservoir_size,
+               bkey->reservoir + bkey->reservoir_size + bkey->reservoir_offset,
+                                                                        bkey->reservoir_count );
+      bkey->reservoir_offset = 0;
+    }
+    blocks = (ak_int64)(( bkey->reservoir_size - bkey->reservoir_count )/bkey->bsize );
+    if( bkey->key.resource.value.counter < blocks )
+      blocks = ak_max( bkey->key.resource.value.counter, 0 );
+    bkey->key.resource.value.counter -= blocks;
+  }
+  if( blocks == 0 ) return ak_error_ok;
+
+ /* вырабатываем гамму, начиная со счетчика, следующего за последним блоком резервуара;
+    гамма складывается сразу с маской и в открытом виде не хранится */
+  ptr = (ak_uint64 *)( bkey->reservoir + bkey->reservoir_count );
+  if(( error = ak_random_context_random( &bkey->key.generator,
+                          (ak_uint8 *)ptr + bkey->reservoir_size,
+                                          (ssize_t) blocks*bkey->bsize )) != ak_error_ok ) {
+    bkey->key.resource.value.counter += blocks;
+    return ak_error_message( error, __func__ , "wrong generation a random mask for keystream" );
+  }
+  memcpy( ptr, (ak_uint8 *)ptr + bkey->reservoir_size, (size_t) blocks*bkey->bsize );
+  if( bkey->bsize == 8 )
+    ak_bckey_context_ctr_blocks64( bkey, ptr, ptr, blocks,
+          ak_bckey_context_ctr_get_counter( bkey, oc ) + bkey->reservoir_count/8, oc );
+   else
+    ak_bckey_context_ctr_blocks128( bkey, ptr, ptr, blocks,
+          ak_bckey_context_ctr_get_counter( bkey, oc ) + bkey->reservoir_count/16, oc );
+  bkey->reservoir_count += (size_t) blocks*bkey->bsize;
+
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                 режим гаммирования с одновременной выработкой имитовставки                      */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция проверяет параметры и выполняет действия, предваряющие шифрование
+    в режиме гаммирования с одновременной выработкой имитовставки.                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_ctr_mac_prepare( ak_bckey bkey, ak_mac mctx, size_t size,
+                                                  ak_pointer iv, size_t iv_size, const int oc )
+{
+  int error = ak_error_ok;
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to block cipher key" );
+  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                             "using null pointer to mac context" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+               ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher key" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+ /* проверяем ключ, уменьшаем его ресурс и устанавливаем синхропосылку */
+  if(( error = ak_bckey_context_ctr_prepare( bkey, (ak_int64)(( size + bkey->bsize - 1 )/
+                                            bkey->bsize ), iv, iv_size, oc )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of counter mode" );
+ /* сжимающее отображение вычисляется заново */
+  if(( error = ak_mac_context_clean( mctx )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect cleaning of mac context" );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования данных с одновременной выработкой имитовставки.
+
+    Данные обрабатываются фрагментами длины \ref ak_bckey_context_ctr_mac_chunk_size байт:
+    фрагмент гаммируется и сразу же, пока он находится в кэш-памяти, передается
+    сжимающему отображению. При зашифровании сжимающему отображению передается результат
+    гаммирования, при расшифровании - входные данные, причем до их изменения, что позволяет
+    указателям `in` и `out` совпадать.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param mctx Контекст сжимающего отображения, очищенный перед вызовом функции.
+    @param in Указатель на входные данные.
+    @param out Указатель на выходные данные.
+    @param size Размер обрабатываемых данных (в байтах).
+    @param encrypt Флаг зашифрования.
+    @param oc Флаг использования формата, совместимого с openssl.
+    @param tag Область памяти, куда помещается имитовставка.
+    @param tag_size Размер имитовставки (в байтах).
+    @return В случае успеха возвращается \ref ak_error_ok (ноль), в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_ctr_mac_chunks( ak_bckey bkey, ak_mac mctx, ak_uint8 *in,
+                        ak_uint8 *out, size_t size, const bool_t encrypt, const int oc,
+                                                              ak_pointer tag, const size_t tag_size )
+{
+  size_t len = 0, tail = size%bkey->bsize,
+         blocks = size/bkey->bsize, chunk = ak_bckey_context_ctr_mac_chunk_size/bkey->bsize;
+  ak_uint64 x = ak_bckey_context_ctr_get_counter( bkey, oc );
+
+  while( blocks > 0 ) {
+     len = ak_min( blocks, chunk );
+     if( !encrypt ) ak_mac_context_update( mctx, in, len*bkey->bsize );
+     if( bkey->bsize == 16 ) ak_bckey_context_ctr_blocks128( bkey, ( ak_uint64 *)in,
+                                                       ( ak_uint64 *)out, (ak_int64) len, x, oc );
+      else ak_bckey_context_ctr_blocks64( bkey, ( ak_uint64 *)in,
+                                                       ( ak_uint64 *)out, (ak_int64) len, x, oc );
+     if( encrypt ) ak_mac_context_update( mctx, out, len*bkey->bsize );
+     in += len*bkey->bsize; out += len*bkey->bsize;
+     x += len; blocks -= len;
+  }
+  ak_bckey_context_ctr_set_counter( bkey, x, oc );
+
+ /* обрабатываем хвост сообщения */
+  if( tail ) {
+    if( !encrypt ) ak_mac_context_update( mctx, in, tail );
+    ak_bckey_context_ctr_tail( bkey, in, out, (ak_int64) tail, oc );
+    if( encrypt ) ak_mac_context_update( mctx, out, tail );
+  }
+
+ return ak_mac_context_finalize( mctx, "", 0, tag, tag_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция зашифровывает данные в режиме гаммирования и вычисляет имитовставку от полученного
+    шифртекста (схема encrypt-then-mac). В качестве алгоритма выработки имитовставки может
+    использоваться любой алгоритм, реализованный с помощью контекста сжимающего отображения,
+    например, \ref omac или \ref hmac (в этом случае передается указатель на поле `mctx`).
+
+    Результат работы функции совпадает с результатом последовательного вызова функций
+    ak_bckey_context_ctr() и ak_mac_context_ptr() (например, ak_omac_context_ptr() или
+    ak_hmac_context_ptr()) для зашифрованных данных. Однако данные обрабатываются
+    за один проход: каждый фрагмент длины \ref ak_bckey_context_ctr_mac_chunk_size байт
+    передается сжимающему отображению сразу после зашифрования, пока он находится в кэш-памяти.
+    Поэтому для больших сообщений объем обращений к оперативной памяти уменьшается вдвое.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param mctx Контекст сжимающего отображения, ключ которого должен быть заранее установлен.
+    @param in Указатель на область памяти, где хранятся входные (открытые) данные.
+    @param out Указатель на область памяти, куда помещаются зашифрованные данные
+    (этот указатель может совпадать с `in`).
+    @param size Размер зашифровываемых данных (в байтах).
+    @param iv Указатель на синхропосылку или NULL.
+    @param iv_size Длина синхропосылки в байтах.
+    @param tag Область памяти, куда помещается имитовставка.
+    @param tag_size Размер имитовставки (в байтах).
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_encrypt_ctr_mac( ak_bckey bkey, ak_mac mctx, ak_pointer in, ak_pointer out,
+                 size_t size, ak_pointer iv, size_t iv_size, ak_pointer tag, size_t tag_size )
+{
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( tag == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                     "using null pointer to authentication code" );
+  if(( error = ak_bckey_context_ctr_mac_prepare( bkey, mctx,
+                                                      size, iv, iv_size, oc )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of encryption" );
+
+  if(( error = ak_bckey_context_ctr_mac_chunks( bkey, mctx, in, out,
+                                              size, ak_true, oc, tag, tag_size )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect calculation of authentication code" );
+
+ /* перемаскируем ключ */
+  if( bkey->key.set_mask( &bkey->key ) != ak_error_ok )
+    return ak_error_message( ak_error_get_value(), __func__ , "wrong remasking of secret key" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет имитовставку от зашифрованных данных и расшифровывает их в режиме
+    гаммирования за один проход по данным; функция является обратной к функции
+    ak_bckey_context_encrypt_ctr_mac(). Каждый фрагмент передается сжимающему отображению
+    до расшифрования, поэтому данные могут расшифровываться на месте.
+
+    Если вычисленная имитовставка не совпадает с заданной, то расшифрованные данные
+    обнуляются и функция возвращает \ref ak_error_not_equal_data.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param mctx Контекст сжимающего отображения, ключ которого должен быть заранее установлен.
+    @param in Указатель на область памяти, где хранятся зашифрованные данные.
+    @param out Указатель на область памяти, куда помещаются расшифрованные данные
+    (этот указатель может совпадать с `in`).
+    @param size Размер расшифровываемых данных (в байтах).
+    @param iv Указатель на синхропосылку или NULL.
+    @param iv_size Длина синхропосылки в байтах.
+    @param tag Указатель на имитовставку, с которой сравнивается вычисленное значение.
+    @param tag_size Размер имитовставки (в байтах), не более \ref ak_mac_context_max_buffer_size.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). Если имитовставка
+    не совпадает с вычисленным значением, возвращается \ref ak_error_not_equal_data.
+    В остальных случаях возвращается код ошибки.                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_decrypt_ctr_mac( ak_bckey bkey, ak_mac mctx, ak_pointer in, ak_pointer out,
+                 size_t size, ak_pointer iv, size_t iv_size, ak_pointer tag, size_t tag_size )
+{
+  ak_uint8 icode[ak_mac_context_max_buffer_size];
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( tag == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                     "using null pointer to authentication code" );
+  if(( tag_size == 0 ) || ( tag_size > sizeof( icode )))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                 "incorrect length of authentication code" );
+  if(( error = ak_bckey_context_ctr_mac_prepare( bkey, mctx,
+                                                      size, iv, iv_size, oc )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of decryption" );
+
+  memset( icode, 0, sizeof( icode ));
+  if(( error = ak_bckey_context_ctr_mac_chunks( bkey, mctx, in, out,
+                                           size, ak_false, oc, icode, tag_size )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect calculation of authentication code" );
+
+ /* перемаскируем ключ */
+  if( bkey->key.set_mask( &bkey->key ) != ak_error_ok )
+    return ak_error_message( ak_error_get_value(), __func__ , "wrong remasking of secret key" );
+
+  if(( error != ak_error_ok ) || !ak_ptr_is_equal( icode, tag, tag_size )) {
+    if( size ) memset( out, 0, size );
+    return ak_error_set_value( error != ak_error_ok ? error : ak_error_not_equal_data );
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                     режим гаммирования с преобразованием ключа CTR-ACPKM                        */
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет производный ключ \f$ K^{i+1} = ACPKM(K^i) \f$ в соответствии с
+    Р 1323565.1.012-2018: новое значение ключа образуют старшие 256 бит результата зашифрования
+    константы \f$ D = 0x80||0x81|| \ldots ||0x9F\f$ в режиме простой замены на текущем ключе.
+
+    Вычисленное значение присваивается ключу без повторного выделения памяти: используется
+    уже существующий буффер ключа и вызывается функция развертки раундовых ключей
+    \ref bckey::schedule_keys, повторно использующая память, на которую указывает `skey->data`.
+    Ресурс ключа устанавливается заново.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_next_acpkm_key( ak_bckey bkey )
+{
+  size_t i = 0, j = 0, blocks = 0;
+  ak_uint8 d[32], nkey[32];
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to block cipher context" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+                     ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher" );
+  if( bkey->key.key_size != sizeof( nkey )) return ak_error_message( ak_error_wrong_key_length,
+                                                   __func__ , "unsupported length of secret key" );
+ /* проверяем целостность ключа */
+  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+    return ak_error_message( ak_error_wrong_key_icode,
+                                        __func__, "incorrect integrity code of secret key value" );
+ /* гамма, выработанная на текущем значении ключа, больше не используется */
+  ak_bckey_context_ctr_reservoir_clean( bkey );
+
+ /* формируем константу D: в каждом блоке старший октет располагается
+    в начале блока для совместимого с openssl формата и в конце блока в противном случае */
+  blocks = sizeof( d )/bkey->bsize;
+  for( i = 0; i < blocks; i++ )
+     for( j = 0; j < bkey->bsize; j++ )
+        d[i*bkey->bsize + ( oc ? j : bkey->bsize-1-j )] = ( ak_uint8 )( 0x80 + i*bkey->bsize + j );
+  bkey->encrypt_blocks( &bkey->key, d, d, blocks );
+
+ /* ключ, как и блоки данных, хранится в обратном порядке октетов,
+    поэтому для формата без совместимости с openssl порядок блоков изменяется на обратный */
+  for( i = 0; i < blocks; i++ )
+     memcpy( nkey + i*bkey->bsize, d + ( oc ? i : blocks-1-i )*bkey->bsize, bkey->bsize );
+
+ /* присваиваем значение в существующий буффер ключа и вырабатываем раундовые ключи */
+  if(( error = ak_skey_context_set_key( &bkey->key, nkey, sizeof( nkey ))) != ak_error_ok )
+    ak_error_message( error, __func__ , "incorrect assigning of derived key value" );
+   else
+    if(( bkey->schedule_keys != NULL ) &&
+       (( error = bkey->schedule_keys( &bkey->key )) != ak_error_ok ))
+      ak_error_message( error, __func__, "incorrect execution of key scheduling procedure" );
+
+  ak_ptr_context_wipe( d, sizeof( d ), &bkey->key.generator );
+  ak_ptr_context_wipe( nkey, sizeof( nkey ), &bkey->key.generator );
+  if( error != ak_error_ok ) return error;
+
+ /* устанавливаем ресурс производного ключа */
+  if(( error = ak_skey_context_set_resource( &bkey->key, block_counter_resource,
+       bkey->bsize == 8 ? "magma_cipher_resource" : "kuznechik_cipher_resource", 0, 0 )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect assigning of block cipher resource" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция реализует режим гаммирования CTR-ACPKM из Р 1323565.1.017-2018.
+    Данные разбиваются на секции длины `section_size` октетов; первая секция зашифровывается
+    на исходном ключе, каждая последующая - на ключе, вычисленном из предыдущего функцией
+    ak_bckey_context_next_acpkm_key(). Значение счетчика при смене ключа не изменяется.
+
+    Преобразование ключа выполняется непосредственно в контексте `bkey`, поэтому после вызова
+    функции контекст содержит ключ текущей секции. Аналогично функции ak_bckey_context_ctr()
+    данные могут обрабатываться фрагментами: при повторных вызовах, в которых синхропосылка
+    не задается, шифрование продолжается с текущего положения внутри секции (при этом длина
+    секции не должна изменяться). Для шифрования нового сообщения исходный ключ
+    должен быть присвоен заново.
+
+    Ресурс ключа расходуется в пределах одной секции, поэтому общий объем зашифровываемых данных
+    не ограничивается ресурсом исходного ключа.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на входные данные.
+    @param out Указатель на выходные данные (может совпадать с `in`).
+    @param size Размер данных в октетах.
+    @param section_size Длина секции в октетах; должна быть кратна длине блока.
+    Если значение равно нулю, то используется длина, определяемая опциями
+    `acpkm_section_magma_block_count` и `acpkm_section_kuznechik_block_count`.
+    @param iv Указатель на синхропосылку или NULL для продолжения шифрования.
+    @param iv_size Длина синхропосылки (половина длины блока).
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_ctr_acpkm( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
+                                             size_t section_size, ak_pointer iv, size_t iv_size )
+{
+  ak_int64 blocks = 0, tail = 0, section = 0, pos = 0, count = 0;
+  ak_uint64 x = 0, *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to block cipher context" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+                     ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher" );
+  if( section_size == 0 )
+    section_size = bkey->bsize*( size_t ) ak_libakrypt_get_option( bkey->bsize == 8 ?
+                          "acpkm_section_magma_block_count" : "acpkm_section_kuznechik_block_count" );
+  if(( section_size == 0 ) || ( section_size%bkey->bsize ))
+    return ak_error_message( ak_error_wrong_length, __func__ ,
+                                          "section length is not divided by block length" );
+
+ /* проверяем ключ и устанавливаем синхропосылку (ресурс ключа проверяется для каждой секции) */
+  if(( error = ak_bckey_context_ctr_prepare( bkey, 0, iv, iv_size, oc )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of counter mode" );
+
+  blocks = (ak_int64)( size/bkey->bsize );
+  tail = (ak_int64)( size%bkey->bsize );
+  section = (ak_int64)( section_size/bkey->bsize );
+
+ /* младшая половина счетчика равна количеству уже обработанных блоков,
+    что позволяет определить текущее положение внутри секции */
+  x = ak_bckey_context_ctr_get_counter( bkey, oc );
+  pos = (ak_int64)(( bkey->bsize == 8 ? ( x&0xFFFFFFFFLL ) : x )%( ak_uint64 )section );
+
+  while( blocks > 0 ) {
+    count = ak_min( blocks, section - pos );
+    if( bkey->key.resource.value.counter < count )
+      return ak_error_message( ak_error_low_key_resource,
+                                                   __func__ , "low resource of block cipher key" );
+    bkey->key.resource.value.counter -= count;
+
+    if( bkey->bsize == 8 ) ak_bckey_context_ctr_blocks64( bkey, inptr, outptr, count, x, oc );
+     else ak_bckey_context_ctr_blocks128( bkey, inptr, outptr, count, x, oc );
+    x += ( ak_uint64 )count;
+    inptr += count*( ak_int64 )( bkey->bsize >> 3 );
+    outptr += count*( ak_int64 )( bkey->bsize >> 3 );
+    blocks -= count;
+
+   /* секция обработана полностью: вычисляем ключ следующей секции */
+    if(( pos += count ) == section ) {
+      ak_bckey_context_ctr_set_counter( bkey, x, oc );
+      if(( error = ak_bckey_context_next_acpkm_key( bkey )) != ak_error_ok )
+        return ak_error_message( error, __func__, "incorrect generation of next section key" );
+      pos = 0;
+    }
+  }
+  ak_bckey_context_ctr_set_counter( bkey, x, oc );
+
+ /* обрабатываем хвост сообщения */
+  if( tail ) {
+    if( bkey->key.resource.value.counter < 1 )
+      return ak_error_message( ak_error_low_key_resource,
+                                                   __func__ , "low resource of block cipher key" );
+    bkey->key.resource.value.counter--;
+    ak_bckey_context_ctr_tail( bkey, (ak_uint8 *)inptr, (ak_uint8 *)outptr, tail, oc );
+  }
+
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                 обработка данных, расположенных в нескольких фрагментах                         */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция обработки непрерывного участка данных в режиме гаммирования. */
+ typedef int ( ak_function_bckey_fragment )( ak_bckey , ak_uint8 * , ak_uint8 * ,
+                                                                          size_t , ak_pointer );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательно обрабатывает фрагменты данных так, как если бы они
+    были расположены в одной непрерывной области памяти.
+
+    Блоки, целиком лежащие внутри фрагмента, обрабатываются на месте, без копирования.
+    Блок, пересекающий границу фрагментов, собирается во внутреннем буффере длины одного блока,
+    обрабатывается и возвращается в выходные фрагменты. Функция `function` вызывается
+    только для участков, длина которых кратна длине блока, за исключением последнего вызова.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Массив входных фрагментов.
+    @param out Массив выходных фрагментов.
+    @param count Количество фрагментов.
+    @param function Функция обработки непрерывного участка данных.
+    @param ctx Указатель, передаваемый функции `function`.
+    @return В случае успеха возвращается \ref ak_error_ok (ноль), в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_walk_fragments( ak_bckey bkey, ak_fragment in, ak_fragment out,
+                      const size_t count, ak_function_bckey_fragment *function, ak_pointer ctx )
+{
+  size_t i = 0, j = 0, n = 0, len = 0, used = 0;
+  ak_uint8 block[16], *dst[16], *inptr = NULL, *outptr = NULL;
+  int error = ak_error_ok;
+
+  if(( bkey->bsize == 0 ) || ( bkey->bsize > sizeof( block ))) return ak_error_message(
+               ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher key" );
+  for( i = 0; i < count; i++ ) {
+     inptr = ( ak_uint8 *)in[i].data;
+     outptr = ( ak_uint8 *)out[i].data;
+     n = in[i].size;
+
+    /* дополняем блок, начатый в предыдущих фрагментах */
+     if(( used > 0 ) && ( used < bkey->bsize )) {
+       len = ak_min( n, bkey->bsize - used );
+       for( j = 0; j < len; j++ ) { block[used+j] = inptr[j]; dst[used+j] = outptr + j; }
+       used += len; inptr += len; outptr += len; n -= len;
+       if( used < bkey->bsize ) continue;
+
+       if(( error = function( bkey, block, block, used, ctx )) != ak_error_ok ) return error;
+       for( j = 0; j < used; j++ ) *dst[j] = block[j];
+       used = 0;
+     }
+    /* обрабатываем блоки, целиком лежащие во фрагменте */
+     if(( len = n - n%bkey->bsize ) > 0 ) {
+       if(( error = function( bkey, inptr, outptr, len, ctx )) != ak_error_ok ) return error;
+       inptr += len; outptr += len; n -= len;
+     }
+    /* сохраняем начало блока, продолжающегося в следующих фрагментах
+       (здесь used = 0 и n < bsize) */
+     len = ak_min( n, bkey->bsize - used );
+     for( j = 0; j < len; j++ ) { block[used+j] = inptr[j]; dst[used+j] = outptr + j; }
+     used += len;
+  }
+
+ /* обрабатываем последний неполный блок */
+  if( used ) {
+    if(( error = function( bkey, block, block, used, ctx )) != ak_error_ok ) return error;
+    for( j = 0; j < used; j++ ) *dst[j] = block[j];
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция проверяет массивы входных и выходных фрагментов и вычисляет
+    общую длину обрабатываемых данных.                                                             */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_check_fragments( ak_fragment in, ak_fragment out,
+                                                            const size_t count, size_t *size )
+{
+  size_t i = 0;
+
+  if(( in == NULL ) && ( count > 0 )) return ak_error_message( ak_error_null_pointer,
+                                              __func__, "using a null pointer to fragments array" );
+  for( i = 0, *size = 0; i < count; i++ ) {
+     if(( in[i].data == NULL ) && ( in[i].size > 0 ))
+       return ak_error_message( ak_error_null_pointer, __func__,
+                                                           "using a null pointer to fragment data" );
+     if( out[i].size < in[i].size )
+       return ak_error_message( ak_error_wrong_length, __func__,
+                                                       "output fragment is shorter than input one" );
+     *size += in[i].size;
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования непрерывного участка данных без проверки ключа и
+    изменения его ресурса (используется функцией ak_bckey_context_ctr_fragments()).                */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_ctr_fragment( ak_bckey bkey, ak_uint8 *in, ak_uint8 *out,
+                                                                   size_t size, ak_pointer ctx )
+{
+  const int oc = *( int *)ctx;
+  ak_int64 blocks = (ak_int64)( size/bkey->bsize ),
+             tail = (ak_int64)( size%bkey->bsize );
+  ak_uint64 x = ak_bckey_context_ctr_get_counter( bkey, oc );
+
+  if( bkey->bsize == 16 ) ak_bckey_context_ctr_blocks128( bkey,
+                                               ( ak_uint64 *)in, ( ak_uint64 *)out, blocks, x, oc );
+   else ak_bckey_context_ctr_blocks64( bkey, ( ak_uint64 *)in, ( ak_uint64 *)out, blocks, x, oc );
+  ak_bckey_context_ctr_set_counter( bkey, x + (ak_uint64)blocks, oc );
+  if( tail ) ak_bckey_context_ctr_tail( bkey, in + blocks*bkey->bsize,
+                                                             out + blocks*bkey->bsize, tail, oc );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция является вариантом функции ak_bckey_context_ctr() для данных, расположенных
+    в нескольких несмежных областях памяти (scatter/gather). Фрагменты обрабатываются
+    так, как если бы они были последовательно расположены в одной области памяти, поэтому
+    результат шифрования и изменение состояния контекста ключа совпадают с результатом вызова
+    функции ak_bckey_context_ctr() для объединенных данных. Копирование данных в промежуточный
+    буффер не выполняется: во внутреннем буффере собираются только блоки, пересекающие
+    границы фрагментов. Проверка ключа и его перемаскирование выполняются один раз.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Массив входных фрагментов.
+    @param out Массив выходных фрагментов; длина i-го выходного фрагмента должна быть не меньше
+    длины i-го входного фрагмента. Если указатель равен NULL, то данные обрабатываются на месте.
+    @param count Количество фрагментов.
+    @param iv Указатель на синхропосылку или NULL.
+    @param iv_size Длина синхропосылки в байтах.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_ctr_fragments( ak_bckey bkey, ak_fragment in, ak_fragment out,
+                                         const size_t count, ak_pointer iv, size_t iv_size )
+{
+  size_t size = 0;
+  int error = ak_error_ok, mask_error = ak_error_ok,
+      oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to block cipher context" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+                    ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher" );
+  if( out == NULL ) out = in;
+  if(( error = ak_bckey_context_check_fragments( in, out, count, &size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect fragments of input data" );
+
+ /* проверяем ключ, уменьшаем его ресурс и устанавливаем синхропосылку */
+  if(( error = ak_bckey_context_ctr_prepare( bkey, (ak_int64)(( size + bkey->bsize - 1 )/
+                                            bkey->bsize ), iv, iv_size, oc )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of counter mode" );
+
+  if(( error = ak_bckey_context_walk_fragments( bkey, in, out, count,
+                                             ak_bckey_context_ctr_fragment, &oc )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect encryption of fragments" );
+
+ /* перемаскируем ключ */
+  if(( mask_error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( mask_error, __func__ , "wrong remasking of secret key" );
+
+ return error != ak_error_ok ? error : mask_error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция шифрования непрерывного участка данных в режиме CTR-ACPKM
+    (используется функцией ak_bckey_context_ctr_acpkm_fragments()).                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_ctr_acpkm_fragment( ak_bckey bkey, ak_uint8 *in, ak_uint8 *out,
+                                                                   size_t size, ak_pointer ctx )
+{
+ return ak_bckey_context_ctr_acpkm( bkey, in, out, size, *( size_t *)ctx, NULL, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция является вариантом функции ak_bckey_context_ctr_acpkm() для данных, расположенных
+    в нескольких несмежных областях памяти. Результат шифрования совпадает с результатом
+    вызова функции ak_bckey_context_ctr_acpkm() для объединенных данных.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Массив входных фрагментов.
+    @param out Массив выходных фрагментов или NULL для обработки данных на месте.
+    @param count Количество фрагментов.
+    @param section_size Длина секции в октетах (см. ak_bckey_context_ctr_acpkm()).
+    @param iv Указатель на синхропосылку или NULL для продолжения шифрования.
+    @param iv_size Длина синхропосылки (половина длины блока).
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_ctr_acpkm_fragments( ak_bckey bkey, ak_fragment in, ak_fragment out,
+                     const size_t count, size_t section_size, ak_pointer iv, size_t iv_size )
+{
+  size_t size = 0;
+  int error = ak_error_ok;
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to block cipher context" );
+  if( out == NULL ) out = in;
+  if(( error = ak_bckey_context_check_fragments( in, out, count, &size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect fragments of input data" );
+
+ /* устанавливаем синхропосылку и проверяем параметры режима */
+  if(( error = ak_bckey_context_ctr_acpkm( bkey, "", "", 0,
+                                                section_size, iv, iv_size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of ctr-acpkm mode" );
+
+  if(( error = ak_bckey_context_walk_fragments( bkey, in, out, count,
+                          ak_bckey_context_ctr_acpkm_fragment, &section_size )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect encryption of fragments" );
+
+ return error;
+}
+
+ int ak_bckey_context_encrypt_cbc( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
+                                    ak_pointer iv, size_t iv_size )
+ {
+   ak_int64 blocks = 0;
+   ak_uint64 yaout[2], z = iv_size / bkey->bsize;
+   ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out, *ivector = (ak_uint64 *)bkey->ivector;
+   int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+   if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                 "wrong value for \"openssl_compability\" option" );
+
+  /* выполняем проверку размера входных данных */
+   if( size%bkey->bsize != 0 )
+     return ak_error_message( ak_error_wrong_block_cipher_length,
+                             __func__ , "the length of input data is not divided by block length" );
+
+  /* проверяем целостность ключа */
+   if( bkey->key.check_icode( &bkey->key ) != ak_true )
+     return ak_error_message( ak_error_wrong_key_icode,
+                                         __func__, "incorrect integrity code of secret key value" );
+  /* уменьшаем значение ресурса ключа */
+   blocks = (ak_int64 ) (size/bkey->bsize);
+   if( bkey->key.resource.value.counter < blocks )
+     return ak_error_message( ak_error_low_key_resource,
+                                                    __func__ , "low resource of block cipher key" );
+    else bkey->key.resource.value.counter -= blocks;
+
+     /* проверяем длину синхропосылки (если меньше блока или больше внутреннего буффера, то плохо) */
+      if( iv_size < bkey->bsize || iv_size%bkey->bsize != 0 || iv_size > sizeof( bkey->ivector ))
+        return ak_error_message( ak_error_wrong_iv_length, __func__,
+                                                               "incorrect length of initial value" );
+
+     ak_bckey_context_ctr_reservoir_clean( bkey );
+     memcpy(bkey->ivector, iv, iv_size);
 
   /* теперь приступаем к зашифрованию данных */
    switch( bkey->bsize ) {
@@ -678,17 +1728,23 @@
   return ak_error_ok;
  }
 
- int ak_bckey_context_decrypt_cbc( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
-                                   ak_pointer iv, size_t iv_size )
- {
-  ak_int64 blocks = 0;
-  ak_uint64 yaout[2];
-  ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out, *ivector = (ak_uint64 *)bkey->ivector;
-  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
-
-  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
-                                                "wrong value for \"openssl_compability\" option" );
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция выполняет проверки, предваряющие шифрование в режиме простой замены
+    с зацеплением; ресурс и состояние ключа не изменяются.
 
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param size Размер обрабатываемых данных (в байтах).
+    @param iv_size Длина синхропосылки в байтах, должна быть кратна длине блока.
+    @return В случае успеха возвращается \ref ak_error_ok (ноль), в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_cbc_check( ak_bckey bkey, size_t size, size_t iv_size )
+{
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to block cipher key" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 ))
+    return ak_error_message( ak_error_wrong_block_cipher,
+                                          __func__ , "incorrect block size of block cipher key" );
 
  /* выполняем проверку размера входных данных */
   if( size%bkey->bsize != 0 )
@@ -699,6 +1755,33 @@
   if( bkey->key.check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode,
                                         __func__, "incorrect integrity code of secret key value" );
+
+ /* проверяем длину синхропосылки (если меньше блока или больше внутреннего буффера, то плохо) */
+  if( iv_size < bkey->bsize || iv_size%bkey->bsize != 0 || iv_size > sizeof( bkey->ivector ))
+    return ak_error_message( ak_error_wrong_iv_length, __func__,
+                                                              "incorrect length of initial value" );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция выполняет проверки, предваряющие шифрование в режиме простой замены
+    с зацеплением, уменьшает ресурс ключа и помещает синхропосылку в контекст ключа.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param size Размер обрабатываемых данных (в байтах).
+    @param iv Указатель на синхропосылку.
+    @param iv_size Длина синхропосылки в байтах, должна быть кратна длине блока.
+    @return В случае успеха возвращается \ref ak_error_ok (ноль), в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_context_cbc_prepare( ak_bckey bkey, size_t size,
+                                                                  ak_pointer iv, size_t iv_size )
+{
+  int error = ak_error_ok;
+  ak_int64 blocks = 0;
+
+  if(( error = ak_bckey_context_cbc_check( bkey, size, iv_size )) != ak_error_ok ) return error;
+
  /* уменьшаем значение ресурса ключа */
   blocks = (ak_int64 ) (size/bkey->bsize);
   if( bkey->key.resource.value.counter < blocks )
@@ -706,57 +1789,1151 @@
                                                    __func__ , "low resource of block cipher key" );
    else bkey->key.resource.value.counter -= blocks;
 
-    /* проверяем длину синхропосылки (если меньше  блока, то плохо) */
-     if( iv_size < bkey->bsize || iv_size%bkey->bsize != 0 )
+  ak_bckey_context_ctr_reservoir_clean( bkey );
+  memcpy( bkey->ivector, iv, iv_size );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифровывает последовательность блоков в режиме простой замены с зацеплением.
+
+    Блоки шифртекста расшифровываются группами при помощи многоблочной функции,
+    после чего результат складывается с содержимым регистра сдвига, состоящего из z блоков.
+    Очередной блок шифртекста помещается в регистр до записи выходных данных,
+    поэтому указатели in и out могут совпадать.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на расшифровываемые данные.
+    @param out Указатель на расшифрованные данные (может совпадать с `in`).
+    @param blocks Количество обрабатываемых блоков.
+    @param reg Регистр сдвига; первым используется блок с нулевым индексом.
+    @param z Количество блоков в регистре сдвига.                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_decrypt_cbc_blocks( ak_bckey bkey, ak_uint8 *in, ak_uint8 *out,
+                                                      size_t blocks, ak_uint8 *reg, const size_t z )
+{
+  size_t idx = 0, jdx = 0, words = bkey->bsize >> 3;
+  ak_uint64 yaout[2*ak_bckey_context_buffer_blocks];
+
+  while( blocks > 0 ) {
+     size_t count = ak_min( blocks, ak_bckey_context_buffer_blocks );
+
+     bkey->decrypt_blocks( &bkey->key, in, yaout, count );
+     for( idx = 0; idx < count; idx++ ) {
+        size_t k = 0;
+        ak_uint64 *r = (ak_uint64 *)( reg + jdx*bkey->bsize );
+        for( k = 0; k < words; k++ ) {
+           ak_uint64 c = ((ak_uint64 *)in)[k];
+           ((ak_uint64 *)out)[k] = yaout[idx*words+k] ^ r[k];
+           r[k] = c;
+        }
+        in += bkey->bsize; out += bkey->bsize;
+        if( ++jdx == z ) jdx = 0;
+     }
+     blocks -= count;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_decrypt_cbc( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
+                                   ak_pointer iv, size_t iv_size )
+ {
+  int error = ak_error_ok;
+
+ /* проверяем ключ, уменьшаем его ресурс и устанавливаем синхропосылку */
+  if(( error = ak_bckey_context_cbc_prepare( bkey, size, iv, iv_size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of cbc mode" );
+
+ /* теперь приступаем к расшифрованию данных */
+  ak_bckey_context_decrypt_cbc_blocks( bkey, in, out, size/bkey->bsize,
+                                                        bkey->ivector, iv_size/bkey->bsize );
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return ak_error_ok;
+ }
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифровывает в режиме простой замены с зацеплением группу сообщений,
+    использующих один и тот же ключ.
+
+    Сообщения обрабатываются синхронно: на очередном шаге от каждого незавершенного сообщения
+    берется один блок, блоки складываются со значениями регистров сдвига и зашифровываются
+    одним вызовом многоблочной функции. Регистр сдвига каждого сообщения образуют
+    последние z блоков уже записанного шифртекста (или синхропосылки), поэтому
+    указатели на входные и выходные данные сообщения могут совпадать.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param streams Массив описаний сообщений.
+    @param idx Индексы обрабатываемых сообщений в массиве (содержимое массива изменяется).
+    @param active Количество сообщений, не более \ref ak_bckey_context_buffer_blocks.             */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_encrypt_cbc_lockstep( ak_bckey bkey, ak_bckey_stream streams,
+                                                                  size_t *idx, size_t active )
+{
+  size_t j = 0, t = 0, k = 0, words = bkey->bsize >> 3;
+  ak_uint64 buffer[2*ak_bckey_context_buffer_blocks];
+
+  for( j = 0; ; j++ ) {
+    /* исключаем завершенные сообщения */
+     for( t = 0; t < active; ) {
+        if( j*bkey->bsize >= streams[idx[t]].size ) idx[t] = idx[--active];
+          else t++;
+     }
+     if( active == 0 ) break;
+
+    /* формируем блоки, складывая открытый текст со значениями регистров сдвига */
+     for( t = 0; t < active; t++ ) {
+        ak_bckey_stream s = streams + idx[t];
+        size_t z = s->iv_size/bkey->bsize;
+        ak_uint64 *inptr = ( ak_uint64 *)(( ak_uint8 *)s->in + j*bkey->bsize ),
+                  *reg = ( ak_uint64 *)( j < z ? ( ak_uint8 *)s->iv + j*bkey->bsize :
+                                                  ( ak_uint8 *)s->out + ( j-z )*bkey->bsize );
+        for( k = 0; k < words; k++ ) buffer[t*words+k] = inptr[k] ^ reg[k];
+     }
+     bkey->encrypt_blocks( &bkey->key, buffer, buffer, active );
+     for( t = 0; t < active; t++ )
+        memcpy(( ak_uint8 *)streams[idx[t]].out + j*bkey->bsize, buffer + t*words, bkey->bsize );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция зашифровывает несколько независимых сообщений в режиме простой замены с зацеплением;
+    результат совпадает с последовательными вызовами функции ak_bckey_context_encrypt_cbc()
+    для каждого из сообщений.
+
+    Зашифрование одного сообщения в режиме простой замены с зацеплением является
+    последовательным, поэтому многоблочные реализации алгоритмов шифрования не могут быть
+    использованы. Функция обрабатывает сообщения, использующие один и тот же ключ, синхронно
+    (группами не более \ref ak_bckey_context_buffer_blocks сообщений), передавая
+    в многоблочную функцию зашифрования по одному блоку от каждого сообщения.
+    Сообщения могут иметь различные длины, синхропосылки и ключи.
+
+    @param streams Массив описаний сообщений.
+    @param count Количество сообщений.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль). Проверка всех сообщений выполняется до начала
+    зашифрования.                                                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_encrypt_cbc_streams( ak_bckey_stream streams, size_t count )
+{
+  size_t i = 0, k = 0, n = 0, idx[ak_bckey_context_buffer_blocks];
+  int error = ak_error_ok;
+
+  if(( streams == NULL ) && ( count > 0 )) return ak_error_message( ak_error_null_pointer,
+                                                __func__, "using null pointer to streams array" );
+ /* проверяем ключи и синхропосылки всех сообщений, ресурс ключей пока не изменяется */
+  for( i = 0; i < count; i++ ) {
+     ak_int64 blocks = 0;
+     ak_bckey bkey = streams[i].bkey;
+
+     if(( error = ak_bckey_context_cbc_check( bkey,
+                                           streams[i].size, streams[i].iv_size )) != ak_error_ok )
+       return ak_error_message( error, __func__, "incorrect initialization of cbc mode" );
+
+    /* суммарный ресурс проверяется при первом появлении ключа */
+     for( k = 0; k < i; k++ ) if( streams[k].bkey == bkey ) break;
+     if( k < i ) continue;
+     for( k = i; k < count; k++ )
+        if( streams[k].bkey == bkey ) blocks += ( ak_int64 )( streams[k].size/bkey->bsize );
+     if( bkey->key.resource.value.counter < blocks )
+       return ak_error_message( ak_error_low_key_resource,
+                                                   __func__ , "low resource of block cipher key" );
+  }
+
+ /* теперь уменьшаем ресурс ключей и устанавливаем синхропосылки */
+  for( i = 0; i < count; i++ )
+     ak_bckey_context_cbc_prepare( streams[i].bkey,
+                                           streams[i].size, streams[i].iv, streams[i].iv_size );
+
+ /* обрабатываем сообщения, объединяя их в группы по используемому ключу */
+  for( i = 0; i < count; i++ ) {
+     ak_bckey bkey = streams[i].bkey;
+
+    /* группа обрабатывается при первом появлении ключа */
+     for( k = 0; k < i; k++ ) if( streams[k].bkey == bkey ) break;
+     if( k < i ) continue;
+
+     for( k = i, n = 0; k < count; k++ ) {
+        if( streams[k].bkey != bkey ) continue;
+        idx[n++] = k;
+        if( n == ak_bckey_context_buffer_blocks ) {
+          ak_bckey_context_encrypt_cbc_lockstep( bkey, streams, idx, n );
+          n = 0;
+        }
+     }
+     if( n ) ak_bckey_context_encrypt_cbc_lockstep( bkey, streams, idx, n );
+
+    /* перемаскируем ключ */
+     if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+       ak_error_message( error, __func__ , "wrong remasking of secret key" );
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования блоков, собранных из нескольких независимых сообщений.
+
+    Значения счетчиков, расположенные в массиве `counters`, зашифровываются одним вызовом
+    многоблочной функции, после чего полученная гамма складывается с блоками сообщений.
+    Неполный последний блок сообщения гаммируется так же, как в функции ak_bckey_context_ctr_tail().
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param counters Массив значений счетчиков.
+    @param in Массив указателей на входные блоки.
+    @param out Массив указателей на выходные блоки.
+    @param len Массив длин блоков.
+    @param count Количество блоков.
+    @param oc Флаг использования формата, совместимого с openssl.                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_ctr_streams_blocks( ak_bckey bkey, ak_uint64 *counters,
+                 ak_uint8 **in, ak_uint8 **out, size_t *len, const size_t count, const int oc )
+{
+  size_t t = 0, i = 0, words = bkey->bsize >> 3;
+
+  bkey->encrypt_blocks( &bkey->key, counters, counters, count );
+  for( t = 0; t < count; t++ ) {
+     ak_uint8 *gamma = ( ak_uint8 *)( counters + t*words );
+     if( len[t] == bkey->bsize ) {
+       for( i = 0; i < words; i++ )
+          (( ak_uint64 *)out[t])[i] = (( ak_uint64 *)in[t])[i] ^ counters[t*words+i];
+     } else {
+        if( !oc ) gamma += bkey->bsize - len[t];
+        for( i = 0; i < len[t]; i++ ) out[t][i] = in[t][i] ^ gamma[i];
+       }
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция зашифровывает (расшифровывает) несколько независимых сообщений в режиме гаммирования;
+    результат совпадает с последовательными вызовами функции ak_bckey_context_ctr()
+    для каждого из сообщений с заданной синхропосылкой.
+
+    Функция предназначена для обработки большого количества коротких сообщений (например,
+    сетевых пакетов), для которых затраты на проверку целостности ключа, изменение его ресурса
+    и перемаскирование сравнимы с затратами на шифрование. Эти действия выполняются один раз
+    для каждого используемого ключа, а не для каждого сообщения. Значения счетчиков для блоков
+    различных сообщений, использующих один ключ, собираются вместе и зашифровываются
+    одним вызовом многоблочной функции (по \ref ak_bckey_context_buffer_blocks блоков
+    для алгоритмов с длиной блока 128 бит).
+
+    Каждое сообщение должно иметь собственную синхропосылку; значение синхропосылки,
+    хранящееся в контексте ключа, не используется, а после вызова функции ее дальнейшее
+    использование запрещается.
+
+    @param streams Массив описаний сообщений.
+    @param count Количество сообщений.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль). Проверка всех сообщений и ключей выполняется
+    до начала шифрования.                                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_ctr_streams( ak_bckey_stream streams, size_t count )
+{
+  size_t i = 0, j = 0, k = 0, n = 0, words = 0, batch = 0, halfsize = 0;
+  ak_int64 blocks = 0;
+  ak_uint64 x = 0, counters[2*ak_bckey_context_buffer_blocks], base[2];
+  ak_uint8 *in[2*ak_bckey_context_buffer_blocks], *out[2*ak_bckey_context_buffer_blocks];
+  size_t len[2*ak_bckey_context_buffer_blocks];
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if(( streams == NULL ) && ( count > 0 )) return ak_error_message( ak_error_null_pointer,
+                                                __func__, "using null pointer to streams array" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+ /* проверяем сообщения и синхропосылки */
+  for( i = 0; i < count; i++ ) {
+     if( streams[i].bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to block cipher key" );
+     if(( streams[i].bkey->bsize != 8 ) && ( streams[i].bkey->bsize != 16 ))
+       return ak_error_message( ak_error_wrong_block_cipher, __func__ ,
+                                                        "incorrect block size of block cipher key" );
+     if( streams[i].iv == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to initial vector" );
+     if( streams[i].iv_size < ( streams[i].bkey->bsize >> 1 ))
        return ak_error_message( ak_error_wrong_iv_length, __func__,
                                                               "incorrect length of initial value" );
+  }
 
-    memcpy(bkey->ivector, iv, iv_size);
+ /* проверяем целостность ключей и их ресурс (один раз для каждого ключа) */
+  for( i = 0; i < count; i++ ) {
+     ak_bckey bkey = streams[i].bkey;
 
-     ak_uint64 z = iv_size / bkey->bsize;
- /* теперь приступаем к расшифрованию данных */
-  switch( bkey->bsize ) {
-    case  8: /* шифр с длиной блока 64 бита */
-      while( blocks > 0 ) {
-          bkey->decrypt( &bkey->key, inptr, yaout );
-          if (z == 0)
-              ivector = (ak_uint64 *)in;
-          *outptr = yaout[0] ^ *ivector; outptr++; ivector++;
-          inptr++;
-          --blocks;
-          --z;
-      }
-    break;
+     for( k = 0; k < i; k++ ) if( streams[k].bkey == bkey ) break;
+     if( k < i ) continue;
 
-    case 16: /* шифр с длиной блока 128 бит */
-      while( blocks > 0 ) {
-          bkey->decrypt( &bkey->key, inptr, yaout );
-          if (z == 0)
-              ivector = (ak_uint64 *)in;
-          *outptr = yaout[0] ^ *ivector; outptr++; ivector++;
-          *outptr = yaout[1] ^ *ivector; outptr++; ivector++;
-          inptr+=2;
-          --blocks;
-          --z;
-      }
+     if( bkey->key.check_icode( &bkey->key ) != ak_true )
+       return ak_error_message( ak_error_wrong_key_icode, __func__,
+                                                   "incorrect integrity code of secret key value" );
+     for( k = i, blocks = 0; k < count; k++ )
+        if( streams[k].bkey == bkey )
+          blocks += (ak_int64)(( streams[k].size + bkey->bsize - 1 )/bkey->bsize );
+     if( bkey->key.resource.value.counter < blocks )
+       return ak_error_message( ak_error_low_key_resource,
+                                                    __func__ , "low resource of block cipher key" );
+  }
 
+ /* обрабатываем сообщения, объединяя их в группы по используемому ключу */
+  for( i = 0; i < count; i++ ) {
+     ak_bckey bkey = streams[i].bkey;
+
+     for( k = 0; k < i; k++ ) if( streams[k].bkey == bkey ) break;
+     if( k < i ) continue;
+
+     words = bkey->bsize >> 3;
+     halfsize = bkey->bsize >> 1;
+     batch = 2*ak_bckey_context_buffer_blocks/words;
+     for( k = i, n = 0; k < count; k++ ) {
+        ak_bckey_stream s = streams + k;
+        if( s->bkey != bkey ) continue;
+
+       /* начальное значение счетчика формируется так же, как в ak_bckey_context_ctr_prepare() */
+        memset( base, 0, sizeof( base ));
+        memcpy(( ak_uint8 *)base + halfsize*((unsigned int)(1-oc)), s->iv, halfsize );
+        x = ak_bckey_context_ctr_encode( base[( words == 2 ) ? oc : 0], oc );
+        bkey->key.resource.value.counter -= (ak_int64)(( s->size + bkey->bsize - 1 )/bkey->bsize );
+
+        for( j = 0; j*bkey->bsize < s->size; j++ ) {
+           counters[n*words] = base[0];
+           if( words == 2 ) counters[n*words+1] = base[1];
+           counters[n*words + (( words == 2 ) ? oc : 0 )] =
+                                                     ak_bckey_context_ctr_encode( x + j, oc );
+           in[n] = ( ak_uint8 *)s->in + j*bkey->bsize;
+           out[n] = ( ak_uint8 *)s->out + j*bkey->bsize;
+           len[n] = ak_min( bkey->bsize, s->size - j*bkey->bsize );
+           if( ++n == batch ) {
+             ak_bckey_context_ctr_streams_blocks( bkey, counters, in, out, len, n, oc );
+             n = 0;
+           }
+        }
+     }
+     if( n ) ak_bckey_context_ctr_streams_blocks( bkey, counters, in, out, len, n, oc );
+
+    /* синхропосылка каждого сообщения задается явно, поэтому внутреннее значение
+       синхропосылки не может быть использовано для продолжения шифрования */
+     ak_bckey_context_ctr_reservoir_clean( bkey );
+     memset( bkey->ivector, 0, sizeof( bkey->ivector ));
+     bkey->key.flags |= ak_key_flag_not_ctr;
+
+    /* перемаскируем ключ */
+     if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+       ak_error_message( error, __func__ , "wrong remasking of secret key" );
+  }
 
-    break;
-    default: return ak_error_message( ak_error_wrong_block_cipher,
-                                          __func__ , "incorrect block size of block cipher key" );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*           многопоточная реализация режимов простой замены, гаммирования и зацепления            */
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+/*! \brief Структура, описывающая фрагмент данных, обрабатываемый одним потоком. */
+ typedef struct bckey_range {
+  /*! \brief Контекст ключа алгоритма блочного шифрования. */
+   ak_bckey bkey;
+  /*! \brief Указатель на входные данные фрагмента. */
+   ak_uint8 *in;
+  /*! \brief Указатель на выходные данные фрагмента. */
+   ak_uint8 *out;
+  /*! \brief Количество блоков (или секторов) во фрагменте. */
+   size_t blocks;
+  /*! \brief Количество блоков в одном секторе. */
+   size_t per;
+  /*! \brief Значение счетчика или номер сектора для первого блока фрагмента
+      (режим гаммирования). */
+   ak_uint64 counter;
+  /*! \brief Флаг использования формата, совместимого с openssl. */
+   int oc;
+  /*! \brief Регистр сдвига, используемый при обработке фрагмента (режим простой замены
+      с зацеплением). */
+   ak_uint8 ivector[64];
+  /*! \brief Количество блоков в регистре сдвига. */
+   size_t ivblocks;
+  /*! \brief Поток, обрабатывающий фрагмент. */
+   pthread_t thread;
+} *ak_bckey_range;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования фрагмента в режиме простой замены. */
+ static void *ak_bckey_range_encrypt_ecb( void *ptr )
+{
+  ak_bckey_range range = ( ak_bckey_range ) ptr;
+  range->bkey->encrypt_blocks( &range->bkey->key, range->in, range->out, range->blocks );
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования фрагмента в режиме простой замены. */
+ static void *ak_bckey_range_decrypt_ecb( void *ptr )
+{
+  ak_bckey_range range = ( ak_bckey_range ) ptr;
+  range->bkey->decrypt_blocks( &range->bkey->key, range->in, range->out, range->blocks );
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования фрагмента, состоящего из полных блоков. */
+ static void *ak_bckey_range_ctr( void *ptr )
+{
+  ak_bckey_range range = ( ak_bckey_range ) ptr;
+  if( range->bkey->bsize == 16 )
+    ak_bckey_context_ctr_blocks128( range->bkey, ( ak_uint64 *)range->in,
+                      ( ak_uint64 *)range->out, (ak_int64) range->blocks, range->counter, range->oc );
+   else ak_bckey_context_ctr_blocks64( range->bkey, ( ak_uint64 *)range->in,
+                      ( ak_uint64 *)range->out, (ak_int64) range->blocks, range->counter, range->oc );
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирования фрагмента, состоящего из последовательных секторов. */
+ static void *ak_bckey_range_ctr_sectors( void *ptr )
+{
+  ak_bckey_range range = ( ak_bckey_range ) ptr;
+  ak_bckey_context_ctr_sectors_blocks( range->bkey, ( ak_uint64 *)range->in,
+                                     ( ak_uint64 *)range->out, range->blocks*range->per,
+                                                  range->counter, 0, range->per, range->oc );
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования фрагмента в режиме простой замены с зацеплением. */
+ static void *ak_bckey_range_decrypt_cbc( void *ptr )
+{
+  ak_bckey_range range = ( ak_bckey_range ) ptr;
+  ak_bckey_context_decrypt_cbc_blocks( range->bkey, range->in, range->out,
+                                                   range->blocks, range->ivector, range->ivblocks );
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция разбивает данные на фрагменты из целого числа блоков (или секторов).
+
+    @param ranges Массив, в который помещаются описания фрагментов.
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на входные данные.
+    @param out Указатель на выходные данные.
+    @param blocks Общее количество блоков (или секторов).
+    @param per Количество блоков в одном секторе; при разбиении данных на блоки равно единице.
+    @param counter Значение счетчика для первого блока или номер первого сектора
+    (используется в режиме гаммирования).
+    @param oc Флаг использования формата, совместимого с openssl.
+    @param threads Количество фрагментов, не более \ref ak_bckey_context_max_threads.              */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_split_ranges( ak_bckey_range ranges, ak_bckey bkey,
+                  ak_uint8 *in, ak_uint8 *out, size_t blocks, const size_t per, ak_uint64 counter,
+                                                             const int oc, const size_t threads )
+{
+  size_t i = 0, offset = 0;
+
+  for( i = 0; i < threads; i++ ) {
+     ranges[i].bkey = bkey;
+     ranges[i].blocks = blocks/threads + ( i < blocks%threads );
+     ranges[i].per = per;
+     ranges[i].in = in + offset*per*bkey->bsize;
+     ranges[i].out = out + offset*per*bkey->bsize;
+     ranges[i].counter = counter + (ak_uint64) offset;
+     ranges[i].oc = oc;
+     ranges[i].ivblocks = 0;
+     offset += ranges[i].blocks;
   }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция обрабатывает фрагменты одновременно в нескольких потоках.
+
+    Первый фрагмент обрабатывается вызывающим потоком. Если создать очередной поток не удалось,
+    соответствующий фрагмент обрабатывается вызывающим потоком после завершения первого.
+
+    @param ranges Массив описаний фрагментов.
+    @param function Функция обработки фрагмента.
+    @param threads Количество фрагментов, не более \ref ak_bckey_context_max_threads.              */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_start_ranges( ak_bckey_range ranges,
+                                         void *( *function )( void * ), const size_t threads )
+{
+  size_t i = 0;
+  bool_t started[ak_bckey_context_max_threads];
+
+  for( i = 1; i < threads; i++ )
+     started[i] = ( pthread_create( &ranges[i].thread, NULL, function, ranges+i ) == 0 );
+  function( ranges );
+  for( i = 1; i < threads; i++ ) {
+     if( started[i] ) pthread_join( ranges[i].thread, NULL );
+       else function( ranges+i );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция разбивает данные на фрагменты из целого числа блоков и обрабатывает
+    их одновременно в нескольких потоках.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param function Функция обработки фрагмента.
+    @param in Указатель на входные данные.
+    @param out Указатель на выходные данные.
+    @param blocks Общее количество блоков.
+    @param counter Значение счетчика для первого блока (используется в режиме гаммирования).
+    @param oc Флаг использования формата, совместимого с openssl.
+    @param threads Количество потоков, не более \ref ak_bckey_context_max_threads.                */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_context_run_ranges( ak_bckey bkey, void *( *function )( void * ),
+                    ak_uint8 *in, ak_uint8 *out, size_t blocks, ak_uint64 counter, const int oc,
+                                                                             const size_t threads )
+{
+  struct bckey_range ranges[ak_bckey_context_max_threads];
+
+  ak_bckey_context_split_ranges( ranges, bkey, in, out, blocks, 1, counter, oc, threads );
+  ak_bckey_context_start_ranges( ranges, function, threads );
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Количество потоков определяется опцией библиотеки `bckey_thread_count`; нулевое значение
+    опции означает использование всех доступных процессоров. Количество потоков уменьшается так,
+    чтобы каждый поток обрабатывал не менее \ref ak_bckey_context_thread_min_blocks блоков.
+
+    @param blocks Количество обрабатываемых блоков.
+    @return Количество потоков. Если библиотека собрана без поддержки потоков,
+    функция возвращает единицу.                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ size_t ak_bckey_context_get_threads_count( const size_t blocks )
+{
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  ak_int64 count = ak_libakrypt_get_option( "bckey_thread_count" );
+
+  if( count <= 0 ) {
+   #if defined( LIBAKRYPT_HAVE_UNISTD_H ) && defined( _SC_NPROCESSORS_ONLN )
+    count = (ak_int64) sysconf( _SC_NPROCESSORS_ONLN );
+   #else
+    count = 1;
+   #endif
+  }
+  if( count > ak_bckey_context_max_threads ) count = ak_bckey_context_max_threads;
+  if( count > (ak_int64)( blocks/ak_bckey_context_thread_min_blocks ))
+    count = (ak_int64)( blocks/ak_bckey_context_thread_min_blocks );
+ return count < 1 ? 1 : (size_t) count;
+#else
+  (void) blocks;
+ return 1;
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция является многопоточным вариантом функции ak_bckey_context_encrypt_ecb(): данные
+    разбиваются на фрагменты из целого числа блоков, которые зашифровываются одновременно
+    в нескольких потоках. Результат зашифрования, а также изменение ресурса ключа совпадают
+    с результатом последовательной реализации. Для алгоритмов с длиной блока 64 бита
+    вызывается последовательная реализация.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на область памяти, где хранятся входные (зашифровываемые) данные
+    @param out Указатель на область памяти, куда помещаются зашифрованные данные
+    (этот указатель может совпадать с in)
+    @param size Размер зашировываемых данных (в байтах), должен быть кратен длине блока.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается ak_error_ok (ноль)                                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_encrypt_ecb_parallel( ak_bckey bkey, ak_pointer in,
+                                                                     ak_pointer out, size_t size )
+{
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  int error = ak_error_ok;
+  size_t threads = ak_bckey_context_get_threads_count( size/bkey->bsize );
+
+ /* алгоритм Магма использует общий для ключа запас траекторий маскирования и генератор
+    случайных масок, поэтому для алгоритмов с длиной блока 64 бита потоки не используются */
+  if(( bkey->bsize != 16 ) || ( threads < 2 ))
+    return ak_bckey_context_encrypt_ecb( bkey, in, out, size );
+
+ /* проверяем ключ и уменьшаем его ресурс */
+  if(( error = ak_bckey_context_ecb_prepare( bkey, size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of ecb mode" );
+
+  ak_bckey_context_run_ranges( bkey, ak_bckey_range_encrypt_ecb,
+                                                      in, out, size/bkey->bsize, 0, 0, threads );
  /* перемаскируем ключ */
   if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of secret key" );
 
  return ak_error_ok;
- }
+#else
+ return ak_bckey_context_encrypt_ecb( bkey, in, out, size );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция является многопоточным вариантом функции ak_bckey_context_decrypt_ecb().
+    Для алгоритмов с длиной блока 64 бита вызывается последовательная реализация.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на область памяти, где хранятся входные (расшифровываемые) данные.
+    @param out Указатель на область памяти, куда помещаются расшифрованные данные
+    (этот указатель может совпадать с in).
+    @param size Размер расшировываемых данных (в байтах), должен быть кратен длине блока.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается ak_error_ok (ноль)                                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_decrypt_ecb_parallel( ak_bckey bkey, ak_pointer in,
+                                                                     ak_pointer out, size_t size )
+{
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  int error = ak_error_ok;
+  size_t threads = ak_bckey_context_get_threads_count( size/bkey->bsize );
+
+ /* алгоритм Магма использует общий для ключа запас траекторий маскирования и генератор
+    случайных масок, поэтому для алгоритмов с длиной блока 64 бита потоки не используются */
+  if(( bkey->bsize != 16 ) || ( threads < 2 ))
+    return ak_bckey_context_decrypt_ecb( bkey, in, out, size );
+
+ /* проверяем ключ и уменьшаем его ресурс */
+  if(( error = ak_bckey_context_ecb_prepare( bkey, size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of ecb mode" );
+
+  ak_bckey_context_run_ranges( bkey, ak_bckey_range_decrypt_ecb,
+                                                      in, out, size/bkey->bsize, 0, 0, threads );
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return ak_error_ok;
+#else
+ return ak_bckey_context_decrypt_ecb( bkey, in, out, size );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция является многопоточным вариантом функции ak_bckey_context_ctr(). Данные разбиваются
+    на фрагменты из целого числа блоков; для каждого фрагмента вычисляется начальное значение
+    счетчика, после чего фрагменты обрабатываются одновременно в нескольких потоках.
+    Неполный последний блок обрабатывается вызывающим потоком.
+
+    Результат шифрования, значение синхропосылки, сохраняемое в контексте ключа,
+    и изменение ресурса ключа совпадают с результатом последовательной реализации, поэтому
+    вызовы функций ak_bckey_context_ctr() и ak_bckey_context_ctr_parallel() могут чередоваться.
+    Для алгоритмов с длиной блока 64 бита вызывается последовательная реализация.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на область памяти, где хранятся входные (открытые) данные.
+    @param out Указатель на область памяти, куда помещаются зашифрованные данные
+    (этот указатель может совпадать с `in`).
+    @param size Размер зашировываемых данных (в байтах).
+    @param iv Указатель на синхропосылку или NULL.
+    @param iv_size Длина синхропосылки в байтах.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_ctr_parallel( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
+                                                                     ak_pointer iv, size_t iv_size )
+{
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  ak_uint64 x = 0;
+  ak_int64 blocks = (ak_int64)( size/bkey->bsize ),
+             tail = (ak_int64)( size%bkey->bsize );
+  size_t threads = ak_bckey_context_get_threads_count( (size_t) blocks );
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if(( bkey->bsize != 16 ) || ( threads < 2 ))
+    return ak_bckey_context_ctr( bkey, in, out, size, iv, iv_size );
+
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+ /* проверяем ключ, уменьшаем его ресурс и устанавливаем синхропосылку */
+  if(( error = ak_bckey_context_ctr_prepare( bkey,
+                                         blocks + ( tail > 0 ), iv, iv_size, oc )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of counter mode" );
+
+ /* обрабатываем полные блоки и сохраняем значение счетчика */
+  x = ak_bckey_context_ctr_get_counter( bkey, oc );
+  ak_bckey_context_run_ranges( bkey, ak_bckey_range_ctr, in, out, (size_t) blocks, x, oc, threads );
+  ak_bckey_context_ctr_set_counter( bkey, x + (ak_uint64)blocks, oc );
+
+ /* обрабатываем хвост сообщения */
+  if( tail ) ak_bckey_context_ctr_tail( bkey, (ak_uint8 *)in + blocks*16,
+                                                          (ak_uint8 *)out + blocks*16, tail, oc );
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return error;
+#else
+ return ak_bckey_context_ctr( bkey, in, out, size, iv, iv_size );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция является многопоточным вариантом функции ak_bckey_context_decrypt_cbc().
+    В отличие от зашифрования, расшифрование каждого блока в режиме простой замены
+    с зацеплением не зависит от результатов расшифрования других блоков, поэтому данные
+    разбиваются на фрагменты из целого числа блоков, которые обрабатываются одновременно.
+
+    Перед запуском потоков для каждого фрагмента копируются предшествующие ему блоки шифртекста
+    (или синхропосылки), образующие начальное значение регистра сдвига. Поэтому каждый
+    поток читает только данные своего фрагмента, и указатели `in` и `out` могут совпадать.
+    Результат расшифрования и изменение ресурса ключа совпадают с результатом
+    последовательной реализации. Для алгоритмов с длиной блока 64 бита вызывается
+    последовательная реализация.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на область памяти, где хранятся расшифровываемые данные.
+    @param out Указатель на область памяти, куда помещаются расшифрованные данные
+    (этот указатель может совпадать с `in`).
+    @param size Размер расшифровываемых данных (в байтах), должен быть кратен длине блока.
+    @param iv Указатель на синхропосылку.
+    @param iv_size Длина синхропосылки в байтах, должна быть кратна длине блока.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_decrypt_cbc_parallel( ak_bckey bkey, ak_pointer in, ak_pointer out,
+                                                     size_t size, ak_pointer iv, size_t iv_size )
+{
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  size_t i = 0, t = 0, z = 0, threads = 0;
+  int error = ak_error_ok;
+  struct bckey_range ranges[ak_bckey_context_max_threads];
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to block cipher key" );
+  threads = ak_bckey_context_get_threads_count( size/bkey->bsize );
+
+ /* для алгоритма Магма потоки не используются (см. ak_bckey_context_encrypt_ecb_parallel()) */
+  if(( bkey->bsize != 16 ) || ( threads < 2 ))
+    return ak_bckey_context_decrypt_cbc( bkey, in, out, size, iv, iv_size );
+
+ /* проверяем ключ, уменьшаем его ресурс и устанавливаем синхропосылку */
+  if(( error = ak_bckey_context_cbc_prepare( bkey, size, iv, iv_size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of cbc mode" );
+
+ /* формируем начальные значения регистров сдвига до начала записи выходных данных:
+    регистр фрагмента, начинающегося с блока m, содержит блоки c_{m-z}, ..., c_{m-1},
+    где c_{-z}, ..., c_{-1} - блоки синхропосылки */
+  z = iv_size/bkey->bsize;
+  ak_bckey_context_split_ranges( ranges, bkey, in, out, size/bkey->bsize, 1, 0, 0, threads );
+  for( i = 0; i < threads; i++ ) {
+     ranges[i].ivblocks = z;
+     for( t = 0; t < z; t++ ) {
+        ak_int64 m = (ak_int64) ranges[i].counter - (ak_int64) z + (ak_int64) t;
+        memcpy( ranges[i].ivector + t*bkey->bsize,
+                 m < 0 ? bkey->ivector + ( m + (ak_int64) z )*bkey->bsize :
+                                         ( ak_uint8 *)in + m*bkey->bsize, bkey->bsize );
+     }
+  }
+  ak_bckey_context_start_ranges( ranges, ak_bckey_range_decrypt_cbc, threads );
+
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return ak_error_ok;
+#else
+ return ak_bckey_context_decrypt_cbc( bkey, in, out, size, iv, iv_size );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция зашифровывает (расшифровывает) фрагмент длины `size` байт, расположенный со смещением
+    `offset` байт от начала сообщения, зашифрованного в режиме гаммирования на синхропосылке `iv`.
+    Вырабатываются только те блоки гаммы, которые перекрываются с заданным фрагментом, поэтому
+    функция позволяет обращаться к произвольным участкам больших зашифрованных образов
+    без обработки предшествующих данных. Полные блоки обрабатываются многоблочной функцией
+    зашифрования, при большом объеме данных - одновременно в нескольких потоках.
+
+    Результат совпадает с соответствующим фрагментом результата функции ak_bckey_context_ctr(),
+    примененной ко всему сообщению, если фрагмент не затрагивает последний неполный блок
+    сообщения. Неполные блоки фрагмента гаммируются теми же байтами гаммы, что и полные
+    блоки, то есть сообщение рассматривается как часть бесконечной последовательности
+    полных блоков (в формате, совместимом с openssl, результат совпадает всегда).
+
+    Функция не использует значение синхропосылки, хранящееся в контексте ключа. После ее вызова
+    внутреннее значение счетчика соответствует блоку, следующему за обработанным фрагментом,
+    если фрагмент заканчивается на границе блока; в противном случае дальнейшее
+    использование внутреннего значения синхропосылки запрещается. Ресурс ключа уменьшается
+    на количество затронутых блоков. Несколько потоков используются только для алгоритмов
+    с длиной блока 128 бит.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на область памяти, где хранятся входные данные.
+    @param out Указатель на область памяти, куда помещаются выходные данные
+    (этот указатель может совпадать с `in`).
+    @param size Размер обрабатываемого фрагмента (в байтах).
+    @param offset Смещение фрагмента от начала сообщения (в байтах).
+    @param iv Указатель на синхропосылку (не может быть равен NULL).
+    @param iv_size Длина синхропосылки в байтах.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_ctr_offset( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
+                                       ak_uint64 offset, ak_pointer iv, size_t iv_size )
+{
+  ak_uint64 x = 0, yaout[2];
+  size_t i = 0, skip = 0, head = 0, tail = 0, blocks = 0, end = 0;
+  ak_uint8 *inptr = ( ak_uint8 *)in, *outptr = ( ak_uint8 *)out;
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  size_t threads = 1;
+#endif
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to block cipher key" );
+  if(( iv == NULL ) || ( iv_size == 0 )) return ak_error_message( ak_error_null_pointer,
+                                                  __func__, "using null pointer to initial vector" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+               ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher key" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+  if( size == 0 ) return ak_error_ok;
+
+ /* проверяем ключ, уменьшаем его ресурс на количество затронутых блоков
+    и устанавливаем синхропосылку */
+  skip = ( size_t )( offset%bkey->bsize );
+  end = ( skip + size )%bkey->bsize;
+  if(( error = ak_bckey_context_ctr_prepare( bkey, (ak_int64)(( skip + size
+                      + bkey->bsize - 1 )/bkey->bsize ), iv, iv_size, oc )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of counter mode" );
+  x = ak_bckey_context_ctr_get_counter( bkey, oc ) + offset/bkey->bsize;
+
+ /* обрабатываем начало фрагмента, не выровненное на границу блока */
+  if( skip ) {
+    head = ak_min( bkey->bsize - skip, size );
+    ak_bckey_context_ctr_set_counter( bkey, x++, oc );
+    bkey->encrypt( &bkey->key, bkey->ivector, yaout );
+    for( i = 0; i < head; i++ ) outptr[i] = inptr[i]^( (ak_uint8 *)yaout )[skip+i];
+    inptr += head; outptr += head; size -= head;
+  }
+
+ /* обрабатываем полные блоки */
+  blocks = size/bkey->bsize;
+  tail = size%bkey->bsize;
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+ /* для алгоритма Магма потоки не используются (см. ak_bckey_context_encrypt_ecb_parallel()) */
+  if(( bkey->bsize == 16 ) && (( threads = ak_bckey_context_get_threads_count( blocks )) > 1 ))
+    ak_bckey_context_run_ranges( bkey, ak_bckey_range_ctr, inptr, outptr, blocks, x, oc, threads );
+   else
+#endif
+  {
+    if( bkey->bsize == 16 ) ak_bckey_context_ctr_blocks128( bkey, ( ak_uint64 *)inptr,
+                                                  ( ak_uint64 *)outptr, (ak_int64) blocks, x, oc );
+     else ak_bckey_context_ctr_blocks64( bkey, ( ak_uint64 *)inptr,
+                                                  ( ak_uint64 *)outptr, (ak_int64) blocks, x, oc );
+  }
+  x += blocks;
+  inptr += blocks*bkey->bsize; outptr += blocks*bkey->bsize;
+  ak_bckey_context_ctr_set_counter( bkey, x, oc );
+
+ /* обрабатываем окончание фрагмента, не выровненное на границу блока */
+  if( tail ) {
+    bkey->encrypt( &bkey->key, bkey->ivector, yaout );
+    for( i = 0; i < tail; i++ ) outptr[i] = inptr[i]^( (ak_uint8 *)yaout )[i];
+  }
+ /* фрагмент, в том числе умещающийся в первом блоке, заканчивается внутри блока */
+  if( end ) {
+    memset( bkey->ivector, 0, sizeof( bkey->ivector ));
+    bkey->key.flags |= ak_key_flag_not_ctr;
+  }
+
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция зашифровывает (расшифровывает) в режиме гаммирования `count` последовательных
+    секторов длины `sector_size` байт, первый из которых имеет номер `sector`. Каждый сектор
+    зашифровывается независимо от остальных на собственной синхропосылке, которая получается
+    сложением по модулю два синхропосылки `iv` и номера сектора (синхропосылка рассматривается
+    как целое число, байты которого упорядочены так же, как байты счетчика; для алгоритма
+    с длиной блока 64 бита используются младшие 32 бита номера). Таким образом,
+    результат зашифрования сектора совпадает с результатом вызова функции
+    ak_bckey_context_ctr() для данных сектора с указанной синхропосылкой.
+
+    Значения счетчиков вычисляются для всех блоков обрабатываемых секторов сразу, поэтому
+    короткие сектора не обрабатываются по одному: гамма для нескольких секторов вырабатывается
+    одним вызовом многоблочной функции зашифрования. При большом объеме данных
+    сектора распределяются между несколькими потоками (только для алгоритмов с длиной блока
+    128 бит). Проверка ключа, изменение его ресурса
+    и перемаскирование выполняются один раз за вызов функции.
+
+    После вызова функции дальнейшее использование внутреннего значения синхропосылки
+    запрещается.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на область памяти, где хранятся входные данные.
+    @param out Указатель на область памяти, куда помещаются выходные данные
+    (этот указатель может совпадать с `in`).
+    @param sector_size Длина сектора в байтах, должна быть кратна длине блока.
+    @param sector Номер первого обрабатываемого сектора.
+    @param count Количество обрабатываемых секторов.
+    @param iv Указатель на синхропосылку (не может быть равен NULL).
+    @param iv_size Длина синхропосылки в байтах.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_ctr_sectors( ak_bckey bkey, ak_pointer in, ak_pointer out,
+             size_t sector_size, ak_uint64 sector, size_t count, ak_pointer iv, size_t iv_size )
+{
+  size_t per = 0, blocks = 0;
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  size_t threads = 1;
+#endif
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to block cipher key" );
+  if(( iv == NULL ) || ( iv_size == 0 )) return ak_error_message( ak_error_null_pointer,
+                                                  __func__, "using null pointer to initial vector" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+               ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher key" );
+  if(( sector_size == 0 ) || ( sector_size%bkey->bsize ))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                   "sector size must be a multiple of block size" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+  if( count == 0 ) return ak_error_ok;
+
+ /* проверяем ключ, уменьшаем его ресурс и устанавливаем синхропосылку */
+  per = sector_size/bkey->bsize;
+  blocks = per*count;
+  if(( error = ak_bckey_context_ctr_prepare( bkey,
+                                           (ak_int64) blocks, iv, iv_size, oc )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of counter mode" );
+
+ /* обрабатываем сектора */
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  if( bkey->bsize == 16 ) threads = ak_min( ak_bckey_context_get_threads_count( blocks ), count );
+  if( threads > 1 ) {
+    struct bckey_range ranges[ak_bckey_context_max_threads];
+
+    ak_bckey_context_split_ranges( ranges, bkey, in, out, count, per, sector, oc, threads );
+    ak_bckey_context_start_ranges( ranges, ak_bckey_range_ctr_sectors, threads );
+  } else
+#endif
+   ak_bckey_context_ctr_sectors_blocks( bkey, ( ak_uint64 *)in,
+                                            ( ak_uint64 *)out, blocks, sector, 0, per, oc );
+
+ /* синхропосылка каждого сектора определяется его номером, поэтому внутреннее значение
+    синхропосылки не может быть использовано для продолжения шифрования */
+  memset( bkey->ivector, 0, sizeof( bkey->ivector ));
+  bkey->key.flags |= ak_key_flag_not_ctr;
+
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                      функции тестирования                                       */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция изменяет порядок октетов в каждом блоке данных на обратный
+    (неполный последний блок обращается в пределах своей длины).                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_test_reverse( ak_uint8 *out, const ak_uint8 *in,
+                                                              const size_t size, const size_t bsize )
+{
+  size_t i = 0, j = 0, len = 0;
+
+  for( i = 0; i < size; i += bsize ) {
+     len = ak_min( bsize, size - i );
+     for( j = 0; j < len; j++ ) out[i+j] = in[i+len-1-j];
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция проверяет режим CTR-ACPKM для одного ключа: однократным вызовом,
+    обработкой данных фрагментами, а также расшифрованием данных на месте.
+    Тестовые данные передаются в представлении Р 1323565.1.017-2018
+    (старшие октеты блока расположены в его начале).                                              */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_bckey_test_acpkm_one( ak_bckey bkey, const int oc, ak_uint8 *key, ak_uint8 *iv,
+                          ak_uint8 *in, ak_uint8 *cipher, size_t size, const size_t section_size )
+{
+  int error = ak_error_ok;
+  size_t bsize = bkey->bsize, half = bkey->bsize >> 1, part = 0;
+  const char *name = bkey->key.oid->names[0];
+  ak_uint8 nonce[16], p[128], c[128], out[128];
+
+ /* приводим данные к используемому представлению */
+  if((( bsize != 8 ) && ( bsize != 16 )) || ( size > sizeof( p ))) return ak_false;
+  if( oc ) {
+    memcpy( nonce, iv, half ); memcpy( p, in, size ); memcpy( c, cipher, size );
+  } else {
+    ak_bckey_test_reverse( nonce, iv, half, half );
+    ak_bckey_test_reverse( p, in, size, bsize );
+    ak_bckey_test_reverse( c, cipher, size, bsize );
+  }
+
+ /* 1. однократное зашифрование */
+  memset( out, 0, sizeof( out ));
+  if(( error = ak_bckey_context_ctr_acpkm( bkey, p, out, size,
+                                                   section_size, nonce, half )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "incorrect encryption in ctr-acpkm mode" );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, c, size )) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                            "wrong encryption test for %s from R 1323565.1.017-2018", name );
+    return ak_false;
+  }
+
+ /* 2. зашифрование фрагментами, граница которых не совпадает с границей секции */
+  part = section_size + bsize;
+  memset( out, 0, sizeof( out ));
+  if(( error = ak_bckey_context_set_key( bkey, key, 32 )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong assigning a constant key value" );
+    return ak_false;
+  }
+  ak_bckey_context_ctr_acpkm( bkey, p, out, part, section_size, nonce, half );
+  ak_bckey_context_ctr_acpkm( bkey, p+part, out+part, size-part, section_size, NULL, 0 );
+  if( !ak_ptr_is_equal_with_log( out, c, size )) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                                         "wrong incremental encryption test for %s", name );
+    return ak_false;
+  }
+
+ /* 3. расшифрование на месте */
+  if(( error = ak_bckey_context_set_key( bkey, key, 32 )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong assigning a constant key value" );
+    return ak_false;
+  }
+  if(( error = ak_bckey_context_ctr_acpkm( bkey, out, out, size,
+                                                   section_size, nonce, half )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "incorrect decryption in ctr-acpkm mode" );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, p, size )) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                            "wrong decryption test for %s from R 1323565.1.017-2018", name );
+    return ak_false;
+  }
+
+  if( ak_log_get_level() >= ak_log_maximum ) ak_error_message_fmt( ak_error_ok, __func__ ,
+                                      "the test for %s from R 1323565.1.017-2018 is Ok", name );
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция проверяет корректность реализации режима гаммирования CTR-ACPKM на тестовых примерах
+    из Р 1323565.1.017-2018 для блочных шифров Кузнечик и Магма.
+
+    @return Возвращает ak_true в случае успешного тестирования. В случае возникновения ошибки
+    функция возвращает ak_false.                                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_bckey_test_acpkm( void )
+{
+  struct bckey bkey;
+  bool_t result = ak_true;
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+ /* ключ из Р 1323565.1.017-2018, приложение А */
+  ak_uint8 key[32] = {
+    0xef,0xcd,0xab,0x89,0x67,0x45,0x23,0x01,0x10,0x32,0x54,0x76,0x98,0xba,0xdc,0xfe,
+    0x77,0x66,0x55,0x44,0x33,0x22,0x11,0x00,0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88
+  };
+  ak_uint8 oc_key[32] = {
+    0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff,0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,
+    0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10,0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef
+  };
+
+ /* данные для алгоритма Кузнечик: длина секции 256 бит */
+  ak_uint8 iv[8] = { 0x12,0x34,0x56,0x78,0x90,0xab,0xce,0xf0 };
+  ak_uint8 in[112] = {
+    0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x00,0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88,
+    0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,
+    0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,
+    0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,0x11,
+    0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,0x11,0x22,
+    0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,0x11,0x22,0x33,
+    0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,0x11,0x22,0x33,0x44
+  };
+  ak_uint8 cipher[112] = {
+    0xf1,0x95,0xd8,0xbe,0xc1,0x0e,0xd1,0xdb,0xd5,0x7b,0x5f,0xa2,0x40,0xbd,0xa1,0xb8,
+    0x85,0xee,0xe7,0x33,0xf6,0xa1,0x3e,0x5d,0xf3,0x3c,0xe4,0xb3,0x3c,0x45,0xde,0xe4,
+    0x4b,0xce,0xeb,0x8f,0x64,0x6f,0x4c,0x55,0x00,0x17,0x06,0x27,0x5e,0x85,0xe8,0x00,
+    0x58,0x7c,0x4d,0xf5,0x68,0xd0,0x94,0x39,0x3e,0x48,0x34,0xaf,0xd0,0x80,0x50,0x46,
+    0xcf,0x30,0xf5,0x76,0x86,0xae,0xec,0xe1,0x1c,0xfc,0x6c,0x31,0x6b,0x8a,0x89,0x6e,
+    0xdf,0xfd,0x07,0xec,0x81,0x36,0x36,0x46,0x0c,0x4f,0x3b,0x74,0x34,0x23,0x16,0x3e,
+    0x64,0x09,0xa9,0xc2,0x82,0xfa,0xc8,0xd4,0x69,0xd2,0x21,0xe7,0xfb,0xd6,0xde,0x5d
+  };
+
+ /* данные для алгоритма Магма: длина секции 128 бит */
+  ak_uint8 magma_iv[4] = { 0x12,0x34,0x56,0x78 };
+  ak_uint8 magma_in[56] = {
+    0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x00,0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88,
+    0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,
+    0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,
+    0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99
+  };
+  ak_uint8 magma_cipher[56] = {
+    0x2a,0xb8,0x1d,0xee,0xeb,0x1e,0x4c,0xab,0x68,0xe1,0x04,0xc4,0xbd,0x6b,0x94,0xea,
+    0xc7,0x2c,0x67,0xaf,0x6c,0x2e,0x5b,0x6b,0x0e,0xaf,0xb6,0x17,0x70,0xf1,0xb3,0x2e,
+    0xa1,0xae,0x71,0x14,0x9e,0xed,0x13,0x82,0xab,0xd4,0x67,0x18,0x06,0x72,0xec,0x6f,
+    0x84,0xa2,0xf1,0x5b,0x3f,0xca,0x72,0xc1
+  };
+
+  if(( oc < 0 ) || ( oc > 1 )) {
+    ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+    return ak_false;
+  }
+
+ /* 1. тестируем режим CTR-ACPKM для алгоритма Кузнечик */
+  if(( error = ak_bckey_context_create_kuznechik( &bkey )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong creation of kuznechik key context" );
+    return ak_false;
+  }
+  if(( error = ak_bckey_context_set_key( &bkey, oc ? oc_key : key, 32 )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong assigning a constant key value" );
+    result = ak_false;
+  } else result = ak_bckey_test_acpkm_one( &bkey, oc, oc ? oc_key : key, iv,
+                                                         in, cipher, sizeof( in ), 32 );
+  ak_bckey_context_destroy( &bkey );
+  if( result != ak_true ) return result;
+
+ /* 2. тестируем режим CTR-ACPKM для алгоритма Магма
+       (алгоритм Магма реализован только без совместимости с openssl) */
+  if( oc ) return result;
+  if(( error = ak_bckey_context_create_magma( &bkey )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong creation of magma key context" );
+    return ak_false;
+  }
+  if(( error = ak_bckey_context_set_key( &bkey, key, 32 )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong assigning a constant key value" );
+    result = ak_false;
+  } else result = ak_bckey_test_acpkm_one( &bkey, oc, key, magma_iv,
+                                           magma_in, magma_cipher, sizeof( magma_in ), 16 );
+  ak_bckey_context_destroy( &bkey );
+
+ return result;
+}
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \example test-bckey01.c                                                                        */
 /*! \example test-bckey02.c                                                                        */
 /*! \example test-bckey04.c                                                                        */
 /*! \example test-bckey05.c                                                                        */
+/*! \example test-bckey06.c                                                                        */
+/*! \example test-bckey08.c                                                                        */
+/*! \example test-bckey09.c                                                                        */
+/*! \example test-bckey10.c                                                                        */
+/*! \example test-bckey11.c                                                                        */
+/*! \example test-bckey12.c                                                                        */
+/*! \example test-bckey13.c                                                                        */
+/*! \example test-bckey14.c                                                                        */
+/*! \example test-bckey15.c                                                                        */
+/*! \example test-bckey16.c                                                                        */
+/*! \example test-bckey17.c                                                                        */
 /* ----------------------------------------------------------------------------------------------- */
 /*                                                                                     ak_bckey.c  */
 /* ----------------------------------------------------------------------------------------------- */
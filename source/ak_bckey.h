@@ -10,6 +10,12 @@
 /* ----------------------------------------------------------------------------------------------- */
  #include <ak_skey.h>
  #include <ak_parameters.h>
+ #include <ak_mac.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Максимальное количество блоков, передаваемых режимами шифрования
+    в многоблочную функцию за один вызов. */
+ #define ak_bckey_context_buffer_blocks (32)
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Указатель на структуру ключа блочного алгоритма шифрования. */
@@ -20,6 +26,8 @@
  typedef int ( ak_function_bckey_create ) ( ak_bckey );
 /*! \brief Функция зашифрования/расширования одного блока информации. */
  typedef void ( ak_function_bckey )( ak_skey, ak_pointer, ak_pointer );
+/*! \brief Функция зашифрования/расширования нескольких последовательно расположенных блоков информации. */
+ typedef void ( ak_function_bckey_blocks )( ak_skey, ak_pointer, ak_pointer, size_t );
 /*! \brief Функция, предназначенная для зашифрования/расшифрования области памяти заданного размера */
  typedef int ( ak_function_bckey_encrypt )( ak_bckey, ak_pointer, ak_pointer, size_t,
                                                                                 ak_pointer, size_t );
@@ -36,16 +44,74 @@
    ak_uint8 ivector[64];
   /*! \brief Текущий размер вектора синхропосылки (в октетах) */
    size_t ivector_size;
+  /*! \brief Резервуар гаммы, заранее выработанной в режиме гаммирования (может быть NULL).
+      \details Неиспользованная гамма занимает `reservoir_count` октетов, начиная со смещения
+      `reservoir_offset`; значение счетчика во внутреннем буффере `ivector` всегда соответствует
+      первому неиспользованному блоку гаммы. Гамма хранится в маскированном виде: первые
+      `reservoir_size` октетов резервуара содержат маскированную гамму, следующие
+      `reservoir_size` октетов - ее маску (аналогично хранению ключа). */
+   ak_uint8 *reservoir;
+  /*! \brief Размер резервуара гаммы (в октетах). */
+   size_t reservoir_size;
+  /*! \brief Смещение первого неиспользованного октета гаммы в резервуаре. */
+   size_t reservoir_offset;
+  /*! \brief Количество неиспользованных октетов гаммы в резервуаре. */
+   size_t reservoir_count;
+  /*! \brief Функция маскирования ключа, замененная на время существования резервуара функцией,
+      которая также меняет маску гаммы. */
+   ak_function_skey *reservoir_set_mask;
   /*! \brief Функция заширования одного блока информации. */
    ak_function_bckey *encrypt;
   /*! \brief Функция расширования одного блока информации. */
    ak_function_bckey *decrypt;
+  /*! \brief Функция зашифрования нескольких последовательно расположенных блоков информации. */
+   ak_function_bckey_blocks *encrypt_blocks;
+  /*! \brief Функция расшифрования нескольких последовательно расположенных блоков информации. */
+   ak_function_bckey_blocks *decrypt_blocks;
+  /*! \brief Функция последовательного сжатия нескольких блоков информации в режиме
+      выработки имитовставки: каждый блок складывается с текущим значением цепочки,
+      после чего результат зашифровывается.
+      \details Текущее значение цепочки передается и возвращается через третий аргумент функции;
+      если указатель не определен, используется функция зашифрования одного блока. */
+   ak_function_bckey_blocks *mac_blocks;
   /*! \brief Функция развертки ключа. */
    ak_function_skey *schedule_keys;
   /*! \brief Функция уничтожения развернутых ключей. */
    ak_function_skey *delete_keys;
 };
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Описание одного из независимых сообщений, обрабатываемых совместно
+    (например, функцией ak_bckey_context_encrypt_cbc_streams()). */
+ typedef struct bckey_stream {
+  /*! \brief Ключ алгоритма блочного шифрования, используемый для обработки сообщения. */
+   ak_bckey bkey;
+  /*! \brief Указатель на входные данные. */
+   ak_pointer in;
+  /*! \brief Указатель на выходные данные (может совпадать с `in`). */
+   ak_pointer out;
+  /*! \brief Размер обрабатываемых данных (в байтах). */
+   size_t size;
+  /*! \brief Указатель на синхропосылку. */
+   ak_pointer iv;
+  /*! \brief Длина синхропосылки (в байтах). */
+   size_t iv_size;
+} *ak_bckey_stream;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Описание последовательности блоков, зашифровываемых на заданном ключе
+    при пакетной обработке данных, принадлежащих различным ключам. */
+ typedef struct bckey_batch {
+  /*! \brief Ключ алгоритма блочного шифрования, на котором зашифровываются блоки. */
+   ak_bckey bkey;
+  /*! \brief Указатель на входные данные. */
+   ak_pointer in;
+  /*! \brief Указатель на выходные данные (может совпадать с `in`). */
+   ak_pointer out;
+  /*! \brief Количество зашифровываемых блоков. */
+   size_t blocks;
+} *ak_bckey_batch;
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Инициализация ключа произвольного алгоритма блочного шифрования. */
  int ak_bckey_context_create( ak_bckey , size_t , size_t );
@@ -84,16 +150,66 @@
  int ak_bckey_context_decrypt_ecb( ak_bckey , ak_pointer , ak_pointer , size_t );
 /*! \brief Шифрование данных в режиме гаммирования из ГОСТ Р 34.13-2015 (counter mode, ctr). */
  int ak_bckey_context_ctr( ak_bckey , ak_pointer , ak_pointer , size_t , ak_pointer , size_t );
+/*! \brief Выделение резервуара для заранее вырабатываемой гаммы режима гаммирования. */
+ int ak_bckey_context_set_ctr_reservoir( ak_bckey , const size_t );
+/*! \brief Заблаговременная выработка гаммы режима гаммирования. */
+ int ak_bckey_context_ctr_reservoir_fill( ak_bckey , ak_pointer , size_t );
+/*! \brief Шифрование фрагмента сообщения с заданным смещением в режиме гаммирования. */
+ int ak_bckey_context_ctr_offset( ak_bckey , ak_pointer , ak_pointer , size_t , ak_uint64 ,
+                                                                           ak_pointer , size_t );
+/*! \brief Шифрование последовательности секторов в режиме гаммирования. */
+ int ak_bckey_context_ctr_sectors( ak_bckey , ak_pointer , ak_pointer , size_t , ak_uint64 ,
+                                                                   size_t , ak_pointer , size_t );
+/*! \brief Шифрование нескольких независимых сообщений в режиме гаммирования. */
+ int ak_bckey_context_ctr_streams( ak_bckey_stream , size_t );
  /*! \brief Зашифрование данных в режиме простой замены с зацеплением из ГОСТ Р 34.13-2015 (cbc). */
  int ak_bckey_context_encrypt_cbc( ak_bckey , ak_pointer , ak_pointer , size_t , ak_pointer , size_t );
  /*! \brief Расшифрование данных в режиме простой замены с зацеплением из ГОСТ Р 34.13-2015 (cbc). */
  int ak_bckey_context_decrypt_cbc( ak_bckey , ak_pointer , ak_pointer , size_t , ak_pointer , size_t );
+/*! \brief Зашифрование нескольких независимых сообщений в режиме простой замены с зацеплением. */
+ int ak_bckey_context_encrypt_cbc_streams( ak_bckey_stream , size_t );
+/*! \brief Зашифрование данных в режиме гаммирования с одновременной выработкой имитовставки. */
+ int ak_bckey_context_encrypt_ctr_mac( ak_bckey , ak_mac , ak_pointer , ak_pointer , size_t ,
+                                                   ak_pointer , size_t , ak_pointer , size_t );
+/*! \brief Расшифрование данных в режиме гаммирования с одновременной проверкой имитовставки. */
+ int ak_bckey_context_decrypt_ctr_mac( ak_bckey , ak_mac , ak_pointer , ak_pointer , size_t ,
+                                                   ak_pointer , size_t , ak_pointer , size_t );
 /*! \brief Шифрование данных в режиме CTR-ACPKM из Р 1323565.1.017—2018. */
  int ak_bckey_context_ctr_acpkm( ak_bckey , ak_pointer , ak_pointer , size_t , size_t ,
                                                                            ak_pointer , size_t );
+/*! \brief Шифрование в режиме гаммирования данных, расположенных в нескольких фрагментах. */
+ int ak_bckey_context_ctr_fragments( ak_bckey , ak_fragment , ak_fragment , const size_t ,
+                                                                           ak_pointer , size_t );
+/*! \brief Шифрование в режиме CTR-ACPKM данных, расположенных в нескольких фрагментах. */
+ int ak_bckey_context_ctr_acpkm_fragments( ak_bckey , ak_fragment , ak_fragment , const size_t ,
+                                                                  size_t , ak_pointer , size_t );
 /*! \brief Вычисление имитовставки согласно ГОСТ Р 34.13-2015. */
  int ak_bckey_context_omac( ak_bckey , ak_pointer , size_t , ak_pointer , size_t );
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Размер фрагмента данных, обрабатываемого за один шаг режимов гаммирования
+    с одновременной выработкой имитовставки. */
+ #define ak_bckey_context_ctr_mac_chunk_size (16384)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Максимальное количество потоков, используемых многопоточными реализациями режимов. */
+ #define ak_bckey_context_max_threads (64)
+/*! \brief Минимальное количество блоков, обрабатываемых одним потоком. */
+ #define ak_bckey_context_thread_min_blocks (1024)
+
+/*! \brief Количество потоков, используемых для обработки заданного количества блоков. */
+ size_t ak_bckey_context_get_threads_count( const size_t );
+/*! \brief Многопоточное зашифрование данных в режиме простой замены. */
+ int ak_bckey_context_encrypt_ecb_parallel( ak_bckey , ak_pointer , ak_pointer , size_t );
+/*! \brief Многопоточное расшифрование данных в режиме простой замены. */
+ int ak_bckey_context_decrypt_ecb_parallel( ak_bckey , ak_pointer , ak_pointer , size_t );
+/*! \brief Многопоточное шифрование данных в режиме гаммирования из ГОСТ Р 34.13-2015. */
+ int ak_bckey_context_ctr_parallel( ak_bckey , ak_pointer , ak_pointer , size_t ,
+                                                                           ak_pointer , size_t );
+/*! \brief Многопоточное расшифрование данных в режиме простой замены с зацеплением. */
+ int ak_bckey_context_decrypt_cbc_parallel( ak_bckey , ak_pointer , ak_pointer , size_t ,
+                                                                           ak_pointer , size_t );
+
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Выработка матрицы, соответствующей 16 тактам работы линейного региста сдвига. */
@@ -107,6 +223,27 @@
  int ak_bckey_context_kuznechik_init_tables( const linear_register , const sbox , ak_kuznechik_params );
 /*! \brief Инициализация внутренних переменных значениями, регламентируемыми ГОСТ Р 34.12-2015. */
  int ak_bckey_context_kuznechik_init_gost_tables( void );
+/*! \brief Инициализация развернутых таблиц замен, используемых при реализации алгоритма
+    блочного шифрования Магма (ГОСТ Р 34.12-2015). */
+ int ak_bckey_context_magma_init_tables( void );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Автоматический выбор реализации алгоритма Кузнечик. */
+ #define ak_kuznechik_kernel_auto      (0)
+/*! \brief Базовая реализация алгоритма Кузнечик, использующая 64-х битные слова. */
+ #define ak_kuznechik_kernel_base      (1)
+/*! \brief Векторная реализация алгоритма Кузнечик, использующая инструкции SSSE3. */
+ #define ak_kuznechik_kernel_ssse3     (2)
+/*! \brief Реализация алгоритма Кузнечик, использующая компактные (менее 16 Кбайт) таблицы. */
+ #define ak_kuznechik_kernel_compact   (3)
+
+/*! \brief Проверка доступности реализации алгоритма Кузнечик на текущем процессоре. */
+ bool_t ak_kuznechik_kernel_is_available( const int );
+/*! \brief Получение номера реализации алгоритма Кузнечик, используемой при создании ключей. */
+ int ak_kuznechik_kernel_get( void );
+/*! \brief Зашифрование блоков, принадлежащих различным ключам алгоритма Кузнечик,
+    в едином цикле раундов. */
+ int ak_kuznechik_encrypt_batch( ak_bckey_batch , const size_t );
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Тестирование корректной работы алгоритма блочного шифрования Магма (ГОСТ Р 34.12-2015). */
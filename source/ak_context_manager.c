@@ -5,6 +5,7 @@
 /*  - содержит реализацию функций для управления контекстами.                                      */
 /* ----------------------------------------------------------------------------------------------- */
  #include <ak_hmac.h>
+ #include <ak_omac.h>
  #include <ak_bckey.h>
  #include <ak_tools.h>
  #include <ak_context_manager.h>
@@ -54,6 +55,9 @@
     case hmac_function:
                   oid = (( ak_hmac ) ctx )->key.oid;
                   break;
+    case omac_function:
+                  oid = (( ak_omac ) ctx )->bkey.key.oid;
+                  break;
     case block_cipher:
                   oid = (( ak_bckey ) ctx )->key.oid;
                   break;
@@ -112,7 +116,7 @@
   }
 
  /* разбираемся с описанием: выделяем память и копируем */
-  len = 1 + ak_min( strlen( description ), 127 );
+  if( description != NULL ) len = 1 + ak_min( strlen( description ), 127 );
   if(( description == NULL ) || ( len == 1 )) node->description = NULL;
     else {
       if(( node->description = malloc( len )) != NULL ) {
@@ -660,6 +664,19 @@
       }
       break;
 
+    case omac_function:
+      if(( ctx = malloc( sizeof( struct omac ))) == NULL ) {
+        ak_error_message( ak_error_out_of_memory, __func__,
+                                         "incorrect allocation memory for omac function context" );
+        return ak_error_wrong_handle;
+      }
+      if(( error = ((ak_function_bckey_create *)oid->func.create)( ctx )) != ak_error_ok ) {
+        free( ctx );
+        ak_error_message( error, __func__, "incorrect creation of omac function context" );
+        return ak_error_wrong_handle;
+      }
+      break;
+
     case block_cipher:
     case random_generator:
 
@@ -690,6 +707,12 @@
   return ak_handle_new( "hmac-streebog512", NULL );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+ ak_handle ak_handle_new_omac_magma( void ) { return ak_handle_new( "omac-magma", NULL ); }
+
+/* ----------------------------------------------------------------------------------------------- */
+ ak_handle ak_handle_new_omac_kuznechik( void ) { return ak_handle_new( "omac-kuznechik", NULL ); }
+
 /* ----------------------------------------------------------------------------------------------- */
  int ak_handle_delete( ak_handle handle )
 {
@@ -793,6 +816,9 @@
     case hmac_function:
       return (( ak_hmac )manager->array[idx]->ctx )->ctx.data.sctx.hsize;
 
+    case omac_function:
+      return (( ak_omac )manager->array[idx]->ctx )->bkey.bsize;
+
     case block_cipher:
       return (( ak_bckey )manager->array[idx]->ctx )->bsize;
 
@@ -881,6 +907,10 @@
       error = ak_hmac_context_set_key( ctx, key, 64 );
       break;
 
+    case omac_function:
+      error = ak_omac_context_set_key( ctx, key, 32 );
+      break;
+
     case block_cipher:
       error = ak_bckey_context_set_key( ctx, key, 32 );
       break;
@@ -919,6 +949,10 @@
       error = ak_hmac_context_set_key_from_password( ctx, pass, pass_size, salt, salt_size );
       break;
 
+    case omac_function:
+      error = ak_omac_context_set_key_from_password( ctx, pass, pass_size, salt, salt_size );
+      break;
+
     case block_cipher:
       error = ak_bckey_context_set_key_from_password( ctx, pass, pass_size, salt, salt_size );
       break;
@@ -957,6 +991,7 @@
   {
     case hash_function: return ak_hash_context_file( ctx, filename, out, out_size );
     case hmac_function: return ak_hmac_context_file( ctx, filename, out, out_size );
+    case omac_function: return ak_omac_context_file( ctx, filename, out, out_size );
 
    /* для остальных возвращаем ошибку */
     default:
@@ -996,6 +1031,7 @@
   {
     case hash_function: return ak_hash_context_ptr( ctx, in, size, out, out_size );
     case hmac_function: return ak_hmac_context_ptr( ctx, in, size, out, out_size );
+    case omac_function: return ak_omac_context_ptr( ctx, in, size, out, out_size );
 
    /* для остальных возвращаем ошибку */
     default:
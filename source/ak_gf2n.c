@@ -107,6 +107,41 @@
 #endif
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет сумму попарных произведений \f$ z = z \oplus \sum_{i=0}^{n-1} x_i \otimes y_i\f$
+    элементов конечного поля \f$ \mathbb F_{2^{64}}\f$. Элементы \f$ x_i\f$ и \f$ y_i\f$
+    последовательно расположены в памяти.
+    Для умножения используется функция ak_gf64_mul_uint64().                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf64_mulsum_uint64( ak_pointer z, ak_pointer x, ak_pointer y, size_t count )
+{
+ size_t i = 0;
+ ak_uint64 t;
+
+ for( i = 0; i < count; i++ ) {
+    ak_gf64_mul_uint64( &t, ((ak_uint64 *)x)+i, ((ak_uint64 *)y)+i );
+    ((ak_uint64 *)z)[0] ^= t;
+ }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет сумму попарных произведений \f$ z = z \oplus \sum_{i=0}^{n-1} x_i \otimes y_i\f$
+    элементов конечного поля \f$ \mathbb F_{2^{128}}\f$. Элементы \f$ x_i\f$ и \f$ y_i\f$
+    последовательно расположены в памяти.
+    Для умножения используется функция ak_gf128_mul_uint64().                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf128_mulsum_uint64( ak_pointer z, ak_pointer x, ak_pointer y, size_t count )
+{
+ size_t i = 0;
+ ak_uint64 t[2];
+
+ for( i = 0; i < count; i++ ) {
+    ak_gf128_mul_uint64( t, ((ak_uint64 *)x)+2*i, ((ak_uint64 *)y)+2*i );
+    ((ak_uint64 *)z)[0] ^= t[0];
+    ((ak_uint64 *)z)[1] ^= t[1];
+ }
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция реализует операцию умножения двух элементов конечного поля \f$ \mathbb F_{2^{256}}\f$,
     порожденного неприводимым многочленом
@@ -380,6 +415,78 @@
 #endif
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет сумму попарных произведений \f$ z = z \oplus \sum_{i=0}^{n-1} x_i \otimes y_i\f$
+    элементов конечного поля \f$ \mathbb F_{2^{64}}\f$ с помощью команды PCLMULQDQ.
+
+    Произведения многочленов складываются без приведения по модулю (сумма произведений
+    занимает не более 127 бит), приведение выполняется один раз для всей суммы.
+    За одну итерацию цикла обрабатываются два элемента.                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf64_mulsum_pcmulqdq( ak_pointer z, ak_pointer x, ak_pointer y, size_t count )
+{
+  size_t i = 0;
+  ak_uint64 acc[2], t[2], u[2];
+  const __m128i gm = _mm_set_epi64x( 0, 0x1B );
+  __m128i am, bm, cm = _mm_setzero_si128();
+
+ /* накопление суммы произведений без приведения */
+  for( ; i+1 < count; i += 2 ) {
+     am = _mm_loadu_si128( (__m128i *)( ((ak_uint64 *)x)+i ));
+     bm = _mm_loadu_si128( (__m128i *)( ((ak_uint64 *)y)+i ));
+     cm = _mm_xor_si128( cm, _mm_clmulepi64_si128( am, bm, 0x00 ));
+     cm = _mm_xor_si128( cm, _mm_clmulepi64_si128( am, bm, 0x11 ));
+  }
+  if( i < count ) {
+    am = _mm_loadl_epi64( (__m128i *)( ((ak_uint64 *)x)+i ));
+    bm = _mm_loadl_epi64( (__m128i *)( ((ak_uint64 *)y)+i ));
+    cm = _mm_xor_si128( cm, _mm_clmulepi64_si128( am, bm, 0x00 ));
+  }
+  _mm_storeu_si128( (__m128i *)acc, cm );
+
+ /* приведение: x^64 = x^4 + x^3 + x + 1 */
+  _mm_storeu_si128( (__m128i *)t, _mm_clmulepi64_si128( _mm_set_epi64x( 0, acc[1] ), gm, 0x00 ));
+  _mm_storeu_si128( (__m128i *)u, _mm_clmulepi64_si128( _mm_set_epi64x( 0, t[1] ), gm, 0x00 ));
+
+  ((ak_uint64 *)z)[0] ^= acc[0]^t[0]^u[0];
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет сумму попарных произведений \f$ z = z \oplus \sum_{i=0}^{n-1} x_i \otimes y_i\f$
+    элементов конечного поля \f$ \mathbb F_{2^{128}}\f$ с помощью команды PCLMULQDQ.
+
+    Произведения многочленов (длиной 255 бит) складываются без приведения по модулю,
+    приведение выполняется один раз для всей суммы. Тем самым, стоимость приведения
+    распределяется между всеми слагаемыми.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf128_mulsum_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b, size_t count )
+{
+  size_t i = 0;
+  ak_uint64 c[2], d[2], e[2], x3, D;
+  __m128i am, bm, cm = _mm_setzero_si128(), dm = _mm_setzero_si128(), em = _mm_setzero_si128();
+
+ /* накопление суммы произведений без приведения */
+  for( i = 0; i < count; i++ ) {
+     am = _mm_loadu_si128( (__m128i *)( ((ak_uint64 *)a)+2*i ));
+     bm = _mm_loadu_si128( (__m128i *)( ((ak_uint64 *)b)+2*i ));
+     cm = _mm_xor_si128( cm, _mm_clmulepi64_si128( am, bm, 0x00 )); /* a0*b0 */
+     dm = _mm_xor_si128( dm, _mm_clmulepi64_si128( am, bm, 0x11 )); /* a1*b1 */
+     em = _mm_xor_si128( em, _mm_clmulepi64_si128( am, bm, 0x10 )); /* a0*b1 */
+     em = _mm_xor_si128( em, _mm_clmulepi64_si128( am, bm, 0x01 )); /* a1*b0 */
+  }
+  _mm_storeu_si128( (__m128i *)c, cm );
+  _mm_storeu_si128( (__m128i *)d, dm );
+  _mm_storeu_si128( (__m128i *)e, em );
+
+ /* приведение (аналогично функции ak_gf128_mul_pcmulqdq()) */
+  x3 = d[1];
+  D = d[0] ^ e[1] ^ (x3 >> 63) ^ (x3 >> 62) ^ (x3 >> 57);
+
+  ((ak_uint64 *)z)[0] ^= c[0] ^ D ^ (D << 1) ^ (D << 2) ^ (D << 7);
+  ((ak_uint64 *)z)[1] ^= c[1] ^ e[0] ^ x3 ^ (x3 << 1) ^ (D >> 63) ^ (x3 << 2) ^ (D >> 62) ^
+                                                                         (x3 << 7) ^ (D >> 57);
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция реализует операцию умножения двух элементов конечного поля \f$ \mathbb F_{2^{256}}\f$,
     порожденного неприводимым многочленом
@@ -1143,6 +1250,50 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
  return ak_true;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Тестирование операций сложения попарных произведений элементов полей
+    \f$ \mathbb F_{2^{64}}\f$ и \f$ \mathbb F_{2^{128}}\f$.
+    \details Результат вычисления сравнивается с последовательностью умножений
+    и сложений, выполняемых функциями ak_gf64_mul() и ak_gf128_mul().                             */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_gfn_mulsum_test( void )
+{
+  size_t i = 0, count = 0;
+  ak_uint64 x[34], y[34], z[2], s[2], t[2];
+
+ /* заполняем массивы псевдослучайными значениями */
+  x[0] = 0x1aaabcda1115LL; y[0] = 0xF1abcd5421110011LL;
+  for( i = 1; i < 34; i++ ) {
+     ak_gf64_mul( x+i, x+i-1, y+i-1 ); x[i] ^= i;
+     ak_gf64_mul( y+i, y+i-1, x+i ); y[i] ^= ( i << 32 );
+  }
+
+  for( count = 0; count < 17; count++ ) {
+    /* поле GF(2^64), нечетное количество слагаемых проверяет обработку последнего элемента */
+     z[0] = s[0] = y[33];
+     for( i = 0; i < count; i++ ) { ak_gf64_mul( t, x+i, y+i ); s[0] ^= t[0]; }
+     ak_gf64_mulsum( z, x, y, count );
+     if( z[0] != s[0] ) {
+       ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                    "wrong sum of products in GF(2^64) for %u elements", (unsigned int) count );
+       return ak_false;
+     }
+
+    /* поле GF(2^128) */
+     z[0] = s[0] = x[33]; z[1] = s[1] = y[33];
+     for( i = 0; i < count; i++ ) {
+        ak_gf128_mul( t, x+2*i, y+2*i ); s[0] ^= t[0]; s[1] ^= t[1];
+     }
+     ak_gf128_mulsum( z, x, y, count );
+     if(( z[0] != s[0] ) || ( z[1] != s[1] )) {
+       ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                   "wrong sum of products in GF(2^128) for %u elements", (unsigned int) count );
+       return ak_false;
+     }
+  }
+ return ak_true;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
  bool_t ak_gfn_multiplication_test( void )
 {
@@ -1188,6 +1339,13 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
     if( audit >= ak_log_maximum )
       ak_error_message( ak_error_get_value(), __func__ , "multiplication test in GF(2^512) is OK");
 
+ if( ak_gfn_mulsum_test( ) != ak_true ) {
+   ak_error_message( ak_error_get_value(), __func__ , "incorrect test for sum of products");
+   return ak_false;
+ } else
+    if( audit >= ak_log_maximum )
+      ak_error_message( ak_error_get_value(), __func__ , "sum of products test is OK");
+
 
  if( audit >= ak_log_maximum )
    ak_error_message( ak_error_ok, __func__ ,
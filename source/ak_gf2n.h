@@ -33,6 +33,10 @@
  void ak_gf256_mul_uint64( ak_pointer z, ak_pointer x, ak_pointer y );
 /*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{512}}\f$. */
  void ak_gf512_mul_uint64( ak_pointer z, ak_pointer x, ak_pointer y );
+/*! \brief Сложение попарных произведений элементов поля \f$ \mathbb F_{2^{64}}\f$. */
+ void ak_gf64_mulsum_uint64( ak_pointer z, ak_pointer x, ak_pointer y, size_t count );
+/*! \brief Сложение попарных произведений элементов поля \f$ \mathbb F_{2^{128}}\f$. */
+ void ak_gf128_mulsum_uint64( ak_pointer z, ak_pointer x, ak_pointer y, size_t count );
 
 #ifdef LIBAKRYPT_HAVE_BUILTIN_CLMULEPI64
 /*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{64}}\f$. */
@@ -43,17 +47,27 @@
  void ak_gf256_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b );
 /*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{512}}\f$. */
  void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b );
+/*! \brief Сложение попарных произведений элементов поля \f$ \mathbb F_{2^{64}}\f$
+    с однократным приведением по модулю. */
+ void ak_gf64_mulsum_pcmulqdq( ak_pointer z, ak_pointer x, ak_pointer y, size_t count );
+/*! \brief Сложение попарных произведений элементов поля \f$ \mathbb F_{2^{128}}\f$
+    с однократным приведением по модулю. */
+ void ak_gf128_mulsum_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b, size_t count );
 
  #define ak_gf64_mul ak_gf64_mul_pcmulqdq
  #define ak_gf128_mul ak_gf128_mul_pcmulqdq
  #define ak_gf256_mul ak_gf256_mul_pcmulqdq
  #define ak_gf512_mul ak_gf512_mul_pcmulqdq
+ #define ak_gf64_mulsum ak_gf64_mulsum_pcmulqdq
+ #define ak_gf128_mulsum ak_gf128_mulsum_pcmulqdq
 
 #else
  #define ak_gf64_mul ak_gf64_mul_uint64
  #define ak_gf128_mul ak_gf128_mul_uint64
  #define ak_gf256_mul ak_gf256_mul_uint64
  #define ak_gf512_mul ak_gf512_mul_uint64
+ #define ak_gf64_mulsum ak_gf64_mulsum_uint64
+ #define ak_gf128_mulsum ak_gf128_mulsum_uint64
 #endif
 
 /*! \brief Функция тестирования корректности реализации операций умножения в полях характеристики 2. */
@@ -20,6 +20,18 @@
 #else
  #error Library cannot be compiled without string.h header
 #endif
+#ifdef LIBAKRYPT_HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+ #include <pthread.h>
+#endif
+#ifdef LIBAKRYPT_HAVE_BUILTIN_XOR_SI128
+ #include <emmintrin.h>
+#endif
+#ifdef LIBAKRYPT_HAVE_BUILTIN_AVX2
+ #include <immintrin.h>
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*                            Реализация функции хеширования Стрибог                               */
@@ -84,6 +96,274 @@
        for ( idx = 0; idx < 8; idx++ ) ctx->h[idx] ^= T[idx] ^ K[idx] ^ m[idx];
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                 Реализации функции сжатия, использующие совмещенные таблицы                     */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Таблицы преобразования LPS с совмещенной подстановкой.
+    \details Элемент `streebog_lps_table[j][b]` равен `streebog_Areverse_expand[j][gost_pi[b]]`,
+    т.е. для каждого октета входных данных выполняется ровно одно обращение к памяти.
+    Таблицы вычисляются функцией ak_hash_context_streebog_init_tables().                           */
+ static ak_uint64 streebog_lps_table[8][256];
+
+/*! \brief Реализация функции сжатия, выбираемая при нулевом значении опции `streebog_kernel`. */
+ static int streebog_kernel_best = ak_streebog_kernel_base;
+
+#ifdef LIBAKRYPT_LITTLE_ENDIAN
+ #define ak_streebog_lps_byte( x, j, i ) \
+                                      streebog_lps_table[j][( ak_uint8 )(( x )[j] >> ( 8*( i )))]
+#else
+ #define ak_streebog_lps_byte( x, j, i ) \
+                                 streebog_lps_table[j][(( const ak_uint8 *)( x ))[8*( j )+( i )]]
+#endif
+ #define ak_streebog_lps_word( x, i ) \
+   ( ak_streebog_lps_byte( x, 0, i ) ^ ak_streebog_lps_byte( x, 1, i ) ^ \
+     ak_streebog_lps_byte( x, 2, i ) ^ ak_streebog_lps_byte( x, 3, i ) ^ \
+     ak_streebog_lps_byte( x, 4, i ) ^ ak_streebog_lps_byte( x, 5, i ) ^ \
+     ak_streebog_lps_byte( x, 6, i ) ^ ak_streebog_lps_byte( x, 7, i ))
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Развернутое преобразование LPS с использованием совмещенных таблиц.
+    \note Массивы result и data не должны пересекаться.                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_hash_context_streebog_lps_fused( ak_uint64 *result, const ak_uint64 *data )
+{
+  result[0] = ak_streebog_lps_word( data, 0 );
+  result[1] = ak_streebog_lps_word( data, 1 );
+  result[2] = ak_streebog_lps_word( data, 2 );
+  result[3] = ak_streebog_lps_word( data, 3 );
+  result[4] = ak_streebog_lps_word( data, 4 );
+  result[5] = ak_streebog_lps_word( data, 5 );
+  result[6] = ak_streebog_lps_word( data, 6 );
+  result[7] = ak_streebog_lps_word( data, 7 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование G, использующее совмещенные таблицы.
+    \details Преобразования X выполняются непосредственно перед LPS; временный массив B
+    имеет фиксированные индексы и размещается компилятором в регистрах.                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_context_streebog_g_fused( ak_streebog ctx, ak_uint64 *n, const ak_uint64 *m )
+{
+  int idx = 0, i = 0;
+  ak_uint64 K[8], T[8], B[8];
+
+  if( n != NULL ) {
+    for( i = 0; i < 8; i++ ) B[i] = ctx->h[i] ^ n[i];
+    ak_hash_context_streebog_lps_fused( K, B );
+  } else ak_hash_context_streebog_lps_fused( K, ctx->h );
+
+  for( i = 0; i < 8; i++ ) B[i] = m[i] ^ K[i];
+  ak_hash_context_streebog_lps_fused( T, B );
+  for( idx = 0; idx < 11; idx++ ) {
+    /* цепочки вычисления текста и ключа независимы и выполняются процессором одновременно */
+     for( i = 0; i < 8; i++ ) B[i] = K[i] ^ streebog_c[idx][i];
+     ak_hash_context_streebog_lps_fused( K, B );
+     for( i = 0; i < 8; i++ ) B[i] = T[i] ^ K[i];
+     ak_hash_context_streebog_lps_fused( T, B );
+  }
+  for( i = 0; i < 8; i++ ) B[i] = K[i] ^ streebog_c[11][i];
+  ak_hash_context_streebog_lps_fused( K, B );
+
+  for( i = 0; i < 8; i++ ) ctx->h[i] ^= T[i] ^ K[i] ^ m[i];
+}
+
+#if defined( LIBAKRYPT_HAVE_BUILTIN_XOR_SI128 ) && defined( __x86_64__ )
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование LPS для данных, размещенных в четырех регистрах SSE2.
+    \details Преобразование X (сложение с ключом) выполняется над 128-ми битными регистрами,
+    результат преобразования LPS собирается в регистрах без обращения к памяти.                    */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_hash_context_streebog_lpsx_sse2( __m128i *r,
+                                                           const __m128i *a, const __m128i *b )
+{
+  int i = 0;
+  ak_uint64 x[8], w[8];
+
+  for( i = 0; i < 4; i++ ) {
+     __m128i t = _mm_xor_si128( a[i], b[i] );
+     x[2*i] = ( ak_uint64 )_mm_cvtsi128_si64( t );
+     x[2*i+1] = ( ak_uint64 )_mm_cvtsi128_si64( _mm_unpackhi_epi64( t, t ));
+  }
+  ak_hash_context_streebog_lps_fused( w, x );
+  for( i = 0; i < 4; i++ )
+     r[i] = _mm_unpacklo_epi64( _mm_cvtsi64_si128(( long long ) w[2*i] ),
+                                _mm_cvtsi64_si128(( long long ) w[2*i+1] ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование G, использующее совмещенные таблицы и инструкции SSE2. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_context_streebog_g_sse2( ak_streebog ctx, ak_uint64 *n, const ak_uint64 *m )
+{
+  int idx = 0, i = 0;
+  __m128i h[4], M[4], K[4], T[4], zero = _mm_setzero_si128();
+
+  for( i = 0; i < 4; i++ ) {
+     h[i] = _mm_loadu_si128(( const __m128i *)( ctx->h + 2*i ));
+     M[i] = _mm_loadu_si128(( const __m128i *)( m + 2*i ));
+     T[i] = n == NULL ? zero : _mm_loadu_si128(( const __m128i *)( n + 2*i ));
+  }
+  ak_hash_context_streebog_lpsx_sse2( K, h, T );
+  ak_hash_context_streebog_lpsx_sse2( T, M, K );
+  for( idx = 0; idx < 12; idx++ ) {
+     __m128i C[4];
+     for( i = 0; i < 4; i++ ) C[i] = _mm_loadu_si128(( const __m128i *)( streebog_c[idx] + 2*i ));
+     ak_hash_context_streebog_lpsx_sse2( K, K, C );
+     if( idx < 11 ) ak_hash_context_streebog_lpsx_sse2( T, T, K );
+  }
+  for( i = 0; i < 4; i++ )
+     _mm_storeu_si128(( __m128i *)( ctx->h + 2*i ),
+                 _mm_xor_si128( _mm_xor_si128( h[i], M[i] ), _mm_xor_si128( T[i], K[i] )));
+}
+#endif
+
+#if defined( LIBAKRYPT_HAVE_BUILTIN_AVX2 ) && defined( __x86_64__ )
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование LPS для данных, размещенных в двух регистрах AVX2. */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx2" )))
+ static inline void ak_hash_context_streebog_lpsx_avx2( __m256i *r,
+                                                           const __m256i *a, const __m256i *b )
+{
+  int i = 0;
+  ak_uint64 x[8], w[8];
+
+  for( i = 0; i < 2; i++ ) {
+     __m256i t = _mm256_xor_si256( a[i], b[i] );
+     x[4*i] = ( ak_uint64 )_mm256_extract_epi64( t, 0 );
+     x[4*i+1] = ( ak_uint64 )_mm256_extract_epi64( t, 1 );
+     x[4*i+2] = ( ak_uint64 )_mm256_extract_epi64( t, 2 );
+     x[4*i+3] = ( ak_uint64 )_mm256_extract_epi64( t, 3 );
+  }
+  ak_hash_context_streebog_lps_fused( w, x );
+  for( i = 0; i < 2; i++ )
+     r[i] = _mm256_set_epi64x(( long long ) w[4*i+3], ( long long ) w[4*i+2],
+                              ( long long ) w[4*i+1], ( long long ) w[4*i] );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование G, использующее совмещенные таблицы и инструкции AVX2. */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx2" )))
+ static void ak_hash_context_streebog_g_avx2( ak_streebog ctx, ak_uint64 *n, const ak_uint64 *m )
+{
+  int idx = 0, i = 0;
+  __m256i h[2], M[2], K[2], T[2], zero = _mm256_setzero_si256();
+
+  for( i = 0; i < 2; i++ ) {
+     h[i] = _mm256_loadu_si256(( const __m256i *)( ctx->h + 4*i ));
+     M[i] = _mm256_loadu_si256(( const __m256i *)( m + 4*i ));
+     T[i] = n == NULL ? zero : _mm256_loadu_si256(( const __m256i *)( n + 4*i ));
+  }
+  ak_hash_context_streebog_lpsx_avx2( K, h, T );
+  ak_hash_context_streebog_lpsx_avx2( T, M, K );
+  for( idx = 0; idx < 12; idx++ ) {
+     __m256i C[2];
+     for( i = 0; i < 2; i++ ) C[i] = _mm256_loadu_si256(( const __m256i *)( streebog_c[idx] + 4*i ));
+     ak_hash_context_streebog_lpsx_avx2( K, K, C );
+     if( idx < 11 ) ak_hash_context_streebog_lpsx_avx2( T, T, K );
+  }
+  for( i = 0; i < 2; i++ )
+     _mm256_storeu_si256(( __m256i *)( ctx->h + 4*i ),
+            _mm256_xor_si256( _mm256_xor_si256( h[i], M[i] ), _mm256_xor_si256( T[i], K[i] )));
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вызов функции сжатия, соответствующей реализации, выбранной при создании контекста. */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_hash_context_streebog_compress( ak_streebog ctx,
+                                                               ak_uint64 *n, const ak_uint64 *m )
+{
+  switch( ctx->kernel ) {
+   #if defined( LIBAKRYPT_HAVE_BUILTIN_AVX2 ) && defined( __x86_64__ )
+    case ak_streebog_kernel_avx2: ak_hash_context_streebog_g_avx2( ctx, n, m );
+      break;
+   #endif
+   #if defined( LIBAKRYPT_HAVE_BUILTIN_XOR_SI128 ) && defined( __x86_64__ )
+    case ak_streebog_kernel_sse2: ak_hash_context_streebog_g_sse2( ctx, n, m );
+      break;
+   #endif
+    case ak_streebog_kernel_fused: ak_hash_context_streebog_g_fused( ctx, n, m );
+      break;
+    default: ak_hash_context_streebog_g( ctx, n, m );
+      break;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет таблицы преобразования LPS с совмещенной подстановкой и определяет
+    реализацию функции сжатия, используемую по умолчанию.
+    Функция должна вызываться до создания контекстов функций хеширования.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль).                            */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_streebog_init_tables( void )
+{
+  int i = 0, j = 0;
+
+  for( j = 0; j < 8; j++ )
+     for( i = 0; i < 256; i++ ) streebog_lps_table[j][i] = streebog_Areverse_expand[j][gost_pi[i]];
+
+ /* векторные реализации выполняют те же обращения к таблицам, что и реализация fused,
+    векторизуется только сложение; устойчивого выигрыша в скорости это не дает,
+    поэтому по умолчанию используется реализация fused, а реализации SSE2 и AVX2
+    выбираются только явным указанием опции streebog_kernel */
+  streebog_kernel_best = ak_streebog_kernel_fused;
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param kernel Номер реализации: \ref ak_streebog_kernel_base, \ref ak_streebog_kernel_fused,
+    \ref ak_streebog_kernel_sse2 или \ref ak_streebog_kernel_avx2.
+    \return Функция возвращает \ref ak_true, если реализация доступна.
+    В противном случае возвращается \ref ak_false.                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_streebog_kernel_is_available( const int kernel )
+{
+  switch( kernel ) {
+    case ak_streebog_kernel_base:
+    case ak_streebog_kernel_fused:
+      return ak_true;
+
+    case ak_streebog_kernel_sse2:
+   #if defined( LIBAKRYPT_HAVE_BUILTIN_XOR_SI128 ) && defined( __x86_64__ )
+      return ak_true;
+   #else
+      return ak_false;
+   #endif
+
+    case ak_streebog_kernel_avx2:
+   #if defined( LIBAKRYPT_HAVE_BUILTIN_AVX2 ) && defined( __x86_64__ ) &&\
+                                                       defined( LIBAKRYPT_HAVE_BUILTIN_CPU_SUPPORTS )
+      __builtin_cpu_init();
+      if( __builtin_cpu_supports( "avx2" )) return ak_true;
+   #endif
+      return ak_false;
+
+    default: break;
+  }
+ return ak_false;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Выбор реализации определяется опцией библиотеки `streebog_kernel`. При нулевом значении
+    опции используется реализация, выбранная при инициализации библиотеки для текущего процессора.
+    Если явно указанная реализация недоступна, то используется реализация, использующая
+    совмещенные таблицы.
+
+    @return Номер реализации функции сжатия.                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_streebog_kernel_get( void )
+{
+  int kernel = (int) ak_libakrypt_get_option( "streebog_kernel" );
+
+  if( kernel == ak_streebog_kernel_auto ) return streebog_kernel_best;
+  if( ak_streebog_kernel_is_available( kernel )) return kernel;
+ return ak_streebog_kernel_fused;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Преобразование Add (увеличение счетчика длины обработаного сообщения).                  */
 /* ----------------------------------------------------------------------------------------------- */
@@ -161,7 +441,7 @@
   if(( size - ( quot << 6 )) != 0 ) return ak_error_message( ak_error_wrong_length, __func__,
                                       "data length is not a multiple of the length of the block" );
   do{
-      ak_hash_context_streebog_g( cx, cx->n, dt );
+      ak_hash_context_streebog_compress( cx, cx->n, dt );
       ak_hash_context_streebog_add( cx, 512 );
       ak_hash_context_streebog_sadd( cx, dt );
       quot--; dt += 8;
@@ -195,11 +475,11 @@
 
   /* при финализации мы изменяем копию существующей структуры */
   memcpy( &sx, cx, sizeof( struct streebog ));
-  ak_hash_context_streebog_g( &sx, sx.n, m );
+  ak_hash_context_streebog_compress( &sx, sx.n, m );
   ak_hash_context_streebog_add( &sx, size << 3 );
   ak_hash_context_streebog_sadd( &sx, m );
-  ak_hash_context_streebog_g( &sx, NULL, sx.n );
-  ak_hash_context_streebog_g( &sx, NULL, sx.sigma );
+  ak_hash_context_streebog_compress( &sx, NULL, sx.n );
+  ak_hash_context_streebog_compress( &sx, NULL, sx.sigma );
 
  /* копируем нужную часть результирующего массива или выдаем сообщение об ошибке */
     if( cx->hsize == 64 ) memcpy( out, sx.h, ak_min( 64, out_size ));
@@ -207,6 +487,477 @@
  return result;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет хеш-код сообщения, состоящего из одного блока длины 64 октета, начиная
+    с заданного состояния функции хеширования. Исходное состояние не изменяется.
+    В отличие от последовательного вызова функций ak_hash_context_update_streebog() и
+    ak_hash_context_finalize_streebog(), функция не проверяет входные данные и не копирует
+    дополненный блок, что существенно для алгоритмов, многократно хеширующих короткие
+    сообщения (например, для итераций алгоритма PBKDF2).
+
+    @param sctx Состояние функции хеширования.
+    @param in Блок сообщения длины 64 октета.
+    @param out Массив для хеш-кода; массив может совпадать с массивом `in`.
+    Длина массива должна быть не менее 64 октетов (32 октетов для функции Стрибог256).             */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_hash_context_streebog_block( ak_streebog sctx, const ak_uint64 *in, ak_uint64 *out )
+{
+  ak_uint64 m[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  struct streebog sx;
+
+  memcpy( &sx, sctx, sizeof( struct streebog ));
+  ak_hash_context_streebog_compress( &sx, sx.n, in );
+  ak_hash_context_streebog_add( &sx, 512 );
+  ak_hash_context_streebog_sadd( &sx, in );
+
+ /* блок дополнения не содержит данных, поэтому длина сообщения не изменяется */
+  (( ak_uint8 *) m )[0] = 1;
+  ak_hash_context_streebog_compress( &sx, sx.n, m );
+  ak_hash_context_streebog_sadd( &sx, m );
+  ak_hash_context_streebog_compress( &sx, NULL, sx.n );
+  ak_hash_context_streebog_compress( &sx, NULL, sx.sigma );
+
+  if( sctx->hsize == 64 ) memcpy( out, sx.h, 64 );
+    else memcpy( out, sx.h+4, 32 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                       Режим древовидного хеширования streebog512-tree                           */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Тип первого блока листа дерева. */
+ #define ak_streebog_tree_leaf   (0)
+/*! \brief Тип первого блока внутреннего узла дерева. */
+ #define ak_streebog_tree_node   (1)
+/*! \brief Тип первого блока вычисления результата. */
+ #define ak_streebog_tree_root   (2)
+
+/*! \brief Длина фрагмента файла, считываемого потоком за одно обращение. */
+ #define ak_streebog_tree_read_size   (65536)
+/*! \brief Количество листьев, обрабатываемых одним потоком за один проход. */
+ #define ak_streebog_tree_batch       (64)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Начало вычисления хеш-кода листа, внутреннего узла или результата.
+    \details Хеш-код каждого элемента дерева вычисляется функцией Стрибог512 от данных,
+    которым предшествует блок длины 64 октета. Нулевой октет блока содержит тип элемента,
+    первый октет - количество потомков внутреннего узла, октеты с 8 по 15 - длину листа
+    (младшие разряды вперед), остальные октеты равны нулю. Тем самым хеш-коды элементов
+    различных типов, а также деревьев с различной длиной листа, не совпадают.                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_context_streebog_tree_start( ak_streebog sctx,
+                                                     const ak_uint8 type, const size_t leaf_size )
+{
+  size_t i = 0;
+  ak_uint64 block[8];
+  ak_uint8 *ptr = ( ak_uint8 *) block;
+
+  memset( block, 0, 64 );
+  ptr[0] = type;
+  ptr[1] = ak_streebog_tree_fanout;
+  for( i = 0; i < 8; i++ ) ptr[8+i] = ( ak_uint8 )(( ak_uint64 ) leaf_size >> ( 8*i ));
+
+  sctx->hsize = 64;
+  ak_hash_context_clean_streebog( sctx );
+  ak_hash_context_update_streebog( sctx, block, 64 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Добавление хеш-кода потомка к узлу заданного уровня дерева.
+    \details Узел, получивший \ref ak_streebog_tree_fanout потомков, завершается сразу,
+    и его хеш-код добавляется к узлу следующего уровня.                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_context_streebog_tree_push( ak_streebog_tree tree,
+                                                           size_t level, const ak_uint64 *hash )
+{
+  ak_uint64 node[8];
+
+  while( level < ak_streebog_tree_max_levels ) {
+     ak_streebog_tree_level lv = tree->levels + level;
+
+     if( lv->count == 0 ) {
+       lv->sctx.kernel = tree->sctx.kernel;
+       ak_hash_context_streebog_tree_start( &lv->sctx, ak_streebog_tree_node, tree->leaf_size );
+       memcpy( lv->child, hash, 64 );
+     }
+     ak_hash_context_update_streebog( &lv->sctx, ( ak_pointer ) hash, 64 );
+     if( ++lv->count < ak_streebog_tree_fanout ) return;
+
+     ak_hash_context_finalize_streebog( &lv->sctx, NULL, 0, node, 64 );
+     lv->count = 0;
+     hash = node;
+     level++;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Завершение текущего листа дерева и начало следующего листа. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_context_streebog_tree_next_leaf( ak_streebog_tree tree )
+{
+  ak_uint64 leaf[8];
+
+  ak_hash_context_finalize_streebog( &tree->sctx, NULL, 0, leaf, 64 );
+  ak_hash_context_streebog_tree_push( tree, 0, leaf );
+  ak_hash_context_streebog_tree_start( &tree->sctx, ak_streebog_tree_leaf, tree->leaf_size );
+  tree->leaf_fill = 0;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_context_clean_streebog_tree( ak_pointer tctx )
+{
+  size_t i = 0;
+  ak_streebog_tree tree = ( ak_streebog_tree ) tctx;
+  if( tree == NULL ) return ak_error_null_pointer;
+
+  for( i = 0; i < ak_streebog_tree_max_levels; i++ ) tree->levels[i].count = 0;
+  ak_hash_context_streebog_tree_start( &tree->sctx, ak_streebog_tree_leaf, tree->leaf_size );
+  tree->leaf_fill = 0;
+  tree->total = 0;
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_context_update_streebog_tree( ak_pointer tctx,
+                                                          const ak_pointer in, const size_t size )
+{
+  size_t len = 0, rest = size;
+  const ak_uint8 *ptr = ( const ak_uint8 *) in;
+  ak_streebog_tree tree = ( ak_streebog_tree ) tctx;
+
+  if( tree == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                "using null pointer to internal tree context" );
+  if(( !size ) || ( in == NULL )) return ak_error_ok;
+  if( size&0x3f ) return ak_error_message( ak_error_wrong_length, __func__,
+                                      "data length is not a multiple of the length of the block" );
+  while( rest > 0 ) {
+    /* лист завершается только тогда, когда известно, что за ним следуют данные */
+     if( tree->leaf_fill == tree->leaf_size ) ak_hash_context_streebog_tree_next_leaf( tree );
+     len = ak_min( rest, tree->leaf_size - tree->leaf_fill );
+     ak_hash_context_update_streebog( &tree->sctx, ( ak_pointer ) ptr, len );
+     tree->leaf_fill += len;
+     tree->total += len;
+     ptr += len; rest -= len;
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \details Результат вычисляется для копии состояния, поэтому функция может повторно
+    вызываться к текущему состоянию контекста.                                                     */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_context_finalize_streebog_tree( ak_pointer tctx,
+                   const ak_pointer in, const size_t size, ak_pointer out, const size_t out_size )
+{
+  size_t i = 0, level = 0;
+  ak_uint64 node[8], tail[8], *top = NULL;
+  struct streebog root;
+  struct streebog_tree tx;
+  struct streebog_tree_level lv[ak_streebog_tree_max_levels];
+  ak_streebog_tree tree = ( ak_streebog_tree ) tctx;
+
+  if( tree == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                "using null pointer to internal tree context" );
+  if( out == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using null pointer to externl result buffer" );
+  if( size >= 64 ) return ak_error_message( ak_error_wrong_length, __func__,
+                                                                      "input length is too huge" );
+ /* при финализации мы изменяем копию существующей структуры */
+  memcpy( &tx, tree, sizeof( struct streebog_tree ));
+  memcpy( lv, tree->levels, sizeof( lv ));
+  tx.levels = lv;
+
+ /* завершаем последний лист; пустые данные образуют один пустой лист */
+  if(( size > 0 ) && ( tx.leaf_fill == tx.leaf_size ))
+    ak_hash_context_streebog_tree_next_leaf( &tx );
+  tx.total += size;
+  if(( tx.leaf_fill > 0 ) || ( size > 0 ) || ( tx.total == 0 )) {
+    ak_hash_context_finalize_streebog( &tx.sctx, in, size, node, 64 );
+    ak_hash_context_streebog_tree_push( &tx, 0, node );
+  }
+
+ /* завершаем незаполненные узлы, начиная с нижнего уровня; вершиной дерева является
+    единственный потомок самого верхнего из незавершенных узлов */
+  for( level = 0; level < ak_streebog_tree_max_levels; level++ ) {
+     bool_t higher = ak_false;
+     if( lv[level].count == 0 ) continue;
+     for( i = level+1; i < ak_streebog_tree_max_levels; i++ ) if( lv[i].count ) higher = ak_true;
+     if(( !higher ) && ( lv[level].count == 1 )) {
+       top = lv[level].child;
+       break;
+     }
+     ak_hash_context_finalize_streebog( &lv[level].sctx, NULL, 0, node, 64 );
+     lv[level].count = 0;
+     if( level+1 < ak_streebog_tree_max_levels )
+       ak_hash_context_streebog_tree_push( &tx, level+1, node );
+  }
+  if( top == NULL ) return ak_error_message( ak_error_wrong_length, __func__,
+                                                                 "data length is too huge" );
+
+ /* результат: хеш-код вершины дерева и общей длины данных */
+  for( i = 0; i < 8; i++ ) (( ak_uint8 *) tail )[i] = ( ak_uint8 )( tx.total >> ( 8*i ));
+  root.kernel = tree->sctx.kernel;
+  ak_hash_context_streebog_tree_start( &root, ak_streebog_tree_root, tx.leaf_size );
+  ak_hash_context_update_streebog( &root, top, 64 );
+ return ak_hash_context_finalize_streebog( &root, tail, 8, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Описание последовательности листьев, обрабатываемой одним потоком. */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct streebog_tree_range {
+  /*! \brief Данные, расположенные в памяти (NULL, если данные считываются из файла). */
+   const ak_uint8 *in;
+  /*! \brief Файл, из которого считываются данные. */
+   ak_file file;
+  /*! \brief Буффер для считывания данных из файла. */
+   ak_uint8 *buffer;
+  /*! \brief Смещение первого листа от начала данных (в октетах). */
+   ak_uint64 offset;
+  /*! \brief Количество листьев. */
+   size_t count;
+  /*! \brief Длина листа (в октетах). */
+   size_t leaf_size;
+  /*! \brief Реализация функции сжатия. */
+   int kernel;
+  /*! \brief Массив для хеш-кодов листьев. */
+   ak_uint64 *out;
+  /*! \brief Код ошибки. */
+   int error;
+ #ifdef LIBAKRYPT_HAVE_PTHREAD
+  /*! \brief Поток, обрабатывающий листья. */
+   pthread_t thread;
+ #endif
+} *ak_streebog_tree_range;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вычисляет хеш-коды последовательных полных листьев. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_streebog_tree_range_leaves( void *ptr )
+{
+  size_t i = 0, done = 0, len = 0;
+  struct streebog sctx;
+  ak_streebog_tree_range range = ( ak_streebog_tree_range ) ptr;
+
+  sctx.kernel = range->kernel;
+  for( i = 0; i < range->count; i++ ) {
+     ak_uint64 offset = range->offset + i*range->leaf_size;
+
+     ak_hash_context_streebog_tree_start( &sctx, ak_streebog_tree_leaf, range->leaf_size );
+     if( range->in != NULL )
+       ak_hash_context_update_streebog( &sctx, ( ak_pointer )( range->in + offset ),
+                                                                              range->leaf_size );
+      else
+       for( done = 0; done < range->leaf_size; done += len ) {
+          len = ak_min( range->leaf_size - done, ak_streebog_tree_read_size );
+          if( ak_file_read_at( range->file, range->buffer, len,
+                                         ( ak_int64 )( offset + done )) != ( ssize_t ) len ) {
+            range->error = ak_error_read_data;
+            return NULL;
+          }
+          ak_hash_context_update_streebog( &sctx, range->buffer, len );
+       }
+     ak_hash_context_finalize_streebog( &sctx, NULL, 0, range->out + 8*i, 64 );
+  }
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество потоков, вычисляющих листья дерева.
+    \details Количество определяется опцией библиотеки `hash_thread_count`; нулевое значение
+    опции означает использование всех доступных процессоров.                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static size_t ak_hash_context_streebog_tree_threads( const size_t leaves )
+{
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  ak_int64 count = ak_libakrypt_get_option( "hash_thread_count" );
+
+  if( count <= 0 ) {
+   #if defined( LIBAKRYPT_HAVE_UNISTD_H ) && defined( _SC_NPROCESSORS_ONLN )
+    count = (ak_int64) sysconf( _SC_NPROCESSORS_ONLN );
+   #else
+    count = 1;
+   #endif
+  }
+  if( count > ak_streebog_tree_max_threads ) count = ak_streebog_tree_max_threads;
+  if( count > (ak_int64) leaves ) count = (ak_int64) leaves;
+ return count < 1 ? 1 : (size_t) count;
+#else
+  (void) leaves;
+ return 1;
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вычисляет хеш-коды всех полных листьев, кроме последнего, в нескольких потоках
+    и добавляет их в дерево.
+
+    Листья обрабатываются порциями: каждый поток вычисляет до \ref ak_streebog_tree_batch
+    последовательных листьев, после чего хеш-коды добавляются в дерево в исходном порядке.
+    Данные считываются либо из памяти, либо из файла с помощью функции ak_file_read_at(),
+    при этом каждый поток использует собственный буффер.
+
+    @param hctx Контекст режима streebog512-tree.
+    @param in Данные, расположенные в памяти, или NULL.
+    @param file Файл, открытый на чтение (используется, если in равен NULL).
+    @param size Общая длина данных.
+    @return Количество обработанных октетов или ноль в случае ошибки; в последнем случае
+    код ошибки может быть получен с помощью вызова функции ak_error_get_value().                   */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint64 ak_hash_context_streebog_tree_leaves( ak_hash hctx,
+                                    const ak_uint8 *in, ak_file file, const ak_uint64 size )
+{
+  ak_uint64 *hashes = NULL;
+  size_t i = 0, j = 0, threads = 0, count = 0;
+  int error = ak_error_ok;
+  ak_streebog_tree tree = &hctx->data.tctx;
+  struct streebog_tree_range ranges[ak_streebog_tree_max_threads];
+ #ifdef LIBAKRYPT_HAVE_PTHREAD
+  bool_t started[ak_streebog_tree_max_threads];
+ #endif
+ /* последний лист, в том числе полный, обрабатывается функцией finalize */
+  ak_uint64 leaves = size > 0 ? ( size - 1 )/tree->leaf_size : 0, offset = 0;
+
+  if( leaves == 0 ) return 0;
+  threads = ak_hash_context_streebog_tree_threads(( size_t ) ak_min( leaves,
+                                                               ak_streebog_tree_max_threads ));
+  if(( hashes = malloc( threads*ak_streebog_tree_batch*64 )) == NULL ) {
+    ak_error_message( ak_error_out_of_memory, __func__, "memory allocation error for leaves" );
+    return 0;
+  }
+  memset( ranges, 0, sizeof( ranges ));
+  for( i = 0; i < threads; i++ ) {
+     ranges[i].in = in;
+     ranges[i].file = file;
+     ranges[i].leaf_size = tree->leaf_size;
+     ranges[i].kernel = tree->sctx.kernel;
+     ranges[i].out = hashes + 8*i*ak_streebog_tree_batch;
+     if(( in == NULL ) &&
+        (( ranges[i].buffer = malloc( ak_streebog_tree_read_size )) == NULL )) {
+       error = ak_error_message( ak_error_out_of_memory, __func__,
+                                                        "memory allocation error for buffer" );
+       goto labex;
+     }
+  }
+
+  while( offset < leaves*tree->leaf_size ) {
+    /* распределяем очередную порцию листьев между потоками */
+     ak_uint64 rest = leaves - offset/tree->leaf_size;
+     for( i = 0, count = 0; i < threads; i++ ) {
+        ranges[i].offset = offset + count*tree->leaf_size;
+        ranges[i].count = ( size_t ) ak_min( rest - ak_min( rest, count ),
+                                                                     ak_streebog_tree_batch );
+        count += ranges[i].count;
+     }
+   #ifdef LIBAKRYPT_HAVE_PTHREAD
+     for( i = 1; i < threads; i++ )
+        started[i] = ( ranges[i].count > 0 ) && ( pthread_create( &ranges[i].thread, NULL,
+                                                  ak_streebog_tree_range_leaves, ranges+i ) == 0 );
+     ak_streebog_tree_range_leaves( ranges );
+     for( i = 1; i < threads; i++ ) {
+        if( started[i] ) pthread_join( ranges[i].thread, NULL );
+          else ak_streebog_tree_range_leaves( ranges+i );
+     }
+   #else
+     for( i = 0; i < threads; i++ ) ak_streebog_tree_range_leaves( ranges+i );
+   #endif
+
+    /* добавляем хеш-коды листьев в дерево в исходном порядке */
+     for( i = 0; i < threads; i++ ) {
+        if(( error = ranges[i].error ) != ak_error_ok ) {
+          ak_error_message( error, __func__, "incorrect reading of file data" );
+          goto labex;
+        }
+        for( j = 0; j < ranges[i].count; j++ )
+           ak_hash_context_streebog_tree_push( tree, 0, ranges[i].out + 8*j );
+     }
+     offset += count*tree->leaf_size;
+  }
+  tree->total = offset;
+
+  labex:
+   for( i = 0; i < threads; i++ ) if( ranges[i].buffer != NULL ) free( ranges[i].buffer );
+   free( hashes );
+   if( error != ak_error_ok ) return 0;
+ return offset;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Хеширование области памяти в режиме streebog512-tree с вычислением листьев
+    в нескольких потоках. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_context_streebog_tree_ptr( ak_hash hctx, const ak_pointer in,
+                                         const size_t size, ak_pointer out, const size_t out_size )
+{
+  int error = ak_error_ok;
+  ak_uint64 done = 0;
+
+  if(( in == NULL ) && ( size > 0 )) return ak_error_message( ak_error_null_pointer, __func__,
+                                                                 "using null pointer to data" );
+  if(( error = ak_mac_context_clean( &hctx->mctx )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect cleaning of mac context" );
+  ak_error_set_value( ak_error_ok );
+  if((( done = ak_hash_context_streebog_tree_leaves( hctx, in, NULL, size )) == 0 ) &&
+                                                ( ak_error_get_value() != ak_error_ok ))
+    return ak_error_message( ak_error_get_value(), __func__, "incorrect hashing of leaves" );
+
+ return ak_mac_context_finalize( &hctx->mctx, ( ak_uint8 *) in + done,
+                                                       size - ( size_t ) done, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Хеширование файла в режиме streebog512-tree с вычислением листьев
+    в нескольких потоках. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_context_streebog_tree_file( ak_hash hctx, const char *filename,
+                                                           ak_pointer out, const size_t out_size )
+{
+  struct file file;
+  ak_uint64 done = 0;
+  ak_uint8 *buffer = NULL;
+  size_t len = 0, rest = 0;
+  int error = ak_error_ok;
+
+  if( filename == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                                "use a null pointer to filename" );
+  if(( error = ak_mac_context_clean( &hctx->mctx )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect cleaning a mac context");
+  if(( error = ak_file_open_to_read( &file, filename )) != ak_error_ok )
+    return ak_error_message_fmt( error, __func__, "incorrect access to file %s", filename );
+
+  ak_error_set_value( ak_error_ok );
+  done = ak_hash_context_streebog_tree_leaves( hctx, NULL, &file, ( ak_uint64 ) file.size );
+  if(( done == 0 ) && ( ak_error_get_value() != ak_error_ok )) {
+    error = ak_error_message( ak_error_get_value(), __func__, "incorrect hashing of leaves" );
+    goto labex;
+  }
+  if(( buffer = malloc( ak_streebog_tree_read_size )) == NULL ) {
+    error = ak_error_message( ak_error_out_of_memory, __func__ ,
+                                                      "memory allocation error for local buffer" );
+    goto labex;
+  }
+
+ /* последний лист считывается и обрабатывается последовательно */
+  rest = ( size_t )(( ak_uint64 ) file.size - done );
+  do{
+     len = ak_min( rest, ak_streebog_tree_read_size );
+     if( ak_file_read_at( &file, buffer, len, ( ak_int64 ) done ) != ( ssize_t ) len ) {
+       error = ak_error_message_fmt( ak_error_read_data, __func__,
+                                                    "incorrect reading of file %s", filename );
+       goto labex;
+     }
+     done += len; rest -= len;
+     if( rest > 0 ) error = ak_mac_context_update( &hctx->mctx, buffer, len );
+       else error = ak_mac_context_finalize( &hctx->mctx, buffer, len, out, out_size );
+  } while(( rest > 0 ) && ( error == ak_error_ok ));
+
+  labex:
+   if( buffer != NULL ) free( buffer );
+   ak_file_close( &file );
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                               Реализация функция класса hash                                    */
 /* ----------------------------------------------------------------------------------------------- */
@@ -222,6 +973,7 @@
   if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                             "using null pointer to hash context" );
   hctx->data.sctx.hsize = 32;
+  hctx->data.sctx.kernel = ak_streebog_kernel_get();
   if(( hctx->oid = ak_oid_context_find_by_name( "streebog256" )) == NULL )
     return ak_error_message( ak_error_wrong_oid, __func__,
                                            "incorrect internal search of streebog256 identifier" );
@@ -247,6 +999,7 @@
   if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                             "using null pointer to hash context" );
   hctx->data.sctx.hsize = 64;
+  hctx->data.sctx.kernel = ak_streebog_kernel_get();
   if(( hctx->oid = ak_oid_context_find_by_name( "streebog512" )) == NULL )
     return ak_error_message( ak_error_wrong_oid, __func__,
                                            "incorrect internal search of streebog256 identifier" );
@@ -259,6 +1012,57 @@
   return ak_hash_context_clean_streebog( &hctx->data.sctx );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция инициализирует контекст режима древовидного хеширования streebog512-tree.
+    Данные разбиваются на листья, длина которых определяется опцией библиотеки
+    `streebog_tree_leaf_size` в момент создания контекста (по умолчанию 1 Мбайт). Хеш-коды листьев
+    и внутренних узлов дерева, имеющих не более \ref ak_streebog_tree_fanout потомков,
+    вычисляются функцией Стрибог512 с различными блоками-префиксами. Узлы образуются
+    из последовательных групп элементов предыдущего уровня, последняя группа может быть неполной;
+    уровни строятся до тех пор, пока не останется единственный элемент - вершина дерева.
+    Результатом является хеш-код вершины дерева и общей длины данных.
+
+    Функции ak_hash_context_ptr() и ak_hash_context_file() вычисляют хеш-коды листьев
+    одновременно в нескольких потоках, количество которых определяется опцией
+    `hash_thread_count`. Функции ak_hash_context_update() и ak_hash_context_finalize()
+    обрабатывают данные последовательно, результат вычислений при этом не изменяется.
+
+    @param hctx Контекст функции хеширования
+    @return Функция возвращает код ошибки или \ref ak_error_ok (в случае успеха)                   */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_create_streebog512_tree( ak_hash hctx )
+{
+  int error = ak_error_ok;
+  ak_int64 leaf_size = ak_libakrypt_get_option( "streebog_tree_leaf_size" );
+
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hash context" );
+  if(( leaf_size < 64 ) || ( leaf_size > 1073741824 ) || ( leaf_size&0x3f ))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                         "using wrong length of tree leaves" );
+  memset( &hctx->data, 0, sizeof( hctx->data ));
+  hctx->data.tctx.sctx.hsize = 64;
+  hctx->data.tctx.sctx.kernel = ak_streebog_kernel_get();
+  hctx->data.tctx.leaf_size = ( size_t ) leaf_size;
+  if(( hctx->oid = ak_oid_context_find_by_name( "streebog512-tree" )) == NULL )
+    return ak_error_message( ak_error_wrong_oid, __func__,
+                                      "incorrect internal search of streebog512-tree identifier" );
+  if(( hctx->data.tctx.levels = malloc( ak_streebog_tree_max_levels*
+                                            sizeof( struct streebog_tree_level ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                                     "memory allocation error for tree levels" );
+  if(( error = ak_mac_context_create( &hctx->mctx, 64, &hctx->data.tctx,
+                                         ak_hash_context_clean_streebog_tree,
+                                         ak_hash_context_update_streebog_tree,
+                                         ak_hash_context_finalize_streebog_tree )) != ak_error_ok ) {
+    free( hctx->data.tctx.levels );
+    hctx->data.tctx.levels = NULL;
+    return ak_error_message( error, __func__, "incorrect initialization of internal mac context" );
+  }
+
+ return ak_hash_context_clean_streebog_tree( &hctx->data.tctx );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! В случае инициализации контекста алгоритма ГОСТ Р 34.11-94 (в настоящее время выведен из
     действия) используются фиксированные таблицы замен, определяемые константой
@@ -309,7 +1113,10 @@
   if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                        "destroying null pointer to hash context" );
   hctx->oid = NULL;
-  memset( &hctx->data.sctx, 0, sizeof( struct streebog ));
+  if(( hctx->mctx.update == ak_hash_context_update_streebog_tree ) &&
+                                                          ( hctx->data.tctx.levels != NULL ))
+    free( hctx->data.tctx.levels );
+  memset( &hctx->data, 0, sizeof( hctx->data ));
   if( ak_mac_context_destroy( &hctx->mctx ) != ak_error_ok )
     ak_error_message( ak_error_get_value(), __func__,
                                                     "incorrect cleaning of internal mac context" );
@@ -382,9 +1189,262 @@
 {
   if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                             "using null pointer to hash context" );
+  if( hctx->mctx.update == ak_hash_context_update_streebog_tree )
+    return ak_hash_context_streebog_tree_ptr( hctx, in, size, out, out_size );
  return ak_mac_context_ptr( &hctx->mctx, in, size, out, out_size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                    Одновременное хеширование нескольких независимых сообщений                   */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество сообщений, обрабатываемых за один проход функции сжатия
+    (реализация, использующая инструкции AVX2, рассчитана ровно на четыре сообщения). */
+ #define ak_streebog_lanes_count (4)
+
+/*! \brief Нулевой вектор, используемый вместо вектора n на последних шагах хеширования. */
+ static const ak_uint64 streebog_zero[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+/*! \brief Состояние одного из одновременно обрабатываемых сообщений. */
+ struct streebog_lane {
+  /*! \brief Текущее состояние функции хеширования */
+   struct streebog sctx;
+  /*! \brief Обрабатываемое сообщение (NULL, если дорожка свободна) */
+   ak_hash_job job;
+  /*! \brief Указатель на очередной полный блок сообщения */
+   const ak_uint8 *ptr;
+  /*! \brief Количество необработанных полных блоков */
+   size_t blocks;
+  /*! \brief Шаг обработки: 0 - полные блоки, 1 - дополненный блок, 2 - длина, 3 - сумма */
+   int step;
+  /*! \brief Дополненный последний блок сообщения */
+   ak_uint64 m[8];
+ };
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование G, выполняемое одновременно для нескольких независимых состояний.
+    \details Вычисления для различных состояний не зависят друг от друга, поэтому задержки
+    обращений к таблицам одного состояния перекрываются вычислениями для других состояний.         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_context_streebog_g_lanes( ak_streebog *ctx,
+                                                   const ak_uint64 **n, const ak_uint64 **m )
+{
+  int idx = 0, i = 0, l = 0;
+  ak_uint64 K[ak_streebog_lanes_count][8], T[ak_streebog_lanes_count][8], B[8];
+
+  for( l = 0; l < ak_streebog_lanes_count; l++ ) {
+     for( i = 0; i < 8; i++ ) B[i] = ctx[l]->h[i] ^ n[l][i];
+     ak_hash_context_streebog_lps_fused( K[l], B );
+     for( i = 0; i < 8; i++ ) B[i] = m[l][i] ^ K[l][i];
+     ak_hash_context_streebog_lps_fused( T[l], B );
+  }
+  for( idx = 0; idx < 11; idx++ ) {
+     for( l = 0; l < ak_streebog_lanes_count; l++ ) {
+        for( i = 0; i < 8; i++ ) B[i] = K[l][i] ^ streebog_c[idx][i];
+        ak_hash_context_streebog_lps_fused( K[l], B );
+        for( i = 0; i < 8; i++ ) B[i] = T[l][i] ^ K[l][i];
+        ak_hash_context_streebog_lps_fused( T[l], B );
+     }
+  }
+  for( l = 0; l < ak_streebog_lanes_count; l++ ) {
+     for( i = 0; i < 8; i++ ) B[i] = K[l][i] ^ streebog_c[11][i];
+     ak_hash_context_streebog_lps_fused( K[l], B );
+     for( i = 0; i < 8; i++ ) ctx[l]->h[i] ^= T[l][i] ^ K[l][i] ^ m[l][i];
+  }
+}
+
+#if defined( LIBAKRYPT_HAVE_BUILTIN_AVX2 ) && defined( __x86_64__ )
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование LPS, выполняемое одновременно для четырех состояний.
+    \details Регистр x[j] содержит j-е слова четырех состояний; каждое обращение к таблице
+    выполняется одной инструкцией gather сразу для всех четырех состояний.                         */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx2" )))
+ static inline void ak_hash_context_streebog_lps_lanes_avx2( __m256i *r, const __m256i *x )
+{
+  int i = 0, j = 0;
+  const __m256i mask = _mm256_set1_epi64x( 0xff );
+
+  for( i = 0; i < 8; i++ ) {
+     __m256i c = _mm256_setzero_si256();
+     for( j = 0; j < 8; j++ )
+        c = _mm256_xor_si256( c, _mm256_i64gather_epi64(( const long long *) streebog_lps_table[j],
+                             _mm256_and_si256( _mm256_srli_epi64( x[j], 8*i ), mask ), 8 ));
+     r[i] = c;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование G, выполняемое одновременно для четырех состояний с помощью
+    инструкций AVX2.                                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx2" )))
+ static void ak_hash_context_streebog_g_lanes_avx2( ak_streebog *ctx,
+                                                   const ak_uint64 **n, const ak_uint64 **m )
+{
+  int idx = 0, i = 0;
+  __m256i h[8], M[8], K[8], T[8], B[8];
+
+  for( i = 0; i < 8; i++ ) {
+     h[i] = _mm256_set_epi64x(( long long ) ctx[3]->h[i], ( long long ) ctx[2]->h[i],
+                              ( long long ) ctx[1]->h[i], ( long long ) ctx[0]->h[i] );
+     M[i] = _mm256_set_epi64x(( long long ) m[3][i], ( long long ) m[2][i],
+                              ( long long ) m[1][i], ( long long ) m[0][i] );
+     B[i] = _mm256_xor_si256( h[i], _mm256_set_epi64x(( long long ) n[3][i],
+                      ( long long ) n[2][i], ( long long ) n[1][i], ( long long ) n[0][i] ));
+  }
+  ak_hash_context_streebog_lps_lanes_avx2( K, B );
+  for( i = 0; i < 8; i++ ) B[i] = _mm256_xor_si256( M[i], K[i] );
+  ak_hash_context_streebog_lps_lanes_avx2( T, B );
+  for( idx = 0; idx < 12; idx++ ) {
+     for( i = 0; i < 8; i++ )
+        B[i] = _mm256_xor_si256( K[i], _mm256_set1_epi64x(( long long ) streebog_c[idx][i] ));
+     ak_hash_context_streebog_lps_lanes_avx2( K, B );
+     if( idx == 11 ) break;
+     for( i = 0; i < 8; i++ ) B[i] = _mm256_xor_si256( T[i], K[i] );
+     ak_hash_context_streebog_lps_lanes_avx2( T, B );
+  }
+  for( i = 0; i < 8; i++ ) {
+     ak_uint64 w[4];
+     _mm256_storeu_si256(( __m256i *) w,
+            _mm256_xor_si256( _mm256_xor_si256( h[i], M[i] ), _mm256_xor_si256( T[i], K[i] )));
+     ctx[0]->h[i] = w[0]; ctx[1]->h[i] = w[1]; ctx[2]->h[i] = w[2]; ctx[3]->h[i] = w[3];
+  }
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Формирование дополненного последнего блока сообщения. */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_hash_context_streebog_lane_pad( struct streebog_lane *lane )
+{
+  size_t tail = lane->job->size&0x3f;
+
+  memset( lane->m, 0, 64 );
+  if( tail ) memcpy( lane->m, lane->ptr, tail );
+  (( ak_uint8 *) lane->m )[tail] = 1;
+  lane->step = 1;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет хеш-коды нескольких независимых сообщений. Сообщения распределяются
+    по \ref ak_streebog_lanes_count дорожкам, состояния которых обрабатываются функцией
+    сжатия одновременно; как только сообщение на одной из дорожек полностью обработано,
+    его место занимает следующее сообщение. Сообщения могут иметь произвольные различные длины,
+    завершающие шаги хеширования каждого сообщения также выполняются одновременно с обработкой
+    других сообщений. Результат совпадает с результатом вызова функции ak_hash_context_ptr()
+    для каждого сообщения.
+
+    Контекст hctx определяет только алгоритм хеширования (Стрибог256 или Стрибог512),
+    его текущее состояние не используется и не изменяется. Значение опции `streebog_kernel`
+    не учитывается: если процессор поддерживает инструкции AVX2, то обращения к таблицам
+    выполняются инструкциями gather сразу для четырех сообщений, в противном случае
+    используется реализация с совмещенными таблицами.
+
+    @param hctx Контекст функции хеширования.
+    @param jobs Массив описаний сообщений; область памяти для хеш-кода каждого сообщения
+    должна иметь размер не менее значения, возвращаемого функцией ak_hash_context_get_tag_size().
+    @param count Количество сообщений.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_ptr_jobs( ak_hash hctx, ak_hash_job jobs, const size_t count )
+{
+  int l = 0;
+  size_t next = 0, active = 0;
+  struct streebog idle;
+  struct streebog_lane lane[ak_streebog_lanes_count];
+  ak_streebog sx[ak_streebog_lanes_count];
+  const ak_uint64 *n[ak_streebog_lanes_count], *m[ak_streebog_lanes_count];
+ #if defined( LIBAKRYPT_HAVE_BUILTIN_AVX2 ) && defined( __x86_64__ )
+  bool_t avx2 = ak_streebog_kernel_is_available( ak_streebog_kernel_avx2 );
+ #endif
+
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hash context" );
+  if( hctx->mctx.update != ak_hash_context_update_streebog )
+    return ak_error_message( ak_error_undefined_function, __func__,
+                                                 "multi-buffer hashing supports only streebog" );
+  if( count == 0 ) return ak_error_ok;
+  if( jobs == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                               "using null pointer to jobs array" );
+  for( next = 0; next < count; next++ ) {
+     if((( jobs[next].in == NULL ) && ( jobs[next].size > 0 )) || ( jobs[next].out == NULL ))
+       return ak_error_message_fmt( ak_error_null_pointer, __func__,
+                                         "using null pointer in job %u", (unsigned int) next );
+  }
+
+  memset( &idle, 0, sizeof( struct streebog ));
+  for( l = 0; l < ak_streebog_lanes_count; l++ ) lane[l].job = NULL;
+  next = 0;
+
+  for( ;; ) {
+    /* заполняем свободные дорожки очередными сообщениями */
+     for( l = 0; l < ak_streebog_lanes_count; l++ ) {
+        if(( lane[l].job != NULL ) || ( next >= count )) continue;
+        lane[l].job = jobs + next++;
+        lane[l].sctx.hsize = hctx->data.sctx.hsize;
+        lane[l].sctx.kernel = ak_streebog_kernel_fused;
+        ak_hash_context_clean_streebog( &lane[l].sctx );
+        lane[l].ptr = ( const ak_uint8 *) lane[l].job->in;
+        if(( lane[l].blocks = lane[l].job->size >> 6 ) == 0 )
+          ak_hash_context_streebog_lane_pad( lane+l );
+         else lane[l].step = 0;
+        active++;
+     }
+     if( active == 0 ) break;
+
+    /* выбираем аргументы функции сжатия для каждой дорожки */
+     for( l = 0; l < ak_streebog_lanes_count; l++ ) {
+        if( lane[l].job == NULL ) {
+          sx[l] = &idle; n[l] = m[l] = streebog_zero;
+          continue;
+        }
+        sx[l] = &lane[l].sctx;
+        switch( lane[l].step ) {
+          case 0: n[l] = lane[l].sctx.n; m[l] = ( const ak_uint64 *) lane[l].ptr; break;
+          case 1: n[l] = lane[l].sctx.n; m[l] = lane[l].m; break;
+          case 2: n[l] = streebog_zero; m[l] = lane[l].sctx.n; break;
+          default: n[l] = streebog_zero; m[l] = lane[l].sctx.sigma; break;
+        }
+     }
+    #if defined( LIBAKRYPT_HAVE_BUILTIN_AVX2 ) && defined( __x86_64__ )
+     if( avx2 ) ak_hash_context_streebog_g_lanes_avx2( sx, n, m );
+       else
+    #endif
+     ak_hash_context_streebog_g_lanes( sx, n, m );
+
+    /* изменяем счетчики и переходим к следующему шагу */
+     for( l = 0; l < ak_streebog_lanes_count; l++ ) {
+        if( lane[l].job == NULL ) continue;
+        switch( lane[l].step ) {
+          case 0:
+            ak_hash_context_streebog_add( &lane[l].sctx, 512 );
+            ak_hash_context_streebog_sadd( &lane[l].sctx, m[l] );
+            lane[l].ptr += 64;
+            if( --lane[l].blocks == 0 ) ak_hash_context_streebog_lane_pad( lane+l );
+            break;
+          case 1:
+            ak_hash_context_streebog_add( &lane[l].sctx, ( lane[l].job->size&0x3f ) << 3 );
+            ak_hash_context_streebog_sadd( &lane[l].sctx, lane[l].m );
+            lane[l].step = 2;
+            break;
+          case 2:
+            lane[l].step = 3;
+            break;
+          default:
+            if( lane[l].sctx.hsize == 64 ) memcpy( lane[l].job->out, lane[l].sctx.h, 64 );
+              else memcpy( lane[l].job->out, lane[l].sctx.h+4, 32 );
+            lane[l].job = NULL;
+            active--;
+            break;
+        }
+     }
+  }
+
+ return ak_error_ok;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! @param hctx Контекст функции хеширования
     @param filename Имя файла, для котрого вычисляется хеш-код.
@@ -401,6 +1461,8 @@
 {
   if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                             "using null pointer to hash context" );
+  if( hctx->mctx.update == ak_hash_context_update_streebog_tree )
+    return ak_hash_context_streebog_tree_file( hctx, filename, out, out_size );
  return ak_mac_context_file( &hctx->mctx, filename, out, out_size );
 }
 
@@ -452,6 +1514,429 @@
  return ak_mac_context_finalize( &hctx->mctx, in, size, out, out_size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param hctx Контекст функции хеширования
+    @param fragments Массив фрагментов входных данных; результат совпадает с обработкой
+    данных, полученных объединением фрагментов.
+    @param count Количество фрагментов.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_update_fragments( ak_hash hctx, ak_fragment fragments, const size_t count )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                         "updating null pointer to hash context" );
+ return ak_mac_context_update_fragments( &hctx->mctx, fragments, count );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param hctx Контекст функции хеширования
+    @param fragments Массив фрагментов входных данных, для которых вычисляется хеш-код.
+    @param count Количество фрагментов.
+    @param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    @param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_finalize_fragments( ak_hash hctx, ak_fragment fragments, const size_t count,
+                                                           ak_pointer out, const size_t out_size )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                       "finalizing null pointer to hash context" );
+ return ak_mac_context_finalize_fragments( &hctx->mctx, fragments, count, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                 Копирование, сохранение и восстановление промежуточного состояния               */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Версия формата, в котором сохраняется промежуточное состояние функции хеширования. */
+ #define ak_hash_state_version        (1)
+/*! \brief Длина векторов h, n и \f$ \Sigma \f$ функции Стрибог (в октетах). */
+ #define ak_hash_state_vectors_size   (192)
+
+/*! \brief Сигнатура, с которой начинается сохраненное состояние. */
+ static const ak_uint8 ak_hash_state_signature[4] = { 'a', 'k', 'h', 's' };
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Запись 64-х битного целого числа в виде последовательности октетов
+    (младшие разряды вперед).                                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_hash_state_put_uint64( ak_uint8 *out, const ak_uint64 value )
+{
+  int i = 0;
+  for( i = 0; i < 8; i++ ) out[i] = ( ak_uint8 )( value >> ( 8*i ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Чтение 64-х битного целого числа, записанного функцией ak_hash_state_put_uint64(). */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline ak_uint64 ak_hash_state_get_uint64( const ak_uint8 *in )
+{
+  int i = 0;
+  ak_uint64 value = 0;
+  for( i = 7; i >= 0; i-- ) value = ( value << 8 )^in[i];
+ return value;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество уровней дерева, содержащих незавершенные узлы (для остальных контекстов
+    функция возвращает ноль).                                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static size_t ak_hash_context_state_levels( ak_hash hctx )
+{
+  size_t i = 0, count = 0;
+
+  if( hctx->mctx.update != ak_hash_context_update_streebog_tree ) return 0;
+  for( i = 0; i < ak_streebog_tree_max_levels; i++ )
+     if( hctx->data.tctx.levels[i].count ) count = i+1;
+ return count;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция записывает промежуточное состояние контекста функции хеширования в виде
+    последовательности октетов, не зависящей от архитектуры вычислителя. Последовательность
+    содержит
+     - сигнатуру `akhs` и номер версии формата (один октет),
+     - длину и символьную запись идентификатора алгоритма `oid`,
+     - количество октетов во внутреннем буффере `mctx` (один октет) и сам буффер (64 октета),
+     - векторы h, n и \f$ \Sigma \f$ (в том порядке октетов, в котором они обрабатываются
+       функцией сжатия).
+
+    Для режима streebog512-tree дополнительно записываются длина листа, количество октетов
+    текущего листа и общая длина данных (по восемь октетов, младшие разряды вперед), а также
+    количество уровней дерева и, для каждого уровня, количество потомков незавершенного узла,
+    хеш-код первого потомка и векторы состояния узла.
+
+    Функция используется для сохранения как состояния функции хеширования, так и состояния
+    алгоритма HMAC; в последнем случае указываются идентификатор и буффер алгоритма HMAC.
+
+    @param hctx Контекст функции хеширования.
+    @param oid Идентификатор алгоритма, записываемый в сохраняемое состояние.
+    @param mctx Контекст итерационного сжатия, содержащий необработанные данные.
+    @param out Область памяти, в которую помещается состояние. Если out равен NULL,
+    то функция только определяет необходимый размер памяти.
+    @param size Указатель на размер области памяти out; после выполнения функции содержит
+    длину записанного (или необходимого для записи) состояния.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_write_state( ak_hash hctx, ak_oid oid, ak_mac mctx,
+                                                                    ak_pointer out, size_t *size )
+{
+  ak_uint8 *ptr = out;
+  size_t i = 0, len = 0, levels = 0, need = 0;
+
+  if(( hctx == NULL ) || ( oid == NULL ) || ( mctx == NULL ) || ( size == NULL ))
+    return ak_error_message( ak_error_null_pointer, __func__, "using null pointer to context" );
+  if(( len = strlen( oid->id )) > 255 ) return ak_error_message( ak_error_wrong_length,
+                                                __func__, "using oid with very long identifier" );
+  if( mctx->length >= ak_mac_context_max_buffer_size )
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                    "using mac context with wrong buffer length" );
+ /* определяем длину состояния */
+  need = 7 + len + ak_mac_context_max_buffer_size + ak_hash_state_vectors_size;
+  if( hctx->mctx.update == ak_hash_context_update_streebog_tree ) {
+    need += 25 + ( levels = ak_hash_context_state_levels( hctx ));
+    for( i = 0; i < levels; i++ )
+       if( hctx->data.tctx.levels[i].count ) need += 64 + ak_hash_state_vectors_size;
+  }
+  if( out == NULL ) { *size = need; return ak_error_ok; }
+  if( *size < need ) {
+    *size = need;
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                   "using small buffer for hash function state" );
+  }
+
+ /* заголовок */
+  memcpy( ptr, ak_hash_state_signature, 4 );
+  ptr[4] = ak_hash_state_version;
+  ptr[5] = ( ak_uint8 ) len;
+  memcpy( ptr+6, oid->id, len );
+  ptr += 6 + len;
+ /* необработанные данные */
+  *ptr++ = ( ak_uint8 ) mctx->length;
+  memset( ptr, 0, ak_mac_context_max_buffer_size );
+  memcpy( ptr, mctx->data, mctx->length );
+  ptr += ak_mac_context_max_buffer_size;
+ /* векторы состояния функции сжатия не зависят от порядка октетов в машинном слове */
+  memcpy( ptr, hctx->data.sctx.h, 64 );
+  memcpy( ptr+64, hctx->data.sctx.n, 64 );
+  memcpy( ptr+128, hctx->data.sctx.sigma, 64 );
+  ptr += ak_hash_state_vectors_size;
+
+  if( hctx->mctx.update == ak_hash_context_update_streebog_tree ) {
+    ak_streebog_tree tree = &hctx->data.tctx;
+
+    ak_hash_state_put_uint64( ptr, tree->leaf_size );
+    ak_hash_state_put_uint64( ptr+8, tree->leaf_fill );
+    ak_hash_state_put_uint64( ptr+16, tree->total );
+    ptr[24] = ( ak_uint8 ) levels;
+    ptr += 25;
+    for( i = 0; i < levels; i++ ) {
+       ak_streebog_tree_level lv = tree->levels + i;
+       *ptr++ = ( ak_uint8 ) lv->count;
+       if( lv->count == 0 ) continue;
+       memcpy( ptr, lv->child, 64 );
+       memcpy( ptr+64, lv->sctx.h, 64 );
+       memcpy( ptr+128, lv->sctx.n, 64 );
+       memcpy( ptr+192, lv->sctx.sigma, 64 );
+       ptr += 64 + ak_hash_state_vectors_size;
+    }
+  }
+  *size = need;
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Чтение идентификатора алгоритма из сохраненного состояния.
+    \details Функция проверяет сигнатуру и версию формата и возвращает указатель на
+    идентификатор и его длину; в случае ошибки возвращается NULL.                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static const ak_uint8 *ak_hash_state_get_id( const ak_uint8 *in, const size_t size, size_t *len )
+{
+  if(( in == NULL ) || ( size < 6 )) return NULL;
+  if( !ak_ptr_is_equal( in, ak_hash_state_signature, 4 )) return NULL;
+  if( in[4] != ak_hash_state_version ) return NULL;
+  if(( *len = in[5] ) > size - 6 ) return NULL;
+ return in + 6;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция восстанавливает промежуточное состояние, записанное функцией
+    ak_hash_context_write_state(), в ранее созданный контекст функции хеширования.
+    Состояние контекста изменяется только в случае успешной проверки всех
+    считанных значений.
+
+    @param hctx Контекст функции хеширования.
+    @param oid Идентификатор алгоритма, который должен содержаться в сохраненном состоянии.
+    @param mctx Контекст итерационного сжатия, в буффер которого помещаются необработанные данные.
+    @param in Сохраненное состояние.
+    @param size Длина сохраненного состояния (в октетах).
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_read_state( ak_hash hctx, ak_oid oid, ak_mac mctx,
+                                                         const ak_pointer in, const size_t size )
+{
+  size_t i = 0, len = 0, rest = 0;
+  struct streebog sctx;
+  struct streebog_tree tree;
+  struct streebog_tree_level lv[ak_streebog_tree_max_levels];
+  const ak_uint8 *id = NULL, *ptr = NULL;
+
+  if(( hctx == NULL ) || ( oid == NULL ) || ( mctx == NULL ) || ( in == NULL ))
+    return ak_error_message( ak_error_null_pointer, __func__, "using null pointer to context" );
+  if(( id = ak_hash_state_get_id( in, size, &len )) == NULL )
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                            "using data with wrong format of hash function state" );
+  if(( len != strlen( oid->id )) || !ak_ptr_is_equal( id, oid->id, len ))
+    return ak_error_message( ak_error_wrong_oid, __func__,
+                                            "using hash function state of an another algorithm" );
+  ptr = id + len;
+  rest = size - 6 - len;
+
+ /* необработанные данные и векторы состояния */
+  if( rest < 1 + ak_mac_context_max_buffer_size + ak_hash_state_vectors_size )
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                 "using hash function state with wrong length" );
+  if( ptr[0] >= mctx->bsize ) return ak_error_message( ak_error_wrong_length, __func__,
+                                          "using hash function state with wrong buffer length" );
+  memcpy( &sctx, &hctx->data.sctx, sizeof( struct streebog ));
+  memcpy( sctx.h, ptr + 1 + ak_mac_context_max_buffer_size, 64 );
+  memcpy( sctx.n, ptr + 65 + ak_mac_context_max_buffer_size, 64 );
+  memcpy( sctx.sigma, ptr + 129 + ak_mac_context_max_buffer_size, 64 );
+  rest -= 1 + ak_mac_context_max_buffer_size + ak_hash_state_vectors_size;
+
+  if( hctx->mctx.update == ak_hash_context_update_streebog_tree ) {
+    const ak_uint8 *tp = ptr + 1 + ak_mac_context_max_buffer_size + ak_hash_state_vectors_size;
+    size_t levels = 0;
+    ak_uint64 leaf_size = 0;
+
+    if( rest < 25 ) return ak_error_message( ak_error_wrong_length, __func__,
+                                                 "using hash function state with wrong length" );
+    leaf_size = ak_hash_state_get_uint64( tp );
+    memcpy( &tree, &hctx->data.tctx, sizeof( struct streebog_tree ));
+    memcpy( &tree.sctx, &sctx, sizeof( struct streebog ));
+    tree.leaf_fill = ( size_t ) ak_hash_state_get_uint64( tp+8 );
+    tree.total = ak_hash_state_get_uint64( tp+16 );
+    levels = tp[24];
+    if(( leaf_size < 64 ) || ( leaf_size > 1073741824 ) || ( leaf_size&0x3f ) ||
+       ( tree.leaf_fill > leaf_size ) || ( tree.leaf_fill&0x3f ) ||
+       ( tree.total < tree.leaf_fill ) || ( levels > ak_streebog_tree_max_levels ))
+      return ak_error_message( ak_error_invalid_value, __func__,
+                                         "using hash function state with wrong tree parameters" );
+    tree.leaf_size = ( size_t ) leaf_size;
+    tp += 25; rest -= 25;
+
+    memset( lv, 0, sizeof( lv ));
+    for( i = 0; i < levels; i++ ) {
+       if( rest < 1 ) return ak_error_message( ak_error_wrong_length, __func__,
+                                                 "using hash function state with wrong length" );
+       if(( lv[i].count = *tp++ ) >= ak_streebog_tree_fanout )
+         return ak_error_message( ak_error_invalid_value, __func__,
+                                         "using hash function state with wrong tree parameters" );
+       rest--;
+       if( lv[i].count == 0 ) continue;
+       if( rest < 64 + ak_hash_state_vectors_size )
+         return ak_error_message( ak_error_wrong_length, __func__,
+                                                 "using hash function state with wrong length" );
+       memcpy( lv[i].child, tp, 64 );
+       memcpy( lv[i].sctx.h, tp+64, 64 );
+       memcpy( lv[i].sctx.n, tp+128, 64 );
+       memcpy( lv[i].sctx.sigma, tp+192, 64 );
+       lv[i].sctx.hsize = 64;
+       lv[i].sctx.kernel = tree.sctx.kernel;
+       tp += 64 + ak_hash_state_vectors_size;
+       rest -= 64 + ak_hash_state_vectors_size;
+    }
+  }
+  if( rest != 0 ) return ak_error_message( ak_error_wrong_length, __func__,
+                                                 "using hash function state with wrong length" );
+ /* все проверки выполнены, изменяем состояние контекста */
+  memset( mctx->data, 0, ak_mac_context_max_buffer_size );
+  memcpy( mctx->data, ptr+1, mctx->length = ptr[0] );
+  if( hctx->mctx.update == ak_hash_context_update_streebog_tree ) {
+    memcpy( hctx->data.tctx.levels, lv, sizeof( lv ));
+    tree.levels = hctx->data.tctx.levels;
+    memcpy( &hctx->data.tctx, &tree, sizeof( struct streebog_tree ));
+  } else memcpy( &hctx->data.sctx, &sctx, sizeof( struct streebog ));
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция записывает промежуточное состояние контекста функции хеширования в виде
+    последовательности октетов, не зависящей от архитектуры вычислителя (формат описан
+    в документации к функции ak_hash_context_write_state()). Сохраненное состояние позволяет
+    продолжить вычисление хеш-кода, например, после перезапуска программы, без повторной
+    обработки уже хешированных данных.
+
+    @param hctx Контекст функции хеширования.
+    @param out Область памяти, в которую помещается состояние. Если out равен NULL,
+    то функция только определяет необходимый размер памяти.
+    @param size Указатель на размер области памяти out; после выполнения функции содержит
+    длину записанного (или необходимого для записи) состояния.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_export( ak_hash hctx, ak_pointer out, size_t *size )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hash context" );
+ return ak_hash_context_write_state( hctx, hctx->oid, &hctx->mctx, out, size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция создает контекст функции хеширования, алгоритм которой определяется сохраненным
+    состоянием, и восстанавливает в нем промежуточное состояние, записанное функцией
+    ak_hash_context_export(). Для режима streebog512-tree длина листа также берется из
+    сохраненного состояния. После завершения вычислений контекст должен быть
+    освобожден с помощью функции ak_hash_context_destroy().
+
+    @param hctx Контекст функции хеширования (не должен быть ранее инициализирован).
+    @param in Сохраненное состояние.
+    @param size Длина сохраненного состояния (в октетах).
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_import( ak_hash hctx, const ak_pointer in, const size_t size )
+{
+  ak_oid oid = NULL;
+  size_t len = 0;
+  char id[256];
+  int error = ak_error_ok;
+  const ak_uint8 *ptr = NULL;
+
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hash context" );
+  if(( ptr = ak_hash_state_get_id( in, size, &len )) == NULL )
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                            "using data with wrong format of hash function state" );
+  memcpy( id, ptr, len );
+  id[len] = 0;
+  if(( oid = ak_oid_context_find_by_id( id )) == NULL )
+    return ak_error_message( ak_error_wrong_oid, __func__,
+                                           "using hash function state with unsupported algorithm" );
+  if(( error = ak_hash_context_create_oid( hctx, oid )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of hash function context" );
+  if(( error = ak_hash_context_read_state( hctx, oid, &hctx->mctx, in, size )) != ak_error_ok ) {
+    ak_hash_context_destroy( hctx );
+    return ak_error_message( error, __func__, "incorrect reading of hash function state" );
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция копирует промежуточное состояние одного контекста функции хеширования в другой,
+    ранее созданный для того же алгоритма. Функция не выделяет память и позволяет, например,
+    однократно вычислить состояние после обработки общего префикса нескольких сообщений
+    и многократно продолжать вычисления с этого состояния.
+
+    @param dst Контекст, в который копируется состояние.
+    @param src Контекст, состояние которого копируется.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_copy_state( ak_hash dst, ak_hash src )
+{
+  if(( dst == NULL ) || ( src == NULL )) return ak_error_message( ak_error_null_pointer,
+                                                  __func__, "using null pointer to hash context" );
+  if(( dst->oid != src->oid ) || ( dst->mctx.update != src->mctx.update ))
+    return ak_error_message( ak_error_wrong_oid, __func__,
+                                                  "using hash contexts of different algorithms" );
+  if( dst == src ) return ak_error_ok;
+
+  dst->mctx.length = src->mctx.length;
+  memcpy( dst->mctx.data, src->mctx.data, ak_mac_context_max_buffer_size );
+  if( src->mctx.update == ak_hash_context_update_streebog_tree ) {
+    ak_streebog_tree_level levels = dst->data.tctx.levels;
+    memcpy( levels, src->data.tctx.levels,
+                          ak_streebog_tree_max_levels*sizeof( struct streebog_tree_level ));
+    memcpy( &dst->data.tctx, &src->data.tctx, sizeof( struct streebog_tree ));
+    dst->data.tctx.levels = levels;
+  } else memcpy( &dst->data.sctx, &src->data.sctx, sizeof( struct streebog ));
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция создает новый контекст функции хеширования, содержащий копию текущего
+    промежуточного состояния заданного контекста. После завершения вычислений контекст
+    должен быть освобожден с помощью функции ak_hash_context_destroy().
+
+    @param dst Создаваемый контекст (не должен быть ранее инициализирован).
+    @param src Контекст, состояние которого копируется.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_clone( ak_hash dst, ak_hash src )
+{
+  int error = ak_error_ok;
+
+  if(( dst == NULL ) || ( src == NULL )) return ak_error_message( ak_error_null_pointer,
+                                                  __func__, "using null pointer to hash context" );
+  if( dst == src ) return ak_error_message( ak_error_invalid_value, __func__,
+                                                         "cloning a hash context to itself" );
+  if(( error = ak_hash_context_create_oid( dst, src->oid )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of hash function context" );
+  if(( error = ak_hash_context_copy_state( dst, src )) != ak_error_ok ) {
+    ak_hash_context_destroy( dst );
+    return ak_error_message( error, __func__, "incorrect copying of hash function state" );
+  }
+
+ return ak_error_ok;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                          Функции тестирования алгоритмов работы                                 */
 /* ----------------------------------------------------------------------------------------------- */
@@ -785,6 +2270,97 @@
  return result;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Контрольные значения режима streebog512-tree.
+    \details Значения вычислены для длины листа 1024 октета и сообщений длины 0, 1025 и 17415
+    октетов, i-й октет которых равен i mod 256. Последнее сообщение образует дерево
+    из двух уровней внутренних узлов.                                                              */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint8 streebog512_tree_test0[64] = {
+   0x5c, 0xcc, 0x8b, 0x66, 0x07, 0x66, 0x7d, 0xd3, 0x6c, 0xe4, 0xcb, 0x8d, 0x6f, 0xe2, 0x7a, 0xe1,
+   0xfd, 0xd6, 0xdf, 0xbb, 0xfe, 0x98, 0x8f, 0x47, 0x48, 0xb4, 0x06, 0xce, 0xad, 0x7a, 0x6a, 0x2a,
+   0x03, 0xe3, 0xfa, 0x68, 0xde, 0x83, 0x28, 0x62, 0x7c, 0x88, 0x41, 0x04, 0xc2, 0xc4, 0x79, 0xb0,
+   0xc2, 0xf3, 0xa6, 0x7c, 0x6d, 0xee, 0x93, 0x9c, 0x3d, 0xb4, 0x5f, 0x79, 0x4b, 0x25, 0x33, 0x23
+ };
+
+ static ak_uint8 streebog512_tree_test1[64] = {
+   0x74, 0xe6, 0xf2, 0xfc, 0x95, 0xb1, 0x77, 0x46, 0xf0, 0x86, 0x0e, 0xea, 0xc8, 0x18, 0x05, 0x58,
+   0x18, 0xca, 0x8d, 0x59, 0x44, 0x4d, 0x1b, 0xf9, 0x3e, 0xeb, 0x69, 0x43, 0x79, 0xbc, 0x39, 0xb1,
+   0x1b, 0x23, 0x21, 0x71, 0x93, 0xad, 0x52, 0xb2, 0xcd, 0x38, 0x57, 0x7f, 0x6c, 0x9e, 0xb9, 0xac,
+   0x8f, 0x0f, 0x61, 0xfb, 0x33, 0x43, 0xc4, 0x58, 0xc8, 0x97, 0x34, 0x05, 0x05, 0xf8, 0x0b, 0x10
+ };
+
+ static ak_uint8 streebog512_tree_test2[64] = {
+   0x05, 0xe0, 0x9b, 0x46, 0xcd, 0xd8, 0xf2, 0x0c, 0xe1, 0x86, 0x75, 0xb2, 0x29, 0xdb, 0xfb, 0x85,
+   0xdf, 0xe4, 0x42, 0xfc, 0x8d, 0xf2, 0xb8, 0xbe, 0x44, 0xbd, 0xf1, 0xe4, 0x8e, 0x3f, 0x41, 0x96,
+   0x7f, 0x8d, 0x9f, 0xee, 0xa9, 0xad, 0x3e, 0x2f, 0x0c, 0x96, 0x7c, 0x59, 0x69, 0x70, 0x71, 0xb8,
+   0x7d, 0x58, 0x50, 0x5b, 0x8b, 0xb1, 0x14, 0x9a, 0x1f, 0x66, 0xc3, 0x70, 0x83, 0xb8, 0xcf, 0x63
+ };
+
+/* ----------------------------------------------------------------------------------------------- */
+/*!  @return Если тестирование прошло успешно возвращается \ref ak_true (истина). В противном
+     случае возвращается \ref ak_false.                                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_hash_test_streebog512_tree( void )
+{
+  size_t i = 0, j = 0;
+  struct hash ctx;
+  bool_t result = ak_true;
+  int error = ak_error_ok, audit = ak_log_get_level();
+  ak_int64 leaf_size = ak_libakrypt_get_option( "streebog_tree_leaf_size" );
+  ak_uint8 *in = NULL, out[64];
+  size_t sizes[3] = { 0, 1025, 17415 };
+  ak_uint8 *values[3] = { streebog512_tree_test0, streebog512_tree_test1, streebog512_tree_test2 };
+
+  if(( in = malloc( sizes[2] )) == NULL ) {
+    ak_error_message( ak_error_out_of_memory, __func__ , "memory allocation error" );
+    return ak_false;
+  }
+  for( i = 0; i < sizes[2]; i++ ) in[i] = ( ak_uint8 ) i;
+
+ /* контрольные значения вычислены для длины листа 1024 октета */
+  ak_libakrypt_set_option( "streebog_tree_leaf_size", 1024 );
+  error = ak_hash_context_create_streebog512_tree( &ctx );
+  ak_libakrypt_set_option( "streebog_tree_leaf_size", leaf_size );
+  if( error != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong initialization of streebog512-tree context" );
+    free( in );
+    return ak_false;
+  }
+
+  for( i = 0; i < 3; i++ ) {
+    /* многопоточное вычисление */
+     ak_hash_context_ptr( &ctx, in, sizes[i], out, sizeof( out ));
+     if(( error = ak_error_get_value()) != ak_error_ok ) {
+       ak_error_message( error, __func__ , "invalid calculation of streebog512-tree code" );
+       result = ak_false;
+       goto lab_exit;
+     }
+     if(( result = ak_ptr_is_equal_with_log( out, values[i], 64 )) != ak_true ) {
+       ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                                 "the test for %u octets is wrong", (unsigned int) sizes[i] );
+       goto lab_exit;
+     }
+    /* последовательное вычисление */
+     j = sizes[i]&( ~( size_t )0x3f );
+     ak_hash_context_clean( &ctx );
+     ak_hash_context_update( &ctx, in, j );
+     ak_hash_context_finalize( &ctx, in + j, sizes[i] - j, out, sizeof( out ));
+     if(( result = ak_ptr_is_equal_with_log( out, values[i], 64 )) != ak_true ) {
+       ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                      "the sequential test for %u octets is wrong", (unsigned int) sizes[i] );
+       goto lab_exit;
+     }
+     if( audit >= ak_log_maximum ) ak_error_message_fmt( ak_error_ok, __func__ ,
+                                  "the test for %u octets is Ok", (unsigned int) sizes[i] );
+  }
+
+ lab_exit:
+  ak_hash_context_destroy( &ctx );
+  free( in );
+ return result;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                                                                                      ak_hash.c  */
 /* ----------------------------------------------------------------------------------------------- */
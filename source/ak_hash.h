@@ -22,8 +22,68 @@
   ak_uint64 sigma[8];
  /*! \brief Размер блока выходных данных (хеш-кода)*/
   size_t hsize;
+ /*! \brief Реализация функции сжатия, используемая контекстом */
+  int kernel;
 } *ak_streebog;
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выбор реализации функции сжатия Стрибог по умолчанию (совмещенные таблицы). */
+ #define ak_streebog_kernel_auto       (0)
+/*! \brief Базовая реализация функции сжатия (раздельные таблицы подстановки и преобразования). */
+ #define ak_streebog_kernel_base       (1)
+/*! \brief Реализация, использующая таблицы с совмещенными преобразованиями S, P и L. */
+ #define ak_streebog_kernel_fused      (2)
+/*! \brief Реализация, использующая совмещенные таблицы и инструкции SSE2. */
+ #define ak_streebog_kernel_sse2       (3)
+/*! \brief Реализация, использующая совмещенные таблицы и инструкции AVX2. */
+ #define ak_streebog_kernel_avx2       (4)
+
+/*! \brief Инициализация таблиц функции сжатия Стрибог и выбор реализации для текущего процессора. */
+ int ak_hash_context_streebog_init_tables( void );
+/*! \brief Проверка доступности реализации функции сжатия Стрибог на текущем процессоре. */
+ bool_t ak_streebog_kernel_is_available( const int );
+/*! \brief Номер реализации функции сжатия Стрибог, используемой при создании контекстов. */
+ int ak_streebog_kernel_get( void );
+/*! \brief Хеширование одного блока сообщения, начиная с заданного состояния функции Стрибог. */
+ void ak_hash_context_streebog_block( ak_streebog , const ak_uint64 * , ak_uint64 * );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество потомков внутреннего узла дерева в режиме streebog512-tree. */
+ #define ak_streebog_tree_fanout       (16)
+/*! \brief Максимальное количество уровней дерева (достаточно для \f$ 2^{64} \f$ листьев). */
+ #define ak_streebog_tree_max_levels   (17)
+/*! \brief Максимальное количество потоков, вычисляющих листья дерева. */
+ #define ak_streebog_tree_max_threads  (64)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Незавершенный внутренний узел одного уровня дерева в режиме streebog512-tree. */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct streebog_tree_level {
+ /*! \brief Состояние функции хеширования узла */
+  struct streebog sctx;
+ /*! \brief Хеш-код первого потомка узла */
+  ak_uint64 child[8];
+ /*! \brief Количество потомков, уже добавленных в узел */
+  size_t count;
+} *ak_streebog_tree_level;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Структура для хранения внутренних данных режима древовидного хеширования
+    streebog512-tree. */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct streebog_tree {
+ /*! \brief Состояние функции хеширования текущего листа (должно быть первым полем структуры) */
+  struct streebog sctx;
+ /*! \brief Незавершенные узлы каждого из уровней дерева */
+  ak_streebog_tree_level levels;
+ /*! \brief Длина листа (в октетах) */
+  size_t leaf_size;
+ /*! \brief Количество октетов, добавленных в текущий лист */
+  size_t leaf_fill;
+ /*! \brief Общая длина обработанных данных (в октетах) */
+  ak_uint64 total;
+} *ak_streebog_tree;
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Функция создания контекста хеширования. */
  typedef int ( ak_function_hash_context_create )( ak_pointer );
@@ -35,6 +95,7 @@
     с использованием класса \ref hash реализованы следующие отечественные алгоритмы хеширования
      - Стрибог256,
      - Стрибог512,
+     - режим древовидного хеширования streebog512-tree, использующий функцию Стрибог512,
      - ГОСТ Р 34.11-94 (в настоящее время стандарт выведен из обращения).
 
   Перед началом работы контекст функции хэширования должен быть инициализирован
@@ -52,14 +113,31 @@
    union {
    /*! \brief Структура алгоритмов семейства Стрибог. */
     struct streebog sctx;
+   /*! \brief Структура режима древовидного хеширования streebog512-tree. */
+    struct streebog_tree tctx;
    } data;
  } *ak_hash;
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Описание независимого сообщения, хеш-код которого вычисляется функцией
+    ak_hash_context_ptr_jobs() одновременно с хеш-кодами других сообщений. */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct hash_job {
+  /*! \brief Указатель на хешируемые данные */
+   ak_pointer in;
+  /*! \brief Размер хешируемых данных (в октетах) */
+   size_t size;
+  /*! \brief Область памяти для хеш-кода; размер области не меньше длины хеш-кода */
+   ak_pointer out;
+ } *ak_hash_job;
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Инициализация контекста функции бесключевого хеширования ГОСТ Р 34.11-2012 (Стрибог256). */
  int ak_hash_context_create_streebog256( ak_hash );
 /*! \brief Инициализация контекста функции бесключевого хеширования ГОСТ Р 34.11-2012 (Стрибог512). */
  int ak_hash_context_create_streebog512( ak_hash );
+/*! \brief Инициализация контекста режима древовидного хеширования streebog512-tree. */
+ int ak_hash_context_create_streebog512_tree( ak_hash );
 /*! \brief Инициализация контекста функции бесключевого хеширования по заданному OID алгоритма. */
  int ak_hash_context_create_oid( ak_hash, ak_oid );
 /*! \brief Уничтожение контекста функции хеширования. */
@@ -78,16 +156,39 @@
  int ak_hash_context_update( ak_hash , const ak_pointer , const size_t );
 /*! \brief Обновление состояния и вычисление результата применения алгоритма хеширования. */
  int ak_hash_context_finalize( ak_hash , const ak_pointer , const size_t , ak_pointer , const size_t );
+/*! \brief Обновление состояния контекста данными, расположенными в нескольких фрагментах. */
+ int ak_hash_context_update_fragments( ak_hash , ak_fragment , const size_t );
+/*! \brief Завершение вычислений для данных, расположенных в нескольких фрагментах. */
+ int ak_hash_context_finalize_fragments( ak_hash , ak_fragment , const size_t ,
+                                                                       ak_pointer , const size_t );
 /*! \brief Хеширование заданной области памяти. */
  int ak_hash_context_ptr( ak_hash , const ak_pointer , const size_t , ak_pointer , const size_t );
+/*! \brief Одновременное хеширование нескольких независимых областей памяти. */
+ int ak_hash_context_ptr_jobs( ak_hash , ak_hash_job , const size_t );
 /*! \brief Хеширование заданного файла. */
  int ak_hash_context_file( ak_hash , const char*, ak_pointer , const size_t );
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Копирование промежуточного состояния в ранее созданный контекст функции хеширования. */
+ int ak_hash_context_copy_state( ak_hash , ak_hash );
+/*! \brief Создание нового контекста функции хеширования с копией промежуточного состояния. */
+ int ak_hash_context_clone( ak_hash , ak_hash );
+/*! \brief Сохранение промежуточного состояния функции хеширования. */
+ int ak_hash_context_export( ak_hash , ak_pointer , size_t * );
+/*! \brief Создание контекста функции хеширования из сохраненного промежуточного состояния. */
+ int ak_hash_context_import( ak_hash , const ak_pointer , const size_t );
+/*! \brief Запись промежуточного состояния функции хеширования или алгоритма HMAC. */
+ int ak_hash_context_write_state( ak_hash , ak_oid , ak_mac , ak_pointer , size_t * );
+/*! \brief Чтение промежуточного состояния функции хеширования или алгоритма HMAC. */
+ int ak_hash_context_read_state( ak_hash , ak_oid , ak_mac , const ak_pointer , const size_t );
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Проверка корректной работы функции хеширования Стрибог-256 */
  bool_t ak_hash_test_streebog256( void );
 /*! \brief Проверка корректной работы функции хеширования Стрибог-512 */
  bool_t ak_hash_test_streebog512( void );
+/*! \brief Проверка корректной работы режима древовидного хеширования streebog512-tree */
+ bool_t ak_hash_test_streebog512_tree( void );
 
 #endif
 /* ----------------------------------------------------------------------------------------------- */
@@ -18,9 +18,129 @@
 #else
  #error Library cannot be compiled without string.h header
 #endif
+#ifdef LIBAKRYPT_HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+ #include <pthread.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Индекс состояния, полученного после обработки блока \f$ K \oplus ipad \f$. */
+ #define ak_hmac_ipad (0)
+/*! \brief Индекс состояния, полученного после обработки блока \f$ K \oplus opad \f$. */
+ #define ak_hmac_opad (1)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Смена маски сохраненного состояния функции хеширования.
+    \details Новая случайная последовательность складывается как с маскированным состоянием,
+    так и с маской, поэтому значение состояния не изменяется.                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hmac_context_remask_pad( ak_hmac hctx, const int pad )
+{
+  size_t i = 0;
+  int error = ak_error_ok;
+  ak_uint64 newmask[24];
+
+  if(( error = ak_random_context_random( &hctx->key.generator,
+                                                     newmask, sizeof( newmask ))) != ak_error_ok )
+    return ak_error_message( error, __func__, "wrong generation a random mask for hmac state" );
+  for( i = 0; i < 24; i++ ) {
+     hctx->pads[pad][i] ^= newmask[i];
+     hctx->pads[pad+2][i] ^= newmask[i];
+  }
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Перенос сохраненного состояния в контекст функции хеширования.
+    \details После переноса состояние контекста совпадает с состоянием, полученным
+    после очистки контекста и обработки блока \f$ K \oplus ipad \f$ (или \f$ K \oplus opad \f$);
+    маска сохраненного состояния сразу же меняется.                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hmac_context_load_pad( ak_hmac hctx, const int pad )
+{
+  size_t i = 0;
+  ak_streebog sctx = &hctx->ctx.data.sctx;
+
+  memset( hctx->ctx.mctx.data, 0, ak_mac_context_max_buffer_size );
+  hctx->ctx.mctx.length = 0;
+  for( i = 0; i < 8; i++ ) {
+     sctx->h[i] = hctx->pads[pad][i] ^ hctx->pads[pad+2][i];
+     sctx->n[i] = hctx->pads[pad][i+8] ^ hctx->pads[pad+2][i+8];
+     sctx->sigma[i] = hctx->pads[pad][i+16] ^ hctx->pads[pad+2][i+16];
+  }
+ return ak_hmac_context_remask_pad( hctx, pad );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление состояний функции хеширования после обработки блоков \f$ K \oplus ipad \f$
+    и \f$ K \oplus opad \f$.
+    \details Функция вызывается при каждом присвоении ключу нового значения. Вычисленные
+    состояния хранятся в маскированном виде и используются в начале обработки каждого сообщения
+    и при завершении вычислений, что позволяет не сжимать дополненный ключ для каждого
+    сообщения. Ресурс ключа функцией не изменяется.
+
+    \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hmac_context_set_pads( ak_hmac hctx )
+{
+  int pad = 0;
+  int error = ak_error_ok;
+  size_t idx = 0, jdx = 0, len = 0;
+  ak_uint8 buffer[64]; /* буффер для хранения промежуточных значений */
+  const ak_uint8 mask[2] = { 0x36, 0x5C };
+  ak_streebog sctx = &hctx->ctx.data.sctx;
+
+  if( hctx->mctx.bsize > sizeof( buffer )) return ak_error_message( ak_error_wrong_length,
+                                            __func__, "using hash function with huge block size" );
+  for( pad = ak_hmac_ipad; pad <= ak_hmac_opad; pad++ ) {
+    /* фомируем маскированное значение ключа */
+     len = ak_min( hctx->mctx.bsize, jdx = hctx->key.key_size );
+     for( idx = 0; idx < len; idx++, jdx++ ) {
+        buffer[idx] = hctx->key.key[idx] ^ mask[pad];
+        buffer[idx] ^= hctx->key.key[jdx];
+     }
+     for( ; idx < hctx->mctx.bsize; idx++ ) buffer[idx] = mask[pad];
+
+    /* вычисляем состояние контекста хеширования */
+     if(( error = ak_hash_context_clean( &hctx->ctx )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "wrong cleaning of hash function context" );
+       break;
+     }
+     if(( error = ak_hash_context_update( &hctx->ctx, buffer, hctx->mctx.bsize )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "invalid iteration for hmac key context" );
+       break;
+     }
+    /* сохраняем состояние в маскированном виде */
+     if(( error = ak_random_context_random( &hctx->key.generator, hctx->pads[pad+2],
+                                                      sizeof( hctx->pads[0] ))) != ak_error_ok ) {
+       ak_error_message( error, __func__, "wrong generation a random mask for hmac state" );
+       break;
+     }
+     for( idx = 0; idx < 8; idx++ ) {
+        hctx->pads[pad][idx] = sctx->h[idx] ^ hctx->pads[pad+2][idx];
+        hctx->pads[pad][idx+8] = sctx->n[idx] ^ hctx->pads[pad+2][idx+8];
+        hctx->pads[pad][idx+16] = sctx->sigma[idx] ^ hctx->pads[pad+2][idx+16];
+     }
+  }
+
+ /* очищаем буффер и контекст хеширования, перемаскируем ключ */
+  ak_ptr_context_wipe( buffer, sizeof( buffer ), &hctx->key.generator );
+  ak_hash_context_clean( &hctx->ctx );
+  hctx->key.set_mask( &hctx->key );
+ /* без вычисленных состояний ключ не может быть использован */
+  if( error != ak_error_ok ) hctx->key.flags &= ( 0xFFFFFFFFFFFFFFFFLL ^ ak_key_flag_set_key );
+
+ return error;
+}
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Очистка контекста алгоритма hmac.
+    \details Начальное состояние функции хеширования копируется из состояния, вычисленного
+    при присвоении значения ключу, поэтому дополненный ключ повторно не сжимается.
     \param ctx Контекст алгоритма HMAC выработки имитовставки.
     \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
     возвращается код ошибки.                                                                       */
@@ -29,8 +149,6 @@
 {
   int error = ak_error_ok;
   ak_hmac hctx = ( ak_hmac ) ctx;
-  size_t idx = 0, jdx = 0, len = 0;
-  ak_uint8 buffer[64]; /* буффер для хранения промежуточных значений */
 
   if( ctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                       "using a null pointer to hmac key context" );
@@ -41,30 +159,12 @@
   if( hctx->key.resource.value.counter <= 1 ) return ak_error_message( ak_error_low_key_resource,
                                             __func__, "using hmac key context with low resource" );
                       /* нам надо два раза использовать ключ => ресурс должен быть не менее двух */
-  if( hctx->mctx.bsize > sizeof( buffer )) return ak_error_message( ak_error_wrong_length,
-                                            __func__, "using hash function with huge block size" );
-
- /* фомируем маскированное значение ключа */
-  len = ak_min( hctx->mctx.bsize, jdx = hctx->key.key_size );
-  for( idx = 0; idx < len; idx++, jdx++ ) {
-     buffer[idx] = hctx->key.key[idx] ^ 0x36;
-     buffer[idx] ^= hctx->key.key[jdx];
-  }
-  for( ; idx < hctx->mctx.bsize; idx++ ) buffer[idx] = 0x36;
-
- /* инициализируем начальное состояние контекста хеширования */
-  if(( error = ak_hash_context_clean( &hctx->ctx )) != ak_error_ok )
-    return ak_error_message( error, __func__, "wrong cleaning of hash function context" );
 
- /* обновляем состояние контекста хеширования */
-  if(( error = ak_hash_context_update( &hctx->ctx, buffer, hctx->mctx.bsize )) != ak_error_ok )
+ /* инициализируем состояние контекста хеширования */
+  if(( error = ak_hmac_context_load_pad( hctx, ak_hmac_ipad )) != ak_error_ok )
     ak_error_message( error, __func__, "invalid 1st step iteration for hmac key context" );
 
- /* очищаем буффер */
-  ak_ptr_context_wipe( buffer, sizeof( buffer ), &hctx->key.generator );
-
- /* перемаскируем ключ и меняем его ресурс */
-  hctx->key.set_mask( &hctx->key );
+ /* меняем ресурс ключа */
   hctx->key.resource.value.counter--; /* мы использовали ключ один раз */
 
  return error;
@@ -113,9 +213,7 @@
 {
   int error = ak_error_ok;
   ak_hmac hctx = ( ak_hmac ) ctx;
-  size_t idx = 0, jdx = 0, len = 0;
-  ak_uint8 temporary[128]; /* первый буффер для хранения промежуточных значений */
-  ak_uint8 keybuffer[128]; /* второй буффер для хранения промежуточных значений */
+  ak_uint8 temporary[128]; /* буффер для хранения промежуточных значений */
 
  /* выполняем проверки */
   if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
@@ -135,27 +233,11 @@
                                                             sizeof( temporary ))) != ak_error_ok )
     return ak_error_message( error, __func__ , "wrong updating of finalized data" );
 
- /* фомируем маскированное значение ключа */
-  len = ak_min( hctx->mctx.bsize, jdx = hctx->key.key_size );
-  for( idx = 0; idx < len; idx++ , jdx++ ) {
-     keybuffer[idx] = hctx->key.key[idx] ^ 0x5C;
-     keybuffer[idx] ^= hctx->key.key[jdx];
-  }
-  for( ; idx < hctx->mctx.bsize; idx++ ) keybuffer[idx] = 0x5C;
-
- /* возвращаем контекст хеширования в начальное состояние */
-  if(( error = ak_hash_context_clean( &hctx->ctx )) != ak_error_ok )
-    return ak_error_message( error, __func__, "wrong cleaning of hash function context" );
-
- /* обновляем состояние контекста хеширования */
-  if(( error = ak_hash_context_update( &hctx->ctx, keybuffer, hctx->mctx.bsize )) != ak_error_ok )
-    return ak_error_message( error, __func__, "invalid 1st step iteration for hmac key context" );
-
- /* очищаем буффер */
-  ak_ptr_context_wipe( keybuffer, sizeof( keybuffer ), &hctx->key.generator );
+ /* загружаем состояние, полученное после обработки блока K xor opad */
+  if(( error = ak_hmac_context_load_pad( hctx, ak_hmac_opad )) != ak_error_ok )
+    return ak_error_message( error, __func__, "invalid 2nd step iteration for hmac key context" );
 
  /* ресурс ключа */
-  hctx->key.set_mask( &hctx->key );
   hctx->key.resource.value.counter--; /* мы использовали ключ один раз */
 
  /* последний update/finalize и возврат результата */
@@ -221,6 +303,7 @@
   }
  /* доопределяем oid ключа */
   hctx->key.oid = oid;
+  memset( hctx->pads, 0, sizeof( hctx->pads ));
 
  return error;
 }
@@ -257,6 +340,7 @@
     ak_error_message( error, __func__, "incorrect destroying of secret key context" );
   if(( error = ak_mac_context_destroy( &hctx->mctx )) != ak_error_ok )
     ak_error_message( error, __func__, "incorrect destroying of mac context" );
+  memset( hctx->pads, 0, sizeof( hctx->pads ));
 
  return error;
 }
@@ -316,6 +400,10 @@
         return ak_error_message( error, __func__ , "incorrect assigning a secret key value" );
   }
 
+ /* вычисляем состояния функции хеширования, зависящие от ключа */
+  if(( error = ak_hmac_context_set_pads( hctx )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "incorrect precomputation of hmac states" );
+
  /* устанавливаем ресурс ключа */
   if(( error = ak_skey_context_set_resource( &hctx->key,
                           key_using_resource, "hmac_key_count_resource", 0, 0 )) != ak_error_ok )
@@ -343,6 +431,10 @@
   if(( error = ak_skey_context_set_key_random( &hctx->key, generator )) != ak_error_ok )
     return ak_error_message( error, __func__ , "incorrect assigning a secret key value" );
 
+ /* вычисляем состояния функции хеширования, зависящие от ключа */
+  if(( error = ak_hmac_context_set_pads( hctx )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "incorrect precomputation of hmac states" );
+
  /* устанавливаем ресурс ключа */
   if(( error = ak_skey_context_set_resource( &hctx->key,
                           key_using_resource, "hmac_key_count_resource", 0, 0 )) != ak_error_ok )
@@ -380,6 +472,10 @@
                                           pass, pass_size, salt, salt_size )) != ak_error_ok )
     return ak_error_message( error, __func__ , "incorrect assigning a secret key value" );
 
+ /* вычисляем состояния функции хеширования, зависящие от ключа */
+  if(( error = ak_hmac_context_set_pads( hctx )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "incorrect precomputation of hmac states" );
+
  /* устанавливаем ресурс ключа */
   if(( error = ak_skey_context_set_resource( &hctx->key,
                           key_using_resource, "hmac_key_count_resource", 0, 0 )) != ak_error_ok )
@@ -436,6 +532,40 @@
  return ak_mac_context_finalize( &hctx->mctx, in, size, out, out_size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param fragments Массив фрагментов входных данных; результат совпадает с обработкой
+    данных, полученных объединением фрагментов.
+    \param count Количество фрагментов.
+
+    \return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_context_update_fragments( ak_hmac hctx, ak_fragment fragments, const size_t count )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                         "updating null pointer to hmac context" );
+ return ak_mac_context_update_fragments( &hctx->mctx, fragments, count );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param fragments Массив фрагментов входных данных, для которых вычисляется имитовставка.
+    \param count Количество фрагментов.
+    \param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    \param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    \return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_context_finalize_fragments( ak_hmac hctx, ak_fragment fragments, const size_t count,
+                                                           ak_pointer out, const size_t out_size )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                       "finalizing null pointer to hmac context" );
+ return ak_mac_context_finalize_fragments( &hctx->mctx, fragments, count, out, out_size );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \param hctx Контекст алгоритма HMAC выработки имитовставки.
     \param in Указатель на входные данные для которых вычисляется хеш-код.
@@ -507,10 +637,212 @@
 }
 
 /* ----------------------------------------------------------------------------------------------- */
-/*! Пароль должен представлять собой ненулевую строку символов в utf8
-    кодировке. Размер вырабатываемого ключевого вектора может колебаться от 32-х до 64-х байт.
+/*! Функция создает новый контекст алгоритма HMAC с тем же значением секретного ключа и
+    копией текущего промежуточного состояния заданного контекста. Ключ нового контекста
+    и вычисленные для него состояния функции хеширования маскируются заново; номер ключа,
+    контрольная сумма и текущее значение ресурса совпадают с соответствующими значениями
+    ключа исходного контекста. Клонирование позволяет, например, однократно обработать
+    общий префикс нескольких сообщений.
+
+    \param dst Создаваемый контекст (не должен быть ранее инициализирован).
+    \param src Контекст алгоритма HMAC с установленным значением ключа.
+
+    \return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_context_clone( ak_hmac dst, ak_hmac src )
+{
+  int error = ak_error_ok;
+
+  if(( dst == NULL ) || ( src == NULL )) return ak_error_message( ak_error_null_pointer,
+                                                  __func__, "using null pointer to hmac context" );
+  if( dst == src ) return ak_error_message( ak_error_invalid_value, __func__,
+                                                         "cloning a hmac context to itself" );
+  if( !((src->key.flags)&ak_key_flag_set_key )) return ak_error_message( ak_error_key_value,
+                                               __func__ , "using hmac key with unassigned value" );
+  if(( error = ak_hmac_context_create_oid( dst, src->key.oid )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of hmac context" );
+
+ /* копируем маскированное значение ключа вместе с маской и сразу меняем маску */
+  if( dst->key.key_size != src->key.key_size )
+    if(( error = ak_skey_context_alloc_memory( &dst->key,
+                                          src->key.key_size, src->key.policy )) != ak_error_ok ) {
+      ak_error_message( error, __func__, "incorrect allocation of secret key buffer" );
+      goto lab_exit;
+    }
+  memcpy( dst->key.key, src->key.key, src->key.key_size << 1 );
+  memcpy( dst->key.number, src->key.number, sizeof( dst->key.number ));
+  memcpy( &dst->key.resource, &src->key.resource, sizeof( struct resource ));
+  dst->key.icode = src->key.icode;
+  dst->key.flags = src->key.flags;
+  if(( error = dst->key.set_mask( &dst->key )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "wrong secret key masking" );
+    goto lab_exit;
+  }
+  if( !dst->key.check_icode( &dst->key )) {
+    ak_error_message( error = ak_error_wrong_key_icode, __func__,
+                                                      "incorrect integrity code of cloned key" );
+    goto lab_exit;
+  }
+
+ /* копируем промежуточное состояние */
+  if(( error = ak_hash_context_copy_state( &dst->ctx, &src->ctx )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect copying of hash function state" );
+    goto lab_exit;
+  }
+  dst->mctx.length = src->mctx.length;
+  memcpy( dst->mctx.data, src->mctx.data, ak_mac_context_max_buffer_size );
+
+ /* копируем маскированные состояния, зависящие от ключа, и меняем их маски */
+  memcpy( dst->pads, src->pads, sizeof( dst->pads ));
+  if((( error = ak_hmac_context_remask_pad( dst, ak_hmac_ipad )) != ak_error_ok ) ||
+     (( error = ak_hmac_context_remask_pad( dst, ak_hmac_opad )) != ak_error_ok )) goto lab_exit;
+ return ak_error_ok;
+
+ lab_exit:
+  ak_hmac_context_destroy( dst );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция записывает промежуточное состояние алгоритма HMAC в виде последовательности
+    октетов, не зависящей от архитектуры вычислителя (формат описан в документации к функции
+    ak_hash_context_write_state()). Сохраняется только состояние внутренней функции хеширования,
+    секретный ключ в сохраненное состояние не входит, поэтому продолжение вычислений возможно
+    только в контексте с тем же значением ключа.
+
+    \note Сохраненное состояние зависит от значения секретного ключа и должно храниться
+    с теми же мерами защиты, что и вырабатываемые имитовставки.
+
+    \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param out Область памяти, в которую помещается состояние. Если out равен NULL,
+    то функция только определяет необходимый размер памяти.
+    \param size Указатель на размер области памяти out; после выполнения функции содержит
+    длину записанного (или необходимого для записи) состояния.
+
+    \return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_context_export( ak_hmac hctx, ak_pointer out, size_t *size )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hmac context" );
+ return ak_hash_context_write_state( &hctx->ctx, hctx->key.oid, &hctx->mctx, out, size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция восстанавливает промежуточное состояние, записанное функцией
+    ak_hmac_context_export(). Контекст должен быть создан для того же алгоритма HMAC,
+    а его ключ должен иметь то же значение, что и при сохранении состояния
+    (в противном случае будет выработано неверное значение имитовставки).
+
+    \param hctx Контекст алгоритма HMAC выработки имитовставки с установленным значением ключа.
+    \param in Сохраненное состояние.
+    \param size Длина сохраненного состояния (в октетах).
+
+    \return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_context_import( ak_hmac hctx, const ak_pointer in, const size_t size )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hmac context" );
+  if( !((hctx->key.flags)&ak_key_flag_set_key )) return ak_error_message( ak_error_key_value,
+                                               __func__ , "using hmac key with unassigned value" );
+ return ak_hash_context_read_state( &hctx->ctx, hctx->key.oid, &hctx->mctx, in, size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                          функции для выработки ключа из пароля                                  */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Максимальное количество потоков, вычисляющих блоки ключевого вектора PBKDF2. */
+ #define ak_hmac_pbkdf2_max_threads   (64)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Последовательность блоков ключевого вектора, вычисляемых одним потоком. */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct hmac_pbkdf2_range {
+  /*! \brief Немаскированные состояния функции хеширования после обработки блоков
+      \f$ K \oplus ipad \f$ и \f$ K \oplus opad \f$. */
+   ak_streebog states;
+  /*! \brief Количество итераций алгоритма. */
+   size_t cnt;
+  /*! \brief Блоки ключевого вектора; перед вычислениями блоки содержат значения \f$ U_1 \f$. */
+   ak_uint64 *out;
+  /*! \brief Количество блоков. */
+   size_t count;
+ #ifdef LIBAKRYPT_HAVE_PTHREAD
+  /*! \brief Поток, вычисляющий блоки. */
+   pthread_t thread;
+ #endif
+} *ak_hmac_pbkdf2_range;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вычисляет блоки \f$ T_i = U_1 \oplus \ldots \oplus U_c \f$ ключевого вектора.
+    \details Каждая итерация \f$ U_{j+1} = HMAC( P, U_j ) \f$ вычисляется двумя вызовами
+    функции ak_hash_context_streebog_block() от заранее вычисленных состояний, без
+    повторного сжатия дополненного ключа и без обращения к контексту алгоритма HMAC.               */
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_hmac_pbkdf2_range_blocks( void *ptr )
+{
+  size_t i = 0, j = 0, k = 0;
+  ak_uint64 u[8], *t = NULL;
+  ak_hmac_pbkdf2_range range = ( ak_hmac_pbkdf2_range ) ptr;
+
+  for( i = 0; i < range->count; i++ ) {
+     t = range->out + 8*i;
+     memcpy( u, t, 64 );
+     for( j = 1; j < range->cnt; j++ ) {
+        ak_hash_context_streebog_block( range->states + ak_hmac_ipad, u, u );
+        ak_hash_context_streebog_block( range->states + ak_hmac_opad, u, u );
+        for( k = 0; k < 8; k++ ) t[k] ^= u[k];
+     }
+  }
+  memset( u, 0, sizeof( u ));
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество потоков, вычисляющих блоки ключевого вектора.
+    \details Количество определяется опцией библиотеки `hash_thread_count`; нулевое значение
+    опции означает использование всех доступных процессоров.                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static size_t ak_hmac_pbkdf2_threads( const size_t blocks )
+{
+#ifdef LIBAKRYPT_HAVE_PTHREAD
+  ak_int64 count = ak_libakrypt_get_option( "hash_thread_count" );
+
+  if( count <= 0 ) {
+   #if defined( LIBAKRYPT_HAVE_UNISTD_H ) && defined( _SC_NPROCESSORS_ONLN )
+    count = (ak_int64) sysconf( _SC_NPROCESSORS_ONLN );
+   #else
+    count = 1;
+   #endif
+  }
+  if( count > ak_hmac_pbkdf2_max_threads ) count = ak_hmac_pbkdf2_max_threads;
+  if( count > (ak_int64) blocks ) count = (ak_int64) blocks;
+ return count < 1 ? 1 : (size_t) count;
+#else
+  (void) blocks;
+ return 1;
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Пароль должен представлять собой ненулевую строку символов в utf8 кодировке.
     При выработке используется алгоритм hmac-streebog512.
 
+    Ключевой вектор длины не более 64 байт, как и ранее, образуют последние dklen байт блока
+    \f$ T_1 \f$. Ключевой вектор большей длины образуют первые dklen байт последовательности
+    блоков \f$ T_1 || T_2 || \ldots \f$, где блок \f$ T_i \f$ вычисляется для значения
+    счетчика INT(i), как это определено в Р 50.1.111-2016. Блоки вычисляются независимо
+    друг от друга в нескольких потоках, количество которых определяется опцией библиотеки
+    `hash_thread_count`.
+
+    Итерации алгоритма вычисляются непосредственно от состояний функции хеширования,
+    полученных при присвоении ключа, поэтому каждая итерация требует только восьми
+    вызовов функции сжатия.
+
     @param pass Пароль, строка символов в utf8 кодировке.
     @param pass_size Размер пароля в байтах, должен быть отличен от нуля.
     @param salt Строка с инициализационным вектором (произвольная область памяти). Данное значение
@@ -519,8 +851,8 @@
     @param cnt Параметр, определяющий количество однотипных итераций для выработки ключа; данный
     параметр определяет время работы алгоритма; параметр не является секретным и может храниться или
     передаваться в открытом виде.
-    @param dklen Длина вырабатываемого ключевого вектора в байтах, величина должна принимать
-    значение от 32-х до 64-х.
+    @param dklen Длина вырабатываемого ключевого вектора в байтах, величина должна быть
+    отлична от нуля и не превосходить \f$ 64(2^{32}-1) \f$.
     @param out Указатель на массив, куда будет помещен результат; под данный массив должна быть
     заранее выделена память не менее, чем dklen байт.
 
@@ -532,9 +864,15 @@
                                                                const size_t dklen, ak_pointer out )
 {
   struct hmac hctx;
-  ak_uint8 result[64];
+  ak_uint8 counter[4];
+  struct streebog states[2];
   int error = ak_error_ok;
-  size_t idx = 0, jdx = 0;
+  size_t idx = 0, threads = 0, count = 0, blocks = 0;
+  ak_uint64 single[8], *result = single;
+  struct hmac_pbkdf2_range ranges[ak_hmac_pbkdf2_max_threads];
+ #ifdef LIBAKRYPT_HAVE_PTHREAD
+  bool_t started[ak_hmac_pbkdf2_max_threads];
+ #endif
 
  /* в начале, многочисленные проверки входных параметров */
   if( pass == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
@@ -543,46 +881,92 @@
                                                                    "using a zero length password" );
   if( salt == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
                                                                      "using null pointer to salt" );
-  if(( dklen < 32 ) || ( dklen > 64 )) return ak_error_message( ak_error_wrong_length,
-                                       __func__ , "using a wrong length for resulting key vector" );
+  if(( dklen == 0 ) || (( dklen - 1 ) >> 6 ) >= 0xFFFFFFFFLL )
+    return ak_error_message( ak_error_wrong_length, __func__ ,
+                                                  "using a wrong length for resulting key vector" );
   if( out == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
                                                      "using null pointer to resulting key vector" );
+  blocks = (( dklen - 1 ) >> 6 ) + 1;
+  if(( blocks > 1 ) && (( result = malloc( blocks*64 )) == NULL ))
+    return ak_error_message( ak_error_out_of_memory, __func__ ,
+                                                 "memory allocation error for key vector blocks" );
+
  /* создаем контекст алгоритма hmac и определяем его ключ */
-  if(( error = ak_hmac_context_create_streebog512( &hctx )) != ak_error_ok )
-    return ak_error_message( error, __func__, "wrong creation of hmac-streebog512 key context" );
+  memset( states, 0, sizeof( states ));
+  if(( error = ak_hmac_context_create_streebog512( &hctx )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "wrong creation of hmac-streebog512 key context" );
+    if( result != single ) free( result );
+    return error;
+  }
   if(( error = ak_hmac_context_set_key( &hctx, pass, pass_size )) != ak_error_ok ) {
     ak_error_message( error, __func__, "wrong initialization of hmac-streebog512 secret key" );
     goto lab_exit;
   }
 
- /* начальная инициализация промежуточного вектора */
-  memset( result, 0, 64 );
-  result[3] = 1;
-
- /* вычисляем значение первой строки U1  */
-  if(( error = ak_hmac_context_clean( &hctx )) != ak_error_ok ) {
-    ak_error_message( error, __func__, "incorrect cleaning of internal hmac context");
-    goto lab_exit;
-  }
-  if(( error = ak_hmac_context_update( &hctx, salt, salt_size )) != ak_error_ok ) {
-    ak_error_message( error, __func__, "incorrect updating of internal hmac context");
-    goto lab_exit;
+ /* вычисляем значения U1 для каждого блока ключевого вектора */
+  for( idx = 0; idx < blocks; idx++ ) {
+     counter[0] = ( ak_uint8 )(( idx+1 ) >> 24 );
+     counter[1] = ( ak_uint8 )(( idx+1 ) >> 16 );
+     counter[2] = ( ak_uint8 )(( idx+1 ) >> 8 );
+     counter[3] = ( ak_uint8 )( idx+1 );
+     if(( error = ak_hmac_context_clean( &hctx )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "incorrect cleaning of internal hmac context");
+       goto lab_exit;
+     }
+     if(( error = ak_hmac_context_update( &hctx, salt, salt_size )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "incorrect updating of internal hmac context");
+       goto lab_exit;
+     }
+     if(( error = ak_hmac_context_finalize( &hctx, counter, 4,
+                                                            result + 8*idx, 64 )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "incorrect finalizing of internal mac context");
+       goto lab_exit;
+     }
   }
-  if(( error = ak_hmac_context_finalize( &hctx, result, 4,
-                                                      result, sizeof( result ))) != ak_error_ok ) {
-    ak_error_message( error, __func__, "incorrect finalizing of internal mac context");
-    goto lab_exit;
-  }
-  memcpy( out, result+64-dklen, dklen );
 
- /* теперь основной цикл по значению аргумента c */
-  for( idx = 1; idx < cnt; idx++ ) {
-     ak_hmac_context_ptr( &hctx, result, 64, result, sizeof( result ));
-     for( jdx = 0; jdx < dklen; jdx++ ) ((ak_uint8 *)out)[jdx] ^= result[64-dklen+jdx];
+ /* теперь основной цикл по значению аргумента c, вычисляемый от немаскированных состояний */
+  if( cnt > 1 ) {
+    for( idx = ak_hmac_ipad; idx <= ak_hmac_opad; idx++ ) {
+       if(( error = ak_hmac_context_load_pad( &hctx, ( int ) idx )) != ak_error_ok ) {
+         ak_error_message( error, __func__, "incorrect loading of hmac state" );
+         goto lab_exit;
+       }
+       memcpy( states + idx, &hctx.ctx.data.sctx, sizeof( struct streebog ));
+    }
+    ak_hash_context_clean( &hctx.ctx );
+
+    threads = ak_hmac_pbkdf2_threads( blocks );
+    memset( ranges, 0, sizeof( ranges ));
+    for( idx = 0; idx < threads; idx++ ) {
+       ranges[idx].states = states;
+       ranges[idx].cnt = cnt;
+       ranges[idx].out = result + 8*count;
+       ranges[idx].count = blocks/threads + ( idx < blocks%threads ? 1 : 0 );
+       count += ranges[idx].count;
+    }
+   #ifdef LIBAKRYPT_HAVE_PTHREAD
+    for( idx = 1; idx < threads; idx++ )
+       started[idx] = ( pthread_create( &ranges[idx].thread, NULL,
+                                          ak_hmac_pbkdf2_range_blocks, ranges+idx ) == 0 );
+    ak_hmac_pbkdf2_range_blocks( ranges );
+    for( idx = 1; idx < threads; idx++ ) {
+       if( started[idx] ) pthread_join( ranges[idx].thread, NULL );
+         else ak_hmac_pbkdf2_range_blocks( ranges+idx );
+    }
+   #else
+    for( idx = 0; idx < threads; idx++ ) ak_hmac_pbkdf2_range_blocks( ranges+idx );
+   #endif
   }
-  memset( result, 0, 64 );
 
-  lab_exit: ak_hmac_context_destroy( &hctx );
+ /* короткий ключевой вектор образуют последние октеты первого блока */
+  if( dklen <= 64 ) memcpy( out, (( ak_uint8 *) result ) + 64 - dklen, dklen );
+    else memcpy( out, result, dklen );
+
+  lab_exit:
+   ak_ptr_context_wipe( states, sizeof( states ), &hctx.key.generator );
+   ak_ptr_context_wipe( result, 64*blocks, &hctx.key.generator );
+   if( result != single ) free( result );
+   ak_hmac_context_destroy( &hctx );
  return error;
 }
 
@@ -800,12 +1184,25 @@
    0x78, 0xcc, 0xb8, 0x79, 0xf6, 0x70, 0x68, 0xcd, 0xac, 0x19, 0x10, 0x74, 0x08, 0x44, 0xe8, 0x30
   };
 
+ /* ключевой вектор длины 100 октетов (первые октеты последовательности T1 || T2) */
+  ak_uint8 R5[100] = {
+   0xb2, 0xd8, 0xf1, 0x24, 0x5f, 0xc4, 0xd2, 0x92, 0x74, 0x80, 0x20, 0x57, 0xe4, 0xb5, 0x4e, 0x0a,
+   0x07, 0x53, 0xaa, 0x22, 0xfc, 0x53, 0x76, 0x0b, 0x30, 0x1c, 0xf0, 0x08, 0x67, 0x9e, 0x58, 0xfe,
+   0x4b, 0xee, 0x9a, 0xdd, 0xca, 0xe9, 0x9b, 0xa2, 0xb0, 0xb2, 0x0f, 0x43, 0x1a, 0x9c, 0x5e, 0x50,
+   0xf3, 0x95, 0xc8, 0x93, 0x87, 0xd0, 0x94, 0x5a, 0xed, 0xec, 0xa6, 0xeb, 0x40, 0x15, 0xdf, 0xc2,
+   0xbd, 0x24, 0x21, 0xee, 0x9b, 0xb7, 0x11, 0x83, 0xba, 0x88, 0x2c, 0xee, 0xbf, 0xef, 0x25, 0x9f,
+   0x33, 0xf9, 0xe2, 0x7d, 0xc6, 0x17, 0x8c, 0xb8, 0x9d, 0xc3, 0x74, 0x28, 0xcf, 0x9c, 0xc5, 0x2a,
+   0x2b, 0xaa, 0x2d, 0x3a
+  };
+
   ak_uint8 password_one[8] = "password",
            password_two[9] = { 'p', 'a', 's', 's', 0, 'w', 'o', 'r', 'd' },
            salt_one[4]     = "salt",
-           salt_two[5]     = { 's', 'a', 0, 'l', 't' };
+           salt_two[5]     = { 's', 'a', 0, 'l', 't' },
+           password_three[24] = "passwordPASSWORDpassword",
+           salt_three[36]  = "saltSALTsaltSALTsaltSALTsaltSALTsalt";
 
-  ak_uint8 out[64];
+  ak_uint8 out[100];
   int error = ak_error_ok;
   int audit = ak_log_get_level();
 
@@ -864,12 +1261,27 @@
   }
   if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
                                              "the 4th test for pbkdf2 from R 50.1.111-2016 is Ok" );
+
+ /* пятый тест из Р 50.1.111-2016 */
+  if(( error = ak_hmac_context_pbkdf2_streebog512( password_three, 24,
+                                               salt_three, 36, 4096, 100, out )) != ak_error_ok ) {
+    ak_error_message( error,__func__, "incorrect transformation password to key");
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, R5, 100 )) {
+    ak_error_message( ak_error_not_equal_data, __func__ ,
+                                                 "wrong 5th test for pbkdf2 from R 50.1.111-2016" );
+    return ak_false;
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                             "the 5th test for pbkdf2 from R 50.1.111-2016 is Ok" );
  return ak_true;
 }
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \example test-hmac01.c                                                                         */
 /*! \example test-hmac02.c                                                                         */
+/*! \example test-hmac03.c                                                                         */
 /* ----------------------------------------------------------------------------------------------- */
 /*                                                                                      ak_hmac.c  */
 /* ----------------------------------------------------------------------------------------------- */
@@ -34,6 +34,10 @@
    struct mac mctx;
   /*! \brief Контекст функции хеширования */
    struct hash ctx;
+  /*! \brief Состояния функции хеширования (векторы h, n и \f$ \Sigma \f$) после обработки
+      блоков \f$ K \oplus ipad \f$ и \f$ K \oplus opad \f$; первые два состояния маскированы,
+      следующие два являются их масками (аналогично хранению ключа) */
+   ak_uint64 pads[4][24];
 } *ak_hmac;
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -68,11 +72,24 @@
  int ak_hmac_context_update( ak_hmac , const ak_pointer , const size_t );
 /*! \brief Завершение алгоритма выработки имитовставки HMAC. */
  int ak_hmac_context_finalize( ak_hmac , const ak_pointer , const size_t , ak_pointer , const size_t );
+/*! \brief Обновление состояния контекста данными, расположенными в нескольких фрагментах. */
+ int ak_hmac_context_update_fragments( ak_hmac , ak_fragment , const size_t );
+/*! \brief Завершение вычислений для данных, расположенных в нескольких фрагментах. */
+ int ak_hmac_context_finalize_fragments( ak_hmac , ak_fragment , const size_t ,
+                                                                       ak_pointer , const size_t );
 /*! \brief Вычисление имитовставки для заданной области памяти. */
  int ak_hmac_context_ptr( ak_hmac , const ak_pointer , const size_t , ak_pointer , const size_t );
 /*! \brief Вычисление имитовставки для заданного файла. */
  int ak_hmac_context_file( ak_hmac , const char* , ak_pointer , const size_t );
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Создание нового контекста HMAC с тем же ключом и копией промежуточного состояния. */
+ int ak_hmac_context_clone( ak_hmac , ak_hmac );
+/*! \brief Сохранение промежуточного состояния алгоритма выработки имитовставки HMAC. */
+ int ak_hmac_context_export( ak_hmac , ak_pointer , size_t * );
+/*! \brief Восстановление промежуточного состояния алгоритма выработки имитовставки HMAC. */
+ int ak_hmac_context_import( ak_hmac , const ak_pointer , const size_t );
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Развертка ключевого вектора из пароля (согласно Р 50.1.111-2016, раздел 4) */
  int ak_hmac_context_pbkdf2_streebog512( const ak_pointer , const size_t ,
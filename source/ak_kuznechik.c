@@ -20,6 +20,9 @@
 #else
  #error Library cannot be compiled without string.h header
 #endif
+#ifdef LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8
+ #include <tmmintrin.h>
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Развернутые раундовые ключи и маски алгоритма Кузнечик.
@@ -49,19 +52,6 @@
  return z;
 }
 
-/* ----------------------------------------------------------------------------------------------- */
-/*! \brief Функция умножает вектор w на матрицу D, результат помещается в вектор x.                */
-/* ----------------------------------------------------------------------------------------------- */
- static void ak_kuznechik_matrix_mul_vector( linear_matrix D, ak_uint8 *w, ak_uint8* x )
-{
-  int i = 0, j = 0;
-  for( i = 0; i < 16; i++ ) {
-    ak_uint8 z = ak_bckey_context_kuznechik_mul_gf256( D[i][0], w[0] );
-    for( j = 1; j < 16; j++ ) z ^= ak_bckey_context_kuznechik_mul_gf256( D[i][j], w[j] );
-    x[i] = z;
-  }
-}
-
 /* ---------------------------------------------------------------------------------------------- */
 /*! \brief Функция возводит квадратную матрицу в квадрат. */
 /* ---------------------------------------------------------------------------------------------- */
@@ -82,23 +72,6 @@
    for( j = 0; j < 16; j++ ) a[i][j] = c[i][j];
 }
 
-/* ---------------------------------------------------------------------------------------------- */
-/*! \brief Функция реализует линейное преобразование L согласно ГОСТ Р 34.12-2015
-    (шестнадцать тактов работы линейного регистра сдвига).                                        */
-/* ---------------------------------------------------------------------------------------------- */
- static void ak_kuznechik_linear_steps( ak_uint8 *w  )
-{
-  int i = 0, j = 0;
-  for( j = 0; j < 16; j++ ) {
-     ak_uint8 z = w[0];
-     for( i = 1; i < 16; i++ ) {
-        w[i-1] = w[i];
-        z ^= ak_bckey_context_kuznechik_mul_gf256( w[i], kuznechik_parameters.reg[i] );
-     }
-     w[15] = z;
-  }
-}
-
 /* ----------------------------------------------------------------------------------------------- */
 /*! Для заданного линейного регистра сдвига, задаваемого набором коэффициентов `reg`,
     функция вычисляет 16-ю степень сопровождающей матрицы.
@@ -173,6 +146,36 @@
        memcpy( par->dec[i][j], ib, 16 );
      }
   }
+
+ /* вырабатываем компактные таблицы: произведения столбцов матриц на значения полуоктетов */
+  for( i = 0; i < 16; i++ ) {
+     for( j = 0; j < 16; j++ ) {
+       ak_uint8 b[16], ib[16];
+       for( l = 0; l < 16; l++ ) {
+          b[15*oc + (1-2*oc)*l] = ak_bckey_context_kuznechik_mul_gf256( par->L[l][i], j );
+          ib[15*oc + (1-2*oc)*l] = ak_bckey_context_kuznechik_mul_gf256( par->Linv[l][i], j );
+       }
+       memcpy( par->cenc[i][0][j], b, 16 );
+       memcpy( par->cdec[i][0][j], ib, 16 );
+       for( l = 0; l < 16; l++ ) {
+          b[15*oc + (1-2*oc)*l] =
+                         ak_bckey_context_kuznechik_mul_gf256( par->L[l][i], ( ak_uint8 )( j << 4 ));
+          ib[15*oc + (1-2*oc)*l] =
+                      ak_bckey_context_kuznechik_mul_gf256( par->Linv[l][i], ( ak_uint8 )( j << 4 ));
+       }
+       memcpy( par->cenc[i][1][j], b, 16 );
+       memcpy( par->cdec[i][1][j], ib, 16 );
+     }
+  }
+
+ /* вырабатываем константы процедуры развертки ключа, т.е. значения L( i ), i = 1, ..., 32 */
+  for( i = 0; i < 32; i++ ) {
+     ak_uint8 b[16];
+     for( l = 0; l < 16; l++ )
+        b[15*oc + (1-2*oc)*l] =
+                       ak_bckey_context_kuznechik_mul_gf256( par->L[l][0], ( ak_uint8 )( i+1 ));
+     memcpy( par->cst[i], b, 16 );
+  }
  return ak_error_ok;
 }
 
@@ -219,8 +222,52 @@
  return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вычисляет значение преобразования LS, используя развернутые таблицы зашифрования.
+    \details Входной и выходной векторы записаны в том же представлении, что и развернутые
+    таблицы; допускается совпадение указателей `x` и `y`.                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_ls_table( const ak_uint64 *x, ak_uint64 *y, const int oc )
+{
+  int i = 0;
+  ak_uint64 t = 0, s = 0;
+  const ak_uint8 *b = ( const ak_uint8 *)x;
+
+  for( i = 0; i < 16; i++ ) {
+     t ^= kuznechik_parameters.enc[i][b[15*oc + (1-2*oc)*i]][0];
+     s ^= kuznechik_parameters.enc[i][b[15*oc + (1-2*oc)*i]][1];
+  }
+  y[0] = t; y[1] = s;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вычисляет значение обратного линейного преобразования,
+    используя развернутые таблицы расшифрования.
+    \details Поскольку таблицы расшифрования содержат значения преобразования
+    \f$ L^{-1}\pi^{-1} \f$, перед обращением к таблице к каждому байту применяется
+    прямая перестановка \f$ \pi \f$. Допускается совпадение указателей `x` и `y`.                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_linv_table( const ak_uint64 *x, ak_uint64 *y, const int oc )
+{
+  int i = 0;
+  ak_uint64 t = 0, s = 0;
+  const ak_uint8 *b = ( const ak_uint8 *)x;
+
+  for( i = 0; i < 16; i++ ) {
+     ak_uint8 v = kuznechik_parameters.pi[b[15*oc + (1-2*oc)*i]];
+     t ^= kuznechik_parameters.dec[i][v][0];
+     s ^= kuznechik_parameters.dec[i][v][1];
+  }
+  y[0] = t; y[1] = s;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Функция реализует развертку ключей для алгоритма Кузнечик.
+    \details Все вычисления выполняются с помощью развернутых таблиц и заранее
+    вычисленных констант, в том же представлении данных, что и при зашифровании;
+    это позволяет обойтись без побитового умножения в конечном поле и существенно
+    снижает время смены ключа (например, в режиме ACPKM).
+
     \param skey Указатель на контекст секретного ключа, в который помещаются развернутые
     раундовые ключи и маски.
     \return Функция возвращает \ref ak_error_ok в случае успеха.
@@ -228,10 +275,9 @@
 /* ----------------------------------------------------------------------------------------------- */
  static int ak_kuznechik_schedule_keys( ak_skey skey )
 {
-  ak_uint8 reverse[64];
-  int i = 0, j = 0, l = 0, kdx = 2;
-  ak_uint64 a0[2], a1[2], c[2], t[2], idx = 0;
-  ak_int64 oc = ak_libakrypt_get_option( "openssl_compability" );
+  int i = 0, j = 0, idx = 0, kdx = 2;
+  ak_uint64 a0[2], a1[2], t[2];
+  int oc = (int) ak_libakrypt_get_option( "openssl_compability" );
   ak_uint64 *ekey = NULL, *mkey = NULL, *dkey = NULL, *xkey = NULL, *rkey = NULL, *lkey = NULL;
 
  /* выполняем стандартные проверки */
@@ -239,61 +285,52 @@
                                                             "using a null pointer to secret key" );
   if( skey->key_size != 32 ) return ak_error_message( ak_error_null_pointer, __func__ ,
                                                               "unsupported length of secret key" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
  /* проверяем целостность ключа */
   if( skey->check_icode( skey ) != ak_true ) return ak_error_message( ak_error_wrong_key_icode,
                                                 __func__ , "using key with wrong integrity code" );
- /* удаляем былое */
-  if( skey->data != NULL ) ak_kuznechik_delete_keys( skey );
-
- /* далее, по-возможности, выделяем выравненную память */
-  if(( skey->data = ak_libakrypt_aligned_malloc( sizeof( ak_kuznechik_expanded_keys ))) == NULL )
-    return ak_error_message( ak_error_out_of_memory, __func__ ,
+ /* память выделяется только при первой развертке, при повторной развертке
+    (например, при выработке производных ключей ACPKM) значения перезаписываются */
+  if( skey->data == NULL ) {
+   /* по-возможности, выделяем выравненную память */
+    if(( skey->data = ak_libakrypt_aligned_malloc( sizeof( ak_kuznechik_expanded_keys ))) == NULL )
+      return ak_error_message( ak_error_out_of_memory, __func__ ,
                                                              "wrong allocation of internal data" );
+  }
  /* получаем указатели на области памяти */
   ekey = ( ak_uint64 *)skey->data;                  /* 10 прямых раундовых ключей */
   dkey = ( ak_uint64 *)skey->data + 20;           /* 10 обратных раундовых ключей */
   mkey = ( ak_uint64 *)skey->data + 40;   /* 10 масок для прямых раундовых ключей */
   xkey = ( ak_uint64 *)skey->data + 60; /* 10 масок для обратных раундовых ключей */
-  if( oc ) { /* разворачиваем ключ в каноническое представление */
-    for( i = 0; i < 32; i++ ) {
-       reverse[i] = skey->key[31-i];
-       reverse[32+i] = skey->key[63-i];
-    }
-    lkey = ( ak_uint64 *)reverse;
-    rkey = ( ak_uint64 *)( reverse + skey->key_size );
-  } else {
-    lkey = ( ak_uint64 *)skey->key; /* исходный ключ */
-    rkey = ( ak_uint64 *)( skey->key + skey->key_size );
-  }
+  lkey = ( ak_uint64 *)skey->key;                                    /* исходный ключ */
+  rkey = ( ak_uint64 *)( skey->key + skey->key_size );               /* маска ключа */
 
  /* за один вызов вырабатываем маски для прямых и обратных ключей */
   skey->generator.random( &skey->generator, mkey, 40*sizeof( ak_uint64 ));
 
- /* только теперь выполняем алгоритм развертки ключа */
-  a0[0] = lkey[0]^rkey[0]; a0[1] = lkey[1]^rkey[1];
-  a1[0] = lkey[2]^rkey[2]; a1[1] = lkey[3]^rkey[3];
+ /* только теперь выполняем алгоритм развертки ключа;
+    в симметричном представлении половины ключа меняются местами */
+  if( oc ) {
+    a1[0] = lkey[0]^rkey[0]; a1[1] = lkey[1]^rkey[1];
+    a0[0] = lkey[2]^rkey[2]; a0[1] = lkey[3]^rkey[3];
+  } else {
+    a0[0] = lkey[0]^rkey[0]; a0[1] = lkey[1]^rkey[1];
+    a1[0] = lkey[2]^rkey[2]; a1[1] = lkey[3]^rkey[3];
+  }
 
   ekey[0] = a1[0]^mkey[0]; ekey[1] = a1[1]^mkey[1];
   dkey[0] = a1[0]^xkey[0]; dkey[1] = a1[1]^xkey[1];
 
   ekey[2] = a0[0]^mkey[2]; ekey[3] = a0[1]^mkey[3];
-  ak_kuznechik_matrix_mul_vector( kuznechik_parameters.Linv,
-                                            (ak_uint8 *)a0, (ak_uint8 *)( dkey+2 ));
+  ak_kuznechik_linv_table( a0, dkey+2, oc );
   dkey[2] ^= xkey[2]; dkey[3] ^= xkey[3];
 
   for( j = 0; j < 4; j++ ) {
-     for( i = 0; i < 8; i++ ) {
-      #ifdef LIBAKRYPT_LITTLE_ENDIAN
-        c[0] = ++idx; /* вычисляем константу алгоритма согласно ГОСТ Р 34.12-2015 */
-      #else
-        c[0] = bswap_64( ++idx );
-      #endif
-        c[1] = 0;
-        ak_kuznechik_linear_steps(( ak_uint8 *)c );
-
-        t[0] = a1[0] ^ c[0]; t[1] = a1[1] ^ c[1];
-        for( l = 0; l < 16; l++ ) ((ak_uint8 *)t)[l] = gost_pi[ ((ak_uint8 *)t)[l]];
-        ak_kuznechik_linear_steps(( ak_uint8 *)t );
+     for( i = 0; i < 8; i++, idx++ ) {
+        t[0] = a1[0] ^ kuznechik_parameters.cst[idx][0];
+        t[1] = a1[1] ^ kuznechik_parameters.cst[idx][1];
+        ak_kuznechik_ls_table( t, t, oc );
 
         t[0] ^= a0[0]; t[1] ^= a0[1];
         a0[0] = a1[0]; a0[1] = a1[1];
@@ -301,35 +338,15 @@
      }
      kdx += 2;
      ekey[kdx] = a1[0]^mkey[kdx]; ekey[kdx+1] = a1[1]^mkey[kdx+1];
-     ak_kuznechik_matrix_mul_vector( kuznechik_parameters.Linv,
-                                         ( ak_uint8 *)a1, (ak_uint8 *)( dkey+kdx ));
+     ak_kuznechik_linv_table( a1, dkey+kdx, oc );
      dkey[kdx] ^= xkey[kdx]; dkey[kdx+1] ^= xkey[kdx+1];
 
      kdx += 2;
      ekey[kdx] = a0[0]^mkey[kdx]; ekey[kdx+1] = a0[1]^mkey[kdx+1];
-     ak_kuznechik_matrix_mul_vector( kuznechik_parameters.Linv,
-                                         ( ak_uint8 *)a0, (ak_uint8 *)( dkey+kdx ));
+     ak_kuznechik_linv_table( a0, dkey+kdx, oc );
      dkey[kdx] ^= xkey[kdx]; dkey[kdx+1] ^= xkey[kdx+1];
   }
 
-  if( oc ) { /* теперь инвертируем обратно вычисленные значения */
-    ak_uint8 ch, *pe = (ak_uint8 *)ekey, *pm = (ak_uint8 *)mkey;
-    for( i = 0; i < 160; i +=16 ) {
-       for( j = 0; j < 8; j++ ) {
-         ch = pe[i+j]; pe[i+j] = pe[i+15-j]; pe[i+15-j] = ch;
-         ch = pm[i+j]; pm[i+j] = pm[i+15-j]; pm[i+15-j] = ch;
-       }
-    }
-    pe = (ak_uint8 *)dkey; pm = (ak_uint8 *)xkey;
-    for( i = 0; i < 160; i +=16 ) {
-       for( j = 0; j < 8; j++ ) {
-         ch = pe[i+j]; pe[i+j] = pe[i+15-j]; pe[i+15-j] = ch;
-         ch = pm[i+j]; pm[i+j] = pm[i+15-j]; pm[i+15-j] = ch;
-       }
-    }
-    ak_ptr_context_wipe( reverse, sizeof( reverse ), &skey->generator );
-  }
-
  return ak_error_ok;
 }
 
@@ -589,6 +606,1131 @@
   (( ak_uint64 *) out)[1] = x[1] ^ xkey[1];
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                        многоблочная (чередующаяся) реализация алгоритма                         */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество блоков, одновременно обрабатываемых многоблочной реализацией
+    алгоритма Кузнечик. */
+ #define ak_kuznechik_lanes_count (8)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует одно преобразование LS (или обратное к нему) над блоком,
+    записанным в виде двух 64-х битных слов, с использованием развернутой таблицы.
+
+    \param x Обрабатываемый блок; результат преобразования помещается на его место.
+    \param table Развернутая таблица (прямая или обратная).
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_lane_round( ak_uint64 *x,
+                                                            expanded_table table, const int oc )
+{
+  int l = 0;
+  ak_uint64 t = 0, s = 0;
+  const ak_uint8 *b = ( const ak_uint8 *)x;
+
+  for( l = 0; l < 16; l++ ) {
+     t ^= table[l][b[oc ? 15-l : l]][0];
+     s ^= table[l][b[oc ? 15-l : l]][1];
+  }
+  x[0] = t; x[1] = s;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует алгоритм зашифрования \ref ak_kuznechik_lanes_count последовательно
+    расположенных блоков информации шифром Кузнечик (согласно ГОСТ Р 34.12-2015).
+
+    Блоки обрабатываются одновременно: на каждом раунде преобразование применяется ко всем
+    блокам, и цепочки зависимых обращений к таблицам различных блоков выполняются
+    процессором параллельно. Маскирование раундовых ключей выполняется
+    так же, как и в функции ak_kuznechik_encrypt_with_mask().
+
+    \param skey Контекст секретного ключа.
+    \param in Указатель на входные данные.
+    \param out Указатель на выходные данные (может совпадать с `in`).
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_encrypt_lanes_with_mask( ak_skey skey,
+                                                    ak_uint64 *in, ak_uint64 *out, const int oc )
+{
+  int i = 0, j = 0;
+  ak_uint64 *ekey = ( ak_uint64 *)skey->data;
+  ak_uint64 *mkey = ( ak_uint64 *)skey->data + 40;
+  ak_uint64 x[ak_kuznechik_lanes_count][2];
+
+  for( j = 0; j < ak_kuznechik_lanes_count; j++ ) { x[j][0] = in[2*j]; x[j][1] = in[2*j+1]; }
+  for( i = 0; i < 18; i += 2 ) {
+     for( j = 0; j < ak_kuznechik_lanes_count; j++ ) {
+        x[j][0] ^= ekey[i];   x[j][0] ^= mkey[i];
+        x[j][1] ^= ekey[i+1]; x[j][1] ^= mkey[i+1];
+        ak_kuznechik_lane_round( x[j], kuznechik_parameters.enc, oc );
+     }
+  }
+  for( j = 0; j < ak_kuznechik_lanes_count; j++ ) {
+     x[j][0] ^= ekey[18]; x[j][1] ^= ekey[19];
+     out[2*j] = x[j][0] ^ mkey[18];
+     out[2*j+1] = x[j][1] ^ mkey[19];
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует алгоритм расшифрования \ref ak_kuznechik_lanes_count последовательно
+    расположенных блоков информации шифром Кузнечик (согласно ГОСТ Р 34.12-2015).
+
+    \param skey Контекст секретного ключа.
+    \param in Указатель на входные данные.
+    \param out Указатель на выходные данные (может совпадать с `in`).
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_decrypt_lanes_with_mask( ak_skey skey,
+                                                    ak_uint64 *in, ak_uint64 *out, const int oc )
+{
+  int i = 0, j = 0, l = 0;
+  ak_uint64 *dkey = ( ak_uint64 *)skey->data + 20;
+  ak_uint64 *xkey = ( ak_uint64 *)skey->data + 60;
+  ak_uint64 x[ak_kuznechik_lanes_count][2];
+
+  for( j = 0; j < ak_kuznechik_lanes_count; j++ ) {
+     ak_uint8 *b = ( ak_uint8 *)x[j];
+     x[j][0] = in[2*j]; x[j][1] = in[2*j+1];
+     for( l = 0; l < 16; l++ ) b[l] = kuznechik_parameters.pi[b[l]];
+  }
+  for( i = 19; i > 1; i -= 2 ) {
+     for( j = 0; j < ak_kuznechik_lanes_count; j++ ) {
+        ak_kuznechik_lane_round( x[j], kuznechik_parameters.dec, oc );
+        x[j][1] ^= dkey[i];   x[j][1] ^= xkey[i];
+        x[j][0] ^= dkey[i-1]; x[j][0] ^= xkey[i-1];
+     }
+  }
+  for( j = 0; j < ak_kuznechik_lanes_count; j++ ) {
+     ak_uint8 *b = ( ak_uint8 *)x[j];
+     for( l = 0; l < 16; l++ ) b[l] = kuznechik_parameters.pinv[b[l]];
+     x[j][0] ^= dkey[0]; x[j][1] ^= dkey[1];
+     out[2*j] = x[j][0] ^ xkey[0];
+     out[2*j+1] = x[j][1] ^ xkey[1];
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик (согласно ГОСТ Р 34.12-2015).
+
+    Основная часть блоков обрабатывается группами по \ref ak_kuznechik_lanes_count блоков,
+    оставшиеся блоки зашифровываются по одному.
+
+    \param skey Контекст секретного ключа.
+    \param in Указатель на входные данные.
+    \param out Указатель на выходные данные (может совпадать с `in`).
+    \param blocks Количество обрабатываемых блоков.                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_blocks_with_mask( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= ak_kuznechik_lanes_count; blocks -= ak_kuznechik_lanes_count ) {
+     ak_kuznechik_encrypt_lanes_with_mask( skey, inptr, outptr, 0 );
+     inptr += 2*ak_kuznechik_lanes_count; outptr += 2*ak_kuznechik_lanes_count;
+  }
+  for( ; blocks > 0; blocks-- ) {
+     ak_kuznechik_encrypt_with_mask( skey, inptr, outptr );
+     inptr += 2; outptr += 2;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик (согласно ГОСТ Р 34.12-2015).                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_blocks_with_mask( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= ak_kuznechik_lanes_count; blocks -= ak_kuznechik_lanes_count ) {
+     ak_kuznechik_decrypt_lanes_with_mask( skey, inptr, outptr, 0 );
+     inptr += 2*ak_kuznechik_lanes_count; outptr += 2*ak_kuznechik_lanes_count;
+  }
+  for( ; blocks > 0; blocks-- ) {
+     ak_kuznechik_decrypt_with_mask( skey, inptr, outptr );
+     inptr += 2; outptr += 2;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик (согласно ГОСТ Р 34.12-2015).
+
+    Реализуется симметричное преобразование, введенное для совместимости с библиотекой openssl
+    и другими реализациями.                                                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_blocks_with_mask_oc( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= ak_kuznechik_lanes_count; blocks -= ak_kuznechik_lanes_count ) {
+     ak_kuznechik_encrypt_lanes_with_mask( skey, inptr, outptr, 1 );
+     inptr += 2*ak_kuznechik_lanes_count; outptr += 2*ak_kuznechik_lanes_count;
+  }
+  for( ; blocks > 0; blocks-- ) {
+     ak_kuznechik_encrypt_with_mask_oc( skey, inptr, outptr );
+     inptr += 2; outptr += 2;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик (согласно ГОСТ Р 34.12-2015).
+
+    Реализуется симметричное преобразование, введенное для совместимости с библиотекой openssl
+    и другими реализациями.                                                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_blocks_with_mask_oc( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= ak_kuznechik_lanes_count; blocks -= ak_kuznechik_lanes_count ) {
+     ak_kuznechik_decrypt_lanes_with_mask( skey, inptr, outptr, 1 );
+     inptr += 2*ak_kuznechik_lanes_count; outptr += 2*ak_kuznechik_lanes_count;
+  }
+  for( ; blocks > 0; blocks-- ) {
+     ak_kuznechik_decrypt_with_mask_oc( skey, inptr, outptr );
+     inptr += 2; outptr += 2;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательного сжатия нескольких блоков информации в режиме выработки
+    имитовставки шифром Кузнечик.
+
+    Для каждого блока вычисляется значение \f$ x = e_k( x \oplus in_i ) \f$; функция
+    зашифрования вызывается напрямую, что позволяет компилятору встроить ее в тело цикла.
+
+    \param skey Контекст секретного ключа.
+    \param in Указатель на входные данные.
+    \param state Текущее значение цепочки (16 октетов), изменяется функцией.
+    \param blocks Количество обрабатываемых блоков.                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_mac_blocks_with_mask( ak_skey skey,
+                                                ak_pointer in, ak_pointer state, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *x = ( ak_uint64 *)state;
+
+  for( ; blocks > 0; blocks--, inptr += 2 ) {
+     x[0] ^= inptr[0]; x[1] ^= inptr[1];
+     ak_kuznechik_encrypt_with_mask( skey, x, x );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательного сжатия нескольких блоков информации в режиме выработки
+    имитовставки шифром Кузнечик (симметричное преобразование, совместимое с openssl).            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_mac_blocks_with_mask_oc( ak_skey skey,
+                                                ak_pointer in, ak_pointer state, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *x = ( ak_uint64 *)state;
+
+  for( ; blocks > 0; blocks--, inptr += 2 ) {
+     x[0] ^= inptr[0]; x[1] ^= inptr[1];
+     ak_kuznechik_encrypt_with_mask_oc( skey, x, x );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                      реализация алгоритма с использованием компактных таблиц                    */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество блоков, одновременно обрабатываемых реализацией алгоритма Кузнечик,
+    использующей компактные таблицы. */
+ #define ak_kuznechik_compact_lanes_count (4)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует одно преобразование LS (или обратное к нему) над блоком,
+    записанным в виде двух 64-х битных слов, с использованием компактной таблицы.
+
+    В отличие от функции ak_kuznechik_lane_round(), нелинейное преобразование выполняется
+    отдельно, а линейное преобразование вычисляется по значениям полуоктетов. Это удваивает
+    количество обращений к памяти, однако весь используемый объем таблиц (8 Кбайт таблицы
+    и 256 октетов перестановки) целиком помещается в кэш первого уровня и не вытесняет из
+    него данные других приложений.
+
+    \param x Обрабатываемый блок; результат преобразования помещается на его место.
+    \param table Компактная таблица (прямая или обратная).
+    \param s Нелинейная перестановка, применяемая к октетам блока перед линейным преобразованием.
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_compact_round( ak_uint64 *x,
+                                          compact_table table, const ak_uint8 *s, const int oc )
+{
+  int l = 0;
+  ak_uint64 t = 0, u = 0;
+  const ak_uint8 *b = ( const ak_uint8 *)x;
+
+  for( l = 0; l < 16; l++ ) {
+     ak_uint8 v = s[b[oc ? 15-l : l]];
+     t ^= table[l][0][v&0xf][0]; t ^= table[l][1][v >> 4][0];
+     u ^= table[l][0][v&0xf][1]; u ^= table[l][1][v >> 4][1];
+  }
+  x[0] = t; x[1] = u;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует алгоритм зашифрования `lanes` последовательно расположенных блоков
+    информации шифром Кузнечик с использованием компактных таблиц.
+
+    Маскирование раундовых ключей выполняется так же, как и в функции
+    ak_kuznechik_encrypt_with_mask().
+
+    \param skey Контекст секретного ключа.
+    \param in Указатель на входные данные.
+    \param out Указатель на выходные данные (может совпадать с `in`).
+    \param lanes Количество блоков, не более \ref ak_kuznechik_compact_lanes_count.
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_encrypt_compact_lanes( ak_skey skey, ak_uint64 *in,
+                                               ak_uint64 *out, const size_t lanes, const int oc )
+{
+  int i = 0;
+  size_t j = 0;
+  ak_uint64 *ekey = ( ak_uint64 *)skey->data;
+  ak_uint64 *mkey = ( ak_uint64 *)skey->data + 40;
+  ak_uint64 x[ak_kuznechik_compact_lanes_count][2];
+
+  for( j = 0; j < lanes; j++ ) { x[j][0] = in[2*j]; x[j][1] = in[2*j+1]; }
+  for( i = 0; i < 18; i += 2 ) {
+     for( j = 0; j < lanes; j++ ) {
+        x[j][0] ^= ekey[i];   x[j][0] ^= mkey[i];
+        x[j][1] ^= ekey[i+1]; x[j][1] ^= mkey[i+1];
+        ak_kuznechik_compact_round( x[j],
+                                 kuznechik_parameters.cenc, kuznechik_parameters.pi, oc );
+     }
+  }
+  for( j = 0; j < lanes; j++ ) {
+     x[j][0] ^= ekey[18]; x[j][1] ^= ekey[19];
+     out[2*j] = x[j][0] ^ mkey[18];
+     out[2*j+1] = x[j][1] ^ mkey[19];
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует алгоритм расшифрования `lanes` последовательно расположенных блоков
+    информации шифром Кузнечик с использованием компактных таблиц.
+
+    Используются те же раундовые ключи, что и в функции ak_kuznechik_decrypt_with_mask().
+
+    \param skey Контекст секретного ключа.
+    \param in Указатель на входные данные.
+    \param out Указатель на выходные данные (может совпадать с `in`).
+    \param lanes Количество блоков, не более \ref ak_kuznechik_compact_lanes_count.
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_decrypt_compact_lanes( ak_skey skey, ak_uint64 *in,
+                                               ak_uint64 *out, const size_t lanes, const int oc )
+{
+  int i = 0, l = 0;
+  size_t j = 0;
+  ak_uint64 *dkey = ( ak_uint64 *)skey->data + 20;
+  ak_uint64 *xkey = ( ak_uint64 *)skey->data + 60;
+  ak_uint64 x[ak_kuznechik_compact_lanes_count][2];
+
+  for( j = 0; j < lanes; j++ ) {
+     ak_uint8 *b = ( ak_uint8 *)x[j];
+     x[j][0] = in[2*j]; x[j][1] = in[2*j+1];
+     for( l = 0; l < 16; l++ ) b[l] = kuznechik_parameters.pi[b[l]];
+  }
+  for( i = 19; i > 1; i -= 2 ) {
+     for( j = 0; j < lanes; j++ ) {
+        ak_kuznechik_compact_round( x[j],
+                               kuznechik_parameters.cdec, kuznechik_parameters.pinv, oc );
+        x[j][1] ^= dkey[i];   x[j][1] ^= xkey[i];
+        x[j][0] ^= dkey[i-1]; x[j][0] ^= xkey[i-1];
+     }
+  }
+  for( j = 0; j < lanes; j++ ) {
+     ak_uint8 *b = ( ak_uint8 *)x[j];
+     for( l = 0; l < 16; l++ ) b[l] = kuznechik_parameters.pinv[b[l]];
+     x[j][0] ^= dkey[0]; x[j][1] ^= dkey[1];
+     out[2*j] = x[j][0] ^ xkey[0];
+     out[2*j+1] = x[j][1] ^ xkey[1];
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования одного блока информации шифром Кузнечик
+    с использованием компактных таблиц.                                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_compact( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  ak_kuznechik_encrypt_compact_lanes( skey, in, out, 1, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования одного блока информации шифром Кузнечик
+    с использованием компактных таблиц.                                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_compact( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  ak_kuznechik_decrypt_compact_lanes( skey, in, out, 1, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования одного блока информации шифром Кузнечик
+    с использованием компактных таблиц (симметричное преобразование, совместимое с openssl).      */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_compact_oc( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  ak_kuznechik_encrypt_compact_lanes( skey, in, out, 1, 1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования одного блока информации шифром Кузнечик
+    с использованием компактных таблиц (симметричное преобразование, совместимое с openssl).      */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_compact_oc( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  ak_kuznechik_decrypt_compact_lanes( skey, in, out, 1, 1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик с использованием компактных таблиц.
+
+    Основная часть блоков обрабатывается группами по \ref ak_kuznechik_compact_lanes_count блоков,
+    оставшиеся блоки обрабатываются одним вызовом.                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_blocks_compact( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= ak_kuznechik_compact_lanes_count; blocks -= ak_kuznechik_compact_lanes_count ) {
+     ak_kuznechik_encrypt_compact_lanes( skey, inptr, outptr, ak_kuznechik_compact_lanes_count, 0 );
+     inptr += 2*ak_kuznechik_compact_lanes_count; outptr += 2*ak_kuznechik_compact_lanes_count;
+  }
+  if( blocks ) ak_kuznechik_encrypt_compact_lanes( skey, inptr, outptr, blocks, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик с использованием компактных таблиц.                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_blocks_compact( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= ak_kuznechik_compact_lanes_count; blocks -= ak_kuznechik_compact_lanes_count ) {
+     ak_kuznechik_decrypt_compact_lanes( skey, inptr, outptr, ak_kuznechik_compact_lanes_count, 0 );
+     inptr += 2*ak_kuznechik_compact_lanes_count; outptr += 2*ak_kuznechik_compact_lanes_count;
+  }
+  if( blocks ) ak_kuznechik_decrypt_compact_lanes( skey, inptr, outptr, blocks, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик с использованием компактных таблиц
+    (симметричное преобразование, совместимое с openssl).                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_blocks_compact_oc( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= ak_kuznechik_compact_lanes_count; blocks -= ak_kuznechik_compact_lanes_count ) {
+     ak_kuznechik_encrypt_compact_lanes( skey, inptr, outptr, ak_kuznechik_compact_lanes_count, 1 );
+     inptr += 2*ak_kuznechik_compact_lanes_count; outptr += 2*ak_kuznechik_compact_lanes_count;
+  }
+  if( blocks ) ak_kuznechik_encrypt_compact_lanes( skey, inptr, outptr, blocks, 1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик с использованием компактных таблиц
+    (симметричное преобразование, совместимое с openssl).                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_blocks_compact_oc( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= ak_kuznechik_compact_lanes_count; blocks -= ak_kuznechik_compact_lanes_count ) {
+     ak_kuznechik_decrypt_compact_lanes( skey, inptr, outptr, ak_kuznechik_compact_lanes_count, 1 );
+     inptr += 2*ak_kuznechik_compact_lanes_count; outptr += 2*ak_kuznechik_compact_lanes_count;
+  }
+  if( blocks ) ak_kuznechik_decrypt_compact_lanes( skey, inptr, outptr, blocks, 1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательного сжатия нескольких блоков информации в режиме выработки
+    имитовставки шифром Кузнечик с использованием компактных таблиц.                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_mac_blocks_compact( ak_skey skey,
+                                                ak_pointer in, ak_pointer state, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *x = ( ak_uint64 *)state;
+
+  for( ; blocks > 0; blocks--, inptr += 2 ) {
+     x[0] ^= inptr[0]; x[1] ^= inptr[1];
+     ak_kuznechik_encrypt_compact_lanes( skey, x, x, 1, 0 );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательного сжатия нескольких блоков информации в режиме выработки
+    имитовставки шифром Кузнечик с использованием компактных таблиц
+    (симметричное преобразование, совместимое с openssl).                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_mac_blocks_compact_oc( ak_skey skey,
+                                                ak_pointer in, ak_pointer state, size_t blocks )
+{
+  ak_uint64 *inptr = ( ak_uint64 *)in, *x = ( ak_uint64 *)state;
+
+  for( ; blocks > 0; blocks--, inptr += 2 ) {
+     x[0] ^= inptr[0]; x[1] ^= inptr[1];
+     ak_kuznechik_encrypt_compact_lanes( skey, x, x, 1, 1 );
+  }
+}
+
+#ifdef LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8
+/* ----------------------------------------------------------------------------------------------- */
+/*                  векторная реализация алгоритма (инструкции SSE2 и SSSE3)                      */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество блоков, одновременно обрабатываемых векторной реализацией
+    алгоритма Кузнечик. */
+ #define ak_kuznechik_ssse3_lanes_count (8)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует одно преобразование LS (или обратное к нему) над блоком,
+    размещенным в 128-ми битном регистре.
+
+    Развернутая таблица рассматривается как массив 128-ми битных векторов. Инструкция `pshufb`
+    за одно действие расщепляет блок на четные и нечетные октеты, расширенные до 16-ти бит;
+    после сдвига на четыре разряда полученные слова являются смещениями векторов в таблице.
+    Порядок следования октетов (прямой или симметричный, совместимый с openssl) задается
+    масками `even` и `odd`, поэтому обе разновидности преобразования обслуживаются одним кодом.
+
+    \param x Обрабатываемый блок.
+    \param table Развернутая таблица (прямая или обратная).
+    \param even Маска, выделяющая октеты блока, соответствующие таблицам с четными номерами.
+    \param odd Маска, выделяющая октеты блока, соответствующие таблицам с нечетными номерами.
+    \return Результат преобразования.                                                              */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline __m128i ak_kuznechik_ssse3_round( __m128i x, const ak_uint8 *table,
+                                                              const __m128i even, const __m128i odd )
+{
+  __m128i t, lo = _mm_slli_epi16( _mm_shuffle_epi8( x, even ), 4 ),
+             hi = _mm_slli_epi16( _mm_shuffle_epi8( x, odd ), 4 );
+
+  t = _mm_loadu_si128(( const __m128i *)( table +         _mm_extract_epi16( lo, 0 )));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table +  4096 + _mm_extract_epi16( hi, 0 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table +  8192 + _mm_extract_epi16( lo, 1 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 12288 + _mm_extract_epi16( hi, 1 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 16384 + _mm_extract_epi16( lo, 2 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 20480 + _mm_extract_epi16( hi, 2 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 24576 + _mm_extract_epi16( lo, 3 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 28672 + _mm_extract_epi16( hi, 3 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 32768 + _mm_extract_epi16( lo, 4 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 36864 + _mm_extract_epi16( hi, 4 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 40960 + _mm_extract_epi16( lo, 5 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 45056 + _mm_extract_epi16( hi, 5 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 49152 + _mm_extract_epi16( lo, 6 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 53248 + _mm_extract_epi16( hi, 6 ))));
+  t = _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 57344 + _mm_extract_epi16( lo, 7 ))));
+ return _mm_xor_si128( t, _mm_loadu_si128(( const __m128i *)( table + 61440 + _mm_extract_epi16( hi, 7 ))));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вычисляет маски, определяющие порядок выборки октетов блока
+    в функции ak_kuznechik_ssse3_round().                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_ssse3_masks( __m128i *even, __m128i *odd, const int oc )
+{
+  if( oc ) {
+    *even = _mm_setr_epi8( 15, -1, 13, -1, 11, -1, 9, -1, 7, -1, 5, -1, 3, -1, 1, -1 );
+    *odd = _mm_setr_epi8( 14, -1, 12, -1, 10, -1, 8, -1, 6, -1, 4, -1, 2, -1, 0, -1 );
+  } else {
+    *even = _mm_setr_epi8( 0, -1, 2, -1, 4, -1, 6, -1, 8, -1, 10, -1, 12, -1, 14, -1 );
+    *odd = _mm_setr_epi8( 1, -1, 3, -1, 5, -1, 7, -1, 9, -1, 11, -1, 13, -1, 15, -1 );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует алгоритм зашифрования `lanes` последовательно расположенных блоков
+    информации шифром Кузнечик с использованием векторных инструкций.
+
+    Маскирование раундовых ключей выполняется так же, как и в функции
+    ak_kuznechik_encrypt_with_mask().
+
+    \param skey Контекст секретного ключа.
+    \param in Указатель на входные данные.
+    \param out Указатель на выходные данные (может совпадать с `in`).
+    \param lanes Количество блоков, не более \ref ak_kuznechik_ssse3_lanes_count.
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_encrypt_ssse3_lanes( ak_skey skey, ak_uint8 *in,
+                                                ak_uint8 *out, const size_t lanes, const int oc )
+{
+  size_t i = 0, j = 0;
+  __m128i even, odd, k, m, x[ak_kuznechik_ssse3_lanes_count];
+  ak_uint64 *ekey = ( ak_uint64 *)skey->data;
+  ak_uint64 *mkey = ( ak_uint64 *)skey->data + 40;
+  const ak_uint8 *table = ( const ak_uint8 *)kuznechik_parameters.enc;
+
+  ak_kuznechik_ssse3_masks( &even, &odd, oc );
+  for( j = 0; j < lanes; j++ ) x[j] = _mm_loadu_si128(( const __m128i *)( in + 16*j ));
+  for( i = 0; i < 18; i += 2 ) {
+     k = _mm_loadu_si128(( const __m128i *)( ekey + i ));
+     m = _mm_loadu_si128(( const __m128i *)( mkey + i ));
+     for( j = 0; j < lanes; j++ )
+        x[j] = ak_kuznechik_ssse3_round( _mm_xor_si128( _mm_xor_si128( x[j], k ), m ),
+                                                                             table, even, odd );
+  }
+  k = _mm_loadu_si128(( const __m128i *)( ekey + 18 ));
+  m = _mm_loadu_si128(( const __m128i *)( mkey + 18 ));
+  for( j = 0; j < lanes; j++ )
+     _mm_storeu_si128(( __m128i *)( out + 16*j ), _mm_xor_si128( _mm_xor_si128( x[j], k ), m ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует алгоритм расшифрования `lanes` последовательно расположенных блоков
+    информации шифром Кузнечик с использованием векторных инструкций.
+
+    Нелинейные преобразования, выполняемые до первого и после последнего раунда,
+    реализуются заменой октетов в памяти.
+
+    \param skey Контекст секретного ключа.
+    \param in Указатель на входные данные.
+    \param out Указатель на выходные данные (может совпадать с `in`).
+    \param lanes Количество блоков, не более \ref ak_kuznechik_ssse3_lanes_count.
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_decrypt_ssse3_lanes( ak_skey skey, ak_uint8 *in,
+                                                ak_uint8 *out, const size_t lanes, const int oc )
+{
+  int i = 0;
+  size_t j = 0, l = 0;
+  __m128i even, odd, k, m, x[ak_kuznechik_ssse3_lanes_count];
+  ak_uint8 b[16*ak_kuznechik_ssse3_lanes_count];
+  ak_uint64 *dkey = ( ak_uint64 *)skey->data + 20;
+  ak_uint64 *xkey = ( ak_uint64 *)skey->data + 60;
+  const ak_uint8 *table = ( const ak_uint8 *)kuznechik_parameters.dec;
+
+  ak_kuznechik_ssse3_masks( &even, &odd, oc );
+  for( l = 0; l < 16*lanes; l++ ) b[l] = kuznechik_parameters.pi[in[l]];
+  for( j = 0; j < lanes; j++ ) x[j] = _mm_loadu_si128(( const __m128i *)( b + 16*j ));
+  for( i = 18; i > 0; i -= 2 ) {
+     k = _mm_loadu_si128(( const __m128i *)( dkey + i ));
+     m = _mm_loadu_si128(( const __m128i *)( xkey + i ));
+     for( j = 0; j < lanes; j++ )
+        x[j] = _mm_xor_si128( _mm_xor_si128(
+                                    ak_kuznechik_ssse3_round( x[j], table, even, odd ), k ), m );
+  }
+  for( j = 0; j < lanes; j++ ) _mm_storeu_si128(( __m128i *)( b + 16*j ), x[j] );
+  for( l = 0; l < 16*lanes; l++ ) b[l] = kuznechik_parameters.pinv[b[l]];
+
+  k = _mm_loadu_si128(( const __m128i *)dkey );
+  m = _mm_loadu_si128(( const __m128i *)xkey );
+  for( j = 0; j < lanes; j++ )
+     _mm_storeu_si128(( __m128i *)( out + 16*j ), _mm_xor_si128( _mm_xor_si128(
+                                     _mm_loadu_si128(( const __m128i *)( b + 16*j )), k ), m ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования одного блока информации шифром Кузнечик
+    с использованием векторных инструкций.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_ssse3( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  ak_kuznechik_encrypt_ssse3_lanes( skey, in, out, 1, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования одного блока информации шифром Кузнечик
+    с использованием векторных инструкций.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_ssse3( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  ak_kuznechik_decrypt_ssse3_lanes( skey, in, out, 1, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования одного блока информации шифром Кузнечик
+    с использованием векторных инструкций (симметричное преобразование, совместимое с openssl). */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_ssse3_oc( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  ak_kuznechik_encrypt_ssse3_lanes( skey, in, out, 1, 1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования одного блока информации шифром Кузнечик
+    с использованием векторных инструкций (симметричное преобразование, совместимое с openssl). */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_ssse3_oc( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  ak_kuznechik_decrypt_ssse3_lanes( skey, in, out, 1, 1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик с использованием векторных инструкций.
+
+    Основная часть блоков обрабатывается группами по \ref ak_kuznechik_ssse3_lanes_count блоков,
+    оставшиеся блоки обрабатываются одной группой меньшего размера.                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_blocks_ssse3( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint8 *inptr = ( ak_uint8 *)in, *outptr = ( ak_uint8 *)out;
+
+  for( ; blocks >= ak_kuznechik_ssse3_lanes_count; blocks -= ak_kuznechik_ssse3_lanes_count ) {
+     ak_kuznechik_encrypt_ssse3_lanes( skey, inptr, outptr, ak_kuznechik_ssse3_lanes_count, 0 );
+     inptr += 16*ak_kuznechik_ssse3_lanes_count; outptr += 16*ak_kuznechik_ssse3_lanes_count;
+  }
+  if( blocks ) ak_kuznechik_encrypt_ssse3_lanes( skey, inptr, outptr, blocks, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик с использованием векторных инструкций.                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_blocks_ssse3( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint8 *inptr = ( ak_uint8 *)in, *outptr = ( ak_uint8 *)out;
+
+  for( ; blocks >= ak_kuznechik_ssse3_lanes_count; blocks -= ak_kuznechik_ssse3_lanes_count ) {
+     ak_kuznechik_decrypt_ssse3_lanes( skey, inptr, outptr, ak_kuznechik_ssse3_lanes_count, 0 );
+     inptr += 16*ak_kuznechik_ssse3_lanes_count; outptr += 16*ak_kuznechik_ssse3_lanes_count;
+  }
+  if( blocks ) ak_kuznechik_decrypt_ssse3_lanes( skey, inptr, outptr, blocks, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик с использованием векторных инструкций (симметричное преобразование,
+    совместимое с openssl).                                                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_blocks_ssse3_oc( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint8 *inptr = ( ak_uint8 *)in, *outptr = ( ak_uint8 *)out;
+
+  for( ; blocks >= ak_kuznechik_ssse3_lanes_count; blocks -= ak_kuznechik_ssse3_lanes_count ) {
+     ak_kuznechik_encrypt_ssse3_lanes( skey, inptr, outptr, ak_kuznechik_ssse3_lanes_count, 1 );
+     inptr += 16*ak_kuznechik_ssse3_lanes_count; outptr += 16*ak_kuznechik_ssse3_lanes_count;
+  }
+  if( blocks ) ak_kuznechik_encrypt_ssse3_lanes( skey, inptr, outptr, blocks, 1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования нескольких последовательно расположенных блоков информации
+    шифром Кузнечик с использованием векторных инструкций (симметричное преобразование,
+    совместимое с openssl).                                                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_decrypt_blocks_ssse3_oc( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint8 *inptr = ( ak_uint8 *)in, *outptr = ( ak_uint8 *)out;
+
+  for( ; blocks >= ak_kuznechik_ssse3_lanes_count; blocks -= ak_kuznechik_ssse3_lanes_count ) {
+     ak_kuznechik_decrypt_ssse3_lanes( skey, inptr, outptr, ak_kuznechik_ssse3_lanes_count, 1 );
+     inptr += 16*ak_kuznechik_ssse3_lanes_count; outptr += 16*ak_kuznechik_ssse3_lanes_count;
+  }
+  if( blocks ) ak_kuznechik_decrypt_ssse3_lanes( skey, inptr, outptr, blocks, 1 );
+}
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательного сжатия нескольких блоков информации в режиме выработки
+    имитовставки шифром Кузнечик с использованием векторных инструкций.
+
+    Текущее значение цепочки на протяжении всей обработки хранится в регистре процессора.
+
+    \param skey Контекст секретного ключа.
+    \param in Указатель на входные данные.
+    \param state Текущее значение цепочки (16 октетов), изменяется функцией.
+    \param blocks Количество обрабатываемых блоков.
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_mac_ssse3_lanes( ak_skey skey, ak_uint8 *in,
+                                             ak_uint8 *state, size_t blocks, const int oc )
+{
+  int i = 0;
+  __m128i even, odd, x, k[10], m[10];
+  ak_uint64 *ekey = ( ak_uint64 *)skey->data;
+  ak_uint64 *mkey = ( ak_uint64 *)skey->data + 40;
+  const ak_uint8 *table = ( const ak_uint8 *)kuznechik_parameters.enc;
+
+  ak_kuznechik_ssse3_masks( &even, &odd, oc );
+ /* раундовые ключи и маски загружаются один раз и складываются с блоком по отдельности */
+  for( i = 0; i < 10; i++ ) {
+     k[i] = _mm_loadu_si128(( const __m128i *)( ekey + 2*i ));
+     m[i] = _mm_loadu_si128(( const __m128i *)( mkey + 2*i ));
+  }
+  x = _mm_loadu_si128(( const __m128i *)state );
+  for( ; blocks > 0; blocks--, in += 16 ) {
+     x = _mm_xor_si128( x, _mm_loadu_si128(( const __m128i *)in ));
+     for( i = 0; i < 9; i++ )
+        x = ak_kuznechik_ssse3_round( _mm_xor_si128( _mm_xor_si128( x, k[i] ), m[i] ),
+                                                                             table, even, odd );
+     x = _mm_xor_si128( _mm_xor_si128( x, k[9] ), m[9] );
+  }
+  _mm_storeu_si128(( __m128i *)state, x );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательного сжатия нескольких блоков информации в режиме выработки
+    имитовставки шифром Кузнечик с использованием векторных инструкций.                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_mac_blocks_ssse3( ak_skey skey,
+                                                ak_pointer in, ak_pointer state, size_t blocks )
+{
+  ak_kuznechik_mac_ssse3_lanes( skey, in, state, blocks, 0 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательного сжатия нескольких блоков информации в режиме выработки
+    имитовставки шифром Кузнечик с использованием векторных инструкций (симметричное
+    преобразование, совместимое с openssl).                                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_mac_blocks_ssse3_oc( ak_skey skey,
+                                                ak_pointer in, ak_pointer state, size_t blocks )
+{
+  ak_kuznechik_mac_ssse3_lanes( skey, in, state, blocks, 1 );
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                      многоключевая реализация алгоритма (пакетная обработка)                    */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество блоков, одновременно обрабатываемых многоключевой реализацией
+    алгоритма Кузнечик. */
+ #define ak_kuznechik_multikey_lanes_count (8)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Описание одного блока, обрабатываемого многоключевой реализацией алгоритма Кузнечик.
+    \details Каждый блок зашифровывается на собственных раундовых ключах и масках, взятых
+    из поля `skey->data` ключа, которому принадлежит блок; таблицы алгоритма являются общими
+    для всех блоков.                                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct kuznechik_lane {
+  /*! \brief Развернутые раундовые ключи и маски (содержимое поля `skey->data`). */
+   ak_uint64 *key;
+  /*! \brief Указатель на зашифровываемый блок. */
+   ak_uint64 *in;
+  /*! \brief Указатель на место размещения зашифрованного блока (может совпадать с `in`). */
+   ak_uint64 *out;
+} *ak_kuznechik_lane;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования группы блоков, принадлежащих, вообще говоря, различным ключам,
+    с использованием развернутых таблиц.
+
+    Раунды всех блоков выполняются в одном цикле, так же, как и в функции
+    ak_kuznechik_encrypt_lanes_with_mask(); отличие состоит лишь в том, что раундовый ключ
+    и маска выбираются для каждого блока отдельно.
+
+    \param lane Массив из \ref ak_kuznechik_multikey_lanes_count описаний обрабатываемых блоков.
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_encrypt_multikey_lanes( ak_kuznechik_lane lane,
+                                                                                   const int oc )
+{
+  int i = 0;
+  size_t j = 0;
+  ak_uint64 x[ak_kuznechik_multikey_lanes_count][2];
+
+  for( j = 0; j < ak_kuznechik_multikey_lanes_count; j++ ) {
+     x[j][0] = lane[j].in[0]; x[j][1] = lane[j].in[1];
+  }
+  for( i = 0; i < 18; i += 2 ) {
+     for( j = 0; j < ak_kuznechik_multikey_lanes_count; j++ ) {
+        x[j][0] ^= lane[j].key[i];   x[j][0] ^= lane[j].key[40+i];
+        x[j][1] ^= lane[j].key[i+1]; x[j][1] ^= lane[j].key[41+i];
+        ak_kuznechik_lane_round( x[j], kuznechik_parameters.enc, oc );
+     }
+  }
+  for( j = 0; j < ak_kuznechik_multikey_lanes_count; j++ ) {
+     x[j][0] ^= lane[j].key[18]; x[j][1] ^= lane[j].key[19];
+     lane[j].out[0] = x[j][0] ^ lane[j].key[58];
+     lane[j].out[1] = x[j][1] ^ lane[j].key[59];
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования группы блоков, принадлежащих различным ключам,
+    с использованием компактных таблиц.                                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_encrypt_multikey_compact_lanes( ak_kuznechik_lane lane,
+                                                                                   const int oc )
+{
+  int i = 0;
+  size_t j = 0;
+  ak_uint64 x[ak_kuznechik_multikey_lanes_count][2];
+
+  for( j = 0; j < ak_kuznechik_multikey_lanes_count; j++ ) {
+     x[j][0] = lane[j].in[0]; x[j][1] = lane[j].in[1];
+  }
+  for( i = 0; i < 18; i += 2 ) {
+     for( j = 0; j < ak_kuznechik_multikey_lanes_count; j++ ) {
+        x[j][0] ^= lane[j].key[i];   x[j][0] ^= lane[j].key[40+i];
+        x[j][1] ^= lane[j].key[i+1]; x[j][1] ^= lane[j].key[41+i];
+        ak_kuznechik_compact_round( x[j],
+                                 kuznechik_parameters.cenc, kuznechik_parameters.pi, oc );
+     }
+  }
+  for( j = 0; j < ak_kuznechik_multikey_lanes_count; j++ ) {
+     x[j][0] ^= lane[j].key[18]; x[j][1] ^= lane[j].key[19];
+     lane[j].out[0] = x[j][0] ^ lane[j].key[58];
+     lane[j].out[1] = x[j][1] ^ lane[j].key[59];
+  }
+}
+
+#ifdef LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования группы блоков, принадлежащих различным ключам,
+    с использованием векторных инструкций.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_kuznechik_encrypt_multikey_ssse3_lanes( ak_kuznechik_lane lane,
+                                                                                   const int oc )
+{
+  size_t i = 0, j = 0;
+  __m128i even, odd, x[ak_kuznechik_multikey_lanes_count];
+  const ak_uint8 *table = ( const ak_uint8 *)kuznechik_parameters.enc;
+
+  ak_kuznechik_ssse3_masks( &even, &odd, oc );
+  for( j = 0; j < ak_kuznechik_multikey_lanes_count; j++ )
+     x[j] = _mm_loadu_si128(( const __m128i *)lane[j].in );
+  for( i = 0; i < 18; i += 2 ) {
+     for( j = 0; j < ak_kuznechik_multikey_lanes_count; j++ )
+        x[j] = ak_kuznechik_ssse3_round( _mm_xor_si128( _mm_xor_si128( x[j],
+                                      _mm_loadu_si128(( const __m128i *)( lane[j].key + i ))),
+                                      _mm_loadu_si128(( const __m128i *)( lane[j].key + 40 + i ))),
+                                                                             table, even, odd );
+  }
+  for( j = 0; j < ak_kuznechik_multikey_lanes_count; j++ )
+     _mm_storeu_si128(( __m128i *)lane[j].out, _mm_xor_si128( _mm_xor_si128( x[j],
+                                     _mm_loadu_si128(( const __m128i *)( lane[j].key + 18 ))),
+                                     _mm_loadu_si128(( const __m128i *)( lane[j].key + 58 ))));
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования блоков, собранных в массиве `lane`, с помощью выбранной
+    реализации алгоритма.
+
+    Функции, реализующие раунды, всегда обрабатывают \ref ak_kuznechik_multikey_lanes_count
+    блоков, что позволяет компилятору полностью развернуть внутренние циклы. Поэтому неполная
+    группа дополняется копиями первого блока: все блоки группы считываются до начала записи
+    результата, и повторная запись одного и того же значения не изменяет выходных данных.
+
+    \param lane Массив описаний обрабатываемых блоков, рассчитанный
+    на \ref ak_kuznechik_multikey_lanes_count элементов.
+    \param lanes Количество заполненных элементов массива (отлично от нуля).
+    \param kernel Номер используемой реализации алгоритма.
+    \param oc Флаг использования симметричного (совместимого с openssl) преобразования.            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_multikey( ak_kuznechik_lane lane, size_t lanes,
+                                                              const int kernel, const int oc )
+{
+  for( ; lanes < ak_kuznechik_multikey_lanes_count; lanes++ ) lane[lanes] = lane[0];
+  switch( kernel ) {
+#ifdef LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8
+    case ak_kuznechik_kernel_ssse3:
+      if( oc ) ak_kuznechik_encrypt_multikey_ssse3_lanes( lane, 1 );
+        else ak_kuznechik_encrypt_multikey_ssse3_lanes( lane, 0 );
+      break;
+#endif
+    case ak_kuznechik_kernel_compact:
+      if( oc ) ak_kuznechik_encrypt_multikey_compact_lanes( lane, 1 );
+        else ak_kuznechik_encrypt_multikey_compact_lanes( lane, 0 );
+      break;
+
+    default:
+      if( oc ) ak_kuznechik_encrypt_multikey_lanes( lane, 1 );
+        else ak_kuznechik_encrypt_multikey_lanes( lane, 0 );
+      break;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция определяет, в каком представлении (прямом или симметричном, совместимом
+    с openssl) был создан ключ алгоритма Кузнечик.
+
+    \param bkey Контекст ключа алгоритма блочного шифрования.
+    \return Функция возвращает 0 или 1 для ключей алгоритма Кузнечик и -1 для ключей
+    других алгоритмов блочного шифрования.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_kuznechik_key_oc( ak_bckey bkey )
+{
+  if(( bkey->encrypt == ak_kuznechik_encrypt_with_mask ) ||
+     ( bkey->encrypt == ak_kuznechik_encrypt_compact )) return 0;
+  if(( bkey->encrypt == ak_kuznechik_encrypt_with_mask_oc ) ||
+     ( bkey->encrypt == ak_kuznechik_encrypt_compact_oc )) return 1;
+#ifdef LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8
+  if( bkey->encrypt == ak_kuznechik_encrypt_ssse3 ) return 0;
+  if( bkey->encrypt == ak_kuznechik_encrypt_ssse3_oc ) return 1;
+#endif
+ return -1;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция предназначена для серверов, обслуживающих большое количество сессий, каждая
+    из которых использует собственный ключ, а объем данных, передаваемых в одном пакете,
+    составляет лишь несколько блоков. В этом случае многоблочные функции отдельного ключа
+    практически не дают выигрыша, поскольку обрабатывают слишком короткие последовательности.
+
+    Функция формирует очередь из блоков всех элементов массива `batch` и зашифровывает их
+    группами по \ref ak_kuznechik_multikey_lanes_count блоков в одном цикле раундов,
+    независимо от того, каким ключам принадлежат блоки. Для каждого блока используются
+    раундовые ключи и маски его собственного ключа, таблицы алгоритма являются общими.
+    Результат совпадает с результатом последовательных вызовов функции
+    ak_bckey_context_encrypt_ecb() для каждого элемента массива.
+
+    Перед зашифрованием проверяется целостность всех ключей и уменьшается их ресурс.
+    Если ресурса какого-либо ключа недостаточно, то ресурсы всех ключей восстанавливаются
+    и данные не зашифровываются. После зашифрования каждый использованный ключ перемаскируется.
+
+    \param batch Массив описаний обрабатываемых данных; один и тот же ключ может встречаться
+    в массиве несколько раз. Все ключи должны быть ключами алгоритма Кузнечик.
+    \param count Количество элементов массива.
+    \return В случае успеха возвращается \ref ak_error_ok (ноль), в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_kuznechik_encrypt_batch( ak_bckey_batch batch, const size_t count )
+{
+  int error = ak_error_ok, oc = 0;
+  size_t i = 0, j = 0, lanes = 0;
+  int kernel = ak_kuznechik_kernel_get();
+  struct kuznechik_lane lane[ak_kuznechik_multikey_lanes_count];
+
+  if( batch == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                        "using null pointer to batch description" );
+ /* проверяем ключи и уменьшаем их ресурс */
+  for( i = 0; i < count; i++ ) {
+     ak_bckey bkey = batch[i].bkey;
+
+     if( bkey == NULL ) {
+       error = ak_error_message( ak_error_null_pointer, __func__,
+                                                 "using null pointer to block cipher key context" );
+       break;
+     }
+     if( ak_kuznechik_key_oc( bkey ) < 0 ) {
+       error = ak_error_message( ak_error_wrong_block_cipher, __func__,
+                                                         "using key of non kuznechik block cipher" );
+       break;
+     }
+     if( batch[i].blocks == 0 ) continue;
+     if(( batch[i].in == NULL ) || ( batch[i].out == NULL )) {
+       error = ak_error_message( ak_error_null_pointer, __func__,
+                                                                   "using null pointer to data" );
+       break;
+     }
+     if( bkey->key.check_icode( &bkey->key ) != ak_true ) {
+       error = ak_error_message( ak_error_wrong_key_icode, __func__,
+                                                  "incorrect integrity code of secret key value" );
+       break;
+     }
+     if( bkey->key.resource.value.counter < (ssize_t)batch[i].blocks ) {
+       error = ak_error_message( ak_error_low_key_resource, __func__,
+                                                               "low resource of block cipher key" );
+       break;
+     }
+     bkey->key.resource.value.counter -= batch[i].blocks;
+  }
+ /* при возникновении ошибки восстанавливаем ресурс уже учтенных ключей */
+  if( error != ak_error_ok ) {
+    for( j = 0; j < i; j++ )
+       if( batch[j].blocks ) batch[j].bkey->key.resource.value.counter += batch[j].blocks;
+    return error;
+  }
+
+ /* формируем очередь блоков и зашифровываем ее группами; ключи, созданные в различных
+    представлениях, обрабатываются за два прохода */
+  for( oc = 0; oc < 2; oc++ ) {
+     for( i = 0; i < count; i++ ) {
+        ak_uint64 *in = ( ak_uint64 *)batch[i].in, *out = ( ak_uint64 *)batch[i].out;
+
+        if(( batch[i].blocks == 0 ) || ( ak_kuznechik_key_oc( batch[i].bkey ) != oc )) continue;
+        for( j = 0; j < batch[i].blocks; j++, in += 2, out += 2 ) {
+           lane[lanes].key = ( ak_uint64 *)batch[i].bkey->key.data;
+           lane[lanes].in = in;
+           lane[lanes].out = out;
+           if( ++lanes == ak_kuznechik_multikey_lanes_count ) {
+             ak_kuznechik_encrypt_multikey( lane, lanes, kernel, oc );
+             lanes = 0;
+           }
+        }
+     }
+     if( lanes ) ak_kuznechik_encrypt_multikey( lane, lanes, kernel, oc );
+     lanes = 0;
+  }
+
+ /* перемаскируем ключи; повторяющиеся подряд ключи перемаскируются один раз */
+  for( i = 0; i < count; i++ ) {
+     if( batch[i].blocks == 0 ) continue;
+     if(( i > 0 ) && ( batch[i-1].bkey == batch[i].bkey )) continue;
+     if(( error = batch[i].bkey->key.set_mask( &batch[i].bkey->key )) != ak_error_ok )
+       ak_error_message( error, __func__ , "wrong remasking of secret key" );
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция проверяет, может ли заданная реализация алгоритма Кузнечик быть использована
+    на текущем процессоре.
+
+    \param kernel Номер реализации: \ref ak_kuznechik_kernel_base,
+    \ref ak_kuznechik_kernel_ssse3 или \ref ak_kuznechik_kernel_compact.
+    \return Функция возвращает \ref ak_true, если реализация доступна.
+    В противном случае возвращается \ref ak_false.                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_kuznechik_kernel_is_available( const int kernel )
+{
+  switch( kernel ) {
+    case ak_kuznechik_kernel_base:
+    case ak_kuznechik_kernel_compact:
+      return ak_true;
+
+    case ak_kuznechik_kernel_ssse3:
+   #ifdef LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8
+    #ifdef LIBAKRYPT_HAVE_BUILTIN_CPU_SUPPORTS
+      __builtin_cpu_init();
+      if( __builtin_cpu_supports( "ssse3" )) return ak_true;
+    #else
+      return ak_true;
+    #endif
+   #endif
+      return ak_false;
+
+    default:
+      return ak_false;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Выбор реализации определяется опцией библиотеки `kuznechik_kernel`. При нулевом
+    значении опции выбирается наиболее быстрая из реализаций, доступных на текущем процессоре.
+    Если явно указанная реализация недоступна, то используется базовая реализация.
+    Реализация, использующая компактные таблицы, автоматически не выбирается и должна быть
+    указана явно.
+
+    \return Номер используемой реализации алгоритма Кузнечик.                                     */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_kuznechik_kernel_get( void )
+{
+  int kernel = (int) ak_libakrypt_get_option( "kuznechik_kernel" );
+
+  if( kernel == ak_kuznechik_kernel_auto ) {
+    if( ak_kuznechik_kernel_is_available( ak_kuznechik_kernel_ssse3 ))
+      return ak_kuznechik_kernel_ssse3;
+    return ak_kuznechik_kernel_base;
+  }
+  if( ak_kuznechik_kernel_is_available( kernel )) return kernel;
+ return ak_kuznechik_kernel_base;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! После инициализации устанавливаются обработчики (функции класса). Однако само значение
     ключу не присваивается - поле `bkey->key` остается неопределенным.
@@ -622,13 +1764,41 @@
  /* устанавливаем методы */
   bkey->schedule_keys = ak_kuznechik_schedule_keys;
   bkey->delete_keys = ak_kuznechik_delete_keys;
+#ifdef LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8
+  if( ak_kuznechik_kernel_get() == ak_kuznechik_kernel_ssse3 ) {
+    bkey->encrypt = oc ? ak_kuznechik_encrypt_ssse3_oc : ak_kuznechik_encrypt_ssse3;
+    bkey->decrypt = oc ? ak_kuznechik_decrypt_ssse3_oc : ak_kuznechik_decrypt_ssse3;
+    bkey->encrypt_blocks = oc ? ak_kuznechik_encrypt_blocks_ssse3_oc :
+                                                                ak_kuznechik_encrypt_blocks_ssse3;
+    bkey->decrypt_blocks = oc ? ak_kuznechik_decrypt_blocks_ssse3_oc :
+                                                                ak_kuznechik_decrypt_blocks_ssse3;
+    bkey->mac_blocks = oc ? ak_kuznechik_mac_blocks_ssse3_oc : ak_kuznechik_mac_blocks_ssse3;
+    return error;
+  }
+#endif
+  if( ak_kuznechik_kernel_get() == ak_kuznechik_kernel_compact ) {
+    bkey->encrypt = oc ? ak_kuznechik_encrypt_compact_oc : ak_kuznechik_encrypt_compact;
+    bkey->decrypt = oc ? ak_kuznechik_decrypt_compact_oc : ak_kuznechik_decrypt_compact;
+    bkey->encrypt_blocks = oc ? ak_kuznechik_encrypt_blocks_compact_oc :
+                                                              ak_kuznechik_encrypt_blocks_compact;
+    bkey->decrypt_blocks = oc ? ak_kuznechik_decrypt_blocks_compact_oc :
+                                                              ak_kuznechik_decrypt_blocks_compact;
+    bkey->mac_blocks = oc ? ak_kuznechik_mac_blocks_compact_oc : ak_kuznechik_mac_blocks_compact;
+    return error;
+  }
   if( oc ) {
     bkey->encrypt = ak_kuznechik_encrypt_with_mask_oc;
     bkey->decrypt = ak_kuznechik_decrypt_with_mask_oc;
+    bkey->encrypt_blocks = ak_kuznechik_encrypt_blocks_with_mask_oc;
+    bkey->decrypt_blocks = ak_kuznechik_decrypt_blocks_with_mask_oc;
+    bkey->mac_blocks = ak_kuznechik_mac_blocks_with_mask_oc;
   }
    else {
     bkey->encrypt = ak_kuznechik_encrypt_with_mask;
     bkey->decrypt = ak_kuznechik_decrypt_with_mask;
+    bkey->encrypt_blocks = ak_kuznechik_encrypt_blocks_with_mask;
+    bkey->decrypt_blocks = ak_kuznechik_decrypt_blocks_with_mask;
+    bkey->mac_blocks = ak_kuznechik_mac_blocks_with_mask;
   }
  return error;
 }
@@ -922,7 +2092,8 @@
 /* ----------------------------------------------------------------------------------------------- */
  bool_t ak_bckey_test_kuznechik( void )
 {
-  int audit = audit = ak_log_get_level();
+  bool_t result = ak_true;
+  int i = 0, kernel = 0, audit = audit = ak_log_get_level();
 
  /* тестируем стандартные параметры алгоритма */
   if( !ak_bckey_test_kuznechik_parameters( )) {
@@ -933,11 +2104,21 @@
   if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
                                  "testing of predefined parameters from GOST R 34.12-2015 is Ok" );
 
- /* тестируем работу алоритма на контрольных примерах из ГОСТов и рекомендаций */
-  if( !ak_bckey_test_kuznechik_modes( )) {
-    ak_error_message( ak_error_get_value(), __func__,
-                                                   "incorrect testing of kuznechik block cipher" );
-    return ak_false;
+ /* тестируем работу алоритма на контрольных примерах из ГОСТов и рекомендаций,
+    контрольные примеры проверяются для каждой реализации, доступной на текущем процессоре */
+  kernel = (int) ak_libakrypt_get_option( "kuznechik_kernel" );
+  for( i = ak_kuznechik_kernel_base; i <= ak_kuznechik_kernel_compact; i++ ) {
+     if( !ak_kuznechik_kernel_is_available( i )) continue;
+     ak_libakrypt_set_option( "kuznechik_kernel", i );
+     result = ak_bckey_test_kuznechik_modes( );
+     ak_libakrypt_set_option( "kuznechik_kernel", kernel );
+     if( !result ) {
+       ak_error_message_fmt( ak_error_get_value(), __func__,
+                                  "incorrect testing of kuznechik block cipher (kernel %d)", i );
+       return ak_false;
+     }
+     if( audit >= ak_log_maximum ) ak_error_message_fmt( ak_error_ok, __func__ ,
+                                                  "testing of kuznechik kernel %d is Ok", i );
   }
   if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
                                                         "testing of kuznechik block ciper is Ok" );
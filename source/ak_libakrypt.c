@@ -21,6 +21,7 @@
 
 #ifdef LIBAKRYPT_CRYPTO_FUNCTIONS
  #include <ak_hmac.h>
+ #include <ak_omac.h>
  #include <ak_bckey.h>
  #include <ak_context_manager.h>
 #endif
@@ -98,6 +99,14 @@
    #ifdef LIBAKRYPT_HAVE_BUILTIN_CLMULEPI64
     ak_error_message( ak_error_ok, __func__ , "library applies clmulepi64 instruction" );
    #endif
+   #ifdef LIBAKRYPT_HAVE_BUILTIN_SHUFFLE_EPI8
+    if( ak_kuznechik_kernel_is_available( ak_kuznechik_kernel_ssse3 ))
+      ak_error_message( ak_error_ok, __func__ , "library applies shuffle_epi8 instruction" );
+   #endif
+   #ifdef LIBAKRYPT_HAVE_BUILTIN_AVX2
+    if( ak_streebog_kernel_is_available( ak_streebog_kernel_avx2 ))
+      ak_error_message( ak_error_ok, __func__ , "library applies avx2 instructions" );
+   #endif
    #ifdef LIBAKRYPT_HAVE_BUILTIN_MULQ_GCC
     ak_error_message( ak_error_ok, __func__ , "library applies assembler code for mulq command" );
    #endif
@@ -123,19 +132,33 @@
 /* ----------------------------------------------------------------------------------------------- */
  static bool_t ak_libakrypt_test_hash_functions( void )
 {
-  int audit = ak_log_get_level();
+  bool_t result = ak_true;
+  int i = 0, kernel = 0, audit = ak_log_get_level();
   if( audit >= ak_log_maximum )
     ak_error_message( ak_error_ok, __func__ , "testing hash functions started" );
 
- /* тестируем функцию Стрибог256 */
-  if( ak_hash_test_streebog256() != ak_true ) {
-    ak_error_message( ak_error_get_value(), __func__, "incorrect streebog256 testing" );
-    return ak_false;
+ /* функции Стрибог256 и Стрибог512 проверяются для каждой реализации функции сжатия,
+    доступной на текущем процессоре */
+  kernel = (int) ak_libakrypt_get_option( "streebog_kernel" );
+  for( i = ak_streebog_kernel_base; i <= ak_streebog_kernel_avx2; i++ ) {
+     if( !ak_streebog_kernel_is_available( i )) continue;
+     ak_libakrypt_set_option( "streebog_kernel", i );
+
+    /* тестируем функцию Стрибог256 */
+     if(( result = ak_hash_test_streebog256()) != ak_true )
+       ak_error_message_fmt( ak_error_get_value(), __func__,
+                                                "incorrect streebog256 testing (kernel %d)", i );
+    /* тестируем функцию Стрибог512 */
+     if(( result == ak_true ) && (( result = ak_hash_test_streebog512()) != ak_true ))
+       ak_error_message_fmt( ak_error_get_value(), __func__,
+                                                "incorrect streebog512 testing (kernel %d)", i );
+     ak_libakrypt_set_option( "streebog_kernel", kernel );
+     if( !result ) return ak_false;
   }
 
- /* тестируем функцию Стрибог512 */
-  if( ak_hash_test_streebog512() != ak_true ) {
-    ak_error_message( ak_error_get_value(), __func__, "incorrect streebog512 testing" );
+ /* тестируем режим древовидного хеширования */
+  if( ak_hash_test_streebog512_tree() != ak_true ) {
+    ak_error_message( ak_error_get_value(), __func__, "incorrect streebog512-tree testing" );
     return ak_false;
   }
 
@@ -157,11 +180,11 @@
   if( audit >= ak_log_maximum )
     ak_error_message( ak_error_ok, __func__ , "testing block ciphers started" );
 
-// /* тестируем корректность реализации блочного шифра Магма */
-//  if( ak_bckey_test_magma()  != ak_true ) {
-//    ak_error_message( ak_error_get_value(), __func__ , "incorrect testing of magma block cipher" );
-//    return ak_false;
-//  }
+ /* тестируем корректность реализации блочного шифра Магма */
+  if( ak_bckey_test_magma()  != ak_true ) {
+    ak_error_message( ak_error_get_value(), __func__ , "incorrect testing of magma block cipher" );
+    return ak_false;
+  }
 
  /* тестируем корректность реализации блочного шифра Кузнечик */
   if( ak_bckey_test_kuznechik()  != ak_true ) {
@@ -170,17 +193,17 @@
     return ak_false;
   }
 
-// /* тестируем дополнительные режимы работы */
-//  if( ak_bckey_test_mgm()  != ak_true ) {
-//    ak_error_message( ak_error_get_value(), __func__ ,
-//                                               "incorrect testing of mgm mode for block ciphers" );
-//    return ak_false;
-//  }
-//  if( ak_bckey_test_acpkm()  != ak_true ) {
-//    ak_error_message( ak_error_get_value(), __func__ ,
-//                                  "incorrect testing of acpkm encryption mode for block ciphers" );
-//    return ak_false;
-//  }
+ /* тестируем дополнительные режимы работы */
+  if( ak_bckey_test_mgm()  != ak_true ) {
+    ak_error_message( ak_error_get_value(), __func__ ,
+                                               "incorrect testing of mgm mode for block ciphers" );
+    return ak_false;
+  }
+  if( ak_bckey_test_acpkm()  != ak_true ) {
+    ak_error_message( ak_error_get_value(), __func__ ,
+                                  "incorrect testing of acpkm encryption mode for block ciphers" );
+    return ak_false;
+  }
 
   if( audit >= ak_log_maximum )
    ak_error_message( ak_error_ok, __func__ , "testing block ciphers ended successfully" );
@@ -221,11 +244,12 @@
 //    return ak_false;
 //  }
 
-//  if( ak_mac_test_omac_functions() != ak_true ) {
-//    ak_error_message( ak_error_get_value(), __func__,
-//                                   "incorrect testing mac algorithms based on block ciphers" );
-//    return ak_false
-//  }
+ /* тестирование механизма выработки имитовставки на основе блочных шифров */
+  if( ak_mac_test_omac_functions() != ak_true ) {
+    ak_error_message( ak_error_get_value(), __func__,
+                                   "incorrect testing mac algorithms based on block ciphers" );
+    return ak_false;
+  }
 
   if( audit >= ak_log_maximum )
    ak_error_message( ak_error_ok, __func__ , "testing mac algorithms ended successfully" );
@@ -382,6 +406,18 @@
     return ak_false;
   }
 
+ /* инициализируем развернутые таблицы замен для алгоритма Магма */
+  if(( error = ak_bckey_context_magma_init_tables()) != ak_error_ok ) {
+    ak_error_message( error, __func__, "initialization of magma tables is wrong" );
+    return ak_false;
+  }
+
+ /* инициализируем совмещенные таблицы и выбираем реализацию функции сжатия Стрибог */
+  if(( error = ak_hash_context_streebog_init_tables()) != ak_error_ok ) {
+    ak_error_message( error, __func__, "initialization of streebog tables is wrong" );
+    return ak_false;
+  }
+
  /* инициализируем структуру управления контекстами */
    if(( error = ak_libakrypt_create_context_manager()) != ak_error_ok ) {
      ak_error_message( error, __func__, "initialization of context manager is wrong" );
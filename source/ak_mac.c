@@ -169,6 +169,63 @@
  return mctx->finalize( mctx->ctx, mctx->data, mctx->length, out, out_size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция последовательно обрабатывает фрагменты так, как если бы они были расположены
+    в одной непрерывной области памяти. Неполный блок данных, образующийся на границе
+    фрагментов, сохраняется во внутреннем буффере контекста и дополняется данными следующих
+    фрагментов, поэтому результат совпадает с результатом вызова функции ak_mac_context_update()
+    для объединенных данных.
+
+    @param mctx Указатель на контекст итерационного сжатия.
+    @param fragments Массив фрагментов сжимаемых данных; фрагменты могут иметь
+    произвольную, в том числе нулевую, длину.
+    @param count Количество фрагментов.
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mac_context_update_fragments( ak_mac mctx, ak_fragment fragments, const size_t count )
+{
+  size_t i = 0;
+  int error = ak_error_ok;
+
+  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to internal mac context" );
+  if(( fragments == NULL ) && ( count > 0 )) return ak_error_message( ak_error_null_pointer,
+                                              __func__, "using a null pointer to fragments array" );
+  for( i = 0; i < count; i++ ) {
+     if( fragments[i].size == 0 ) continue;
+     if(( error = ak_mac_context_update( mctx,
+                                    fragments[i].data, fragments[i].size )) != ak_error_ok )
+       return ak_error_message( error, __func__ , "incorrect updating input data" );
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Результат совпадает с результатом вызова функции ak_mac_context_finalize()
+    для данных, полученных объединением фрагментов.
+
+    @param mctx Указатель на контекст итерационного сжатия.
+    @param fragments Массив фрагментов сжимаемых данных.
+    @param count Количество фрагментов.
+    @param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    @param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mac_context_finalize_fragments( ak_mac mctx, ak_fragment fragments, const size_t count,
+                                                           ak_pointer out, const size_t out_size )
+{
+  int error = ak_error_ok;
+
+  if(( error = ak_mac_context_update_fragments( mctx, fragments, count )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "incorrect updating input data" );
+
+ return ak_mac_context_finalize( mctx, "", 0, out, out_size );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \note Внутренняя структура, хранящая промежуточные данные, не очищается. Это позволяет повторно
     вызывать функцию finalize к текущему состоянию.
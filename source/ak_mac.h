@@ -23,6 +23,18 @@
 /*! \brief Максимальный размер блока входных данных. */
  #define ak_mac_context_max_buffer_size (64)
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Фрагмент данных, расположенный в непрерывной области памяти.
+    \details Массив фрагментов описывает данные, расположенные в нескольких несмежных областях
+    памяти (например, заголовок, содержимое и окончание сетевого пакета), и позволяет
+    обрабатывать их без предварительного копирования в один буффер. */
+ typedef struct fragment {
+  /*! \brief Указатель на данные фрагмента. */
+   ak_pointer data;
+  /*! \brief Размер фрагмента (в октетах). */
+   size_t size;
+ } *ak_fragment;
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Контекст алгоритима итерационного сжатия. */
 /*! Класс предоставляет интерфейс для реализации процедруры последовательного итерационного сжатия.
@@ -57,6 +69,13 @@
  int ak_mac_context_update( ak_mac , const ak_pointer , const size_t );
 /*! \brief Обновление состояния и вычисление результата применения сжимающего отображения. */
  int ak_mac_context_finalize( ak_mac , const ak_pointer , const size_t , ak_pointer , const size_t );
+/*! \brief Обновление состояния контекста сжимающего отображения данными,
+    расположенными в нескольких фрагментах. */
+ int ak_mac_context_update_fragments( ak_mac , ak_fragment , const size_t );
+/*! \brief Обновление состояния данными, расположенными в нескольких фрагментах,
+    и вычисление результата применения сжимающего отображения. */
+ int ak_mac_context_finalize_fragments( ak_mac , ak_fragment , const size_t ,
+                                                                       ak_pointer , const size_t );
 /*! \brief Применение сжимающего отображения к заданной области памяти. */
  int ak_mac_context_ptr( ak_mac , ak_pointer , const size_t , ak_pointer , const size_t );
 /*! \brief Применение сжимающего отображения к заданному файлу. */
@@ -21,6 +21,11 @@
  #error Library cannot be compiled without string.h header
 #endif
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество случайных траекторий, вырабатываемых за одно обращение к генератору
+    в маскированной реализации Магмы. */
+ #define ak_magma_walk_pool_size    (256)
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief  Структура для хранения внутренних данных в маскированной реализации Магмы. */
  struct magma_encrypted_keys {
@@ -29,93 +34,249 @@
   /*! \brief  Две маски для двух ключевых последовательностей, соответственно,
       прямой и инвертированной. */
   ak_uint32 inmask[2][8];
+  /*! \brief  Запас случайных траекторий; i-й бит траектории определяет, какая из двух
+      ключевых последовательностей используется в (i+1)-м такте преобразования. */
+  ak_uint32 walk[ak_magma_walk_pool_size];
+  /*! \brief  Количество использованных траекторий из запаса. */
+  size_t walk_used;
 };
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Развернутые таблицы замен маскированной реализации Магмы.
+    \details Для каждого из четырех вариантов таблиц замен `magma_boxes[j][i]` хранятся четыре
+    таблицы из 256 32-х битных слов, содержащие значения подстановки, уже размещенные
+    в соответствующем октете слова и циклически сдвинутые на 11 разрядов влево. Общий объем
+    таблиц составляет 16 килобайт, по 4 килобайта на каждый вариант таблиц замен.              */
+ static ak_uint32 magma_expanded_boxes[2][2][4][256];
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет развернутые таблицы замен, используемые при реализации
+    алгоритма блочного шифрования Магма. Функция должна вызываться до создания ключей.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль).                            */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_magma_init_tables( void )
+{
+  ak_uint32 x = 0;
+  size_t i = 0, j = 0, k = 0, v = 0;
+
+  for( j = 0; j < 2; j++ )
+     for( i = 0; i < 2; i++ )
+        for( k = 0; k < 4; k++ )
+           for( v = 0; v < 256; v++ ) {
+              x = (( ak_uint32 ) magma_boxes[j][i][k][v] ) << ( 8*k );
+              magma_expanded_boxes[j][i][k][v] = x<<11 | x>>(32-11);
+           }
+  if( ak_log_get_level() >= ak_log_maximum ) return ak_error_message( ak_error_ok, __func__ ,
+                                                  "generation of magma expanded tables is Ok" );
+ return ak_error_ok;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Функция реализует один такт шифрующего преобразования ГОСТ 34.12-2015 (Mагма).
 
+    Подстановка и циклический сдвиг выполняются за четыре обращения к развернутым таблицам.
+
     @param x Обрабатываемая половина блока (более детально смотри описание сети Фейстеля).
     @return Результат криптографического преобразования.                                           */
 /* ----------------------------------------------------------------------------------------------- */
  static inline ak_uint32 ak_magma_gostf_boxes( ak_uint32 x, const ak_uint8 i, const ak_uint8 j )
 {
-  x = magma_boxes[j][i][3][x>>24 & 255] << 24 | magma_boxes[j][i][2][x>>16 & 255] << 16 |
-                           magma_boxes[j][i][1][x>> 8 & 255] <<  8 | magma_boxes[j][i][0][x & 255];
-  return x<<11 | x>>(32-11);
+  const ak_uint32 (*t)[256] = ( const ak_uint32 (*)[256] ) magma_expanded_boxes[j][i];
+  return t[0][x & 255] ^ t[1][x>> 8 & 255] ^ t[2][x>>16 & 255] ^ t[3][x>>24];
 }
 
 /* ----------------------------------------------------------------------------------------------- */
-/*! \brief Функция зашифрования одного блока информации алгоритмом ГОСТ 34.12-2015 (Магма).
+/*! \brief Функция возвращает очередную случайную траекторию из запаса, хранящегося
+    во внутренних данных ключа.
+
+    Запас траекторий пополняется целиком, одним обращением к генератору ключа, после того,
+    как все ранее выработанные траектории использованы. Траектория возвращается
+    сдвинутой на один разряд: нулевой и 33-й биты результата равны нулю, что
+    соответствует неизменным значениям до первого и после последнего тактов.
 
     @param skey Контекст секретного ключа.
-    @param in Блок входной информации (открытый текст).
-    @param out Блок выходной информации (шифртекст).                                               */
+    @return Значение траектории.                                                                   */
 /* ----------------------------------------------------------------------------------------------- */
- static void ak_magma_encrypt_with_random_walk( ak_skey skey, ak_pointer in, ak_pointer out )
+ static inline ak_uint64 ak_magma_next_walk( ak_skey skey )
 {
-  ak_uint8 m[34];
-  ak_uint32 i, mv = 0;
-  ak_uint32 (*kp)[8] = ((struct magma_encrypted_keys *)skey->data)->inkey;
-  ak_uint32 (*mp)[8] = ((struct magma_encrypted_keys *)skey->data)->inmask;
-  register ak_uint32 n3, n4, p = 0;
+  struct magma_encrypted_keys *data = ( struct magma_encrypted_keys *)skey->data;
+  size_t idx = data->walk_used;
 
- /* вырабатываем случайную траекторию */
-  skey->generator.random( &skey->generator, &mv, sizeof( ak_uint32 ));
+  if( idx >= ak_magma_walk_pool_size ) {
+    skey->generator.random( &skey->generator, data->walk, sizeof( data->walk ));
+    idx = 0;
+  }
+  data->walk_used = idx + 1;
+ return (( ak_uint64 )data->walk[idx] ) << 1;
+}
 
- /* формируем вектор раундовых поворотов */
-  m[0] = m[33] = 0;
-  for( i = 0; i < 32; i++ ) m[i+1] = (ak_uint8)(( mv >> i) & 0x01 );
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Значение бита траектории `w`, соответствующего такту с номером `r`. */
+ #define ak_magma_walk_bit( w, r )  (( ak_uint32 )(( (w) >> ( r )) & 0x01 ))
+
+/*! \brief Такт преобразования с использованием ключевой последовательности,
+    определяемой траекторией `w`. */
+ #define ak_magma_walk_round( w, a, b, r, k ) { \
+   p = a; p -= mp[ak_magma_walk_bit( w, r )][k]; \
+   p += kp[ak_magma_walk_bit( w, r )][k] + ak_magma_walk_bit( w, r ); \
+   b ^= ak_magma_gostf_boxes( p, \
+             ( ak_uint8 )( ak_magma_walk_bit( w, (r)+1 )^ak_magma_walk_bit( w, (r)-1 )), \
+                                                             ( ak_uint8 )ak_magma_walk_bit( w, r )); \
+ }
+
+/*! \brief Такт преобразования одного блока. */
+ #define ak_magma_round1( a, b, r, k ) ak_magma_walk_round( w, a, b, r, k )
+
+/*! \brief Такт преобразования, выполняемый одновременно для четырех независимых блоков. */
+ #define ak_magma_round4( a, b, r, k ) { \
+   ak_magma_walk_round( w[0], a[0], b[0], r, k ); ak_magma_walk_round( w[1], a[1], b[1], r, k ); \
+   ak_magma_walk_round( w[2], a[2], b[2], r, k ); ak_magma_walk_round( w[3], a[3], b[3], r, k ); \
+ }
+
+/*! \brief Последовательность тактов зашифрования (номер такта и номер раундового ключа). */
+ #define ak_magma_encrypt_rounds( R ) \
+  R( n3, n4,  1, 7 ) R( n4, n3,  2, 6 ) R( n3, n4,  3, 5 ) R( n4, n3,  4, 4 ) \
+  R( n3, n4,  5, 3 ) R( n4, n3,  6, 2 ) R( n3, n4,  7, 1 ) R( n4, n3,  8, 0 ) \
+  R( n3, n4,  9, 7 ) R( n4, n3, 10, 6 ) R( n3, n4, 11, 5 ) R( n4, n3, 12, 4 ) \
+  R( n3, n4, 13, 3 ) R( n4, n3, 14, 2 ) R( n3, n4, 15, 1 ) R( n4, n3, 16, 0 ) \
+  R( n3, n4, 17, 7 ) R( n4, n3, 18, 6 ) R( n3, n4, 19, 5 ) R( n4, n3, 20, 4 ) \
+  R( n3, n4, 21, 3 ) R( n4, n3, 22, 2 ) R( n3, n4, 23, 1 ) R( n4, n3, 24, 0 ) \
+  R( n3, n4, 25, 0 ) R( n4, n3, 26, 1 ) R( n3, n4, 27, 2 ) R( n4, n3, 28, 3 ) \
+  R( n3, n4, 29, 4 ) R( n4, n3, 30, 5 ) R( n3, n4, 31, 6 ) R( n4, n3, 32, 7 )
+
+/*! \brief Последовательность тактов расшифрования (номер такта и номер раундового ключа). */
+ #define ak_magma_decrypt_rounds( R ) \
+  R( n3, n4,  1, 7 ) R( n4, n3,  2, 6 ) R( n3, n4,  3, 5 ) R( n4, n3,  4, 4 ) \
+  R( n3, n4,  5, 3 ) R( n4, n3,  6, 2 ) R( n3, n4,  7, 1 ) R( n4, n3,  8, 0 ) \
+  R( n3, n4,  9, 0 ) R( n4, n3, 10, 1 ) R( n3, n4, 11, 2 ) R( n4, n3, 12, 3 ) \
+  R( n3, n4, 13, 4 ) R( n4, n3, 14, 5 ) R( n3, n4, 15, 6 ) R( n4, n3, 16, 7 ) \
+  R( n3, n4, 17, 0 ) R( n4, n3, 18, 1 ) R( n3, n4, 19, 2 ) R( n4, n3, 20, 3 ) \
+  R( n3, n4, 21, 4 ) R( n4, n3, 22, 5 ) R( n3, n4, 23, 6 ) R( n4, n3, 24, 7 ) \
+  R( n3, n4, 25, 0 ) R( n4, n3, 26, 1 ) R( n3, n4, 27, 2 ) R( n4, n3, 28, 3 ) \
+  R( n3, n4, 29, 4 ) R( n4, n3, 30, 5 ) R( n3, n4, 31, 6 ) R( n4, n3, 32, 7 )
+
+/*! \brief Загрузка блока и наложение маски, определяемой первым тактом траектории. */
+#ifdef LIBAKRYPT_LITTLE_ENDIAN
+ #define ak_magma_walk_load( w, in, n3, n4 ) { \
+   n3 = ((ak_uint32 *)( in ))[0]^( ak_magma_walk_bit( w, 1 ) * 0xffffffff ); \
+   n4 = ((ak_uint32 *)( in ))[1]; \
+ }
+#else
+ #define ak_magma_walk_load( w, in, n3, n4 ) { \
+   n3 = bswap_32( ((ak_uint32 *)( in ))[0] )^( ak_magma_walk_bit( w, 1 ) * 0xffffffff ); \
+   n4 = bswap_32( ((ak_uint32 *)( in ))[1] ); \
+ }
+#endif
 
- /* начинаем движение */
+/*! \brief Снятие маски, определяемой последним тактом траектории, и сохранение блока. */
 #ifdef LIBAKRYPT_LITTLE_ENDIAN
-  n3 = ((ak_uint32 *) in)[0]^( m[1] * 0xffffffff );
-  n4 = ((ak_uint32 *) in)[1];
+ #define ak_magma_walk_store( w, out, n3, n4 ) { \
+   ((ak_uint32 *)( out ))[0] = n4^( ak_magma_walk_bit( w, 32 ) * 0xffffffff ); \
+   ((ak_uint32 *)( out ))[1] = n3; \
+ }
 #else
-  n3 = bswap_32( ((ak_uint32 *) in)[0] )^( m[1] * 0xffffffff );
-  n4 = bswap_32( ((ak_uint32 *) in)[1] );
+ #define ak_magma_walk_store( w, out, n3, n4 ) { \
+   ((ak_uint32 *)( out ))[0] = bswap_32( n4 )^( ak_magma_walk_bit( w, 32 ) * 0xffffffff ); \
+   ((ak_uint32 *)( out ))[1] = bswap_32( n3 ); \
+ }
 #endif
 
-  p = n3; p -= mp[m[ 1]][7]; p += kp[m[ 1]][7] + m[ 1]; n4 ^= ak_magma_gostf_boxes( p, m[ 2] ^ m[ 0], m[ 1] );
-  p = n4; p -= mp[m[ 2]][6]; p += kp[m[ 2]][6] + m[ 2]; n3 ^= ak_magma_gostf_boxes( p, m[ 3] ^ m[ 1], m[ 2] );
-  p = n3; p -= mp[m[ 3]][5]; p += kp[m[ 3]][5] + m[ 3]; n4 ^= ak_magma_gostf_boxes( p, m[ 4] ^ m[ 2], m[ 3] );
-  p = n4; p -= mp[m[ 4]][4]; p += kp[m[ 4]][4] + m[ 4]; n3 ^= ak_magma_gostf_boxes( p, m[ 5] ^ m[ 3], m[ 4] );
-  p = n3; p -= mp[m[ 5]][3]; p += kp[m[ 5]][3] + m[ 5]; n4 ^= ak_magma_gostf_boxes( p, m[ 6] ^ m[ 4], m[ 5] );
-  p = n4; p -= mp[m[ 6]][2]; p += kp[m[ 6]][2] + m[ 6]; n3 ^= ak_magma_gostf_boxes( p, m[ 7] ^ m[ 5], m[ 6] );
-  p = n3; p -= mp[m[ 7]][1]; p += kp[m[ 7]][1] + m[ 7]; n4 ^= ak_magma_gostf_boxes( p, m[ 8] ^ m[ 6], m[ 7] );
-  p = n4; p -= mp[m[ 8]][0]; p += kp[m[ 8]][0] + m[ 8]; n3 ^= ak_magma_gostf_boxes( p, m[ 9] ^ m[ 7], m[ 8] );
-
-  p = n3; p -= mp[m[ 9]][7]; p += kp[m[ 9]][7] + m[ 9]; n4 ^= ak_magma_gostf_boxes( p, m[10] ^ m[ 8], m[ 9] );
-  p = n4; p -= mp[m[10]][6]; p += kp[m[10]][6] + m[10]; n3 ^= ak_magma_gostf_boxes( p, m[11] ^ m[ 9], m[10] );
-  p = n3; p -= mp[m[11]][5]; p += kp[m[11]][5] + m[11]; n4 ^= ak_magma_gostf_boxes( p, m[12] ^ m[10], m[11] );
-  p = n4; p -= mp[m[12]][4]; p += kp[m[12]][4] + m[12]; n3 ^= ak_magma_gostf_boxes( p, m[13] ^ m[11], m[12] );
-  p = n3; p -= mp[m[13]][3]; p += kp[m[13]][3] + m[13]; n4 ^= ak_magma_gostf_boxes( p, m[14] ^ m[12], m[13] );
-  p = n4; p -= mp[m[14]][2]; p += kp[m[14]][2] + m[14]; n3 ^= ak_magma_gostf_boxes( p, m[15] ^ m[13], m[14] );
-  p = n3; p -= mp[m[15]][1]; p += kp[m[15]][1] + m[15]; n4 ^= ak_magma_gostf_boxes( p, m[16] ^ m[14], m[15] );
-  p = n4; p -= mp[m[16]][0]; p += kp[m[16]][0] + m[16]; n3 ^= ak_magma_gostf_boxes( p, m[17] ^ m[15], m[16] );
-
-  p = n3; p -= mp[m[17]][7]; p += kp[m[17]][7] + m[17]; n4 ^= ak_magma_gostf_boxes( p, m[18] ^ m[16], m[17] );
-  p = n4; p -= mp[m[18]][6]; p += kp[m[18]][6] + m[18]; n3 ^= ak_magma_gostf_boxes( p, m[19] ^ m[17], m[18] );
-  p = n3; p -= mp[m[19]][5]; p += kp[m[19]][5] + m[19]; n4 ^= ak_magma_gostf_boxes( p, m[20] ^ m[18], m[19] );
-  p = n4; p -= mp[m[20]][4]; p += kp[m[20]][4] + m[20]; n3 ^= ak_magma_gostf_boxes( p, m[21] ^ m[19], m[20] );
-  p = n3; p -= mp[m[21]][3]; p += kp[m[21]][3] + m[21]; n4 ^= ak_magma_gostf_boxes( p, m[22] ^ m[20], m[21] );
-  p = n4; p -= mp[m[22]][2]; p += kp[m[22]][2] + m[22]; n3 ^= ak_magma_gostf_boxes( p, m[23] ^ m[21], m[22] );
-  p = n3; p -= mp[m[23]][1]; p += kp[m[23]][1] + m[23]; n4 ^= ak_magma_gostf_boxes( p, m[24] ^ m[22], m[23] );
-  p = n4; p -= mp[m[24]][0]; p += kp[m[24]][0] + m[24]; n3 ^= ak_magma_gostf_boxes( p, m[25] ^ m[23], m[24] );
-
-  p = n3; p -= mp[m[25]][0]; p += kp[m[25]][0] + m[25]; n4 ^= ak_magma_gostf_boxes( p, m[26] ^ m[24], m[25] );
-  p = n4; p -= mp[m[26]][1]; p += kp[m[26]][1] + m[26]; n3 ^= ak_magma_gostf_boxes( p, m[27] ^ m[25], m[26] );
-  p = n3; p -= mp[m[27]][2]; p += kp[m[27]][2] + m[27]; n4 ^= ak_magma_gostf_boxes( p, m[28] ^ m[26], m[27] );
-  p = n4; p -= mp[m[28]][3]; p += kp[m[28]][3] + m[28]; n3 ^= ak_magma_gostf_boxes( p, m[29] ^ m[27], m[28] );
-  p = n3; p -= mp[m[29]][4]; p += kp[m[29]][4] + m[29]; n4 ^= ak_magma_gostf_boxes( p, m[30] ^ m[28], m[29] );
-  p = n4; p -= mp[m[30]][5]; p += kp[m[30]][5] + m[30]; n3 ^= ak_magma_gostf_boxes( p, m[31] ^ m[29], m[30] );
-  p = n3; p -= mp[m[31]][6]; p += kp[m[31]][6] + m[31]; n4 ^= ak_magma_gostf_boxes( p, m[32] ^ m[30], m[31] );
-  p = n4; p -= mp[m[32]][7]; p += kp[m[32]][7] + m[32]; n3 ^= ak_magma_gostf_boxes( p, m[33] ^ m[31], m[32] );
-
- #ifdef LIBAKRYPT_LITTLE_ENDIAN
-  ((ak_uint32 *)out)[0] = n4^( m[32] * 0xffffffff ); ((ak_uint32 *)out)[1] = n3;
- #else
-  ((ak_uint32 *)out)[0] = bswap_32( n4 )^( m[32] * 0xffffffff ); ((ak_uint32 *)out)[1] = bswap_32( n3 );
- #endif
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования одного блока информации алгоритмом ГОСТ 34.12-2015 (Магма)
+    вдоль заданной траектории.
+
+    @param kp Ключевые последовательности.
+    @param mp Маски ключевых последовательностей.
+    @param w Траектория, выработанная функцией ak_magma_next_walk().
+    @param in Блок входной информации (открытый текст).
+    @param out Блок выходной информации (шифртекст).                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_magma_encrypt_walk( ak_uint32 (*kp)[8], ak_uint32 (*mp)[8],
+                                            const ak_uint64 w, ak_pointer in, ak_pointer out )
+{
+  register ak_uint32 n3, n4, p = 0;
+
+  ak_magma_walk_load( w, in, n3, n4 );
+  ak_magma_encrypt_rounds( ak_magma_round1 )
+  ak_magma_walk_store( w, out, n3, n4 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования одного блока информации алгоритмом ГОСТ 34.12-2015 (Магма)
+    вдоль заданной траектории.
+
+    @param kp Ключевые последовательности.
+    @param mp Маски ключевых последовательностей.
+    @param w Траектория, выработанная функцией ak_magma_next_walk().
+    @param in Блок входной информации (шифртекст).
+    @param out Блок выходной информации (открытый текст).                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_magma_decrypt_walk( ak_uint32 (*kp)[8], ak_uint32 (*mp)[8],
+                                            const ak_uint64 w, ak_pointer in, ak_pointer out )
+{
+  register ak_uint32 n3, n4, p = 0;
+
+  ak_magma_walk_load( w, in, n3, n4 );
+  ak_magma_decrypt_rounds( ak_magma_round1 )
+  ak_magma_walk_store( w, out, n3, n4 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования четырех последовательно расположенных блоков информации.
+    \details Преобразования четырех блоков чередуются, что позволяет процессору
+    выполнять независимые обращения к таблицам замен одновременно.
+
+    @param kp Ключевые последовательности.
+    @param mp Маски ключевых последовательностей.
+    @param w Четыре траектории, по одной для каждого блока.
+    @param in Указатель на входные данные (четыре блока).
+    @param out Указатель на выходные данные (четыре блока).                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_magma_encrypt_walk4( ak_uint32 (*kp)[8], ak_uint32 (*mp)[8],
+                                            const ak_uint64 *w, ak_uint64 *in, ak_uint64 *out )
+{
+  ak_uint32 n3[4], n4[4], p = 0;
+
+  ak_magma_walk_load( w[0], in, n3[0], n4[0] ); ak_magma_walk_load( w[1], in+1, n3[1], n4[1] );
+  ak_magma_walk_load( w[2], in+2, n3[2], n4[2] ); ak_magma_walk_load( w[3], in+3, n3[3], n4[3] );
+  ak_magma_encrypt_rounds( ak_magma_round4 )
+  ak_magma_walk_store( w[0], out, n3[0], n4[0] ); ak_magma_walk_store( w[1], out+1, n3[1], n4[1] );
+  ak_magma_walk_store( w[2], out+2, n3[2], n4[2] ); ak_magma_walk_store( w[3], out+3, n3[3], n4[3] );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования четырех последовательно расположенных блоков информации.
+
+    @param kp Ключевые последовательности.
+    @param mp Маски ключевых последовательностей.
+    @param w Четыре траектории, по одной для каждого блока.
+    @param in Указатель на входные данные (четыре блока).
+    @param out Указатель на выходные данные (четыре блока).                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_magma_decrypt_walk4( ak_uint32 (*kp)[8], ak_uint32 (*mp)[8],
+                                            const ak_uint64 *w, ak_uint64 *in, ak_uint64 *out )
+{
+  ak_uint32 n3[4], n4[4], p = 0;
+
+  ak_magma_walk_load( w[0], in, n3[0], n4[0] ); ak_magma_walk_load( w[1], in+1, n3[1], n4[1] );
+  ak_magma_walk_load( w[2], in+2, n3[2], n4[2] ); ak_magma_walk_load( w[3], in+3, n3[3], n4[3] );
+  ak_magma_decrypt_rounds( ak_magma_round4 )
+  ak_magma_walk_store( w[0], out, n3[0], n4[0] ); ak_magma_walk_store( w[1], out+1, n3[1], n4[1] );
+  ak_magma_walk_store( w[2], out+2, n3[2], n4[2] ); ak_magma_walk_store( w[3], out+3, n3[3], n4[3] );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования одного блока информации алгоритмом ГОСТ 34.12-2015 (Магма).
+
+    @param skey Контекст секретного ключа.
+    @param in Блок входной информации (открытый текст).
+    @param out Блок выходной информации (шифртекст).                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_magma_encrypt_with_random_walk( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  struct magma_encrypted_keys *data = ( struct magma_encrypted_keys *)skey->data;
+  ak_magma_encrypt_walk( data->inkey, data->inmask, ak_magma_next_walk( skey ), in, out );
 }
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -128,69 +289,84 @@
 /* ----------------------------------------------------------------------------------------------- */
  static void ak_magma_decrypt_with_random_walk( ak_skey skey, ak_pointer in, ak_pointer out )
 {
-  ak_uint8 m[34];
-  ak_uint32 i, mv = 0;
-  ak_uint32 (*kp)[8] = ((struct magma_encrypted_keys *)skey->data)->inkey;
-  ak_uint32 (*mp)[8] = ((struct magma_encrypted_keys *)skey->data)->inmask;
-  register ak_uint32 n3, n4, p = 0;
+  struct magma_encrypted_keys *data = ( struct magma_encrypted_keys *)skey->data;
+  ak_magma_decrypt_walk( data->inkey, data->inmask, ak_magma_next_walk( skey ), in, out );
+}
 
- /* вырабатываем случайную траекторию */
-  skey->generator.random( &skey->generator, &mv, sizeof( ak_uint32 ));
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования нескольких последовательно расположенных блоков информации
+    алгоритмом ГОСТ 34.12-2015 (Магма).
 
- /* формируем вектор раундовых поворотов */
-  m[0] = m[33] = 0;
-  for( i = 0; i < 32; i++ ) m[i+1] = (ak_uint8)((mv >> i) & 0x01 );
+    Для каждого блока используется своя случайная траектория из запаса,
+    хранящегося во внутренних данных ключа. Блоки обрабатываются четверками.
 
- /* начинаем движение */
-#ifdef LIBAKRYPT_LITTLE_ENDIAN
-  n3 = ((ak_uint32 *) in)[0]^( m[1] * 0xffffffff );
-  n4 = ((ak_uint32 *) in)[1];
-#else
-  n3 = bswap_32( ((ak_uint32 *) in)[0] )^( m[1] * 0xffffffff );
-  n4 = bswap_32( ((ak_uint32 *) in)[1] );
-#endif
+    @param skey Контекст секретного ключа.
+    @param in Указатель на входные данные (открытый текст).
+    @param out Указатель на выходные данные (шифртекст).
+    @param blocks Количество обрабатываемых блоков.                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_magma_encrypt_blocks_with_random_walk( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 w[4];
+  struct magma_encrypted_keys *data = ( struct magma_encrypted_keys *)skey->data;
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= 4; blocks -= 4, inptr += 4, outptr += 4 ) {
+     w[0] = ak_magma_next_walk( skey ); w[1] = ak_magma_next_walk( skey );
+     w[2] = ak_magma_next_walk( skey ); w[3] = ak_magma_next_walk( skey );
+     ak_magma_encrypt_walk4( data->inkey, data->inmask, w, inptr, outptr );
+  }
+  for( ; blocks > 0; blocks-- )
+     ak_magma_encrypt_walk( data->inkey, data->inmask, ak_magma_next_walk( skey ),
+                                                                            inptr++, outptr++ );
+}
 
-  p = (n3 - mp[m[ 1]][7]); p += kp[m[ 1]][7] + m[ 1]; n4 ^= ak_magma_gostf_boxes(p, m[ 2] ^ m[ 0], m[ 1] );
-  p = (n4 - mp[m[ 2]][6]); p += kp[m[ 2]][6] + m[ 2]; n3 ^= ak_magma_gostf_boxes(p, m[ 3] ^ m[ 1], m[ 2] );
-  p = (n3 - mp[m[ 3]][5]); p += kp[m[ 3]][5] + m[ 3]; n4 ^= ak_magma_gostf_boxes(p, m[ 4] ^ m[ 2], m[ 3] );
-  p = (n4 - mp[m[ 4]][4]); p += kp[m[ 4]][4] + m[ 4]; n3 ^= ak_magma_gostf_boxes(p, m[ 5] ^ m[ 3], m[ 4] );
-  p = (n3 - mp[m[ 5]][3]); p += kp[m[ 5]][3] + m[ 5]; n4 ^= ak_magma_gostf_boxes(p, m[ 6] ^ m[ 4], m[ 5] );
-  p = (n4 - mp[m[ 6]][2]); p += kp[m[ 6]][2] + m[ 6]; n3 ^= ak_magma_gostf_boxes(p, m[ 7] ^ m[ 5], m[ 6] );
-  p = (n3 - mp[m[ 7]][1]); p += kp[m[ 7]][1] + m[ 7]; n4 ^= ak_magma_gostf_boxes(p, m[ 8] ^ m[ 6], m[ 7] );
-  p = (n4 - mp[m[ 8]][0]); p += kp[m[ 8]][0] + m[ 8]; n3 ^= ak_magma_gostf_boxes(p, m[ 9] ^ m[ 7], m[ 8] );
-
-  p = (n3 - mp[m[ 9]][0]); p += kp[m[ 9]][0] + m[ 9]; n4 ^= ak_magma_gostf_boxes(p, m[10] ^ m[ 8], m[ 9] );
-  p = (n4 - mp[m[10]][1]); p += kp[m[10]][1] + m[10]; n3 ^= ak_magma_gostf_boxes(p, m[11] ^ m[ 9], m[10] );
-  p = (n3 - mp[m[11]][2]); p += kp[m[11]][2] + m[11]; n4 ^= ak_magma_gostf_boxes(p, m[12] ^ m[10], m[11] );
-  p = (n4 - mp[m[12]][3]); p += kp[m[12]][3] + m[12]; n3 ^= ak_magma_gostf_boxes(p, m[13] ^ m[11], m[12] );
-  p = (n3 - mp[m[13]][4]); p += kp[m[13]][4] + m[13]; n4 ^= ak_magma_gostf_boxes(p, m[14] ^ m[12], m[13] );
-  p = (n4 - mp[m[14]][5]); p += kp[m[14]][5] + m[14]; n3 ^= ak_magma_gostf_boxes(p, m[15] ^ m[13], m[14] );
-  p = (n3 - mp[m[15]][6]); p += kp[m[15]][6] + m[15]; n4 ^= ak_magma_gostf_boxes(p, m[16] ^ m[14], m[15] );
-  p = (n4 - mp[m[16]][7]); p += kp[m[16]][7] + m[16]; n3 ^= ak_magma_gostf_boxes(p, m[17] ^ m[15], m[16] );
-
-  p = (n3 - mp[m[17]][0]); p += kp[m[17]][0] + m[17]; n4 ^= ak_magma_gostf_boxes(p, m[18] ^ m[16], m[17] );
-  p = (n4 - mp[m[18]][1]); p += kp[m[18]][1] + m[18]; n3 ^= ak_magma_gostf_boxes(p, m[19] ^ m[17], m[18] );
-  p = (n3 - mp[m[19]][2]); p += kp[m[19]][2] + m[19]; n4 ^= ak_magma_gostf_boxes(p, m[20] ^ m[18], m[19] );
-  p = (n4 - mp[m[20]][3]); p += kp[m[20]][3] + m[20]; n3 ^= ak_magma_gostf_boxes(p, m[21] ^ m[19], m[20] );
-  p = (n3 - mp[m[21]][4]); p += kp[m[21]][4] + m[21]; n4 ^= ak_magma_gostf_boxes(p, m[22] ^ m[20], m[21] );
-  p = (n4 - mp[m[22]][5]); p += kp[m[22]][5] + m[22]; n3 ^= ak_magma_gostf_boxes(p, m[23] ^ m[21], m[22] );
-  p = (n3 - mp[m[23]][6]); p += kp[m[23]][6] + m[23]; n4 ^= ak_magma_gostf_boxes(p, m[24] ^ m[22], m[23] );
-  p = (n4 - mp[m[24]][7]); p += kp[m[24]][7] + m[24]; n3 ^= ak_magma_gostf_boxes(p, m[25] ^ m[23], m[24] );
-
-  p = (n3 - mp[m[25]][0]); p += kp[m[25]][0] + m[25]; n4 ^= ak_magma_gostf_boxes(p, m[26] ^ m[24], m[25] );
-  p = (n4 - mp[m[26]][1]); p += kp[m[26]][1] + m[26]; n3 ^= ak_magma_gostf_boxes(p, m[27] ^ m[25], m[26] );
-  p = (n3 - mp[m[27]][2]); p += kp[m[27]][2] + m[27]; n4 ^= ak_magma_gostf_boxes(p, m[28] ^ m[26], m[27] );
-  p = (n4 - mp[m[28]][3]); p += kp[m[28]][3] + m[28]; n3 ^= ak_magma_gostf_boxes(p, m[29] ^ m[27], m[28] );
-  p = (n3 - mp[m[29]][4]); p += kp[m[29]][4] + m[29]; n4 ^= ak_magma_gostf_boxes(p, m[30] ^ m[28], m[29] );
-  p = (n4 - mp[m[30]][5]); p += kp[m[30]][5] + m[30]; n3 ^= ak_magma_gostf_boxes(p, m[31] ^ m[29], m[30] );
-  p = (n3 - mp[m[31]][6]); p += kp[m[31]][6] + m[31]; n4 ^= ak_magma_gostf_boxes(p, m[32] ^ m[30], m[31] );
-  p = (n4 - mp[m[32]][7]); p += kp[m[32]][7] + m[32]; n3 ^= ak_magma_gostf_boxes(p, m[33] ^ m[31], m[32] );
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования нескольких последовательно расположенных блоков информации
+    алгоритмом ГОСТ 34.12-2015 (Магма).
 
-#ifdef LIBAKRYPT_LITTLE_ENDIAN
-  ((ak_uint32 *)out)[0] = n4 ^ (m[32] * 0xffffffff); ((ak_uint32 *)out)[1] = n3;
-#else
-  ((ak_uint32 *)out)[0] = bswap_32( n4 ) ^ (m[32] * 0xffffffff); ((ak_uint32 *)out)[1] = bswap_32( n3 );
-#endif
+    @param skey Контекст секретного ключа.
+    @param in Указатель на входные данные (шифртекст).
+    @param out Указатель на выходные данные (открытый текст).
+    @param blocks Количество обрабатываемых блоков.                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_magma_decrypt_blocks_with_random_walk( ak_skey skey,
+                                                  ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint64 w[4];
+  struct magma_encrypted_keys *data = ( struct magma_encrypted_keys *)skey->data;
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+
+  for( ; blocks >= 4; blocks -= 4, inptr += 4, outptr += 4 ) {
+     w[0] = ak_magma_next_walk( skey ); w[1] = ak_magma_next_walk( skey );
+     w[2] = ak_magma_next_walk( skey ); w[3] = ak_magma_next_walk( skey );
+     ak_magma_decrypt_walk4( data->inkey, data->inmask, w, inptr, outptr );
+  }
+  for( ; blocks > 0; blocks-- )
+     ak_magma_decrypt_walk( data->inkey, data->inmask, ak_magma_next_walk( skey ),
+                                                                            inptr++, outptr++ );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательного сжатия нескольких блоков информации в режиме выработки
+    имитовставки алгоритмом ГОСТ 34.12-2015 (Магма).
+
+    @param skey Контекст секретного ключа.
+    @param in Указатель на входные данные.
+    @param state Текущее значение цепочки (8 октетов), изменяется функцией.
+    @param blocks Количество обрабатываемых блоков.                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_magma_mac_blocks_with_random_walk( ak_skey skey,
+                                                ak_pointer in, ak_pointer state, size_t blocks )
+{
+  struct magma_encrypted_keys *data = ( struct magma_encrypted_keys *)skey->data;
+  ak_uint64 *inptr = ( ak_uint64 *)in, *x = ( ak_uint64 *)state;
+
+  for( ; blocks > 0; blocks-- ) {
+     *x ^= *inptr++;
+     ak_magma_encrypt_walk( data->inkey, data->inmask, ak_magma_next_walk( skey ), x, x );
+  }
 }
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -235,17 +411,23 @@
  /* проверяем целостность ключа */
   if( skey->check_icode( skey ) != ak_true ) return ak_error_message( ak_error_wrong_key_icode,
                                                 __func__ , "using key with wrong integrity code" );
- /* удаляем былое */
-  if( skey->data != NULL ) ak_magma_context_delete_keys( skey );
-
-  if(( data = ak_libakrypt_aligned_malloc( sizeof( struct magma_encrypted_keys ))) == NULL )
-    return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
+ /* память выделяется только при первой развертке, при повторной развертке
+    (например, при выработке производных ключей ACPKM) значения перезаписываются */
+  if(( data = skey->data ) == NULL )
+    if(( data = ak_libakrypt_aligned_malloc( sizeof( struct magma_encrypted_keys ))) == NULL )
+      return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
 
  /* выставляем флаги того, что память выделена */
   memset( data, 0, sizeof( struct magma_encrypted_keys ));
   skey->data = ( ak_pointer )data;
   skey->flags |= ak_key_flag_data_not_free;
 
+ /* заполняем запас случайных траекторий */
+  if(( error = ak_random_context_random( &skey->generator,
+                                             data->walk, sizeof( data->walk ))) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect generation of random walk trajectories" );
+  data->walk_used = 0;
+
  /* размещаем данные */
   if(( error = ak_random_context_random( &skey->generator, data->inmask, sizeof( data->inmask ))) != ak_error_ok )
     return ak_error_message( error, __func__, "incorrect generation first secret key mask" );
@@ -495,10 +677,141 @@ int ak_bckey_context_create_magma( ak_bckey bkey )
   bkey->delete_keys = ak_magma_context_delete_keys;
   bkey->encrypt = ak_magma_encrypt_with_random_walk;
   bkey->decrypt = ak_magma_decrypt_with_random_walk;
+  bkey->encrypt_blocks = ak_magma_encrypt_blocks_with_random_walk;
+  bkey->decrypt_blocks = ak_magma_decrypt_blocks_with_random_walk;
+  bkey->mac_blocks = ak_magma_mac_blocks_with_random_walk;
 
   return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                                      функции тестирования                                       */
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция проверяет корректность реализации алгоритма Магма на контрольных примерах
+    из ГОСТ Р 34.12-2015 и ГОСТ Р 34.13-2015 в режимах простой замены и гаммирования.
+    Поскольку алгоритм Магма реализован только без совместимости с openssl, при установленной
+    опции `openssl_compability` тестирование не производится.
+
+    @return Возвращает ak_true в случае успешного тестирования. В случае возникновения ошибки
+    функция возвращает ak_false. Код ошибки может быть получен с помощью
+    вызова ak_error_get_value().                                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_bckey_test_magma( void )
+{
+  struct bckey bkey;
+  ak_uint8 myout[32];
+  bool_t result = ak_true;
+  int error = ak_error_ok, audit = ak_log_get_level(),
+      oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+ /* тестовый ключ из ГОСТ Р 34.12-2015, приложение А.2 */
+  ak_uint8 key[32] = {
+    0xff,0xfe,0xfd,0xfc,0xfb,0xfa,0xf9,0xf8,0xf7,0xf6,0xf5,0xf4,0xf3,0xf2,0xf1,0xf0,
+    0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff
+  };
+
+ /* открытый текст из ГОСТ Р 34.13-2015, приложение А.2 (каждый блок развернут) */
+  ak_uint8 in[32] = {
+    0x59,0x0a,0x13,0x3c,0x6b,0xf0,0xde,0x92,0x20,0x9d,0x18,0xf8,0x04,0xc7,0x54,0xdb,
+    0x4c,0x02,0xa8,0x67,0x2e,0xfb,0x98,0x4a,0x41,0x7e,0xb5,0x17,0x9b,0x40,0x12,0x89
+  };
+
+ /* результат простой замены */
+  ak_uint8 outecb[32] = {
+    0xa0,0x72,0xf3,0x94,0x04,0x3f,0x07,0x2b,0x48,0x6e,0x55,0xd3,0x15,0xe7,0x70,0xde,
+    0x1e,0xbc,0xcf,0xea,0xe9,0xd9,0xd8,0x11,0xfb,0x7e,0xc6,0x96,0x09,0x26,0x68,0x7c
+  };
+
+ /* синхропосылка и результат применения режима гаммирования */
+  ak_uint8 ivctr[4] = { 0x78,0x56,0x34,0x12 };
+  ak_uint8 outctr[32] = {
+    0x3c,0xb9,0xb7,0x97,0x0c,0x11,0x98,0x4e,0x69,0x5d,0xe8,0xd6,0x93,0x0d,0x25,0x3e,
+    0xef,0xdb,0xb2,0x07,0x88,0x86,0x6d,0x13,0x2d,0xa1,0x52,0xab,0x80,0xb6,0x8e,0x56
+  };
+
+  if(( oc < 0 ) || ( oc > 1 )) {
+    ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+    return ak_false;
+  }
+  if( oc ) {
+    if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                           "testing of magma block cipher is skipped in openssl compatible mode" );
+    return ak_true;
+  }
+
+ /* 1. Создаем контекст ключа алгоритма Магма и устанавливаем значение ключа */
+  if(( error = ak_bckey_context_create_magma( &bkey )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect initialization of magma secret key context");
+    return ak_false;
+  }
+  if(( error = ak_bckey_context_set_key( &bkey, key, sizeof( key ))) != ak_error_ok ) {
+    ak_error_message( error, __func__, "wrong creation of test key" );
+    result = ak_false;
+    goto exit;
+  }
+
+ /* 2. Проверяем режим простой замены */
+  if(( error = ak_bckey_context_encrypt_ecb( &bkey, in, myout, sizeof( in ))) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong ecb mode encryption" );
+    result = ak_false;
+    goto exit;
+  }
+  if( !ak_ptr_is_equal_with_log( myout, outecb, sizeof( outecb ))) {
+    ak_error_message( ak_error_not_equal_data, __func__ ,
+                                 "the ecb mode encryption test from GOST R 34.13-2015 is wrong");
+    result = ak_false;
+    goto exit;
+  }
+  if(( error = ak_bckey_context_decrypt_ecb( &bkey, outecb,
+                                                       myout, sizeof( outecb ))) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong ecb mode decryption" );
+    result = ak_false;
+    goto exit;
+  }
+  if( !ak_ptr_is_equal_with_log( myout, in, sizeof( in ))) {
+    ak_error_message( ak_error_not_equal_data, __func__ ,
+                                 "the ecb mode decryption test from GOST R 34.13-2015 is wrong");
+    result = ak_false;
+    goto exit;
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                       "the ecb mode encryption/decryption test from GOST R 34.13-2015 is Ok" );
+
+ /* 3. Проверяем режим гаммирования: однократным вызовом и фрагментами */
+  if(( error = ak_bckey_context_ctr( &bkey, in, myout, sizeof( in ),
+                                                      ivctr, sizeof( ivctr ))) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong counter mode encryption" );
+    result = ak_false;
+    goto exit;
+  }
+  if( !ak_ptr_is_equal_with_log( myout, outctr, sizeof( outctr ))) {
+    ak_error_message( ak_error_not_equal_data, __func__ ,
+                             "the counter mode encryption test from GOST R 34.13-2015 is wrong");
+    result = ak_false;
+    goto exit;
+  }
+  ak_bckey_context_ctr( &bkey, outctr, myout, 8, ivctr, sizeof( ivctr ));
+  ak_bckey_context_ctr( &bkey, outctr+8, myout+8, sizeof( outctr )-8, NULL, 0 );
+  if( !ak_ptr_is_equal_with_log( myout, in, sizeof( in ))) {
+    ak_error_message( ak_error_not_equal_data, __func__ ,
+                             "the counter mode decryption test from GOST R 34.13-2015 is wrong");
+    result = ak_false;
+    goto exit;
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                   "the counter mode encryption/decryption test from GOST R 34.13-2015 is Ok" );
+
+ /* освобождаем ключ и выходим */
+  exit:
+  if(( error = ak_bckey_context_destroy( &bkey )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "wrong destroying of secret key" );
+    return ak_false;
+  }
+
+ return result;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                                                                                     ak_magma.c  */
 /* ----------------------------------------------------------------------------------------------- */
@@ -0,0 +1,803 @@
+/* ----------------------------------------------------------------------------------------------- */
+/*  Copyright (c) 2014 - 2019 by Axel Kenzo, axelkenzo@mail.ru                                     */
+/*                                                                                                 */
+/*  Файл ak_mgm.c                                                                                  */
+/*  - содержит реализацию режима аутентифицированного шифрования MGM                               */
+/*    из Р 1323565.1.026-2019.                                                                     */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <ak_mgm.h>
+ #include <ak_gf2n.h>
+ #include <ak_tools.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef LIBAKRYPT_HAVE_STRING_H
+ #include <string.h>
+#else
+ #error Library cannot be compiled without string.h header
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование 64-х битного слова из представления в памяти в целое число и обратно. */
+#ifdef LIBAKRYPT_LITTLE_ENDIAN
+ #define ak_mgm_word( x ) ( x )
+#else
+ #define ak_mgm_word( x ) bswap_64( x )
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                 вспомогательные функции режима                                  */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция изменяет порядок следования октетов в блоке на обратный.
+    \details Функция используется для перехода от симметричного (совместимого с openssl)
+    представления данных к представлению, используемому при умножении в конечных полях,
+    и обратно. Допускается совпадение входного и выходного блоков.                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mgm_reverse( ak_uint64 *out, const ak_uint64 *in, const size_t bsize )
+{
+  ak_uint64 t = in[0];
+  if( bsize == 16 ) {
+    out[0] = bswap_64( in[1] );
+    out[1] = bswap_64( t );
+  } else out[0] = bswap_64( t );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция копирует заданное количество блоков, при необходимости изменяя
+    порядок следования октетов в каждом блоке.                                                     */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mgm_copy_blocks( ak_uint64 *out, const ak_uint64 *in,
+                                         const size_t blocks, const size_t bsize, const int oc )
+{
+  size_t i = 0, words = bsize >> 3;
+
+  if( oc ) for( i = 0; i < blocks; i++ ) ak_mgm_reverse( out+i*words, in+i*words, bsize );
+   else memcpy( out, in, blocks*bsize );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Увеличение на единицу правой (младшей) половины счетчика \f$ Y \f$.                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mgm_incr_r( ak_uint64 *x, const size_t bsize )
+{
+  ak_uint64 v = ak_mgm_word( x[0] );
+
+  if( bsize == 16 ) x[0] = ak_mgm_word( v+1 );
+   else x[0] = ak_mgm_word(( v&0xFFFFFFFF00000000LL )|(( v+1 )&0xFFFFFFFFLL ));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Увеличение на единицу левой (старшей) половины счетчика \f$ Z \f$.                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mgm_incr_l( ak_uint64 *x, const size_t bsize )
+{
+  if( bsize == 16 ) x[1] = ak_mgm_word( ak_mgm_word( x[1] )+1 );
+   else x[0] = ak_mgm_word( ak_mgm_word( x[0] )+0x100000000LL );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вырабатывает блоки гаммы и множители, используемые при вычислении имитовставки.
+
+    В начало буффера помещаются `ycount` блоков гаммы \f$ E_K(Y_i) \f$, за ними следуют
+    `zcount` множителей \f$ H_i = E_K(Z_i) \f$. Все блоки зашифровываются одним вызовом
+    функции \ref bckey::encrypt_blocks, что позволяет использовать многоблочные реализации
+    блочных шифров. Множители возвращаются в представлении, используемом функциями
+    умножения в конечных полях; значения счетчиков увеличиваются.
+
+    \param mctx Контекст режима MGM.
+    \param bkey Ключ блочного шифра.
+    \param buf Буффер, длина которого не менее `(ycount+zcount)*bsize` октетов.
+    \param ycount Количество вырабатываемых блоков гаммы.
+    \param zcount Количество вырабатываемых множителей.                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mgm_context_generate( ak_mgm mctx, ak_bckey bkey, ak_uint64 *buf,
+                                                      const size_t ycount, const size_t zcount )
+{
+  size_t i = 0, words = bkey->bsize >> 3;
+  ak_uint64 *ptr = buf;
+
+  for( i = 0; i < ycount; i++, ptr += words ) {
+     if( mctx->oc ) ak_mgm_reverse( ptr, mctx->ycount, bkey->bsize );
+      else memcpy( ptr, mctx->ycount, bkey->bsize );
+     ak_mgm_incr_r( mctx->ycount, bkey->bsize );
+  }
+  for( i = 0; i < zcount; i++, ptr += words ) {
+     if( mctx->oc ) ak_mgm_reverse( ptr, mctx->zcount, bkey->bsize );
+      else memcpy( ptr, mctx->zcount, bkey->bsize );
+     ak_mgm_incr_l( mctx->zcount, bkey->bsize );
+  }
+
+  bkey->encrypt_blocks( &bkey->key, buf, buf, ycount+zcount );
+  if( mctx->oc )
+    for( i = 0, ptr = buf + ycount*words; i < zcount; i++, ptr += words )
+       ak_mgm_reverse( ptr, ptr, bkey->bsize );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция добавляет к сумме, используемой для вычисления имитовставки,
+    попарные произведения множителей и блоков данных.
+    \details Произведения вычисляются функциями ak_gf64_mulsum() и ak_gf128_mulsum(),
+    выполняющими приведение по модулю один раз для всех обрабатываемых блоков.                     */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mgm_context_mulsum( ak_mgm mctx, ak_uint64 *h, ak_uint64 *x,
+                                                       const size_t count, const size_t bsize )
+{
+  if( bsize == 16 ) ak_gf128_mulsum( mctx->sum, h, x, count );
+   else ak_gf64_mulsum( mctx->sum, h, x, count );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция дополняет неполный блок данных нулями до длины блока.
+    \details Данные, с учетом используемого представления, помещаются в старшие октеты блока;
+    результат возвращается в представлении, используемом функциями умножения в конечных полях.     */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mgm_pad_block( ak_uint64 *out, const ak_uint8 *in,
+                                                   const size_t tail, const size_t bsize, const int oc )
+{
+  memset( out, 0, bsize );
+  if( oc ) {
+    memcpy( out, in, tail );
+    ak_mgm_reverse( out, out, bsize );
+  } else memcpy( (ak_uint8 *)out + bsize - tail, in, tail );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция проверяет, что длина данных (в битах) помещается в половину блока.             */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline bool_t ak_mgm_check_length( const ak_uint64 bitlen, const size_t size,
+                                                                               const size_t bsize )
+{
+  ak_uint64 limit = ( bsize == 16 ) ? 0xFFFFFFFFFFFFFFFFLL : 0xFFFFFFFFLL;
+
+  if(( ak_uint64 )size > ( limit >> 3 )) return ak_false;
+ return ( bitlen <= limit - (( ak_uint64 )size << 3 )) ? ak_true : ak_false;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция уменьшает ресурс ключа на заданное количество блоков.                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline int ak_mgm_check_resource( ak_bckey bkey, const ak_int64 blocks, const char *func )
+{
+  if( bkey->key.resource.value.counter < blocks )
+    return ak_error_message( ak_error_low_key_resource, func, "low resource of block cipher key" );
+  bkey->key.resource.value.counter -= blocks;
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                           функции для работы с контекстом mgm                                   */
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет начальные значения счетчиков \f$ Y_1 = E_K(0||ICN) \f$ и
+    \f$ Z_1 = E_K(1||ICN)\f$, где \f$ ICN \f$ - синхропосылка (старший бит синхропосылки
+    игнорируется), а также обнуляет текущее значение имитовставки.
+
+    @param mctx Контекст режима MGM.
+    @param bkey Ключ алгоритма блочного шифрования, используемый для шифрования
+    и выработки имитовставки.
+    @param iv Указатель на синхропосылку.
+    @param iv_size Длина синхропосылки в октетах; должна быть не меньше длины блока.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mgm_context_clean( ak_mgm mctx, ak_bckey bkey, const ak_pointer iv, const size_t iv_size )
+{
+  ak_uint64 buf[4];
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using a null pointer to mgm context" );
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to block cipher context" );
+  if( iv == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to initialization vector" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+                     ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher" );
+  if( iv_size < bkey->bsize ) return ak_error_message( ak_error_wrong_iv_length, __func__,
+                                                       "incorrect length of initialization vector" );
+ /* проверяем целостность ключа */
+  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+    return ak_error_message( ak_error_wrong_key_icode,
+                                        __func__, "incorrect integrity code of secret key value" );
+  if(( error = ak_mgm_check_resource( bkey, 2, __func__ )) != ak_error_ok ) return error;
+
+  memset( mctx, 0, sizeof( struct mgm ));
+  mctx->oc = oc;
+
+ /* формируем значения 0||ICN и 1||ICN */
+  memcpy( buf, iv, bkey->bsize );
+  if( oc ) ak_mgm_reverse( buf, buf, bkey->bsize );
+  memcpy( mctx->ycount, buf, bkey->bsize );
+  memcpy( mctx->zcount, buf, bkey->bsize );
+  ((ak_uint8 *)mctx->ycount)[bkey->bsize-1] &= 0x7F;
+  ((ak_uint8 *)mctx->zcount)[bkey->bsize-1] |= 0x80;
+
+ /* вычисляем начальные значения счетчиков (после выработки буффер содержит
+    значения E(0||ICN) и E(1||ICN), второе из которых уже приведено к нужному представлению) */
+  ak_mgm_context_generate( mctx, bkey, buf, 1, 1 );
+  if( oc ) ak_mgm_reverse( mctx->ycount, buf, bkey->bsize );
+   else memcpy( mctx->ycount, buf, bkey->bsize );
+  memcpy( mctx->zcount, buf + ( bkey->bsize >> 3 ), bkey->bsize );
+
+  ak_ptr_context_wipe( buf, sizeof( buf ), &bkey->key.generator );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция добавляет к значению имитовставки ассоциированные данные, которые не зашифровываются.
+    Функция может вызываться несколько раз, при этом длина каждого фрагмента данных,
+    за исключением последнего, должна быть кратна длине блока. Обработка ассоциированных данных
+    должна быть завершена до начала обработки шифруемых данных.
+
+    @param mctx Контекст режима MGM.
+    @param bkey Ключ алгоритма блочного шифрования.
+    @param adata Указатель на ассоциированные данные.
+    @param adata_size Длина ассоциированных данных в октетах.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mgm_context_authentication_update( ak_mgm mctx, ak_bckey bkey,
+                                                   const ak_pointer adata, const size_t adata_size )
+{
+  int error = ak_error_ok;
+  size_t blocks = 0, tail = 0, count = 0, words = 0;
+  ak_uint64 buf[ak_bckey_context_buffer_blocks*2], *ptr = ( ak_uint64 *)adata,
+                                         data[ak_bckey_context_buffer_blocks*2], *src = NULL;
+
+  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using a null pointer to mgm context" );
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to block cipher context" );
+  if( adata_size == 0 ) return ak_error_ok;
+  if( adata == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                     "using a null pointer to associated data" );
+  if( mctx->flags&( ak_mgm_assosiated_data_bit | ak_mgm_encrypted_data_bit ))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                      "unexpected associated data after incomplete block or data" );
+  if( !ak_mgm_check_length( mctx->abitlen, adata_size, bkey->bsize ))
+    return ak_error_message( ak_error_wrong_length, __func__, "associated data is too long" );
+
+  words = bkey->bsize >> 3;
+  blocks = adata_size/bkey->bsize;
+  tail = adata_size - blocks*bkey->bsize;
+  if(( error = ak_mgm_check_resource( bkey,
+                  ( ak_int64 )( blocks + ( tail > 0 )), __func__ )) != ak_error_ok ) return error;
+
+ /* обрабатываем полные блоки: каждая порция множителей вырабатывается одним вызовом
+    многоблочной функции, а сумма произведений приводится по модулю один раз */
+  while( blocks > 0 ) {
+    count = ak_min( blocks, ak_bckey_context_buffer_blocks*2/words );
+    ak_mgm_context_generate( mctx, bkey, buf, 0, count );
+    if( mctx->oc ) {
+      ak_mgm_copy_blocks( data, ptr, count, bkey->bsize, mctx->oc );
+      src = data;
+    } else src = ptr;
+    ak_mgm_context_mulsum( mctx, buf, src, count, bkey->bsize );
+    ptr += count*words;
+    blocks -= count;
+  }
+
+ /* обрабатываем последний неполный блок */
+  if( tail ) {
+    ak_mgm_context_generate( mctx, bkey, buf, 0, 1 );
+    ak_mgm_pad_block( data, ( ak_uint8 *)ptr, tail, bkey->bsize, mctx->oc );
+    ak_mgm_context_mulsum( mctx, buf, data, 1, bkey->bsize );
+    mctx->flags |= ak_mgm_assosiated_data_bit;
+  }
+  mctx->abitlen += (( ak_uint64 ) adata_size ) << 3;
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифровывает (расшифровывает) данные и добавляет к значению имитовставки
+    блоки шифртекста.
+    \details Для каждой порции данных гамма и множители вырабатываются одним вызовом
+    многоблочной функции зашифрования, после чего данные обрабатываются за один проход.
+    При расшифровании имитовставка вычисляется до наложения гаммы, поэтому
+    допускается совпадение указателей на входные и выходные данные.                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_mgm_context_crypt_update( ak_mgm mctx, ak_bckey bkey, const ak_pointer in,
+                           ak_pointer out, const size_t size, const bool_t encrypt, const char *func )
+{
+  int error = ak_error_ok;
+  size_t i = 0, blocks = 0, tail = 0, count = 0, words = 0;
+  ak_uint64 buf[ak_bckey_context_buffer_blocks*4], data[ak_bckey_context_buffer_blocks*2],
+                             *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out, *h = NULL;
+  ak_uint8 *gamma = NULL;
+
+  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, func,
+                                                          "using a null pointer to mgm context" );
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, func,
+                                                  "using a null pointer to block cipher context" );
+  if( size == 0 ) return ak_error_ok;
+  if(( in == NULL ) || ( out == NULL )) return ak_error_message( ak_error_null_pointer, func,
+                                                                "using a null pointer to data" );
+  if( mctx->flags&ak_mgm_encrypted_tail_bit )
+    return ak_error_message( ak_error_wrong_length, func,
+                                                  "unexpected data after incomplete data block" );
+  if( !ak_mgm_check_length( mctx->pbitlen, size, bkey->bsize ))
+    return ak_error_message( ak_error_wrong_length, func, "encrypted data is too long" );
+
+  words = bkey->bsize >> 3;
+  blocks = size/bkey->bsize;
+  tail = size - blocks*bkey->bsize;
+  if(( error = ak_mgm_check_resource( bkey,
+                ( ak_int64 )( blocks + ( tail > 0 ))*2, func )) != ak_error_ok ) return error;
+  mctx->flags |= ak_mgm_encrypted_data_bit;
+
+ /* обрабатываем полные блоки */
+  while( blocks > 0 ) {
+    count = ak_min( blocks, ak_bckey_context_buffer_blocks*2/words );
+    ak_mgm_context_generate( mctx, bkey, buf, count, count );
+    h = buf + count*words;
+
+    if( !encrypt ) { /* при расшифровании используем входные данные */
+      if( mctx->oc ) ak_mgm_copy_blocks( data, inptr, count, bkey->bsize, mctx->oc );
+      ak_mgm_context_mulsum( mctx, h, mctx->oc ? data : inptr, count, bkey->bsize );
+    }
+    for( i = 0; i < count*words; i++ ) outptr[i] = inptr[i] ^ buf[i];
+    if( encrypt ) { /* при зашифровании используем выходные данные */
+      if( mctx->oc ) ak_mgm_copy_blocks( data, outptr, count, bkey->bsize, mctx->oc );
+      ak_mgm_context_mulsum( mctx, h, mctx->oc ? data : outptr, count, bkey->bsize );
+    }
+    inptr += count*words;
+    outptr += count*words;
+    blocks -= count;
+  }
+
+ /* обрабатываем последний неполный блок: используются старшие октеты гаммы */
+  if( tail ) {
+    ak_mgm_context_generate( mctx, bkey, buf, 1, 1 );
+    gamma = ( ak_uint8 *)buf + ( mctx->oc ? 0 : bkey->bsize - tail );
+
+    if( !encrypt ) ak_mgm_pad_block( data, ( ak_uint8 *)inptr, tail, bkey->bsize, mctx->oc );
+    for( i = 0; i < tail; i++ ) (( ak_uint8 *)outptr)[i] = (( ak_uint8 *)inptr)[i] ^ gamma[i];
+    if( encrypt ) ak_mgm_pad_block( data, ( ak_uint8 *)outptr, tail, bkey->bsize, mctx->oc );
+    ak_mgm_context_mulsum( mctx, buf + words, data, 1, bkey->bsize );
+    mctx->flags |= ak_mgm_encrypted_tail_bit;
+  }
+  mctx->pbitlen += (( ak_uint64 ) size ) << 3;
+
+  ak_ptr_context_wipe( buf, sizeof( buf ), &bkey->key.generator );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция зашифровывает данные и добавляет полученный шифртекст к значению имитовставки.
+    Функция может вызываться несколько раз, при этом длина каждого фрагмента данных,
+    за исключением последнего, должна быть кратна длине блока.
+
+    @param mctx Контекст режима MGM.
+    @param bkey Ключ алгоритма блочного шифрования.
+    @param in Указатель на зашифровываемые данные.
+    @param out Указатель на область памяти, куда помещается шифртекст;
+    может совпадать с указателем `in`.
+    @param size Длина данных в октетах.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mgm_context_encryption_update( ak_mgm mctx, ak_bckey bkey, const ak_pointer in,
+                                                                ak_pointer out, const size_t size )
+{
+  return ak_mgm_context_crypt_update( mctx, bkey, in, out, size, ak_true, __func__ );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция добавляет шифртекст к значению имитовставки и расшифровывает его.
+    Функция может вызываться несколько раз, при этом длина каждого фрагмента данных,
+    за исключением последнего, должна быть кратна длине блока.
+
+    \note Расшифрованные данные не должны использоваться до проверки имитовставки,
+    вычисляемой функцией ak_mgm_context_finalize().
+
+    @param mctx Контекст режима MGM.
+    @param bkey Ключ алгоритма блочного шифрования.
+    @param in Указатель на шифртекст.
+    @param out Указатель на область памяти, куда помещаются расшифрованные данные;
+    может совпадать с указателем `in`.
+    @param size Длина данных в октетах.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mgm_context_decryption_update( ak_mgm mctx, ak_bckey bkey, const ak_pointer in,
+                                                                ak_pointer out, const size_t size )
+{
+  return ak_mgm_context_crypt_update( mctx, bkey, in, out, size, ak_false, __func__ );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция добавляет к сумме произведений блок, содержащий длины обработанных данных,
+    и вычисляет значение имитовставки
+    \f$ T = MSB_S( E_K( \sum H_i \otimes A_i \oplus \sum H_{h+j} \otimes C_j \oplus
+    H_{h+q+1} \otimes ( len(A) || len(C) ))) \f$.
+
+    @param mctx Контекст режима MGM.
+    @param bkey Ключ алгоритма блочного шифрования.
+    @param out Указатель на область памяти, куда помещается имитовставка.
+    @param out_size Длина имитовставки в октетах; если она превышает длину блока,
+    то вычисляется имитовставка, длина которой равна длине блока.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mgm_context_finalize( ak_mgm mctx, ak_bckey bkey, ak_pointer out, const size_t out_size )
+{
+  ak_uint64 buf[2], len[2];
+  size_t tag_size = 0;
+  int error = ak_error_ok;
+
+  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using a null pointer to mgm context" );
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to block cipher context" );
+  if(( out == NULL ) || ( out_size == 0 )) return ak_error_message( ak_error_null_pointer,
+                                         __func__, "using a null pointer to authentication code" );
+  if(( error = ak_mgm_check_resource( bkey, 2, __func__ )) != ak_error_ok ) return error;
+
+ /* формируем блок len(A)||len(C) */
+  if( bkey->bsize == 16 ) {
+    len[0] = ak_mgm_word( mctx->pbitlen );
+    len[1] = ak_mgm_word( mctx->abitlen );
+  } else len[0] = ak_mgm_word(( mctx->abitlen << 32 )^mctx->pbitlen );
+
+  ak_mgm_context_generate( mctx, bkey, buf, 0, 1 );
+  ak_mgm_context_mulsum( mctx, buf, len, 1, bkey->bsize );
+
+ /* зашифровываем сумму и выбираем старшие октеты */
+  if( mctx->oc ) ak_mgm_reverse( buf, mctx->sum, bkey->bsize );
+   else memcpy( buf, mctx->sum, bkey->bsize );
+  bkey->encrypt( &bkey->key, buf, buf );
+
+  tag_size = ak_min( out_size, bkey->bsize );
+  memcpy( out, ( ak_uint8 *)buf + ( mctx->oc ? 0 : bkey->bsize - tag_size ), tag_size );
+  ak_ptr_context_wipe( buf, sizeof( buf ), &bkey->key.generator );
+
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                               функции однократного вызова                                       */
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция зашифровывает данные в режиме MGM и вычисляет имитовставку, зависящую как от
+    ассоциированных, так и от зашифровываемых данных. Все данные обрабатываются за один проход.
+
+    @param bkey Ключ алгоритма блочного шифрования (Магма или Кузнечик).
+    @param adata Указатель на ассоциированные (незашифровываемые) данные.
+    @param adata_size Длина ассоциированных данных в октетах.
+    @param in Указатель на зашифровываемые данные.
+    @param out Указатель на область памяти, куда помещается шифртекст.
+    @param size Длина зашифровываемых данных в октетах.
+    @param iv Указатель на синхропосылку.
+    @param iv_size Длина синхропосылки в октетах.
+    @param icode Указатель на область памяти, куда помещается имитовставка.
+    @param icode_size Длина имитовставки в октетах.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_encrypt_mgm( ak_bckey bkey, const ak_pointer adata, const size_t adata_size,
+                   const ak_pointer in, ak_pointer out, const size_t size, const ak_pointer iv,
+                            const size_t iv_size, ak_pointer icode, const size_t icode_size )
+{
+  struct mgm mctx;
+  int error = ak_error_ok;
+
+  if(( error = ak_mgm_context_clean( &mctx, bkey, iv, iv_size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect initialization of mgm context" );
+  if(( error = ak_mgm_context_authentication_update( &mctx,
+                                              bkey, adata, adata_size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect processing of associated data" );
+  if(( error = ak_mgm_context_encryption_update( &mctx, bkey, in, out, size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect encryption of data" );
+  if(( error = ak_mgm_context_finalize( &mctx, bkey, icode, icode_size )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect calculation of authentication code" );
+
+  ak_ptr_context_wipe( &mctx, sizeof( struct mgm ), &bkey->key.generator );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция расшифровывает данные в режиме MGM, одновременно вычисляя имитовставку,
+    и сравнивает ее с заданным значением. Если значения имитовставки не совпадают,
+    то расшифрованные данные уничтожаются.
+
+    @param bkey Ключ алгоритма блочного шифрования (Магма или Кузнечик).
+    @param adata Указатель на ассоциированные (незашифрованные) данные.
+    @param adata_size Длина ассоциированных данных в октетах.
+    @param in Указатель на шифртекст.
+    @param out Указатель на область памяти, куда помещаются расшифрованные данные.
+    @param size Длина шифртекста в октетах.
+    @param iv Указатель на синхропосылку.
+    @param iv_size Длина синхропосылки в октетах.
+    @param icode Указатель на проверяемое значение имитовставки.
+    @param icode_size Длина имитовставки в октетах.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). Если имитовставка
+    не совпадает с вычисленным значением, возвращается \ref ak_error_not_equal_data.
+    В остальных случаях возвращается код ошибки.                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_decrypt_mgm( ak_bckey bkey, const ak_pointer adata, const size_t adata_size,
+                   const ak_pointer in, ak_pointer out, const size_t size, const ak_pointer iv,
+                      const size_t iv_size, const ak_pointer icode, const size_t icode_size )
+{
+  struct mgm mctx;
+  size_t i = 0;
+  ak_uint8 tag[16], diff = 0;
+  int error = ak_error_ok;
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to block cipher context" );
+  if( icode == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                 "using a null pointer to authentication code" );
+  if(( icode_size == 0 ) || ( icode_size > bkey->bsize ))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                    "incorrect length of authentication code" );
+  memset( tag, 0, sizeof( tag ));
+  if(( error = ak_mgm_context_clean( &mctx, bkey, iv, iv_size )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect initialization of mgm context" );
+    goto lab_exit;
+  }
+  if(( error = ak_mgm_context_authentication_update( &mctx,
+                                              bkey, adata, adata_size )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect processing of associated data" );
+    goto lab_exit;
+  }
+  if(( error = ak_mgm_context_decryption_update( &mctx, bkey, in, out, size )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect decryption of data" );
+    goto lab_exit;
+  }
+  if(( error = ak_mgm_context_finalize( &mctx, bkey, tag, icode_size )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect calculation of authentication code" );
+    goto lab_exit;
+  }
+
+ /* сравниваем имитовставки за время, не зависящее от номера первого несовпадающего октета */
+  for( i = 0; i < icode_size; i++ ) diff |= tag[i]^(( const ak_uint8 *)icode )[i];
+  if( diff ) {
+    if( size ) memset( out, 0, size );
+    error = ak_error_set_value( ak_error_not_equal_data );
+  }
+
+ /* уничтожаем вычисленную имитовставку и внутреннее состояние */
+ lab_exit:
+  ak_ptr_context_wipe( tag, sizeof( tag ), &bkey->key.generator );
+  ak_ptr_context_wipe( &mctx, sizeof( struct mgm ), &bkey->key.generator );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                      функции тестирования                                       */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция изменяет порядок октетов в каждом блоке данных на обратный
+    (неполный последний блок обращается в пределах своей длины).
+    \details Функция используется для перехода от представления тестовых примеров
+    из Р 1323565.1.026-2019 к представлению данных, используемому библиотекой.                    */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mgm_test_reverse( ak_uint8 *out, const ak_uint8 *in,
+                                                              const size_t size, const size_t bsize )
+{
+  size_t i = 0, j = 0, len = 0;
+
+  for( i = 0; i < size; i += bsize ) {
+     len = ak_min( bsize, size - i );
+     for( j = 0; j < len; j++ ) out[i+j] = in[i+len-1-j];
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция проверяет режим MGM для одного ключа: однократным вызовом функций
+    зашифрования/расшифрования, обработкой данных фрагментами, а также отказ в расшифровании
+    при искажении имитовставки. Тестовые данные передаются в представлении
+    Р 1323565.1.026-2019 (старшие октеты блока расположены в его начале).                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_mgm_test_one( ak_bckey bkey, const int oc, ak_uint8 *iv, ak_uint8 *adata,
+               size_t adata_size, ak_uint8 *in, ak_uint8 *cipher, size_t size, ak_uint8 *icode )
+{
+  struct mgm mctx;
+  int error = ak_error_ok;
+  size_t bsize = bkey->bsize, part = 0;
+  const char *name = bkey->key.oid->names[0];
+  ak_uint8 nonce[16], a[128], p[128], c[128], t[16], out[128], tag[16];
+
+ /* приводим данные к используемому представлению */
+  if(( bsize != 8 ) && ( bsize != 16 )) return ak_false;
+  if( oc ) {
+    memcpy( nonce, iv, bsize ); memcpy( a, adata, adata_size ); memcpy( p, in, size );
+    memcpy( c, cipher, size ); memcpy( t, icode, bsize );
+  } else {
+    ak_mgm_test_reverse( nonce, iv, bsize, bsize );
+    ak_mgm_test_reverse( a, adata, adata_size, bsize );
+    ak_mgm_test_reverse( p, in, size, bsize );
+    ak_mgm_test_reverse( c, cipher, size, bsize );
+    ak_mgm_test_reverse( t, icode, bsize, bsize );
+  }
+
+ /* 1. однократное зашифрование */
+  memset( out, 0, sizeof( out )); memset( tag, 0, sizeof( tag ));
+  if(( error = ak_bckey_context_encrypt_mgm( bkey, a, adata_size, p, out, size,
+                                              nonce, bsize, tag, bsize )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "incorrect encryption in mgm mode" );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, c, size )) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                            "wrong encryption test for %s from R 1323565.1.026-2019", name );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( tag, t, bsize )) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                   "wrong authentication code test for %s from R 1323565.1.026-2019", name );
+    return ak_false;
+  }
+
+ /* 2. однократное расшифрование (на месте) */
+  if(( error = ak_bckey_context_decrypt_mgm( bkey, a, adata_size, out, out, size,
+                                                nonce, bsize, t, bsize )) != ak_error_ok ) {
+    ak_error_message_fmt( error, __func__ , "incorrect decryption in mgm mode for %s", name );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, p, size )) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                            "wrong decryption test for %s from R 1323565.1.026-2019", name );
+    return ak_false;
+  }
+
+ /* 3. обработка фрагментами, длина которых кратна длине блока */
+  part = bsize;
+  memset( out, 0, sizeof( out )); memset( tag, 0, sizeof( tag ));
+  ak_mgm_context_clean( &mctx, bkey, nonce, bsize );
+  ak_mgm_context_authentication_update( &mctx, bkey, a, part );
+  ak_mgm_context_authentication_update( &mctx, bkey, a+part, adata_size - part );
+  ak_mgm_context_encryption_update( &mctx, bkey, p, out, 2*part );
+  ak_mgm_context_encryption_update( &mctx, bkey, p+2*part, out+2*part, size - 2*part );
+  if(( error = ak_mgm_context_finalize( &mctx, bkey, tag, bsize )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "incorrect finalizing of mgm context" );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, c, size ) || !ak_ptr_is_equal_with_log( tag, t, bsize )) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                                         "wrong incremental encryption test for %s", name );
+    return ak_false;
+  }
+
+ /* 4. искаженная имитовставка должна отвергаться */
+  t[0] ^= 0x01;
+  error = ak_bckey_context_decrypt_mgm( bkey, a, adata_size, c, out, size, nonce, bsize, t, bsize );
+  t[0] ^= 0x01;
+  if( error != ak_error_not_equal_data ) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                                       "wrong authentication code is accepted for %s", name );
+    return ak_false;
+  }
+  ak_error_set_value( ak_error_ok );
+
+  if( ak_log_get_level() >= ak_log_maximum ) ak_error_message_fmt( ak_error_ok, __func__ ,
+                                      "the test for %s from R 1323565.1.026-2019 is Ok", name );
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция проверяет корректность реализации режима MGM на тестовых примерах
+    из Р 1323565.1.026-2019 для блочных шифров Кузнечик и Магма.
+
+    @return Возвращает ak_true в случае успешного тестирования. В случае возникновения ошибки
+    функция возвращает ak_false.                                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_bckey_test_mgm( void )
+{
+  struct bckey bkey;
+  bool_t result = ak_true;
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+ /* ключ из Р 1323565.1.026-2019, приложение А.1 */
+  ak_uint8 key[32] = {
+    0xef,0xcd,0xab,0x89,0x67,0x45,0x23,0x01,0x10,0x32,0x54,0x76,0x98,0xba,0xdc,0xfe,
+    0x77,0x66,0x55,0x44,0x33,0x22,0x11,0x00,0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88
+  };
+  ak_uint8 oc_key[32] = {
+    0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff,0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,
+    0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10,0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef
+  };
+  ak_uint8 iv[16] = {
+    0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x00,0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88
+  };
+  ak_uint8 adata[41] = {
+    0x02,0x02,0x02,0x02,0x02,0x02,0x02,0x02,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,
+    0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,
+    0xea,0x05,0x05,0x05,0x05,0x05,0x05,0x05,0x05
+  };
+  ak_uint8 in[67] = {
+    0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x00,0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88,
+    0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,
+    0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,
+    0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,0x11,
+    0xaa,0xbb,0xcc
+  };
+  ak_uint8 cipher[67] = {
+    0xa9,0x75,0x7b,0x81,0x47,0x95,0x6e,0x90,0x55,0xb8,0xa3,0x3d,0xe8,0x9f,0x42,0xfc,
+    0x80,0x75,0xd2,0x21,0x2b,0xf9,0xfd,0x5b,0xd3,0xf7,0x06,0x9a,0xad,0xc1,0x6b,0x39,
+    0x49,0x7a,0xb1,0x59,0x15,0xa6,0xba,0x85,0x93,0x6b,0x5d,0x0e,0xa9,0xf6,0x85,0x1c,
+    0xc6,0x0c,0x14,0xd4,0xd3,0xf8,0x83,0xd0,0xab,0x94,0x42,0x06,0x95,0xc7,0x6d,0xeb,
+    0x2c,0x75,0x52
+  };
+  ak_uint8 icode[16] = {
+    0xcf,0x5d,0x65,0x6f,0x40,0xc3,0x4f,0x5c,0x46,0xe8,0xbb,0x0e,0x29,0xfc,0xdb,0x4c
+  };
+
+ /* ключ и данные из Р 1323565.1.026-2019, приложение А.2 */
+  ak_uint8 magma_key[32] = {
+    0xff,0xfe,0xfd,0xfc,0xfb,0xfa,0xf9,0xf8,0xf7,0xf6,0xf5,0xf4,0xf3,0xf2,0xf1,0xf0,
+    0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff
+  };
+  ak_uint8 magma_iv[8] = { 0x12,0xde,0xf0,0x6b,0x3c,0x13,0x0a,0x59 };
+  ak_uint8 magma_adata[41] = {
+    0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x02,0x02,0x02,0x02,0x02,0x02,0x02,0x02,
+    0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x03,0x04,0x04,0x04,0x04,0x04,0x04,0x04,0x04,
+    0x05,0x05,0x05,0x05,0x05,0x05,0x05,0x05,0xea
+  };
+  ak_uint8 magma_in[67] = {
+    0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x00,
+    0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,
+    0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,
+    0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,
+    0xaa,0xbb,0xcc
+  };
+  ak_uint8 magma_cipher[67] = {
+    0xc7,0x95,0x06,0x6c,0x5f,0x9e,0xa0,0x3b,0x85,0x11,0x33,0x42,0x45,0x91,0x85,0xae,
+    0x1f,0x2e,0x00,0xd6,0xbf,0x2b,0x78,0x5d,0x94,0x04,0x70,0xb8,0xbb,0x9c,0x8e,0x7d,
+    0x9a,0x5d,0xd3,0x73,0x1f,0x7d,0xdc,0x70,0xec,0x27,0xcb,0x0a,0xce,0x6f,0xa5,0x76,
+    0x70,0xf6,0x5c,0x64,0x6a,0xbb,0x75,0xd5,0x47,0xaa,0x37,0xc3,0xbc,0xb5,0xc3,0x4e,
+    0x03,0xbb,0x9c
+  };
+  ak_uint8 magma_icode[8] = { 0xa7,0x92,0x80,0x69,0xaa,0x10,0xfd,0x10 };
+
+  if(( oc < 0 ) || ( oc > 1 )) {
+    ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+    return ak_false;
+  }
+
+ /* 1. тестируем режим MGM для алгоритма Кузнечик */
+  if(( error = ak_bckey_context_create_kuznechik( &bkey )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong creation of kuznechik key context" );
+    return ak_false;
+  }
+  if(( error = ak_bckey_context_set_key( &bkey, oc ? oc_key : key, 32 )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong assigning a constant key value" );
+    result = ak_false;
+  } else result = ak_mgm_test_one( &bkey, oc, iv, adata, sizeof( adata ),
+                                                          in, cipher, sizeof( in ), icode );
+  ak_bckey_context_destroy( &bkey );
+  if( result != ak_true ) return result;
+
+ /* 2. тестируем режим MGM для алгоритма Магма
+       (алгоритм Магма реализован только без совместимости с openssl) */
+  if( oc ) return result;
+  if(( error = ak_bckey_context_create_magma( &bkey )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong creation of magma key context" );
+    return ak_false;
+  }
+  if(( error = ak_bckey_context_set_key( &bkey, magma_key, 32 )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong assigning a constant key value" );
+    result = ak_false;
+  } else result = ak_mgm_test_one( &bkey, oc, magma_iv, magma_adata, sizeof( magma_adata ),
+                                        magma_in, magma_cipher, sizeof( magma_in ), magma_icode );
+  ak_bckey_context_destroy( &bkey );
+
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \example test-mgm01.c                                                                          */
+/* ----------------------------------------------------------------------------------------------- */
+/*                                                                                       ak_mgm.c  */
+/* ----------------------------------------------------------------------------------------------- */
@@ -0,0 +1,76 @@
+/* ----------------------------------------------------------------------------------------------- */
+/*  Copyright (c) 2014 - 2019 by Axel Kenzo, axelkenzo@mail.ru                                     */
+/*                                                                                                 */
+/*  Файл ak_mgm.h                                                                                  */
+/*  - содержит описания функций, реализующих режим аутентифицированного шифрования MGM             */
+/*    из Р 1323565.1.026-2019.                                                                     */
+/* ----------------------------------------------------------------------------------------------- */
+#ifndef __AK_MGM_H__
+#define __AK_MGM_H__
+
+/* ----------------------------------------------------------------------------------------------- */
+ #include <ak_bckey.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Флаг, означающий, что обработан неполный блок ассоциированных данных. */
+ #define ak_mgm_assosiated_data_bit    (0x1)
+/*! \brief Флаг, означающий, что началась обработка шифруемых данных. */
+ #define ak_mgm_encrypted_data_bit     (0x2)
+/*! \brief Флаг, означающий, что обработан неполный блок шифруемых данных. */
+ #define ak_mgm_encrypted_tail_bit     (0x4)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Текущее состояние режима аутентифицированного шифрования MGM.
+    \details Структура позволяет обрабатывать ассоциированные (только имитозащищаемые) и
+    шифруемые данные по частям. Ассоциированные данные должны быть обработаны
+    до начала обработки шифруемых данных; длина каждого фрагмента, кроме последнего,
+    должна быть кратна длине блока используемого блочного шифра.
+
+    Все значения, участвующие в вычислении имитовставки, хранятся в представлении,
+    используемом функциями умножения в конечных полях: младшие октеты элемента поля
+    расположены в начале блока.                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct mgm {
+  /*! \brief Текущее значение суммы произведений, используемой для вычисления имитовставки. */
+   ak_uint64 sum[2];
+  /*! \brief Текущее значение счетчика, используемого для выработки множителей. */
+   ak_uint64 zcount[2];
+  /*! \brief Текущее значение счетчика, используемого для выработки гаммы. */
+   ak_uint64 ycount[2];
+  /*! \brief Длина обработанных ассоциированных данных (в битах). */
+   ak_uint64 abitlen;
+  /*! \brief Длина обработанных шифруемых данных (в битах). */
+   ak_uint64 pbitlen;
+  /*! \brief Флаги состояния режима. */
+   ak_uint32 flags;
+  /*! \brief Флаг использования симметричного (совместимого с openssl) представления данных. */
+   int oc;
+} *ak_mgm;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Инициализация состояния режима MGM с помощью заданной синхропосылки. */
+ int ak_mgm_context_clean( ak_mgm , ak_bckey , const ak_pointer , const size_t );
+/*! \brief Обработка ассоциированных (только имитозащищаемых) данных. */
+ int ak_mgm_context_authentication_update( ak_mgm , ak_bckey , const ak_pointer , const size_t );
+/*! \brief Зашифрование данных с одновременным обновлением значения имитовставки. */
+ int ak_mgm_context_encryption_update( ak_mgm , ak_bckey , const ak_pointer ,
+                                                                        ak_pointer , const size_t );
+/*! \brief Расшифрование данных с одновременным обновлением значения имитовставки. */
+ int ak_mgm_context_decryption_update( ak_mgm , ak_bckey , const ak_pointer ,
+                                                                        ak_pointer , const size_t );
+/*! \brief Завершение вычислений и выработка имитовставки. */
+ int ak_mgm_context_finalize( ak_mgm , ak_bckey , ak_pointer , const size_t );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Зашифрование данных и вычисление имитовставки в режиме MGM. */
+ int ak_bckey_context_encrypt_mgm( ak_bckey , const ak_pointer , const size_t , const ak_pointer ,
+                     ak_pointer , const size_t , const ak_pointer , const size_t ,
+                                                                        ak_pointer , const size_t );
+/*! \brief Проверка имитовставки и расшифрование данных в режиме MGM. */
+ int ak_bckey_context_decrypt_mgm( ak_bckey , const ak_pointer , const size_t , const ak_pointer ,
+                     ak_pointer , const size_t , const ak_pointer , const size_t ,
+                                                                  const ak_pointer , const size_t );
+#endif
+/* ----------------------------------------------------------------------------------------------- */
+/*                                                                                       ak_mgm.h  */
+/* ----------------------------------------------------------------------------------------------- */
@@ -9,6 +9,7 @@
 
 #ifdef LIBAKRYPT_CRYPTO_FUNCTIONS
  #include <ak_hmac.h>
+ #include <ak_omac.h>
  #include <ak_bckey.h>
 #endif
 
@@ -33,11 +34,14 @@
  static const char *on_hashrnd[] =          { "hashrnd", NULL };
  static const char *on_streebog256[] =      { "streebog256", "md_gost12_256", NULL };
  static const char *on_streebog512[] =      { "streebog512", "md_gost12_512", NULL };
+ static const char *on_streebog512_tree[] = { "streebog512-tree", NULL };
  static const char *on_hmac_streebog256[] = { "hmac-streebog256", "HMAC-md_gost12_256", NULL };
  static const char *on_hmac_streebog512[] = { "hmac-streebog512", "HMAC-md_gost12_512", NULL };
 
  static const char *on_kuznechik[] =        { "kuznechik", "kuznyechik", "grasshopper", NULL };
  static const char *on_magma[] =            { "magma", NULL };
+ static const char *on_omac_magma[] =       { "omac-magma", NULL };
+ static const char *on_omac_kuznechik[] =   { "omac-kuznechik", "omac-kuznyechik", NULL };
 #endif
  static const char *on_w256_pst[] =         { "id-tc26-gost-3410-2012-256-paramSetTest", NULL };
  static const char *on_w256_psa[] =         { "id-tc26-gost-3410-2012-256-paramSetA", NULL };
@@ -104,6 +108,11 @@
                                         ( ak_function_void *) ak_hash_context_destroy,
                                         ( ak_function_void *) ak_hash_context_delete, NULL, NULL }},
 
+   { hash_function, algorithm, on_streebog512_tree, "1.2.643.2.52.1.2.1", NULL, NULL,
+                      { ( ak_function_void *) ak_hash_context_create_streebog512_tree,
+                                        ( ak_function_void *) ak_hash_context_destroy,
+                                        ( ak_function_void *) ak_hash_context_delete, NULL, NULL }},
+
   /* 3. идентификаторы параметров алгоритма бесключевого хеширования ГОСТ Р 34.11-94.
         значения OID взяты из перечней КриптоПро
 
@@ -121,6 +130,19 @@
                                         ( ak_function_void *) ak_hmac_context_destroy,
                                         ( ak_function_void *) ak_hmac_context_delete, NULL, NULL }},
 
+  /* 5. идентификаторы алгоритмов выработки имитовставки на основе блочных шифров
+        согласно ГОСТ Р 34.13-2015
+        в дереве библиотеки: 1.2.643.2.52.1.5 - алгоритмы выработки имитовставки */
+   { omac_function, algorithm, on_omac_magma, "1.2.643.2.52.1.5.1", NULL, NULL,
+                                 { ( ak_function_void *) ak_omac_context_create_magma,
+                                        ( ak_function_void *) ak_omac_context_destroy,
+                                        ( ak_function_void *) ak_omac_context_delete, NULL, NULL }},
+
+   { omac_function, algorithm, on_omac_kuznechik, "1.2.643.2.52.1.5.2", NULL, NULL,
+                             { ( ak_function_void *) ak_omac_context_create_kuznechik,
+                                        ( ak_function_void *) ak_omac_context_destroy,
+                                        ( ak_function_void *) ak_omac_context_delete, NULL, NULL }},
+
   /* 6. идентификаторы алгоритмов блочного шифрования
         в дереве библиотеки: 1.2.643.2.52.1.6 - алгоритмы блочного шифрования
         в дереве библиотеки: 1.2.643.2.52.1.7 - параметры алгоритмов блочного шифрования */
@@ -0,0 +1,835 @@
+/* ----------------------------------------------------------------------------------------------- */
+/*  Copyright (c) 2014 - 2019 by Axel Kenzo, axelkenzo@mail.ru                                     */
+/*                                                                                                 */
+/*  Файл ak_omac.с                                                                                 */
+/*  - содержит реализацию алгоритма выработки имитовставки на основе блочных шифров                */
+/*    из ГОСТ Р 34.13-2015.                                                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <ak_omac.h>
+ #include <ak_tools.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef LIBAKRYPT_HAVE_STDLIB_H
+ #include <stdlib.h>
+#else
+ #error Library cannot be compiled without stdlib.h header
+#endif
+#ifdef LIBAKRYPT_HAVE_STRING_H
+ #include <string.h>
+#else
+ #error Library cannot be compiled without string.h header
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                         базовые преобразования алгоритма выработки имитовставки                 */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция последовательно сжимает заданное количество блоков данных.
+
+    Если для блочного шифра определена функция \ref bckey::mac_blocks, то все блоки
+    обрабатываются за один ее вызов; в противном случае используется
+    функция зашифрования одного блока.
+
+    \param bkey Контекст ключа алгоритма блочного шифрования.
+    \param in Указатель на обрабатываемые данные.
+    \param state Текущее значение цепочки, изменяется функцией.
+    \param blocks Количество обрабатываемых блоков.                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_omac_chain_blocks( ak_bckey bkey, ak_uint8 *in, ak_uint8 *state, size_t blocks )
+{
+  size_t i = 0, words = bkey->bsize >> 3;
+  ak_uint64 *inptr = ( ak_uint64 *)in, *x = ( ak_uint64 *)state;
+
+  if( !blocks ) return;
+  if( bkey->mac_blocks != NULL ) {
+    bkey->mac_blocks( &bkey->key, in, state, blocks );
+    return;
+  }
+  for( ; blocks > 0; blocks-- ) {
+     for( i = 0; i < words; i++ ) x[i] ^= *inptr++;
+     bkey->encrypt( &bkey->key, state, state );
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция умножает значение вспомогательного ключа на образующий элемент поля
+    (сдвиг на один разряд влево со сложением с константой B при переполнении).
+
+    \param k Значение вспомогательного ключа, изменяется функцией.
+    \param bsize Длина блока (8 или 16 октетов).
+    \param oc Флаг использования симметричного (совместимого с openssl) представления.             */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_omac_shift_subkey( ak_uint8 *k, const size_t bsize, const int oc )
+{
+  size_t i = 0;
+  ak_uint8 carry = 0, b = ( bsize == 16 ) ? 0x87 : 0x1b;
+
+  if( oc ) { /* старший октет располагается в начале блока */
+    carry = k[0] >> 7;
+    for( i = 0; i < bsize-1; i++ ) k[i] = ( ak_uint8 )(( k[i] << 1 ) | ( k[i+1] >> 7 ));
+    k[bsize-1] <<= 1;
+    if( carry ) k[bsize-1] ^= b;
+  } else { /* старший октет располагается в конце блока */
+      carry = k[bsize-1] >> 7;
+      for( i = bsize-1; i > 0; i-- ) k[i] = ( ak_uint8 )(( k[i] << 1 ) | ( k[i-1] >> 7 ));
+      k[0] <<= 1;
+      if( carry ) k[0] ^= b;
+    }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция обрабатывает последний (возможно неполный) блок данных и вычисляет имитовставку.
+
+    Значение цепочки `state` не изменяется, что позволяет повторно вызывать функцию
+    для одного и того же состояния. Ресурс ключа функцией не изменяется.
+
+    \param bkey Контекст ключа алгоритма блочного шифрования.
+    \param state Текущее значение цепочки.
+    \param last Указатель на последний блок данных.
+    \param size Длина последнего блока, от нуля до длины блока включительно.
+    \param out Область памяти, куда помещается имитовставка.
+    \param out_size Размер области памяти; вычисляется имитовставка длины
+    не более длины блока шифра.
+    \param oc Флаг использования симметричного (совместимого с openssl) представления.             */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_omac_final_block( ak_bckey bkey, const ak_uint8 *state, const ak_uint8 *last,
+                              const size_t size, ak_pointer out, const size_t out_size, const int oc )
+{
+  size_t i = 0, tag = ak_min( out_size, bkey->bsize );
+  ak_uint8 subkey[16], block[16];
+
+ /* вырабатываем вспомогательный ключ K1 или K2 */
+  memset( subkey, 0, sizeof( subkey ));
+  bkey->encrypt( &bkey->key, subkey, subkey );
+  ak_omac_shift_subkey( subkey, bkey->bsize, oc );
+
+ /* формируем последний блок, при необходимости дополняя его */
+  memset( block, 0, sizeof( block ));
+  if( size == bkey->bsize ) memcpy( block, last, size );
+   else {
+     ak_omac_shift_subkey( subkey, bkey->bsize, oc );
+     if( oc ) {
+       memcpy( block, last, size );
+       block[size] = 0x80;
+     } else {
+         memcpy( block + bkey->bsize - size, last, size );
+         block[bkey->bsize - size - 1] = 0x80;
+       }
+   }
+
+  for( i = 0; i < bkey->bsize; i++ ) block[i] ^= state[i]^subkey[i];
+  bkey->encrypt( &bkey->key, block, block );
+
+ /* возвращаем старшие октеты результата */
+  if( oc ) memcpy( out, block, tag );
+    else memcpy( out, block + bkey->bsize - tag, tag );
+
+  ak_ptr_context_wipe( subkey, sizeof( subkey ), &bkey->key.generator );
+  ak_ptr_context_wipe( block, sizeof( block ), &bkey->key.generator );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет имитовставку для данных, целиком размещенных в памяти.
+    Для обработки данных по частям следует использовать контекст \ref omac.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на входные данные.
+    @param size Размер входных данных (в байтах), может принимать произвольное значение.
+    @param out Область памяти, куда помещается имитовставка.
+    @param out_size Размер области памяти (в байтах). Если значение меньше длины блока,
+    то вычисляются `out_size` старших октетов имитовставки.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_context_omac( ak_bckey bkey, ak_pointer in, size_t size,
+                                                                  ak_pointer out, size_t out_size )
+{
+  ak_int64 blocks = 0;
+  size_t tail = 0;
+  ak_uint8 state[16];
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to block cipher context" );
+  if(( in == NULL ) && ( size != 0 )) return ak_error_message( ak_error_null_pointer, __func__,
+                                                                "using a null pointer to data" );
+  if(( out == NULL ) || ( out_size == 0 )) return ak_error_message( ak_error_null_pointer,
+                                                  __func__, "using a null pointer to mac value" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 )) return ak_error_message(
+                     ak_error_wrong_block_cipher, __func__ , "incorrect block size of block cipher" );
+ /* проверяем целостность ключа */
+  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+    return ak_error_message( ak_error_wrong_key_icode,
+                                        __func__, "incorrect integrity code of secret key value" );
+ /* последний блок обрабатывается отдельно, даже если он полный */
+  blocks = ( ak_int64 )( size/bkey->bsize );
+  tail = size - ( size_t )blocks*bkey->bsize;
+  if(( blocks > 0 ) && ( tail == 0 )) { blocks--; tail = bkey->bsize; }
+
+ /* уменьшаем значение ресурса ключа: учитываем выработку вспомогательного ключа */
+  if( bkey->key.resource.value.counter < blocks + 2 )
+    return ak_error_message( ak_error_low_key_resource,
+                                                   __func__ , "low resource of block cipher key" );
+   else bkey->key.resource.value.counter -= ( blocks + 2 );
+
+  memset( state, 0, sizeof( state ));
+  ak_omac_chain_blocks( bkey, in, state, ( size_t )blocks );
+  ak_omac_final_block( bkey, state, (ak_uint8 *)in + ( size_t )blocks*bkey->bsize,
+                                                                  tail, out, out_size, oc );
+  ak_ptr_context_wipe( state, sizeof( state ), &bkey->key.generator );
+
+ /* перемаскируем ключ */
+  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                           функции для работы с контекстом omac                                  */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Очистка контекста алгоритма omac.
+    \param ctx Контекст алгоритма OMAC выработки имитовставки.
+    \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_omac_context_internal_clean( ak_pointer ctx )
+{
+  ak_omac octx = ( ak_omac ) ctx;
+
+  if( ctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                      "using a null pointer to omac key context" );
+ /* проверяем наличие ключа и его ресурс */
+  if( !((octx->bkey.key.flags)&ak_key_flag_set_key )) return ak_error_message( ak_error_key_value,
+                                               __func__ , "using omac key with unassigned value" );
+  if( octx->bkey.key.resource.value.counter <= 2 ) return ak_error_message(
+                     ak_error_low_key_resource, __func__, "using omac key context with low resource" );
+
+  memset( octx->state, 0, sizeof( octx->state ));
+  memset( octx->last, 0, sizeof( octx->last ));
+  octx->bkey.key.flags &= ~ak_key_flag_omac_buffer_used;
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Обновление состояния контекста сжимающего отображения.
+
+    Последний блок переданных данных не обрабатывается, а сохраняется в контексте:
+    способ его обработки зависит от того, будут ли далее переданы новые данные.
+    Все остальные блоки обрабатываются одним вызовом функции \ref bckey::mac_blocks.
+
+    \param ctx Контекст алгоритма OMAC выработки имитовставки.
+    \param data Указатель на обрабатываемые данные.
+    \param size Длина обрабатываемых данных (в байтах); длина должна быть кратна длине блока
+    используемого блочного шифра.
+    \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_omac_context_internal_update( ak_pointer ctx, const ak_pointer in, const size_t size )
+{
+  ak_int64 blocks = 0;
+  int error = ak_error_ok;
+  ak_omac octx = ( ak_omac ) ctx;
+
+  if( ctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                      "using a null pointer to omac key context" );
+  if( !size ) return ak_error_message( ak_error_zero_length, __func__ ,
+                                                      "using zero length for authenticated data" );
+  if( size%octx->mctx.bsize ) return ak_error_message( ak_error_wrong_length, __func__ ,
+                                                                  "using data with wrong length" );
+ /* проверяем наличие ключа, его целостность и ресурс */
+  if( !((octx->bkey.key.flags)&ak_key_flag_set_key )) return ak_error_message( ak_error_key_value,
+                                               __func__ , "using omac key with unassigned value" );
+  if( octx->bkey.key.check_icode( &octx->bkey.key ) != ak_true )
+    return ak_error_message( ak_error_wrong_key_icode,
+                                        __func__, "incorrect integrity code of secret key value" );
+  blocks = ( ak_int64 )( size/octx->mctx.bsize );
+  if( octx->bkey.key.resource.value.counter < blocks )
+    return ak_error_message( ak_error_low_key_resource,
+                                                   __func__ , "low resource of block cipher key" );
+   else octx->bkey.key.resource.value.counter -= blocks;
+
+ /* обрабатываем блок, сохраненный при предыдущем вызове, и все новые блоки, кроме последнего */
+  if( octx->bkey.key.flags&ak_key_flag_omac_buffer_used )
+    ak_omac_chain_blocks( &octx->bkey, octx->last, octx->state, 1 );
+  ak_omac_chain_blocks( &octx->bkey, in, octx->state, ( size_t )blocks - 1 );
+
+ /* последний блок сохраняем */
+  memcpy( octx->last, (ak_uint8 *)in + size - octx->mctx.bsize, octx->mctx.bsize );
+  octx->bkey.key.flags |= ak_key_flag_omac_buffer_used;
+
+ /* перемаскируем ключ */
+  if(( error = octx->bkey.key.set_mask( &octx->bkey.key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Обновление состояния и вычисление результата применения сжимающего отображения.
+
+    Функция не изменяет текущее значение цепочки, хранящееся в контексте.
+
+    \param ctx Контекст алгоритма OMAC выработки имитовставки.
+    \param data Блок входных данных; длина блока должна быть менее, чем длина блока
+           используемого блочного шифра.
+    \param size Длина блока обрабатываемых данных
+    \param out Указатель на область памяти, куда будет помещен результат.
+    \param out_size Размер области памяти (в октетах).
+    \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_omac_context_internal_finalize( ak_pointer ctx,
+                    const ak_pointer in, const size_t size, ak_pointer out, const size_t out_size )
+{
+  ak_uint8 state[16];
+  int error = ak_error_ok;
+  ak_omac octx = ( ak_omac ) ctx;
+  int oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+ /* выполняем проверки */
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using a null pointer to omac context" );
+  if(( out == NULL ) || ( out_size == 0 )) return ak_error_message( ak_error_null_pointer,
+                                                  __func__, "using a null pointer to mac value" );
+  if( size >= octx->mctx.bsize ) return ak_error_message( ak_error_zero_length,
+                                          __func__ , "using wrong length for authenticated data" );
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+ /* проверяем наличие ключа, его целостность и ресурс */
+  if( !((octx->bkey.key.flags)&ak_key_flag_set_key )) return ak_error_message( ak_error_key_value,
+                                               __func__ , "using omac key with unassigned value" );
+  if( octx->bkey.key.check_icode( &octx->bkey.key ) != ak_true )
+    return ak_error_message( ak_error_wrong_key_icode,
+                                        __func__, "incorrect integrity code of secret key value" );
+  if( octx->bkey.key.resource.value.counter < 2 )
+    return ak_error_message( ak_error_low_key_resource,
+                                                   __func__ , "low resource of block cipher key" );
+   else octx->bkey.key.resource.value.counter -= 2;
+
+ /* если хвост пуст, то сохраненный блок является последним и дополнение не выполняется */
+  memcpy( state, octx->state, sizeof( state ));
+  if(( size == 0 ) && ( octx->bkey.key.flags&ak_key_flag_omac_buffer_used ))
+    ak_omac_final_block( &octx->bkey, state, octx->last, octx->mctx.bsize, out, out_size, oc );
+   else {
+     if( octx->bkey.key.flags&ak_key_flag_omac_buffer_used )
+       ak_omac_chain_blocks( &octx->bkey, octx->last, state, 1 );
+     ak_omac_final_block( &octx->bkey, state, in, size, out, out_size, oc );
+   }
+  ak_ptr_context_wipe( state, sizeof( state ), &octx->bkey.key.generator );
+
+ /* перемаскируем ключ */
+  if(( error = octx->bkey.key.set_mask( &octx->bkey.key )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \param oid Идентификатор алгоритма OMAC выработки имитовставки.
+    \return В случае успешного завершения функция возвращает \ref ak_error_ok. В случае
+    возникновения ошибки возвращеется ее код.                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_create_oid( ak_omac octx, ak_oid oid )
+{
+  ak_oid bcoid = NULL;
+  int error = ak_error_ok;
+
+ /* выполняем проверку */
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to omac context" );
+  if( oid == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                        "using null pointer to block cipher OID" );
+ /* проверяем, что OID от правильного алгоритма выработки */
+  if( oid->engine != omac_function )
+    return ak_error_message( ak_error_oid_engine, __func__ , "using oid with wrong engine" );
+ /* проверяем, что OID от алгоритма, а не от параметров */
+  if( oid->mode != algorithm )
+    return ak_error_message( ak_error_oid_mode, __func__ , "using oid with wrong mode" );
+
+ /* получаем oid алгоритма блочного шифрования */
+  if(( bcoid = ak_oid_context_find_by_name( oid->names[0]+5 )) == NULL )
+    return ak_error_message( ak_error_get_value(), __func__ ,
+                                                       "incorrect searching of block cipher oid" );
+ /* проверяем, что производящая функция определена */
+  if( bcoid->func.create == NULL )
+    return ak_error_message( ak_error_undefined_function, __func__ ,
+                                             "using block cipher oid with undefined constructor" );
+ /* инициализируем контекст ключа блочного шифра */
+  if(( error = (( ak_function_bckey_create *)bcoid->func.create )
+                                                                 ( &octx->bkey )) != ak_error_ok )
+    return ak_error_message_fmt( error, __func__,
+                                "invalid creation of %s block cipher context", bcoid->names[0] );
+ /* инициализируем контекст сжимающего отображения */
+  if(( error = ak_mac_context_create(
+                 &octx->mctx, /* контекст */
+                 octx->bkey.bsize, /* размер входного блока совпадает с блоком шифра */
+                 octx, /* указатель на объек, которым будут оперировать функции */
+                 ak_omac_context_internal_clean,
+                 ak_omac_context_internal_update,
+                 ak_omac_context_internal_finalize )) != ak_error_ok ) {
+    ak_bckey_context_destroy( &octx->bkey );
+    return ak_error_message( error, __func__, "invalid creation of mac function context" );
+  }
+
+ /* доопределяем oid ключа */
+  octx->bkey.key.oid = oid;
+  memset( octx->state, 0, sizeof( octx->state ));
+  memset( octx->last, 0, sizeof( octx->last ));
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \return В случае успешного завершения функций возвращает \ref ak_error_ok. В случае
+    возникновения ошибки возвращеется ее код.                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_create_magma( ak_omac octx )
+{ return ak_omac_context_create_oid( octx, ak_oid_context_find_by_name( "omac-magma" )); }
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \return В случае успешного завершения функций возвращает \ref ak_error_ok. В случае
+    возникновения ошибки возвращеется ее код.                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_create_kuznechik( ak_omac octx )
+{ return ak_omac_context_create_oid( octx, ak_oid_context_find_by_name( "omac-kuznechik" )); }
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \return В случае успешного завершения функций возвращает \ref ak_error_ok. В случае
+    возникновения ошибки возвращеется ее код.                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_destroy( ak_omac octx )
+{
+  int error = ak_error_ok;
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to omac context" );
+  ak_ptr_context_wipe( octx->state, sizeof( octx->state ), &octx->bkey.key.generator );
+  ak_ptr_context_wipe( octx->last, sizeof( octx->last ), &octx->bkey.key.generator );
+  if(( error = ak_bckey_context_destroy( &octx->bkey )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect destroying of block cipher key context" );
+  if(( error = ak_mac_context_destroy( &octx->mctx )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect destroying of mac context" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \return Функция возвращает NULL. В случае возникновения ошибки, ее код может быть получен с
+    помощью вызова функции ak_error_get_value().                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ ak_pointer ak_omac_context_delete( ak_pointer octx )
+{
+  if( octx != NULL ) {
+      ak_omac_context_destroy(( ak_omac ) octx );
+      free( octx );
+     } else ak_error_message( ak_error_null_pointer, __func__ ,
+                                                            "using null pointer to omac context" );
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    К моменту вызова функции контекст должен быть инициализирован.
+    \param ptr Указатель на данные, которые будут интерпретироваться в качестве значения ключа.
+    \param size Размер данных, на которые указывает `ptr` (размер в байтах); должен совпадать
+    с длиной ключа блочного шифра.
+
+    \return В случае успеха возвращается значение \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_set_key( ak_omac octx, const ak_pointer ptr, const size_t size )
+{
+  int error = ak_error_ok;
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to omac context" );
+  if(( error = ak_bckey_context_set_key( &octx->bkey, ptr, size )) != ak_error_ok )
+    ak_error_message( error, __func__ , "incorrect assigning a secret key value" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки. К моменту вызова функции контекст
+    должен быть инициализирован.
+    \param generator Контекст генератора псевдо-случайных чисел.
+
+    @return В случае успеха возвращается значение \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_set_key_random( ak_omac octx, ak_random generator )
+{
+  int error = ak_error_ok;
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to omac context" );
+  if(( error = ak_bckey_context_set_key_random( &octx->bkey, generator )) != ak_error_ok )
+    ak_error_message( error, __func__ , "incorrect assigning a secret key value" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция присваивает ключу значение, выработанное из заданного пароля при помощи
+    алгоритма PBKDF2, описанного  в рекомендациях по стандартизации Р 50.1.111-2016.
+
+    @param octx Контекст алгоритма OMAC выработки имитовставки. К моменту вызова функции контекст
+    должен быть инициализирован.
+    @param pass Пароль, представленный в виде строки символов.
+    @param pass_size Длина пароля в байтах.
+    @param salt Случайная последовательность, представленная в виде строки символов.
+    @param salt_size Длина случайной последовательности в байтах.
+
+    @return В случае успеха возвращается значение \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_set_key_from_password( ak_omac octx,
+                                                const ak_pointer pass, const size_t pass_size,
+                                                     const ak_pointer salt, const size_t salt_size )
+{
+  int error = ak_error_ok;
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to omac context" );
+  if(( error = ak_bckey_context_set_key_from_password( &octx->bkey,
+                                          pass, pass_size, salt, salt_size )) != ak_error_ok )
+    ak_error_message( error, __func__ , "incorrect assigning a secret key value" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_clean( ak_omac octx )
+{
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                         "cleaning null pointer to omac context" );
+ return ak_mac_context_clean( &octx->mctx );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \param in Указатель на входные данные для которых вычисляется имитовставка.
+    \param size Размер входных данных в байтах. Размер может принимать произвольное,
+    натуральное значение.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_update( ak_omac octx, const ak_pointer in, const size_t size )
+{
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                         "updating null pointer to omac context" );
+ return ak_mac_context_update( &octx->mctx, in, size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \param in Указатель на входные данные для которых вычисляется имитовставка.
+    \param size Размер входных данных в байтах.
+    \param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    \param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+    Если значение меньше длины блока, то вычисляются `out_size` старших октетов имитовставки.
+
+    \return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_finalize( ak_omac octx, const ak_pointer in, const size_t size,
+                                                           ak_pointer out, const size_t out_size )
+{
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                       "finalizing null pointer to omac context" );
+ return ak_mac_context_finalize( &octx->mctx, in, size, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \param fragments Массив фрагментов входных данных; результат совпадает с обработкой
+    данных, полученных объединением фрагментов.
+    \param count Количество фрагментов.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_update_fragments( ak_omac octx, ak_fragment fragments, const size_t count )
+{
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                         "updating null pointer to omac context" );
+ return ak_mac_context_update_fragments( &octx->mctx, fragments, count );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \param fragments Массив фрагментов входных данных, для которых вычисляется имитовставка.
+    \param count Количество фрагментов.
+    \param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    \param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_finalize_fragments( ak_omac octx, ak_fragment fragments, const size_t count,
+                                                           ak_pointer out, const size_t out_size )
+{
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                       "finalizing null pointer to omac context" );
+ return ak_mac_context_finalize_fragments( &octx->mctx, fragments, count, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \param in Указатель на входные данные для которых вычисляется имитовставка.
+    \param size Размер входных данных в байтах.
+    \param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    \param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    \return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_ptr( ak_omac octx, const ak_pointer in, const size_t size,
+                                                           ak_pointer out, const size_t out_size )
+{
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to omac context" );
+ return ak_mac_context_ptr( &octx->mctx, in, size, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Файл обрабатывается фрагментами, размер которых определяется функцией ak_mac_context_file(),
+    поэтому размер обрабатываемого файла не ограничен объемом доступной оперативной памяти.
+
+    \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \param filename Имя файла, для котрого вычисляется имитовставка.
+    \param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    \param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    \return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_omac_context_file( ak_omac octx, const char * filename,
+                                                           ak_pointer out, const size_t out_size )
+{
+  if( octx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to omac context" );
+ return ak_mac_context_file( &octx->mctx, filename, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \return Функция возвращает длину имитовставки в октетах. В случае возникновения ошибки,
+    возвращается ноль. Код ошибки может быть получен с помощью вызова функции ak_error_get_value().*/
+/* ----------------------------------------------------------------------------------------------- */
+ size_t ak_omac_context_get_tag_size( ak_omac octx )
+{
+  if( octx == NULL ) {
+    ak_error_message( ak_error_null_pointer, __func__, "using null pointer to omac context" );
+    return 0;
+  }
+
+ return octx->bkey.bsize;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param octx Контекст алгоритма OMAC выработки имитовставки.
+    \return Функция возвращает длину блока в октетах. В случае возникновения ошибки,
+    возвращается ноль. Код ошибки может быть получен с помощью вызова функции ak_error_get_value().*/
+/* ----------------------------------------------------------------------------------------------- */
+ size_t ak_omac_context_get_block_size( ak_omac octx )
+{
+  if( octx == NULL ) {
+    ak_error_message( ak_error_null_pointer, __func__, "using null pointer to omac context" );
+    return 0;
+  }
+
+ return octx->mctx.bsize;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                      функции тестирования                                       */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция проверяет вычисление имитовставки для одного алгоритма: однократным вызовом
+    функции ak_bckey_context_omac(), через контекст \ref omac, а также при обработке
+    данных фрагментами случайной длины.                                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_mac_test_omac_one( ak_omac octx, ak_uint8 *key, ak_uint8 *in, size_t size,
+                                                       ak_uint8 *mac, size_t mac_size, ak_random rnd )
+{
+  ak_uint32 steps = 0;
+  bool_t result = ak_true;
+  int error = ak_error_ok, audit = ak_log_get_level();
+  ak_uint8 out[16], out2[16], buffer[1024], *ptr = NULL;
+  size_t len = 0, offset = 0;
+  const char *name = octx->bkey.key.oid->names[0];
+
+  if(( error = ak_omac_context_set_key( octx, key, 32 )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong assigning a constant omac key value" );
+    return ak_false;
+  }
+
+ /* 1. однократное вычисление */
+  memset( out, 0, sizeof( out ));
+  if(( error = ak_bckey_context_omac( &octx->bkey, in, size, out, mac_size )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "incorrect calculation of omac code" );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, mac, mac_size )) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                                           "wrong test for %s from GOST R 34.13-2015", name );
+    return ak_false;
+  }
+
+ /* 2. вычисление с использованием контекста */
+  memset( out, 0, sizeof( out ));
+  if(( error = ak_omac_context_ptr( octx, in, size, out, mac_size )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "incorrect calculation of omac code" );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, mac, mac_size )) {
+    ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                                 "wrong streaming test for %s from GOST R 34.13-2015", name );
+    return ak_false;
+  }
+  if( audit >= ak_log_maximum ) ak_error_message_fmt( ak_error_ok, __func__ ,
+                                             "the test for %s from GOST R 34.13-2015 is Ok", name );
+
+ /* 3. случайные блуждания: сравниваем результат обработки фрагментами с однократным вызовом */
+  ak_random_context_random( rnd, buffer, sizeof( buffer ));
+  ak_random_context_random( rnd, &len, sizeof( len ));
+  size = sizeof( buffer ) - len%octx->bkey.bsize; /* длина, как правило, не кратна длине блока */
+  ak_bckey_context_omac( &octx->bkey, buffer, size, out, sizeof( out ));
+
+  ptr = buffer;
+  offset = size;
+  ak_omac_context_clean( octx );
+  do{
+      ak_random_context_random( rnd, &len, sizeof( len )); len = ak_min( len%40, offset );
+      if( len > 0 ) {
+        if(( error = ak_omac_context_update( octx, ptr, len )) != ak_error_ok ) {
+           ak_error_message( error, __func__, "incorrect updating of omac context" );
+           return ak_false;
+        }
+        ptr += len;
+        offset -= len;
+        ++steps;
+      }
+  } while( offset );
+  memset( out2, 0, sizeof( out2 ));
+  ak_omac_context_finalize( octx, NULL, 0, out2, sizeof( out2 ));
+
+  if( ak_ptr_is_equal( out, out2, ak_omac_context_get_tag_size( octx ))) {
+    if( audit >= ak_log_maximum )
+      ak_error_message_fmt( ak_error_ok, __func__ ,
+                                 "the random walk test for %s with %u steps is Ok", name, steps );
+  } else {
+      ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                              "the random walk test for %s with %u steps is wrong", name, steps );
+      ak_log_set_message(( ak_ptr_to_hexstr( out,
+                                              ak_omac_context_get_tag_size( octx ), ak_false )));
+      ak_log_set_message(( ak_ptr_to_hexstr( out2,
+                                              ak_omac_context_get_tag_size( octx ), ak_false )));
+      result = ak_false;
+    }
+
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_mac_test_omac_functions( void )
+{
+  struct omac octx;
+  struct random rnd;
+  bool_t result = ak_true;
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option( "openssl_compability" );
+
+ /* тестовый ключ из ГОСТ Р 34.13-2015, приложение А.1 */
+  ak_uint8 key[32] = {
+    0xef,0xcd,0xab,0x89,0x67,0x45,0x23,0x01,0x10,0x32,0x54,0x76,0x98,0xba,0xdc,0xfe,
+    0x77,0x66,0x55,0x44,0x33,0x22,0x11,0x00,0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88
+  };
+  ak_uint8 oc_key[32] = {
+    0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff,0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,
+    0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10,0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef
+  };
+
+ /* открытый текст из ГОСТ Р 34.13-2015, приложение А.1 */
+  ak_uint8 in[64] = {
+    0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff,0x00,0x77,0x66,0x55,0x44,0x33,0x22,0x11,
+    0x0a,0xff,0xee,0xcc,0xbb,0xaa,0x99,0x88,0x77,0x66,0x55,0x44,0x33,0x22,0x11,0x00,
+    0x00,0x0a,0xff,0xee,0xcc,0xbb,0xaa,0x99,0x88,0x77,0x66,0x55,0x44,0x33,0x22,0x11,
+    0x11,0x00,0x0a,0xff,0xee,0xcc,0xbb,0xaa,0x99,0x88,0x77,0x66,0x55,0x44,0x33,0x22
+  };
+  ak_uint8 oc_in[64] = {
+    0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x00,0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88,
+    0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,
+    0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,
+    0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xee,0xff,0x0a,0x00,0x11
+  };
+
+ /* имитовставка из ГОСТ Р 34.13-2015, приложение А.1.6 (длина 64 бита) */
+  ak_uint8 mac[8] = { 0xe3, 0xfb, 0x59, 0x60, 0x29, 0x4d, 0x6f, 0x33 };
+  ak_uint8 oc_mac[8] = { 0x33, 0x6f, 0x4d, 0x29, 0x60, 0x59, 0xfb, 0xe3 };
+
+ /* тестовый ключ и открытый текст из ГОСТ Р 34.13-2015, приложение А.2 */
+  ak_uint8 magma_key[32] = {
+    0xff, 0xfe, 0xfd, 0xfc, 0xfb, 0xfa, 0xf9, 0xf8, 0xf7, 0xf6, 0xf5, 0xf4, 0xf3, 0xf2, 0xf1, 0xf0,
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+  };
+  ak_uint8 magma_in[32] = {
+    0x59, 0x0a, 0x13, 0x3c, 0x6b, 0xf0, 0xde, 0x92, 0x20, 0x9d, 0x18, 0xf8, 0x04, 0xc7, 0x54, 0xdb,
+    0x4c, 0x02, 0xa8, 0x67, 0x2e, 0xfb, 0x98, 0x4a, 0x41, 0x7e, 0xb5, 0x17, 0x9b, 0x40, 0x12, 0x89
+  };
+
+ /* имитовставка из ГОСТ Р 34.13-2015, приложение А.2.6 (длина 32 бита) */
+  ak_uint8 magma_mac[4] = { 0x10, 0x72, 0x4e, 0x15 };
+
+  if(( oc < 0 ) || ( oc > 1 )) {
+    ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+    return ak_false;
+  }
+  if(( error = ak_random_context_create_lcg( &rnd )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong creation of random generator context" );
+    return ak_false;
+  }
+
+ /* 1. тестируем OMAC на основе алгоритма Кузнечик */
+  if(( error = ak_omac_context_create_kuznechik( &octx )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong creation of omac-kuznechik key context" );
+    result = ak_false;
+    goto lab_exit;
+  }
+  result = ak_mac_test_omac_one( &octx, oc ? oc_key : key, oc ? oc_in : in, sizeof( in ),
+                                                       oc ? oc_mac : mac, sizeof( mac ), &rnd );
+  ak_omac_context_destroy( &octx );
+  if( result != ak_true ) goto lab_exit;
+
+ /* 2. тестируем OMAC на основе алгоритма Магма
+       (алгоритм Магма реализован только без совместимости с openssl) */
+  if( oc ) goto lab_exit;
+  if(( error = ak_omac_context_create_magma( &octx )) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong creation of omac-magma key context" );
+    result = ak_false;
+    goto lab_exit;
+  }
+  result = ak_mac_test_omac_one( &octx, magma_key, magma_in, sizeof( magma_in ),
+                                                           magma_mac, sizeof( magma_mac ), &rnd );
+  ak_omac_context_destroy( &octx );
+
+ lab_exit:
+  ak_random_context_destroy( &rnd );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \example test-omac01.c                                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+/*                                                                                      ak_omac.c  */
+/* ----------------------------------------------------------------------------------------------- */
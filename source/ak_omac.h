@@ -0,0 +1,86 @@
+/* ----------------------------------------------------------------------------------------------- */
+/*  Copyright (c) 2014 - 2019 by Axel Kenzo, axelkenzo@mail.ru                                     */
+/*                                                                                                 */
+/*  Файл ak_omac.h                                                                                 */
+/*  - содержит описания функций, реализующих алгоритм выработки имитовставки                       */
+/*    на основе блочных шифров из ГОСТ Р 34.13-2015.                                               */
+/* ----------------------------------------------------------------------------------------------- */
+#ifndef __AK_OMAC_H__
+#define __AK_OMAC_H__
+
+/* ----------------------------------------------------------------------------------------------- */
+ #include <ak_mac.h>
+ #include <ak_bckey.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Секретный ключ алгоритма выработки имитовставки OMAC. */
+/*!  Алгоритм выработки имитовставки регламентируется ГОСТ Р 34.13-2015 (раздел 5.6) и
+     может быть использован совместно с блочными шифрами Магма и Кузнечик.
+
+     Контекст позволяет обрабатывать данные по частям: промежуточное значение цепочки
+     хранится в поле `state`, а последний полный блок, обработка которого зависит от
+     наличия последующих данных, сохраняется в поле `last` до вызова функции
+     ak_omac_context_finalize() или до поступления новых данных. Наличие сохраненного блока
+     определяется флагом \ref ak_key_flag_omac_buffer_used.                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct omac {
+  /*! \brief Контекст секретного ключа блочного шифра */
+   struct bckey bkey;
+  /*! \brief Контекст итерационного сжатия. */
+   struct mac mctx;
+  /*! \brief Текущее значение цепочки зашифрований. */
+   ak_uint8 state[16];
+  /*! \brief Последний полный блок обработанных данных. */
+   ak_uint8 last[16];
+} *ak_omac;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Создание контекста алгоритма выработки имитовставки OMAC на основе шифра Магма. */
+ int ak_omac_context_create_magma( ak_omac );
+/*! \brief Создание контекста алгоритма выработки имитовставки OMAC на основе шифра Кузнечик. */
+ int ak_omac_context_create_kuznechik( ak_omac );
+/*! \brief Создание контекста алгоритма выработки имитовставки OMAC c помощью заданного oid. */
+ int ak_omac_context_create_oid( ak_omac , ak_oid );
+/*! \brief Уничтожение контекста алгоритма выработки имитовставки OMAC. */
+ int ak_omac_context_destroy( ak_omac );
+/*! \brief Освобождение памяти из под контекста алгоритма выработки имитовставки OMAC. */
+ ak_pointer ak_omac_context_delete( ak_pointer );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Присвоение секретному ключу константного значения. */
+ int ak_omac_context_set_key( ak_omac , const ak_pointer , const size_t );
+/*! \brief Присвоение секретному ключу случайного значения. */
+ int ak_omac_context_set_key_random( ak_omac , ak_random );
+/*! \brief Присвоение секретному ключу значения, выработанного из пароля */
+ int ak_omac_context_set_key_from_password( ak_omac , const ak_pointer , const size_t ,
+                                                                 const ak_pointer , const size_t );
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция возвращает размер вырабатываемой имитовставки. */
+ size_t ak_omac_context_get_tag_size( ak_omac );
+/*! \brief Функция возвращает размер блока входных данных, обрабатываемого функцией выработки имитовставки. */
+ size_t ak_omac_context_get_block_size( ak_omac );
+/*! \brief Очистка контекста алгоритма выработки имитовставки OMAC. */
+ int ak_omac_context_clean( ak_omac );
+/*! \brief Обновление текущего состояния контекста алгоритма выработки имитовставки OMAC. */
+ int ak_omac_context_update( ak_omac , const ak_pointer , const size_t );
+/*! \brief Завершение алгоритма выработки имитовставки OMAC. */
+ int ak_omac_context_finalize( ak_omac , const ak_pointer , const size_t , ak_pointer , const size_t );
+/*! \brief Обновление состояния контекста данными, расположенными в нескольких фрагментах. */
+ int ak_omac_context_update_fragments( ak_omac , ak_fragment , const size_t );
+/*! \brief Завершение вычислений для данных, расположенных в нескольких фрагментах. */
+ int ak_omac_context_finalize_fragments( ak_omac , ak_fragment , const size_t ,
+                                                                       ak_pointer , const size_t );
+/*! \brief Вычисление имитовставки для заданной области памяти. */
+ int ak_omac_context_ptr( ak_omac , const ak_pointer , const size_t , ak_pointer , const size_t );
+/*! \brief Вычисление имитовставки для заданного файла. */
+ int ak_omac_context_file( ak_omac , const char* , ak_pointer , const size_t );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Тестирование алгоритма выработки имитовставки OMAC с блочными шифрами
+    Магма и Кузнечик (ГОСТ Р 34.13-2015). */
+ bool_t ak_mac_test_omac_functions( void );
+
+#endif
+/* ----------------------------------------------------------------------------------------------- */
+/*                                                                                      ak_omac.h  */
+/* ----------------------------------------------------------------------------------------------- */
@@ -27,6 +27,10 @@
  typedef ak_uint8 linear_register[16];
 /*! \brief Таблица, используемая для эффективной реализации алгоритма шифрования Кузнечик. */
  typedef ak_uint64 expanded_table[16][256][2];
+/*! \brief Компактная таблица линейного преобразования алгоритма шифрования Кузнечик.
+    \details Для каждого октета входного блока таблица содержит произведения столбца матрицы
+    линейного преобразования на все значения младшего и старшего полуоктетов (всего 8 Кбайт). */
+ typedef ak_uint64 compact_table[16][2][16][2];
 /*! \brief Структура, содержащая параметры алгоритма блочного шифрования Кузнечик. */
  typedef struct kuznechik_params {
   /*! \brief Линейный регистр сдвига */
@@ -43,6 +47,12 @@
    sbox pinv;
   /*! \brief Развернутые таблицы, используемые для эффективного расшифрования */
    expanded_table dec;
+  /*! \brief Константы, используемые в процедуре развертки ключа */
+   ak_uint64 cst[32][2];
+  /*! \brief Компактные таблицы прямого линейного преобразования */
+   compact_table cenc;
+  /*! \brief Компактные таблицы обратного линейного преобразования */
+   compact_table cdec;
  } *ak_kuznechik_params;
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -6,10 +6,10 @@
 /* ----------------------------------------------------------------------------------------------- */
 
 /* ----------------------------------------------------------------------------------------------- */
-/* это объявление нужно для использования функции fdopen() */
+/* это объявление нужно для использования функций fdopen() и pread() */
 #ifdef __linux__
  #ifndef _POSIX_C_SOURCE
-   #define _POSIX_C_SOURCE 2
+   #define _POSIX_C_SOURCE 200809L
  #endif
 #endif
 
@@ -132,6 +132,23 @@
   /* при значении равным единицы, формат шифрования данных соответствует варианту OpenSSL */
      { "openssl_compability", 0 },
 
+  /* реализация алгоритма Кузнечик: 0 - автоматический выбор, 1 - базовая, 2 - векторная (SSSE3) */
+     { "kuznechik_kernel", 0 },
+
+  /* реализация функции сжатия Стрибог: 0 - по умолчанию (совмещенные таблицы), 1 - базовая,
+     2 - совмещенные таблицы, 3 - совмещенные таблицы и SSE2, 4 - совмещенные таблицы и AVX2 */
+     { "streebog_kernel", 0 },
+
+  /* длина листа (в октетах) в режиме древовидного хеширования streebog512-tree */
+     { "streebog_tree_leaf_size", 1048576 },
+
+  /* количество потоков, вычисляющих листья дерева хеширования и блоки ключевого вектора PBKDF2
+     (0 - по числу процессоров) */
+     { "hash_thread_count", 0 },
+
+  /* количество потоков, используемых многопоточными режимами шифрования (0 - по числу процессоров) */
+     { "bckey_thread_count", 0 },
+
      { NULL, 0 } /* завершающая константа, должна всегда принимать нулевые значения */
  };
 
@@ -466,6 +483,34 @@
           if(( value < 0 ) || ( value > 1 )) value = 0;
           ak_libakrypt_set_option( "openssl_compability", value );
         }
+       /* выбор реализации алгоритма блочного шифрования Кузнечик */
+        if( ak_libakrypt_load_one_option( localbuffer, "kuznechik_kernel = ", &value )) {
+          if(( value < 0 ) || ( value > 3 )) value = 0;
+          ak_libakrypt_set_option( "kuznechik_kernel", value );
+        }
+       /* выбор реализации функции сжатия Стрибог */
+        if( ak_libakrypt_load_one_option( localbuffer, "streebog_kernel = ", &value )) {
+          if(( value < 0 ) || ( value > 4 )) value = 0;
+          ak_libakrypt_set_option( "streebog_kernel", value );
+        }
+       /* длина листа в режиме древовидного хеширования (кратна длине блока) */
+        if( ak_libakrypt_load_one_option( localbuffer, "streebog_tree_leaf_size = ", &value )) {
+          if( value < 64 ) value = 64;
+          if( value > 1073741824 ) value = 1073741824;
+          ak_libakrypt_set_option( "streebog_tree_leaf_size", value&( ~( ak_int64 )0x3f ));
+        }
+       /* количество потоков для древовидного хеширования */
+        if( ak_libakrypt_load_one_option( localbuffer, "hash_thread_count = ", &value )) {
+          if( value < 0 ) value = 0;
+          if( value > 64 ) value = 64;
+          ak_libakrypt_set_option( "hash_thread_count", value );
+        }
+       /* количество потоков для многопоточных режимов шифрования */
+        if( ak_libakrypt_load_one_option( localbuffer, "bckey_thread_count = ", &value )) {
+          if( value < 0 ) value = 0;
+          if( value > 64 ) value = 64;
+          ak_libakrypt_set_option( "bckey_thread_count", value );
+        }
 
       } /* далее мы очищаем строку независимо от ее содержимого */
       off = 0;
@@ -766,6 +811,42 @@
  #endif
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция не изменяет текущую позицию чтения файла и может одновременно вызываться
+    из нескольких потоков для одного и того же дескриптора.
+
+    @param file Дескриптор файла, открытого на чтение.
+    @param buffer Область памяти, в которую помещаются считанные данные.
+    @param size Количество считываемых октетов.
+    @param offset Смещение (в октетах) от начала файла, с которого начинается чтение.
+    @return Количество считанных октетов; меньшее значение, чем size, возвращается при
+    достижении конца файла или при возникновении ошибки.                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ ssize_t ak_file_read_at( ak_file file, ak_pointer buffer, size_t size, ak_int64 offset )
+{
+ #ifdef LIBAKRYPT_HAVE_WINDOWS_H
+  OVERLAPPED overlapped;
+  DWORD dwBytesReaden = 0;
+
+  memset( &overlapped, 0, sizeof( OVERLAPPED ));
+  overlapped.Offset = ( DWORD )( offset&0xffffffff );
+  overlapped.OffsetHigh = ( DWORD )( offset >> 32 );
+  if( ReadFile( file->hFile, buffer, ( DWORD )size, &dwBytesReaden, &overlapped ) == FALSE ) {
+    ak_error_message( ak_error_read_data, __func__, "unable to read from file");
+    return 0;
+  } else return ( ssize_t ) dwBytesReaden;
+ #else
+  size_t done = 0;
+  while( done < size ) {
+    ssize_t len = pread( file->fd, ( ak_uint8 *)buffer + done, size - done,
+                                                                     ( off_t )offset + done );
+    if( len <= 0 ) break;
+    done += ( size_t )len;
+  }
+ return ( ssize_t ) done;
+ #endif
+}
+
 /* ----------------------------------------------------------------------------------------------- */
  ssize_t ak_file_write( ak_file file, ak_const_pointer buffer, size_t size )
 {
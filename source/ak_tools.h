@@ -50,6 +50,8 @@
  int ak_file_close( ak_file );
 /*! \brief Функция считывает заданное количество байт из файла. */
  ssize_t ak_file_read( ak_file , ak_pointer , size_t );
+/*! \brief Функция считывает заданное количество байт, начиная с заданного смещения в файле. */
+ ssize_t ak_file_read_at( ak_file , ak_pointer , size_t , ak_int64 );
 /*! \brief Функция записывает заданное количество байт в файл. */
  ssize_t ak_file_write( ak_file , ak_const_pointer , size_t );
 
@@ -56,13 +56,18 @@
     1234567890abcef00000000000000000 */
   ak_uint8 openssl_ivctr[] = { 0x12,0x34,0x56,0x78,0x90,0xab,0xce,0xf0 };
 
- /* зашифрованный блок из ГОСТ Р 34.12-2015 */
+ /* зашифрованный блок из ГОСТ Р 34.12-2015;
+    последние три октета получены сложением неполного блока { 0x01, 0x02, 0x03 } со старшими
+    октетами гаммы, т.е. с теми же октетами, что и в формате openssl (см. openssl_outctr):
+    0xc7 = 0x01^0x03^0xc5, 0x28 = 0x02^0x02^0x28, 0x6c = 0x03^0x01^0x6e.
+    Ранее использовалось значение { 0xc7, 0xd9, 0x27 }, полученное сложением с младшими октетами
+    гаммы, взятыми в обратном порядке, и не совпадавшее с результатом openssl */
   ak_uint8 outctr[67] = {
     0xb8, 0xa1, 0xbd, 0x40, 0xa2, 0x5f, 0x7b, 0xd5, 0xdb, 0xd1, 0x0e, 0xc1, 0xbe, 0xd8, 0x95, 0xf1,
     0xe4, 0xde, 0x45, 0x3c, 0xb3, 0xe4, 0x3c, 0xf3, 0x5d, 0x3e, 0xa1, 0xf6, 0x33, 0xe7, 0xee, 0x85,
     0xa5, 0xa3, 0x64, 0x35, 0xf1, 0x77, 0xe8, 0xd5, 0xd3, 0x6e, 0x35, 0xe6, 0x8b, 0xe8, 0xea, 0xa5,
     0x73, 0xba, 0xbd, 0x20, 0x58, 0xd1, 0xc6, 0xd1, 0xb6, 0xba, 0x0c, 0xf2, 0xb1, 0xfa, 0x91, 0xcb,
-    0xc7, 0xd9, 0x27
+    0xc7, 0x28, 0x6c
   };
   ak_uint8 openssl_outctr[67] = {
     0xf1,0x95,0xd8,0xbe,0xc1,0x0e,0xd1,0xdb,0xd5,0x7b,0x5f,0xa2,0x40,0xbd,0xa1,0xb8,
@@ -0,0 +1,67 @@
+/* Тестовый пример иллюстрирует применение многоблочных функций зашифрования/расшифрования
+   и проверяет, что режимы простой замены, гаммирования и простой замены с зацеплением,
+   использующие многоблочные функции, дают те же результаты, что и поблочная обработка данных.
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey06.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+ int main( void )
+{
+  size_t i;
+  int oc, result = EXIT_SUCCESS;
+  struct bckey bkey;
+  ak_uint8 key[32], iv[64], in[1040], out[1040], buf[1040];
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 7*i+1 );
+  for( i = 0; i < sizeof( iv ); i++ ) iv[i] = (ak_uint8)( 3*i+5 );
+  for( i = 0; i < sizeof( in ); i++ ) in[i] = (ak_uint8)( 31*i+7 );
+
+  for( oc = 0; oc < 2; oc++ ) {
+   /* устанавливаем нужный вариант совместимости и пересчитываем внутренние таблицы */
+    ak_libakrypt_set_option( "openssl_compability", oc );
+    ak_bckey_context_kuznechik_init_gost_tables();
+    printf("openssl_compability = %d\n", oc );
+
+    ak_bckey_context_create_kuznechik( &bkey );
+    ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+
+   /* 1. многоблочное зашифрование и поблочное зашифрование */
+    ak_bckey_context_encrypt_ecb( &bkey, in, out, sizeof( in ));
+    for( i = 0; i < sizeof( in ); i += 16 ) bkey.encrypt( &bkey.key, in+i, buf+i );
+    printf(" ecb encryption: %s\n", ak_ptr_is_equal( out, buf, sizeof( in )) ? "Ok" : "Wrong" );
+    if( !ak_ptr_is_equal( out, buf, sizeof( in ))) result = EXIT_FAILURE;
+
+    ak_bckey_context_decrypt_ecb( &bkey, out, out, sizeof( in ));
+    printf(" ecb decryption (in place): %s\n", ak_ptr_is_equal( out, in, sizeof( in )) ? "Ok" : "Wrong" );
+    if( !ak_ptr_is_equal( out, in, sizeof( in ))) result = EXIT_FAILURE;
+
+   /* 2. режим гаммирования за один вызов и за несколько вызовов */
+    ak_bckey_context_ctr( &bkey, in, out, sizeof( in ) - 5, iv, 8 );
+    ak_bckey_context_ctr( &bkey, in, buf, 48, iv, 8 );
+    ak_bckey_context_ctr( &bkey, in+48, buf+48, 512, NULL, 0 );
+    ak_bckey_context_ctr( &bkey, in+560, buf+560, sizeof( in ) - 565, NULL, 0 );
+    printf(" ctr encryption by fragments: %s\n",
+                          ak_ptr_is_equal( out, buf, sizeof( in ) - 5 ) ? "Ok" : "Wrong" );
+    if( !ak_ptr_is_equal( out, buf, sizeof( in ) - 5 )) result = EXIT_FAILURE;
+
+   /* 3. режим простой замены с зацеплением, расшифрование на месте */
+    ak_bckey_context_encrypt_cbc( &bkey, in, out, sizeof( in ), iv, 48 );
+    ak_bckey_context_decrypt_cbc( &bkey, out, out, sizeof( in ), iv, 48 );
+    printf(" cbc decryption (in place): %s\n", ak_ptr_is_equal( out, in, sizeof( in )) ? "Ok" : "Wrong" );
+    if( !ak_ptr_is_equal( out, in, sizeof( in ))) result = EXIT_FAILURE;
+
+    ak_bckey_context_destroy( &bkey );
+  }
+
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,80 @@
+/* Тестовый пример проверяет совпадение результатов, вырабатываемых различными реализациями
+   алгоритма блочного шифрования Кузнечик (базовой, векторной и использующей компактные
+   таблицы), в режимах простой замены,
+   гаммирования и простой замены с зацеплением.
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey07.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+/* вычисляем зашифрованный текст в трех режимах при заданной реализации алгоритма */
+ static void encrypt_with_kernel( int kernel, ak_uint8 *key, ak_uint8 *iv,
+                                                        ak_uint8 *in, ak_uint8 *out, size_t size )
+{
+  struct bckey bkey;
+
+  ak_libakrypt_set_option( "kuznechik_kernel", kernel );
+  ak_bckey_context_create_kuznechik( &bkey );
+  ak_bckey_context_set_key( &bkey, key, 32 );
+
+  ak_bckey_context_encrypt_ecb( &bkey, in, out, size );
+  ak_bckey_context_ctr( &bkey, in, out+size, size - 3, iv, 8 );
+  ak_bckey_context_encrypt_cbc( &bkey, in, out+2*size, size, iv, 32 );
+  ak_bckey_context_decrypt_ecb( &bkey, out, out+3*size, size );
+
+  ak_bckey_context_destroy( &bkey );
+}
+
+ int main( void )
+{
+  size_t i, k;
+  int oc, result = EXIT_SUCCESS;
+  int kernels[2] = { ak_kuznechik_kernel_ssse3, ak_kuznechik_kernel_compact };
+  const char *names[2] = { "vector", "compact" };
+  ak_uint8 key[32], iv[32], in[1008], out[4*1008], buf[4*1008];
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 11*i+3 );
+  for( i = 0; i < sizeof( iv ); i++ ) iv[i] = (ak_uint8)( 5*i+1 );
+  for( i = 0; i < sizeof( in ); i++ ) in[i] = (ak_uint8)( 17*i+13 );
+
+  for( oc = 0; oc < 2; oc++ ) {
+   /* устанавливаем нужный вариант совместимости и пересчитываем внутренние таблицы */
+    ak_libakrypt_set_option( "openssl_compability", oc );
+    ak_bckey_context_kuznechik_init_gost_tables();
+    printf("openssl_compability = %d\n", oc );
+
+    encrypt_with_kernel( ak_kuznechik_kernel_base, key, iv, in, out, sizeof( in ));
+    for( k = 0; k < 2; k++ ) {
+       if( !ak_kuznechik_kernel_is_available( kernels[k] )) {
+         printf(" %s implementation of kuznechik is not available, skipped\n", names[k] );
+         continue;
+       }
+       printf(" %s implementation\n", names[k] );
+       encrypt_with_kernel( kernels[k], key, iv, in, buf, sizeof( in ));
+
+       printf("  ecb encryption: %s\n", ak_ptr_is_equal( out, buf, sizeof( in )) ? "Ok" : "Wrong" );
+       if( !ak_ptr_is_equal( out, buf, sizeof( in ))) result = EXIT_FAILURE;
+       printf("  ctr encryption: %s\n",
+                ak_ptr_is_equal( out+sizeof( in ), buf+sizeof( in ), sizeof( in ) - 3 ) ? "Ok" : "Wrong" );
+       if( !ak_ptr_is_equal( out+sizeof( in ), buf+sizeof( in ), sizeof( in ) - 3 )) result = EXIT_FAILURE;
+       printf("  cbc encryption: %s\n",
+                ak_ptr_is_equal( out+2*sizeof( in ), buf+2*sizeof( in ), sizeof( in )) ? "Ok" : "Wrong" );
+       if( !ak_ptr_is_equal( out+2*sizeof( in ), buf+2*sizeof( in ), sizeof( in ))) result = EXIT_FAILURE;
+       printf("  ecb decryption: %s\n",
+                       ak_ptr_is_equal( in, buf+3*sizeof( in ), sizeof( in )) ? "Ok" : "Wrong" );
+       if( !ak_ptr_is_equal( in, buf+3*sizeof( in ), sizeof( in ))) result = EXIT_FAILURE;
+    }
+  }
+
+  ak_libakrypt_set_option( "kuznechik_kernel", ak_kuznechik_kernel_auto );
+  ak_libakrypt_destroy();
+ return result;
+}
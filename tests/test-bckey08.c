@@ -0,0 +1,89 @@
+/* Тестовый пример проверяет, что многопоточные реализации режимов простой замены, гаммирования
+   и расшифрования в режиме простой замены с зацеплением вырабатывают те же результаты,
+   что и последовательные реализации, а также одинаково изменяют значение синхропосылки
+   и ресурс ключа.
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey08.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+ #define size (16*5000+7)
+
+ int main( void )
+{
+  size_t i;
+  int result = EXIT_SUCCESS;
+  struct bckey one, two;
+  ak_uint8 key[32], iv[8], cbciv[32], *in = NULL, *out = NULL, *buf = NULL;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+ /* используем фиксированное количество потоков, не зависящее от числа процессоров */
+  ak_libakrypt_set_option( "bckey_thread_count", 4 );
+  printf("threads count: %u\n", (unsigned int) ak_bckey_context_get_threads_count( size/16 ));
+
+  in = malloc( size ); out = malloc( size ); buf = malloc( size );
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 13*i+5 );
+  for( i = 0; i < sizeof( iv ); i++ ) iv[i] = (ak_uint8)( 3*i+1 );
+  for( i = 0; i < sizeof( cbciv ); i++ ) cbciv[i] = (ak_uint8)( 7*i+2 );
+  for( i = 0; i < size; i++ ) in[i] = (ak_uint8)( 29*i+11 );
+
+  ak_bckey_context_create_kuznechik( &one );
+  ak_bckey_context_set_key( &one, key, sizeof( key ));
+  ak_bckey_context_create_kuznechik( &two );
+  ak_bckey_context_set_key( &two, key, sizeof( key ));
+
+ /* 1. режим простой замены */
+  ak_bckey_context_encrypt_ecb( &one, in, out, size - 7 );
+  ak_bckey_context_encrypt_ecb_parallel( &two, in, buf, size - 7 );
+  printf("ecb encryption: %s\n", ak_ptr_is_equal( out, buf, size - 7 ) ? "Ok" : "Wrong" );
+  if( !ak_ptr_is_equal( out, buf, size - 7 )) result = EXIT_FAILURE;
+
+  ak_bckey_context_decrypt_ecb_parallel( &two, buf, buf, size - 7 );
+  printf("ecb decryption (in place): %s\n", ak_ptr_is_equal( in, buf, size - 7 ) ? "Ok" : "Wrong" );
+  if( !ak_ptr_is_equal( in, buf, size - 7 )) result = EXIT_FAILURE;
+  ak_bckey_context_decrypt_ecb( &one, out, out, size - 7 );
+
+ /* 2. режим гаммирования: полные блоки, затем продолжение с неполным последним блоком */
+  ak_bckey_context_ctr( &one, in, out, 16*3000, iv, sizeof( iv ));
+  ak_bckey_context_ctr_parallel( &two, in, buf, 16*3000, iv, sizeof( iv ));
+  printf("ctr encryption: %s\n", ak_ptr_is_equal( out, buf, 16*3000 ) ? "Ok" : "Wrong" );
+  if( !ak_ptr_is_equal( out, buf, 16*3000 )) result = EXIT_FAILURE;
+  printf("ctr initial vector: %s\n",
+                       ak_ptr_is_equal( one.ivector, two.ivector, 16 ) ? "Ok" : "Wrong" );
+  if( !ak_ptr_is_equal( one.ivector, two.ivector, 16 )) result = EXIT_FAILURE;
+
+  ak_bckey_context_ctr( &one, in+16*3000, out+16*3000, size-16*3000, NULL, 0 );
+  ak_bckey_context_ctr_parallel( &two, in+16*3000, buf+16*3000, size-16*3000, NULL, 0 );
+  printf("ctr encryption (continued): %s\n", ak_ptr_is_equal( out, buf, size ) ? "Ok" : "Wrong" );
+  if( !ak_ptr_is_equal( out, buf, size )) result = EXIT_FAILURE;
+  if( one.key.flags != two.key.flags ) result = EXIT_FAILURE;
+
+ /* 3. режим простой замены с зацеплением (синхропосылка из двух блоков),
+       расшифрование выполняется на месте */
+  ak_bckey_context_encrypt_cbc( &one, in, out, size - 7, cbciv, sizeof( cbciv ));
+  ak_bckey_context_encrypt_cbc( &two, in, buf, size - 7, cbciv, sizeof( cbciv ));
+  ak_bckey_context_decrypt_cbc( &one, out, out, size - 7, cbciv, sizeof( cbciv ));
+  ak_bckey_context_decrypt_cbc_parallel( &two, buf, buf, size - 7, cbciv, sizeof( cbciv ));
+  printf("cbc decryption (in place): %s\n", ak_ptr_is_equal( out, buf, size - 7 ) &&
+                                             ak_ptr_is_equal( in, buf, size - 7 ) ? "Ok" : "Wrong" );
+  if( !ak_ptr_is_equal( out, buf, size - 7 ) || !ak_ptr_is_equal( in, buf, size - 7 ))
+    result = EXIT_FAILURE;
+
+ /* 4. ресурс ключа */
+  printf("key resource: %s\n",
+        one.key.resource.value.counter == two.key.resource.value.counter ? "Ok" : "Wrong" );
+  if( one.key.resource.value.counter != two.key.resource.value.counter ) result = EXIT_FAILURE;
+
+  ak_bckey_context_destroy( &one );
+  ak_bckey_context_destroy( &two );
+  free( in ); free( out ); free( buf );
+
+  ak_libakrypt_destroy();
+ return result;
+}
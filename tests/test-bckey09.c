@@ -0,0 +1,68 @@
+/* Тестовый пример проверяет режим гаммирования для алгоритма Магма: совпадение результатов,
+   полученных за один вызов и при обработке данных фрагментами, а также расшифрование;
+   после этого измеряется скорость зашифрования данных в режиме гаммирования.
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey09.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+/* объем данных не превышает ресурса ключа алгоритма Магма (4 Мб) */
+ #define size (1024*1024)
+
+ int main( void )
+{
+  size_t i, len;
+  clock_t timea;
+  int result = EXIT_SUCCESS;
+  struct bckey bkey;
+  ak_uint8 key[32], iv[4], *in = NULL, *out = NULL, *buf = NULL;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  in = malloc( size ); out = malloc( size ); buf = malloc( size );
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 13*i+5 );
+  for( i = 0; i < sizeof( iv ); i++ ) iv[i] = (ak_uint8)( 3*i+1 );
+  for( i = 0; i < size; i++ ) in[i] = (ak_uint8)( 29*i+11 );
+
+  ak_bckey_context_create_magma( &bkey );
+  ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+
+ /* 1. зашифрование за один вызов и фрагментами, длины которых кратны длине блока */
+  ak_bckey_context_ctr( &bkey, in, out, size - 5, iv, sizeof( iv ));
+  ak_bckey_context_ctr( &bkey, in, buf, 8, iv, sizeof( iv ));
+  for( i = 8, len = 8; i < size - 5; i += len, len += 8 )
+     ak_bckey_context_ctr( &bkey, in+i, buf+i, ak_min( len, size - 5 - i ), NULL, 0 );
+  printf("ctr encryption (fragments): %s\n",
+                                   ak_ptr_is_equal( out, buf, size - 5 ) ? "Ok" : "Wrong" );
+  if( !ak_ptr_is_equal( out, buf, size - 5 )) result = EXIT_FAILURE;
+
+ /* 2. расшифрование на месте */
+  ak_bckey_context_ctr( &bkey, buf, buf, size - 5, iv, sizeof( iv ));
+  printf("ctr decryption (in place): %s\n",
+                                    ak_ptr_is_equal( in, buf, size - 5 ) ? "Ok" : "Wrong" );
+  if( !ak_ptr_is_equal( in, buf, size - 5 )) result = EXIT_FAILURE;
+
+ /* 3. скорость зашифрования (ключ присваивается заново для восстановления ресурса) */
+  timea = clock();
+  for( i = 0; i < 16; i++ ) {
+     ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+     ak_bckey_context_ctr( &bkey, in, out, size, iv, sizeof( iv ));
+  }
+  timea = clock() - timea;
+  printf("ctr encryption of 16MB: %fs, speed = %f MBs\n",
+                       (double) timea / (double) CLOCKS_PER_SEC,
+                       16*(double) CLOCKS_PER_SEC / ( timea > 0 ? (double) timea : 1 ));
+
+  ak_bckey_context_destroy( &bkey );
+  free( in ); free( out ); free( buf );
+
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,143 @@
+/* Пример, иллюстрирующий скорость работы различных реализаций алгоритма блочного шифрования
+   Кузнечик в условиях, когда процессорное ядро совместно используется с другим приложением.
+
+   Данные зашифровываются в режиме гаммирования пакетами по 1500 октетов; в "загрязненном"
+   варианте между пакетами выполняется обработка постороннего буфера объемом 256 Кбайт,
+   которая вытесняет таблицы алгоритма из кэша первого уровня (так ведет себя, например,
+   обработчик сетевых пакетов, работающий на том же ядре). Учитывается только время,
+   затраченное на шифрование. В ОС Linux, при наличии прав доступа к счетчикам
+   производительности, дополнительно выводится количество промахов кэша данных
+   первого уровня, приходящихся на один зашифрованный пакет.
+   Внимание! Используются неэкспортируемые функции.
+
+   test-bckey10.c
+*/
+#ifdef __linux__
+ #define _GNU_SOURCE
+#endif
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+#ifdef __linux__
+ #include <unistd.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <linux/perf_event.h>
+#endif
+
+ #define packet_size   (1500)
+ #define packets_count (8192)
+ #define noise_size    (256*1024)
+
+/* обработка постороннего буфера, имитирующая работу другого приложения */
+ static ak_uint32 noise( ak_uint8 *buffer )
+{
+  size_t i;
+  ak_uint32 sum = 0;
+  for( i = 0; i < noise_size; i += 64 ) { sum += buffer[i]; buffer[i] = ( ak_uint8 )sum; }
+ return sum;
+}
+
+/* счетчик промахов кэша данных первого уровня */
+ static int counter_open( void )
+{
+#ifdef __linux__
+  struct perf_event_attr attr;
+
+  memset( &attr, 0, sizeof( attr ));
+  attr.type = PERF_TYPE_HW_CACHE;
+  attr.size = sizeof( attr );
+  attr.config = PERF_COUNT_HW_CACHE_L1D | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+                                                      ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+ return ( int ) syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+#else
+ return -1;
+#endif
+}
+
+/* шифрование заданного количества пакетов; функция возвращает время шифрования в секундах */
+ static double encrypt_packets( ak_bckey bkey, ak_uint8 *data, ak_uint8 *buffer,
+                                                      const bool_t polluted, const int fd )
+{
+  size_t i;
+  clock_t timea, total = 0;
+  ak_uint8 iv[8] = { 0x12, 0x34, 0x56, 0x78, 0x90, 0xab, 0xce, 0xf0 };
+
+  for( i = 0; i < packets_count; i++ ) {
+     if( polluted ) noise( buffer );
+     iv[0] = ( ak_uint8 )i;
+#ifdef __linux__
+     if( fd >= 0 ) ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 );
+#endif
+     timea = clock();
+     ak_bckey_context_ctr( bkey, data + i*packet_size, data + i*packet_size,
+                                                                   packet_size, iv, sizeof( iv ));
+     total += clock() - timea;
+#ifdef __linux__
+     if( fd >= 0 ) ioctl( fd, PERF_EVENT_IOC_DISABLE, 0 );
+#endif
+  }
+ return ( double ) total / ( double ) CLOCKS_PER_SEC;
+}
+
+ int main( void )
+{
+  size_t k;
+  int fd = -1, polluted;
+  struct bckey bkey;
+  ak_uint8 key[32], *data = NULL, *buffer = NULL;
+  int kernels[3] = { ak_kuznechik_kernel_base, ak_kuznechik_kernel_ssse3,
+                                                                   ak_kuznechik_kernel_compact };
+  const char *names[3] = { "base", "ssse3", "compact" };
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  for( k = 0; k < sizeof( key ); k++ ) key[k] = ( ak_uint8 )( 7*k+1 );
+  data = malloc( packet_size*packets_count );
+  buffer = malloc( noise_size );
+  memset( data, 0x13, packet_size*packets_count );
+  memset( buffer, 0x31, noise_size );
+  if(( fd = counter_open()) < 0 ) printf("performance counters are not available\n");
+
+  for( k = 0; k < 3; k++ ) {
+     if( !ak_kuznechik_kernel_is_available( kernels[k] )) {
+       printf("%-8s: not available\n", names[k] );
+       continue;
+     }
+     ak_libakrypt_set_option( "kuznechik_kernel", kernels[k] );
+     ak_bckey_context_create_kuznechik( &bkey );
+     ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+
+     for( polluted = 0; polluted < 2; polluted++ ) {
+        double sec = encrypt_packets( &bkey, data, buffer, polluted, -1 );
+        printf("%-8s: %s cache, speed = %8.2f MBs", names[k], polluted ? "polluted" : "clean   ",
+                        ( double )( packet_size*packets_count ) / ( sec*1024*1024 ));
+#ifdef __linux__
+        if( fd >= 0 ) {
+          long long misses = 0;
+          ioctl( fd, PERF_EVENT_IOC_RESET, 0 );
+          encrypt_packets( &bkey, data, buffer, polluted, fd );
+          if( read( fd, &misses, sizeof( misses )) == sizeof( misses ))
+            printf(", L1D misses per packet = %8.2f", ( double ) misses / packets_count );
+        }
+#endif
+        printf("\n");
+     }
+     ak_bckey_context_destroy( &bkey );
+  }
+
+#ifdef __linux__
+  if( fd >= 0 ) close( fd );
+#endif
+  free( buffer );
+  free( data );
+  ak_libakrypt_set_option( "kuznechik_kernel", ak_kuznechik_kernel_auto );
+ return ak_libakrypt_destroy();
+}
@@ -0,0 +1,114 @@
+/* Тестовый пример проверяет, что одновременное зашифрование нескольких независимых сообщений
+   в режиме простой замены с зацеплением функцией ak_bckey_context_encrypt_cbc_streams()
+   дает тот же результат, что и последовательные вызовы функции ak_bckey_context_encrypt_cbc().
+   Сообщения имеют различные длины и синхропосылки, используются три различных ключа,
+   часть сообщений зашифровывается на месте. Также проверяется, что при ошибке в одном из
+   сообщений ресурс ключей не изменяется, и выводится скорость зашифрования.
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey11.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+ #define streams_count (40)
+ #define message_size  (4096)
+
+ int main( void )
+{
+  size_t i, j;
+  clock_t timea;
+  double one = 0, many = 0;
+  int result = EXIT_SUCCESS;
+  struct bckey keys[3];
+  ak_int64 counters[3];
+  struct bckey_stream streams[streams_count];
+  ak_uint8 key[32], iv[streams_count][32], *in = NULL, *out = NULL, *buf = NULL;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  in = malloc( streams_count*message_size );
+  out = malloc( streams_count*message_size );
+  buf = malloc( streams_count*message_size );
+  for( i = 0; i < streams_count*message_size; i++ ) in[i] = (ak_uint8)( 31*i+7 );
+  for( i = 0; i < streams_count; i++ )
+     for( j = 0; j < 32; j++ ) iv[i][j] = (ak_uint8)( 5*i+3*j+1 );
+
+  for( i = 0; i < 3; i++ ) {
+     for( j = 0; j < sizeof( key ); j++ ) key[j] = (ak_uint8)( 13*j+5*i+1 );
+     if( i < 2 ) ak_bckey_context_create_kuznechik( keys+i );
+       else ak_bckey_context_create_magma( keys+i );
+     ak_bckey_context_set_key( keys+i, key, sizeof( key ));
+  }
+
+ /* формируем описания сообщений: длины сообщений различны, есть пустые сообщения */
+  for( i = 0; i < streams_count; i++ ) {
+     streams[i].bkey = keys + i%3;
+     streams[i].size = (( 37*i )%( message_size/16 ))*16;
+     streams[i].iv = iv[i];
+     streams[i].iv_size = streams[i].bkey->bsize*( 1 + i%( 32/streams[i].bkey->bsize ));
+     streams[i].in = in + i*message_size;
+     streams[i].out = buf + i*message_size;
+  }
+
+ /* последовательное зашифрование */
+  for( i = 0; i < streams_count; i++ )
+     ak_bckey_context_encrypt_cbc( streams[i].bkey, streams[i].in, out + i*message_size,
+                                     streams[i].size, streams[i].iv, streams[i].iv_size );
+ /* одновременное зашифрование; каждое четвертое сообщение зашифровывается на месте */
+  for( i = 0; i < streams_count; i += 4 ) {
+     memcpy( buf + i*message_size, streams[i].in, streams[i].size );
+     streams[i].in = streams[i].out;
+  }
+  ak_bckey_context_encrypt_cbc_streams( streams, streams_count );
+
+  for( i = 0; i < streams_count; i++ )
+     if( !ak_ptr_is_equal( out + i*message_size, buf + i*message_size, streams[i].size )) {
+       printf("stream %u: Wrong\n", (unsigned int) i );
+       result = EXIT_FAILURE;
+     }
+  printf("cbc encryption of %u streams: %s\n", streams_count,
+                                                     result == EXIT_SUCCESS ? "Ok" : "Wrong" );
+
+ /* сообщение некорректной длины обнаруживается до изменения ресурса ключей */
+  for( i = 0; i < 3; i++ ) counters[i] = keys[i].key.resource.value.counter;
+  streams[streams_count-1].size += 1;
+  if( ak_bckey_context_encrypt_cbc_streams( streams, streams_count ) == ak_error_ok )
+    result = EXIT_FAILURE;
+  streams[streams_count-1].size -= 1;
+  for( i = 0; i < 3; i++ )
+     if( keys[i].key.resource.value.counter != counters[i] ) result = EXIT_FAILURE;
+  ak_error_set_value( ak_error_ok );
+  printf("resource after wrong stream: %s\n", result == EXIT_SUCCESS ? "Ok" : "Wrong" );
+
+ /* сравниваем скорость для сообщений одинаковой длины, использующих один ключ */
+  for( i = 0; i < streams_count; i++ ) {
+     streams[i].bkey = keys;
+     streams[i].size = message_size;
+     streams[i].iv_size = 16;
+     streams[i].in = in + i*message_size;
+  }
+  timea = clock();
+  for( j = 0; j < 50; j++ )
+     for( i = 0; i < streams_count; i++ )
+        ak_bckey_context_encrypt_cbc( keys, streams[i].in, streams[i].out,
+                                                            message_size, streams[i].iv, 16 );
+  one = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  timea = clock();
+  for( j = 0; j < 50; j++ ) ak_bckey_context_encrypt_cbc_streams( streams, streams_count );
+  many = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  printf("sequential: %.2f MBs, streams: %.2f MBs\n",
+                          50.*streams_count*message_size/( 1024*1024*( one > 0 ? one : 1e-9 )),
+                          50.*streams_count*message_size/( 1024*1024*( many > 0 ? many : 1e-9 )));
+
+  for( i = 0; i < 3; i++ ) ak_bckey_context_destroy( keys+i );
+  free( in ); free( out ); free( buf );
+
+  ak_libakrypt_destroy();
+ return result;
+}
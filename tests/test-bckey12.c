@@ -0,0 +1,117 @@
+/* Тестовый пример проверяет функции произвольного доступа к данным, зашифрованным в режиме
+   гаммирования: результат функции ak_bckey_context_ctr_offset() для произвольных фрагментов
+   сообщения сравнивается с соответствующими фрагментами результата функции ak_bckey_context_ctr(),
+   а результат функции ak_bckey_context_ctr_sectors() - с последовательным зашифрованием
+   каждого сектора на синхропосылке, полученной из номера сектора.
+   Проверка выполняется для алгоритмов Магма и Кузнечик, в однопоточном и многопоточном
+   вариантах, для обоих вариантов совместимости с openssl. Также проверяется, что после
+   обработки фрагмента, не заканчивающегося на границе блока, продолжение шифрования запрещено,
+   а зашифрование секторов без синхропосылки невозможно.
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey12.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+ #define size (16*8192)
+
+/* формирование синхропосылки сектора */
+ static void sector_iv( ak_uint8 *ivn, const ak_uint8 *iv,
+                                      const size_t halfsize, const ak_uint64 n, const int oc )
+{
+  size_t k;
+  for( k = 0; ( k < halfsize ) && ( k < 8 ); k++ )
+     ivn[oc ? halfsize-1-k : k] = iv[oc ? halfsize-1-k : k]^( ak_uint8 )( n >> 8*k );
+}
+
+ int main( void )
+{
+  int oc, result = EXIT_SUCCESS;
+  size_t i, j, threads, sector_size, count;
+  ak_uint64 offset, sector;
+  struct bckey bkey;
+  ak_uint8 key[32], iv[8], ivn[8], *in = NULL, *out = NULL, *buf = NULL;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  in = malloc( size ); out = malloc( size ); buf = malloc( size );
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 11*i+3 );
+  for( i = 0; i < sizeof( iv ); i++ ) iv[i] = (ak_uint8)( 5*i+7 );
+  for( i = 0; i < size; i++ ) in[i] = (ak_uint8)( 17*i+1 );
+
+  for( oc = 0; oc < 2; oc++ ) {
+   /* устанавливаем нужный вариант совместимости и пересчитываем внутренние таблицы */
+    ak_libakrypt_set_option( "openssl_compability", oc );
+    ak_bckey_context_kuznechik_init_gost_tables();
+
+    for( j = 0; j < 2; j++ ) {
+     for( threads = 1; threads < 5; threads += 3 ) {
+       int ok = ak_true;
+       ak_libakrypt_set_option( "bckey_thread_count", (ak_int64) threads );
+
+       if( j ) ak_bckey_context_create_kuznechik( &bkey );
+         else ak_bckey_context_create_magma( &bkey );
+       ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+
+      /* 1. произвольные фрагменты сообщения, включая большие и невыровненные */
+       ak_bckey_context_ctr( &bkey, in, out, size, iv, sizeof( iv ));
+       for( i = 0; i < 64; i++ ) {
+          size_t len = ( i%8 == 0 ) ? size/2 + 3*i : ( 97*i*i + 13 )%4096;
+          offset = ( 7919*i + 5*i*i )%( size - len );
+          memcpy( buf, in + offset, len );
+          ak_bckey_context_ctr_offset( &bkey, buf, buf, len, offset, iv, sizeof( iv ));
+          if( !ak_ptr_is_equal( buf, out + offset, len )) ok = ak_false;
+       }
+      /* фрагмент, заканчивающийся на границе блока, допускает продолжение шифрования */
+       ak_bckey_context_ctr_offset( &bkey, in + 5, buf + 5, 16*100 - 5, 5, iv, sizeof( iv ));
+       ak_bckey_context_ctr( &bkey, in + 16*100, buf + 16*100, 16*100, NULL, 0 );
+       if( !ak_ptr_is_equal( buf + 5, out + 5, 16*200 - 5 )) ok = ak_false;
+      /* фрагмент, умещающийся внутри первого блока, запрещает продолжение шифрования */
+       ak_bckey_context_ctr_offset( &bkey, in + 1, buf + 1, 1, 1, iv, sizeof( iv ));
+       if( !ak_ptr_is_equal( buf + 1, out + 1, 1 )) ok = ak_false;
+       if( ak_bckey_context_ctr( &bkey, in + 2, buf + 2, 16, NULL, 0 ) == ak_error_ok )
+         ok = ak_false;
+       ak_error_set_value( ak_error_ok );
+
+       printf("%s (oc = %d, threads = %u) ctr with offset: %s\n", j ? "kuznechik" : "magma",
+                                                  oc, (unsigned int) threads, ok ? "Ok" : "Wrong" );
+       if( !ok ) result = EXIT_FAILURE;
+
+      /* 2. последовательность секторов с различными длинами */
+       for( ok = ak_true, i = 0; i < 3; i++ ) {
+          sector_size = bkey.bsize*( i == 0 ? 1 : ( i == 1 ? 5 : 512 ));
+          count = size/sector_size - i;
+          sector = 0xfffffff0 + 1000*i;
+          for( offset = 0; offset < count; offset++ ) {
+             sector_iv( ivn, iv, bkey.bsize >> 1, sector + offset, oc );
+             ak_bckey_context_ctr( &bkey, in + offset*sector_size, out + offset*sector_size,
+                                                                sector_size, ivn, sizeof( ivn ));
+          }
+          ak_bckey_context_ctr_sectors( &bkey, in, buf, sector_size, sector, count,
+                                                                           iv, sizeof( iv ));
+          if( !ak_ptr_is_equal( buf, out, count*sector_size )) ok = ak_false;
+       }
+      /* синхропосылка не может быть опущена */
+       if( ak_bckey_context_ctr_sectors( &bkey, in, buf, bkey.bsize, 0, 1,
+                                                         NULL, 0 ) != ak_error_null_pointer )
+         ok = ak_false;
+       ak_error_set_value( ak_error_ok );
+       printf("%s (oc = %d, threads = %u) ctr sectors: %s\n", j ? "kuznechik" : "magma",
+                                                  oc, (unsigned int) threads, ok ? "Ok" : "Wrong" );
+       if( !ok ) result = EXIT_FAILURE;
+       ak_bckey_context_destroy( &bkey );
+     }
+    }
+  }
+
+  ak_libakrypt_set_option( "openssl_compability", 0 );
+  ak_bckey_context_kuznechik_init_gost_tables();
+  free( in ); free( out ); free( buf );
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,116 @@
+/* Тестовый пример проверяет, что зашифрование в режиме гаммирования с одновременной выработкой
+   имитовставки функцией ak_bckey_context_encrypt_ctr_mac() дает тот же результат, что и
+   последовательные вызовы функций ak_bckey_context_ctr() и ak_omac_context_ptr() (или
+   ak_hmac_context_ptr()), а также проверяет расшифрование с проверкой имитовставки, в том числе
+   на месте и для искаженных данных. Также выводится скорость однопроходной и двухпроходной
+   обработки данных.
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey13.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_omac.h>
+ #include <ak_hmac.h>
+ #include <ak_tools.h>
+
+ #define size (1024*1024)
+
+ int main( void )
+{
+  clock_t timea;
+  double one = 0, two = 0;
+  size_t i, j, k, tag_size;
+  int error, result = EXIT_SUCCESS;
+  struct bckey bkey;
+  struct omac omac;
+  struct hmac hmac;
+  ak_mac mctx[4];
+  ak_uint8 key[32], iv[8], tag[64], fused[64], *in = NULL, *out = NULL, *buf = NULL;
+  size_t sizes[6] = { 0, 7, 16*1000+5, 3*ak_bckey_context_ctr_mac_chunk_size + 17,
+                                                 2*ak_bckey_context_ctr_mac_chunk_size, 100000 };
+  const char *names[4] = { "omac (magma)", "omac (kuznechik)", "hmac (streebog256)",
+                                                                           "hmac (streebog512)" };
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  in = malloc( size ); out = malloc( size ); buf = malloc( size );
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 5*i+17 );
+  for( i = 0; i < sizeof( iv ); i++ ) iv[i] = (ak_uint8)( 9*i+2 );
+  for( i = 0; i < size; i++ ) in[i] = (ak_uint8)( 23*i+3 );
+
+  for( k = 0; k < 4; k++ ) {
+     int ok = ak_true;
+
+     ak_bckey_context_create_kuznechik( &bkey );
+     ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+     key[0]++;
+     switch( k ) {
+       case 0: ak_omac_context_create_magma( &omac ); break;
+       case 1: ak_omac_context_create_kuznechik( &omac ); break;
+       case 2: ak_hmac_context_create_streebog256( &hmac ); break;
+       case 3: ak_hmac_context_create_streebog512( &hmac ); break;
+     }
+     if( k < 2 ) {
+       ak_omac_context_set_key( &omac, key, sizeof( key ));
+       mctx[k] = &omac.mctx;
+       tag_size = ak_omac_context_get_tag_size( &omac );
+     } else {
+       ak_hmac_context_set_key( &hmac, key, sizeof( key ));
+       mctx[k] = &hmac.mctx;
+       tag_size = ak_hmac_context_get_tag_size( &hmac );
+     }
+
+     for( j = 0; j < 6; j++ ) {
+       /* двухпроходная обработка */
+        ak_bckey_context_ctr( &bkey, in, out, sizes[j], iv, sizeof( iv ));
+        if( k < 2 ) ak_omac_context_ptr( &omac, out, sizes[j], tag, tag_size );
+          else ak_hmac_context_ptr( &hmac, out, sizes[j], tag, tag_size );
+       /* однопроходная обработка, для четных длин - на месте */
+        memcpy( buf, in, sizes[j] );
+        ak_bckey_context_encrypt_ctr_mac( &bkey, mctx[k], buf, buf, sizes[j],
+                                                             iv, sizeof( iv ), fused, tag_size );
+        if( !ak_ptr_is_equal( out, buf, sizes[j] ) || !ak_ptr_is_equal( tag, fused, tag_size ))
+          ok = ak_false;
+        error = ak_bckey_context_decrypt_ctr_mac( &bkey, mctx[k], buf, j%2 ? out : buf,
+                                                   sizes[j], iv, sizeof( iv ), fused, tag_size );
+        if(( error != ak_error_ok ) || !ak_ptr_is_equal( in, j%2 ? out : buf, sizes[j] ))
+          ok = ak_false;
+       /* искаженная имитовставка */
+        fused[0] ^= 1;
+        ak_bckey_context_ctr( &bkey, in, buf, sizes[j], iv, sizeof( iv ));
+        error = ak_bckey_context_decrypt_ctr_mac( &bkey, mctx[k], buf, out,
+                                                   sizes[j], iv, sizeof( iv ), fused, tag_size );
+        if( error != ak_error_not_equal_data ) ok = ak_false;
+        ak_error_set_value( ak_error_ok );
+        for( i = 0; i < sizes[j]; i++ ) if( out[i] ) ok = ak_false;
+     }
+     printf("ctr with %s: %s\n", names[k], ok ? "Ok" : "Wrong" );
+     if( !ok ) result = EXIT_FAILURE;
+
+    /* сравниваем скорость однопроходной и двухпроходной обработки */
+     timea = clock();
+     ak_bckey_context_ctr( &bkey, in, out, size, iv, sizeof( iv ));
+     ak_mac_context_ptr( mctx[k], out, size, tag, tag_size );
+     two = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+     timea = clock();
+     ak_bckey_context_encrypt_ctr_mac( &bkey, mctx[k], in, out, size,
+                                                             iv, sizeof( iv ), fused, tag_size );
+     one = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+     printf(" two passes: %.2f MBs, one pass: %.2f MBs\n",
+                                     size/( 1024*1024*( two > 0 ? two : 1e-9 )),
+                                     size/( 1024*1024*( one > 0 ? one : 1e-9 )));
+     if( !ak_ptr_is_equal( tag, fused, tag_size )) result = EXIT_FAILURE;
+
+     if( k < 2 ) ak_omac_context_destroy( &omac );
+       else ak_hmac_context_destroy( &hmac );
+     ak_bckey_context_destroy( &bkey );
+  }
+
+  free( in ); free( out ); free( buf );
+  ak_libakrypt_destroy();
+ return result;
+}
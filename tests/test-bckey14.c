@@ -0,0 +1,110 @@
+/* Тестовый пример проверяет, что шифрование нескольких независимых сообщений в режиме
+   гаммирования функцией ak_bckey_context_ctr_streams() дает тот же результат, что и
+   последовательные вызовы функции ak_bckey_context_ctr(). Сообщения имеют различные длины
+   (в том числе не кратные длине блока), синхропосылки и ключи, часть сообщений шифруется
+   на месте. Также выводится скорость шифрования коротких сообщений (сетевых пакетов).
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey14.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+ #define records_count (256)
+ #define record_size   (1500)
+
+ int main( void )
+{
+  clock_t timea;
+  double one = 0, many = 0;
+  size_t i, j, k, packet;
+  int oc, result = EXIT_SUCCESS;
+  struct bckey keys[2];
+  struct bckey_stream records[records_count];
+  ak_uint8 key[32], iv[records_count][8], *in = NULL, *out = NULL, *buf = NULL;
+  size_t packets[3] = { 64, 576, 1500 };
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  in = malloc( records_count*record_size );
+  out = malloc( records_count*record_size );
+  buf = malloc( records_count*record_size );
+  for( i = 0; i < records_count*record_size; i++ ) in[i] = (ak_uint8)( 19*i+5 );
+  for( i = 0; i < records_count; i++ )
+     for( j = 0; j < 8; j++ ) iv[i][j] = (ak_uint8)( 7*i+11*j+3 );
+  for( j = 0; j < sizeof( key ); j++ ) key[j] = (ak_uint8)( 3*j+1 );
+
+  for( oc = 0; oc < 2; oc++ ) {
+     int ok = ak_true;
+
+    /* устанавливаем нужный вариант совместимости и пересчитываем внутренние таблицы */
+     ak_libakrypt_set_option( "openssl_compability", oc );
+     ak_bckey_context_kuznechik_init_gost_tables();
+     ak_bckey_context_create_kuznechik( keys );
+     ak_bckey_context_set_key( keys, key, sizeof( key ));
+     ak_bckey_context_create_magma( keys+1 );
+     ak_bckey_context_set_key( keys+1, key, sizeof( key ));
+
+    /* формируем описания сообщений: длины различны, есть пустые сообщения */
+     for( i = 0; i < records_count; i++ ) {
+        records[i].bkey = keys + ( i%5 == 4 );
+        records[i].size = ( 53*i + i*i )%( record_size + 1 );
+        records[i].iv = iv[i];
+        records[i].iv_size = sizeof( iv[i] );
+        records[i].in = in + i*record_size;
+        records[i].out = buf + i*record_size;
+     }
+    /* последовательное шифрование */
+     for( i = 0; i < records_count; i++ )
+        ak_bckey_context_ctr( records[i].bkey, records[i].in, out + i*record_size,
+                                            records[i].size, records[i].iv, records[i].iv_size );
+    /* совместное шифрование; каждое третье сообщение шифруется на месте */
+     for( i = 0; i < records_count; i += 3 ) {
+        memcpy( records[i].out, records[i].in, records[i].size );
+        records[i].in = records[i].out;
+     }
+     ak_bckey_context_ctr_streams( records, records_count );
+     for( i = 0; i < records_count; i++ )
+        if( !ak_ptr_is_equal( out + i*record_size, buf + i*record_size, records[i].size )) {
+          printf("record %u: Wrong\n", (unsigned int) i );
+          ok = ak_false;
+        }
+     printf("ctr encryption of %u records (oc = %d): %s\n", records_count, oc,
+                                                                            ok ? "Ok" : "Wrong" );
+     if( !ok ) result = EXIT_FAILURE;
+
+    /* сравниваем скорость для пакетов одинаковой длины */
+     for( k = 0; oc == 0 && k < 3; k++ ) {
+        packet = packets[k];
+        for( i = 0; i < records_count; i++ ) {
+           records[i].bkey = keys;
+           records[i].size = packet;
+           records[i].in = in + i*record_size;
+        }
+        timea = clock();
+        for( j = 0; j < 20; j++ )
+           for( i = 0; i < records_count; i++ )
+              ak_bckey_context_ctr( keys, records[i].in, records[i].out, packet, iv[i], 8 );
+        one = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+        timea = clock();
+        for( j = 0; j < 20; j++ ) ak_bckey_context_ctr_streams( records, records_count );
+        many = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+        printf(" %4u byte packets: sequential %.2f MBs, batch %.2f MBs\n", (unsigned int) packet,
+                             20.*records_count*packet/( 1024*1024*( one > 0 ? one : 1e-9 )),
+                             20.*records_count*packet/( 1024*1024*( many > 0 ? many : 1e-9 )));
+     }
+     ak_bckey_context_destroy( keys );
+     ak_bckey_context_destroy( keys+1 );
+  }
+
+  ak_libakrypt_set_option( "openssl_compability", 0 );
+  ak_bckey_context_kuznechik_init_gost_tables();
+  free( in ); free( out ); free( buf );
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,110 @@
+/* Тестовый пример проверяет, что шифрование в режимах гаммирования и CTR-ACPKM данных,
+   расположенных в нескольких несмежных фрагментах, функциями ak_bckey_context_ctr_fragments()
+   и ak_bckey_context_ctr_acpkm_fragments() дает тот же результат, что и шифрование
+   объединенных данных функциями ak_bckey_context_ctr() и ak_bckey_context_ctr_acpkm().
+   Фрагменты имеют произвольные длины (в том числе нулевые и меньшие длины блока),
+   данные обрабатываются как на месте, так и в другие фрагменты.
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey15.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+ #define message_size (3001)
+ #define max_fragments (512)
+
+/* разбиение данных на фрагменты произвольной длины, расположенные с промежутками;
+   входные данные копируются во входные фрагменты */
+ static size_t split( ak_uint8 *in, size_t len, ak_uint8 *sin, ak_uint8 *sout,
+                                       ak_fragment fin, ak_fragment fout, size_t seed )
+{
+  size_t count = 0, offset = 0, step = 0;
+
+  while( offset < len ) {
+     step = ( seed = seed*1103515245 + 12345 )%( count%7 == 6 ? 700 : 23 );
+     if( step > len - offset ) step = len - offset;
+     fin[count].data = sin + offset + 2*count;
+     fout[count].data = sout + offset + 2*count;
+     fin[count].size = fout[count].size = step;
+     memcpy( fin[count++].data, in + offset, step );
+     offset += step;
+  }
+ return count;
+}
+
+/* объединение фрагментов */
+ static void gather( ak_uint8 *out, ak_fragment fragments, size_t count )
+{
+  size_t i;
+  for( i = 0; i < count; i++ ) {
+     memcpy( out, fragments[i].data, fragments[i].size );
+     out += fragments[i].size;
+  }
+}
+
+ int main( void )
+{
+  int oc, result = EXIT_SUCCESS;
+  size_t i, j, len, count;
+  struct bckey bkey;
+  struct fragment fin[max_fragments], fout[max_fragments];
+  ak_uint8 key[32], iv[8], in[message_size], out[message_size], *sin = NULL, *sout = NULL, *sbuf = NULL;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  sin = malloc( message_size + 2*max_fragments );
+  sout = malloc( message_size + 2*max_fragments );
+  sbuf = malloc( message_size );
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 9*i+4 );
+  for( i = 0; i < sizeof( iv ); i++ ) iv[i] = (ak_uint8)( 15*i+1 );
+  for( i = 0; i < message_size; i++ ) in[i] = (ak_uint8)( 13*i+7 );
+
+  for( oc = 0; oc < 2; oc++ ) {
+    /* устанавливаем нужный вариант совместимости и пересчитываем внутренние таблицы */
+     ak_libakrypt_set_option( "openssl_compability", oc );
+     ak_bckey_context_kuznechik_init_gost_tables();
+
+     for( j = 0; j < 4; j++ ) {
+        int ok = ak_true;
+
+        if( j%2 ) ak_bckey_context_create_kuznechik( &bkey );
+          else ak_bckey_context_create_magma( &bkey );
+        ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+
+        for( i = 0; i < 16; i++ ) {
+          /* сообщения различной длины, в том числе не кратной длине блока */
+           len = message_size - 37*i;
+           if( j < 2 ) ak_bckey_context_ctr( &bkey, in, out, len, iv, sizeof( iv ));
+             else ak_bckey_context_ctr_acpkm( &bkey, in, out, len, 4*bkey.bsize, iv, sizeof( iv ));
+
+          /* разбиваем входные данные на фрагменты; выходные фрагменты имеют те же длины */
+           count = split( in, len, sin, sout, fin, fout, 17*i+j );
+
+          /* для ключей ACPKM ключ присваивается заново перед каждым сообщением */
+           if( j >= 2 ) ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+           if( j < 2 ) ak_bckey_context_ctr_fragments( &bkey, fin, i%2 ? NULL : fout, count,
+                                                                              iv, sizeof( iv ));
+             else ak_bckey_context_ctr_acpkm_fragments( &bkey, fin, i%2 ? NULL : fout, count,
+                                                        4*bkey.bsize, iv, sizeof( iv ));
+           gather( sbuf, i%2 ? fin : fout, count );
+           if( !ak_ptr_is_equal( out, sbuf, len )) ok = ak_false;
+           if( j >= 2 ) ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+        }
+        printf("%s with %s (oc = %d): %s\n", j < 2 ? "ctr fragments" : "ctr-acpkm fragments",
+                                          j%2 ? "kuznechik" : "magma", oc, ok ? "Ok" : "Wrong" );
+        if( !ok ) result = EXIT_FAILURE;
+        ak_bckey_context_destroy( &bkey );
+     }
+  }
+
+  ak_libakrypt_set_option( "openssl_compability", 0 );
+  ak_bckey_context_kuznechik_init_gost_tables();
+  free( sin ); free( sout ); free( sbuf );
+  ak_libakrypt_destroy();
+ return result;
+}
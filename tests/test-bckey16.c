@@ -0,0 +1,127 @@
+/* Тестовый пример проверяет, что пакетное зашифрование блоков, принадлежащих различным ключам
+   алгоритма Кузнечик, функцией ak_kuznechik_encrypt_batch() дает тот же результат,
+   что и последовательные вызовы функции ak_bckey_context_encrypt_ecb() для каждого пакета.
+   Проверка выполняется для всех доступных реализаций алгоритма и обоих представлений данных.
+   Также выводится скорость зашифрования коротких пакетов, каждый из которых использует
+   собственный ключ.
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey16.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+ #define keys_count    (64)
+ #define packets_count (256)
+ #define max_blocks    (4)
+
+ int main( void )
+{
+  size_t i, j;
+  clock_t timea;
+  int k, oc, result = EXIT_SUCCESS;
+  double one = 0, many = 0;
+  struct bckey keys[keys_count], magma;
+  struct bckey_batch batch[packets_count];
+  ak_uint8 key[32], *in = NULL, *out = NULL, *buf = NULL;
+  int kernels[3] = { ak_kuznechik_kernel_base, ak_kuznechik_kernel_ssse3,
+                                                                   ak_kuznechik_kernel_compact };
+  const char *names[3] = { "base", "ssse3", "compact" };
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  in = malloc( packets_count*max_blocks*16 );
+  out = malloc( packets_count*max_blocks*16 );
+  buf = malloc( packets_count*max_blocks*16 );
+  for( i = 0; i < packets_count*max_blocks*16; i++ ) in[i] = (ak_uint8)( 17*i+3 );
+
+  for( oc = 0; oc < 2; oc++ ) {
+     ak_libakrypt_set_option( "openssl_compability", oc );
+     for( k = 0; k < 3; k++ ) {
+        bool_t equal = ak_true;
+        if( !ak_kuznechik_kernel_is_available( kernels[k] )) continue;
+        ak_libakrypt_set_option( "kuznechik_kernel", kernels[k] );
+
+        for( i = 0; i < keys_count; i++ ) {
+           for( j = 0; j < sizeof( key ); j++ ) key[j] = (ak_uint8)( 11*j+7*i+1 );
+           ak_bckey_context_create_kuznechik( keys+i );
+           ak_bckey_context_set_key( keys+i, key, sizeof( key ));
+        }
+       /* пакеты различной длины, в том числе пустые; ключи пакетов перемешаны */
+        for( i = 0; i < packets_count; i++ ) {
+           batch[i].bkey = keys + ( 7*i )%keys_count;
+           batch[i].blocks = ( 3*i )%( max_blocks+1 );
+           batch[i].in = in + 16*max_blocks*i;
+           batch[i].out = buf + 16*max_blocks*i;
+        }
+        for( i = 0; i < packets_count; i++ )
+           ak_bckey_context_encrypt_ecb( batch[i].bkey, batch[i].in,
+                                                out + 16*max_blocks*i, 16*batch[i].blocks );
+       /* каждый третий пакет зашифровывается на месте */
+        for( i = 0; i < packets_count; i += 3 ) {
+           memcpy( batch[i].out, batch[i].in, 16*batch[i].blocks );
+           batch[i].in = batch[i].out;
+        }
+        if( ak_kuznechik_encrypt_batch( batch, packets_count ) != ak_error_ok ) equal = ak_false;
+        for( i = 0; i < packets_count; i++ )
+           if( !ak_ptr_is_equal( out + 16*max_blocks*i, buf + 16*max_blocks*i,
+                                                                         16*batch[i].blocks )) {
+             printf("packet %u: Wrong\n", (unsigned int) i );
+             equal = ak_false;
+           }
+        printf("%-8s (oc = %d): batch encryption of %u packets is %s\n", names[k], oc,
+                                                packets_count, equal ? "Ok" : "Wrong" );
+        if( !equal ) result = EXIT_FAILURE;
+        for( i = 0; i < keys_count; i++ ) ak_bckey_context_destroy( keys+i );
+     }
+  }
+  ak_libakrypt_set_option( "openssl_compability", 0 );
+  ak_libakrypt_set_option( "kuznechik_kernel", ak_kuznechik_kernel_auto );
+
+ /* ключи других алгоритмов не принимаются */
+  for( i = 0; i < keys_count; i++ ) {
+     for( j = 0; j < sizeof( key ); j++ ) key[j] = (ak_uint8)( 11*j+7*i+1 );
+     ak_bckey_context_create_kuznechik( keys+i );
+     ak_bckey_context_set_key( keys+i, key, sizeof( key ));
+  }
+  ak_bckey_context_create_magma( &magma );
+  ak_bckey_context_set_key( &magma, key, sizeof( key ));
+  batch[0].bkey = &magma;
+  batch[0].blocks = 1;
+  if( ak_kuznechik_encrypt_batch( batch, 1 ) == ak_error_ok ) {
+    printf("magma key is accepted: Wrong\n");
+    result = EXIT_FAILURE;
+  }
+  ak_error_set_value( ak_error_ok );
+  ak_bckey_context_destroy( &magma );
+
+ /* сравниваем скорость для пакетов из двух блоков, каждый из которых использует свой ключ */
+  for( i = 0; i < packets_count; i++ ) {
+     batch[i].bkey = keys + i%keys_count;
+     batch[i].blocks = 2;
+     batch[i].in = in + 16*max_blocks*i;
+     batch[i].out = buf + 16*max_blocks*i;
+  }
+  timea = clock();
+  for( j = 0; j < 200; j++ )
+     for( i = 0; i < packets_count; i++ )
+        ak_bckey_context_encrypt_ecb( batch[i].bkey, batch[i].in, batch[i].out, 32 );
+  one = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  timea = clock();
+  for( j = 0; j < 200; j++ ) ak_kuznechik_encrypt_batch( batch, packets_count );
+  many = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  printf("sequential: %.2f MBs, batch: %.2f MBs\n",
+                                    200.*packets_count*32/( 1024*1024*( one > 0 ? one : 1e-9 )),
+                                    200.*packets_count*32/( 1024*1024*( many > 0 ? many : 1e-9 )));
+
+  for( i = 0; i < keys_count; i++ ) ak_bckey_context_destroy( keys+i );
+  free( in ); free( out ); free( buf );
+
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,175 @@
+/* Тестовый пример проверяет, что шифрование в режиме гаммирования с использованием заранее
+   выработанной гаммы (функции ak_bckey_context_set_ctr_reservoir() и
+   ak_bckey_context_ctr_reservoir_fill()) дает тот же результат, что и обычное шифрование
+   функцией ak_bckey_context_ctr(), а ресурс ключа учитывает каждый выработанный блок гаммы.
+   Также проверяется, что гамма хранится в резервуаре в маскированном виде.
+   Также выводится время шифрования коротких пакетов с использованием резервуара и без него
+   (время заполнения резервуара не учитывается).
+   Внимание! Используются не экспортируемые функции.
+
+   test-bckey17.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_bckey.h>
+ #include <ak_tools.h>
+
+ #define message_size   (8192)
+ #define reservoir_length (1024)
+ #define packet_size    (64)
+ #define packets_count  (16384)
+
+/* сравнение результатов шифрования одного и того же фрагмента на двух ключах */
+ static bool_t compare( ak_bckey one, ak_bckey two, ak_uint8 *in, size_t size,
+                                                          ak_uint8 *iv, size_t iv_size )
+{
+  ak_uint8 out1[message_size], out2[message_size];
+  int error1 = ak_bckey_context_ctr( one, in, out1, size, iv, iv_size );
+  int error2 = ak_bckey_context_ctr( two, in, out2, size, iv, iv_size );
+
+  if( error1 != error2 ) return ak_false;
+  if( error1 != ak_error_ok ) return ak_true;
+ return ak_ptr_is_equal( out1, out2, size );
+}
+
+/* проверка того, что резервуар не содержит гамму в открытом виде: сумма маскированной гаммы
+   и маски совпадает с гаммой, а маскированная гамма изменяется после использования ключа;
+   ключ one, шифрующий без резервуара, обрабатывает те же данные */
+ static bool_t masked( ak_bckey one, ak_bckey bkey, ak_uint8 *in )
+{
+  size_t i;
+  bool_t result = ak_true;
+  ak_uint8 copy[reservoir_length], gamma[reservoir_length], zero[reservoir_length];
+  ak_uint8 *ptr = bkey->reservoir + bkey->reservoir_offset;
+  size_t count = bkey->reservoir_count - bkey->bsize;
+
+  if( bkey->reservoir_count <= bkey->bsize ) return ak_true;
+  memcpy( copy, ptr + bkey->bsize, count );
+  for( i = 0; i < count; i++ )
+     gamma[i] = ptr[bkey->bsize+i]^ptr[bkey->reservoir_size+bkey->bsize+i];
+ /* используем один блок гаммы, при этом ключ и оставшаяся гамма перемаскируются */
+  ak_bckey_context_ctr( bkey, in, zero, bkey->bsize, NULL, 0 );
+  ak_bckey_context_ctr( one, in, zero, bkey->bsize, NULL, 0 );
+  ptr = bkey->reservoir + bkey->reservoir_offset;
+  if( ak_ptr_is_equal( copy, ptr, count )) result = ak_false;
+  for( i = 0; i < count; i++ )
+     if(( ptr[i]^ptr[bkey->reservoir_size+i] ) != gamma[i] ) result = ak_false;
+ /* гамма совпадает с результатом шифрования нулевых данных */
+  memset( zero, 0, count );
+  ak_bckey_context_ctr( bkey, zero, zero, count, NULL, 0 );
+  if( !ak_ptr_is_equal( zero, gamma, count )) result = ak_false;
+  memset( zero, 0, count );
+  ak_bckey_context_ctr( one, zero, zero, count, NULL, 0 );
+  if( !ak_ptr_is_equal( zero, gamma, count )) result = ak_false;
+  if( ak_ptr_is_equal( copy, gamma, count )) result = ak_false;
+ return result;
+}
+
+ static bool_t test_reservoir( ak_function_bckey_create *create, const char *name, const int oc )
+{
+  size_t i;
+  bool_t result = ak_true;
+  struct bckey one, two;
+  ak_uint8 key[32], iv[16], in[message_size];
+  size_t sizes[7] = { 64, 48, 256, 2048, 16, 1024, 512 };
+
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 3*i+1 );
+  for( i = 0; i < sizeof( iv ); i++ ) iv[i] = (ak_uint8)( 5*i+7 );
+  for( i = 0; i < sizeof( in ); i++ ) in[i] = (ak_uint8)( 11*i+13 );
+
+  ak_libakrypt_set_option( "openssl_compability", oc );
+  create( &one ); ak_bckey_context_set_key( &one, key, sizeof( key ));
+  create( &two ); ak_bckey_context_set_key( &two, key, sizeof( key ));
+  ak_bckey_context_set_ctr_reservoir( &two, reservoir_length );
+
+ /* синхропосылка задается при заполнении резервуара, далее используются фрагменты различной
+    длины; часть из них превышает объем гаммы в резервуаре */
+  ak_bckey_context_ctr( &one, in, in, 0, iv, sizeof( iv ));
+  ak_bckey_context_ctr_reservoir_fill( &two, iv, sizeof( iv ));
+  for( i = 0; i < 7; i++ ) {
+     if( !compare( &one, &two, in, sizes[i], NULL, 0 )) result = ak_false;
+     if( i%2 ) ak_bckey_context_ctr_reservoir_fill( &two, NULL, 0 );
+  }
+ /* гамма хранится в маскированном виде, маска меняется при перемаскировании ключа */
+  ak_bckey_context_ctr_reservoir_fill( &two, NULL, 0 );
+  if( !masked( &one, &two, in )) result = ak_false;
+
+ /* ресурс отличается ровно на количество неиспользованных блоков гаммы */
+  if( one.key.resource.value.counter - two.key.resource.value.counter !=
+                                                  (ak_int64)( two.reservoir_count/two.bsize )) {
+    printf("%s: wrong resource accounting\n", name );
+    result = ak_false;
+  }
+
+ /* последний неполный блок берется из резервуара, после чего продолжение невозможно */
+  ak_bckey_context_ctr_reservoir_fill( &two, NULL, 0 );
+  if( !compare( &one, &two, in, 3*one.bsize + 5, NULL, 0 )) result = ak_false;
+  if( two.reservoir_count != 0 ) result = ak_false;
+  if( ak_bckey_context_ctr( &two, in, in, 16, NULL, 0 ) == ak_error_ok ) result = ak_false;
+  ak_error_set_value( ak_error_ok );
+
+ /* новая синхропосылка уничтожает содержимое резервуара */
+  ak_bckey_context_ctr_reservoir_fill( &two, iv, sizeof( iv ));
+  iv[0] ^= 0xaa;
+  if( !compare( &one, &two, in, 208, iv, sizeof( iv ))) result = ak_false;
+  if( two.reservoir_count != 0 ) result = ak_false;
+  if( !compare( &one, &two, in, 320, NULL, 0 )) result = ak_false;
+
+  printf("%s (oc = %d): reservoir is %s\n", name, oc, result ? "Ok" : "Wrong" );
+  ak_bckey_context_destroy( &one );
+  ak_bckey_context_destroy( &two );
+ return result;
+}
+
+ int main( void )
+{
+  size_t i;
+  int oc, result = EXIT_SUCCESS;
+  clock_t timea, total = 0;
+  double one = 0, many = 0;
+  struct bckey bkey;
+  ak_uint8 key[32], iv[8] = { 0x12, 0x34, 0x56, 0x78, 0x90, 0xab, 0xce, 0xf0 },
+           packet[packet_size];
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  for( oc = 0; oc < 2; oc++ ) {
+     if( !test_reservoir( ak_bckey_context_create_kuznechik, "kuznechik", oc ))
+       result = EXIT_FAILURE;
+     if( !test_reservoir( ak_bckey_context_create_magma, "magma", oc ))
+       result = EXIT_FAILURE;
+  }
+  ak_libakrypt_set_option( "openssl_compability", 0 );
+
+ /* сравниваем время шифрования коротких пакетов */
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 7*i+1 );
+  memset( packet, 0x13, sizeof( packet ));
+  ak_bckey_context_create_kuznechik( &bkey );
+  ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+
+  ak_bckey_context_ctr( &bkey, packet, packet, 0, iv, sizeof( iv ));
+  timea = clock();
+  for( i = 0; i < packets_count; i++ )
+     ak_bckey_context_ctr( &bkey, packet, packet, packet_size, NULL, 0 );
+  one = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+
+  ak_bckey_context_set_ctr_reservoir( &bkey, 16*packet_size );
+  ak_bckey_context_ctr_reservoir_fill( &bkey, iv, sizeof( iv ));
+  for( i = 0; i < packets_count; i += 16 ) {
+     size_t j;
+     ak_bckey_context_ctr_reservoir_fill( &bkey, NULL, 0 );
+     timea = clock();
+     for( j = 0; j < 16; j++ ) ak_bckey_context_ctr( &bkey, packet, packet, packet_size, NULL, 0 );
+     total += clock() - timea;
+  }
+  many = (double) total/(double) CLOCKS_PER_SEC;
+  printf("%u packets of %u bytes: direct %.3f sec, with reservoir %.3f sec\n",
+                                     packets_count, packet_size, one, many );
+  ak_bckey_context_destroy( &bkey );
+
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,103 @@
+/* Тестовый пример проверяет, что вычисление хеш-кода и имитовставок HMAC и OMAC
+   для данных, расположенных в нескольких несмежных фрагментах (функции
+   ak_hash_context_finalize_fragments(), ak_hmac_context_update_fragments() и т.п.),
+   дает тот же результат, что и вычисление для объединенных данных.
+   Фрагменты имеют произвольные длины, в том числе нулевые и не кратные длине блока.
+   Внимание! Используются неэкспортируемые функции.
+
+   test-hash05.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_hash.h>
+ #include <ak_hmac.h>
+ #include <ak_omac.h>
+ #include <ak_tools.h>
+
+ #define message_size (2000)
+ #define max_fragments (512)
+
+ int main( void )
+{
+  size_t i, j, k, len, count, offset, seed;
+  int result = EXIT_SUCCESS;
+  struct hash hctx;
+  struct hmac hmac;
+  struct omac omac;
+  struct fragment fragments[max_fragments];
+  ak_uint8 key[32], out[64], out2[64], in[message_size], spread[message_size + max_fragments];
+  const char *names[4] = { "streebog256", "streebog512", "hmac (streebog512)", "omac (kuznechik)" };
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 7*i+3 );
+  for( i = 0; i < message_size; i++ ) in[i] = (ak_uint8)( 11*i+5 );
+
+  ak_hash_context_create_streebog256( &hctx );
+  for( k = 0; k < 4; k++ ) {
+     int ok = ak_true;
+
+     switch( k ) {
+       case 1: ak_hash_context_destroy( &hctx );
+               ak_hash_context_create_streebog512( &hctx );
+               break;
+       case 2: ak_hmac_context_create_streebog512( &hmac );
+               ak_hmac_context_set_key( &hmac, key, sizeof( key ));
+               break;
+       case 3: ak_omac_context_create_kuznechik( &omac );
+               ak_omac_context_set_key( &omac, key, sizeof( key ));
+               break;
+     }
+
+     for( j = 0; j < 20; j++ ) {
+        len = message_size - 97*j;
+       /* результат для объединенных данных */
+        memset( out, 0, sizeof( out ));
+        switch( k ) {
+          case 0:
+          case 1: ak_hash_context_ptr( &hctx, in, len, out, sizeof( out )); break;
+          case 2: ak_hmac_context_ptr( &hmac, in, len, out, sizeof( out )); break;
+          case 3: ak_omac_context_ptr( &omac, in, len, out, 16 ); break;
+        }
+       /* разбиваем данные на фрагменты, расположенные с промежутками */
+        for( count = 0, offset = 0, seed = j+1; offset < len; count++ ) {
+           seed = seed*1103515245 + 12345;
+           fragments[count].size = ak_min( len - offset, seed%( count%5 == 4 ? 300 : 70 ));
+           fragments[count].data = spread + offset + count;
+           memcpy( fragments[count].data, in + offset, fragments[count].size );
+           offset += fragments[count].size;
+        }
+       /* первая часть фрагментов обрабатывается функцией update, остальные - finalize */
+        memset( out2, 0, sizeof( out2 ));
+        switch( k ) {
+          case 0:
+          case 1: ak_hash_context_clean( &hctx );
+                  ak_hash_context_update_fragments( &hctx, fragments, count/2 );
+                  ak_hash_context_finalize_fragments( &hctx, fragments + count/2,
+                                                      count - count/2, out2, sizeof( out2 ));
+                  break;
+          case 2: ak_hmac_context_clean( &hmac );
+                  ak_hmac_context_update_fragments( &hmac, fragments, count/2 );
+                  ak_hmac_context_finalize_fragments( &hmac, fragments + count/2,
+                                                      count - count/2, out2, sizeof( out2 ));
+                  break;
+          case 3: ak_omac_context_clean( &omac );
+                  ak_omac_context_update_fragments( &omac, fragments, count/2 );
+                  ak_omac_context_finalize_fragments( &omac, fragments + count/2,
+                                                                  count - count/2, out2, 16 );
+                  break;
+        }
+        if( !ak_ptr_is_equal( out, out2, sizeof( out ))) ok = ak_false;
+     }
+     printf("%s with fragments: %s\n", names[k], ok ? "Ok" : "Wrong" );
+     if( !ok ) result = EXIT_FAILURE;
+  }
+
+  ak_hash_context_destroy( &hctx );
+  ak_hmac_context_destroy( &hmac );
+  ak_omac_context_destroy( &omac );
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,79 @@
+/* Тестовый пример проверяет, что все реализации функции сжатия Стрибог, доступные на текущем
+   процессоре (опция библиотеки streebog_kernel), вырабатывают одинаковые хеш-коды для данных
+   различной длины, в том числе для длин, не кратных длине блока, и что по умолчанию
+   используется реализация с совмещенными таблицами. Также выводится
+   скорость хеширования для каждой реализации.
+   Внимание! Используются неэкспортируемые функции.
+
+   test-hash06.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_hash.h>
+ #include <ak_tools.h>
+
+ #define message_size (4096)
+ #define speed_size   (4*1024*1024)
+
+ int main( void )
+{
+  size_t i, len;
+  clock_t timea;
+  double sec = 0;
+  int k, result = EXIT_SUCCESS;
+  struct hash hctx;
+  ak_uint8 in[message_size], out[64], base[message_size/61+1][64], *data = NULL;
+  const char *names[5] = { "auto", "base", "fused", "sse2", "avx2" };
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  for( i = 0; i < message_size; i++ ) in[i] = (ak_uint8)( 7*i+11 );
+  data = malloc( speed_size );
+  memset( data, 0x5a, speed_size );
+
+  for( k = ak_streebog_kernel_base; k <= ak_streebog_kernel_avx2; k++ ) {
+     bool_t equal = ak_true;
+     if( !ak_streebog_kernel_is_available( k )) {
+       printf("%-6s: not available\n", names[k] );
+       continue;
+     }
+     ak_libakrypt_set_option( "streebog_kernel", k );
+
+    /* хеш-коды длиной 512 и 256 бит для сообщений различной длины */
+     for( len = 0, i = 0; len < message_size; len += 61, i++ ) {
+        ak_hash_context_create_streebog512( &hctx );
+        ak_hash_context_ptr( &hctx, in, len, out, 64 );
+        ak_hash_context_destroy( &hctx );
+        ak_hash_context_create_streebog256( &hctx );
+        ak_hash_context_ptr( &hctx, in, len, out+32, 32 );
+        ak_hash_context_destroy( &hctx );
+
+        if( k == ak_streebog_kernel_base ) memcpy( base[i], out, 64 );
+          else if( !ak_ptr_is_equal( base[i], out, 64 )) equal = ak_false;
+     }
+     if( !equal ) result = EXIT_FAILURE;
+
+    /* скорость хеширования */
+     ak_hash_context_create_streebog512( &hctx );
+     timea = clock();
+     ak_hash_context_ptr( &hctx, data, speed_size, out, 64 );
+     sec = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+     ak_hash_context_destroy( &hctx );
+
+     printf("%-6s: %s, speed = %8.2f MBs\n", names[k], equal ? "Ok" : "Wrong",
+                                         speed_size/( 1024*1024*( sec > 0 ? sec : 1e-9 )));
+  }
+  ak_libakrypt_set_option( "streebog_kernel", ak_streebog_kernel_auto );
+  ak_hash_context_create_streebog512( &hctx );
+  printf("auto  : kernel %d\n", hctx.data.sctx.kernel );
+ /* векторные реализации выбираются только явно */
+  if( hctx.data.sctx.kernel != ak_streebog_kernel_fused ) result = EXIT_FAILURE;
+  ak_hash_context_destroy( &hctx );
+
+  free( data );
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,88 @@
+/* Тестовый пример проверяет, что одновременное хеширование нескольких независимых сообщений
+   функцией ak_hash_context_ptr_jobs() дает тот же результат, что и последовательные вызовы
+   функции ak_hash_context_ptr() для каждого сообщения. Сообщения имеют различные длины,
+   в том числе нулевую и кратную длине блока. Также выводится скорость хеширования
+   коротких сообщений.
+   Внимание! Используются неэкспортируемые функции.
+
+   test-hash07.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_hash.h>
+ #include <ak_tools.h>
+
+ #define jobs_count   (67)
+ #define message_size (1024)
+ #define record_size  (320)
+ #define records      (4096)
+
+ int main( void )
+{
+  size_t i, j;
+  clock_t timea;
+  double one = 0, many = 0;
+  int k, result = EXIT_SUCCESS;
+  struct hash hctx;
+  struct hash_job jobs[records];
+  ak_uint8 *in = NULL, out[jobs_count][64], buf[jobs_count][64];
+  const char *names[2] = { "streebog256", "streebog512" };
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  in = malloc( records*record_size );
+  for( i = 0; i < records*record_size; i++ ) in[i] = (ak_uint8)( 13*i+5 );
+
+  for( k = 0; k < 2; k++ ) {
+     bool_t equal = ak_true;
+     if( k ) ak_hash_context_create_streebog512( &hctx );
+       else ak_hash_context_create_streebog256( &hctx );
+
+    /* сообщения различной длины, в том числе пустые и кратные длине блока */
+     for( i = 0; i < jobs_count; i++ ) {
+        jobs[i].in = in + i*message_size/4;
+        jobs[i].size = ( i%5 == 0 ) ? 64*( i%17 ) : ( 97*i )%message_size;
+        jobs[i].out = buf[i];
+        ak_hash_context_ptr( &hctx, jobs[i].in, jobs[i].size, out[i], 64 );
+     }
+     if( ak_hash_context_ptr_jobs( &hctx, jobs, jobs_count ) != ak_error_ok ) equal = ak_false;
+     for( i = 0; i < jobs_count; i++ )
+        if( !ak_ptr_is_equal( out[i], buf[i], ak_hash_context_get_tag_size( &hctx ))) {
+          printf("job %u: Wrong\n", (unsigned int) i );
+          equal = ak_false;
+        }
+    /* количество сообщений, меньшее числа дорожек */
+     if( ak_hash_context_ptr_jobs( &hctx, jobs+3, 2 ) != ak_error_ok ) equal = ak_false;
+     if( !ak_ptr_is_equal( out[3], buf[3], ak_hash_context_get_tag_size( &hctx ))) equal = ak_false;
+     printf("%s: hashing of %u jobs is %s\n", names[k], jobs_count, equal ? "Ok" : "Wrong" );
+     if( !equal ) result = EXIT_FAILURE;
+     ak_hash_context_destroy( &hctx );
+  }
+
+ /* сравниваем скорость для коротких записей */
+  ak_hash_context_create_streebog256( &hctx );
+  for( i = 0; i < records; i++ ) {
+     jobs[i].in = in + i*record_size;
+     jobs[i].size = record_size;
+     jobs[i].out = out[i%jobs_count];
+  }
+  timea = clock();
+  for( j = 0; j < 10; j++ )
+     for( i = 0; i < records; i++ )
+        ak_hash_context_ptr( &hctx, jobs[i].in, jobs[i].size, jobs[i].out, 32 );
+  one = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  timea = clock();
+  for( j = 0; j < 10; j++ ) ak_hash_context_ptr_jobs( &hctx, jobs, records );
+  many = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  printf("records of %u bytes: sequential %.2f MBs, jobs %.2f MBs\n", record_size,
+                                    10.*records*record_size/( 1024*1024*( one > 0 ? one : 1e-9 )),
+                                    10.*records*record_size/( 1024*1024*( many > 0 ? many : 1e-9 )));
+  ak_hash_context_destroy( &hctx );
+
+  free( in );
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,138 @@
+/* Тестовый пример проверяет режим древовидного хеширования streebog512-tree. Результаты
+   многопоточного хеширования области памяти (функция ak_hash_context_ptr()) и файла
+   (функция ak_hash_context_file()), а также последовательного хеширования фрагментами
+   различной длины, сравниваются с результатом прямого построения дерева при помощи функции
+   Стрибог512. Также выводится скорость хеширования в сравнении с функцией Стрибог512.
+   Внимание! Используются неэкспортируемые функции.
+
+   test-hash08.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <ak_hash.h>
+ #include <ak_tools.h>
+
+ #define leaf_size    (1024)
+ #define speed_size   (32*1024*1024)
+ #define file_name    "test-hash08.dat"
+
+/* хеш-код функции Стрибог512 от блока-префикса и данных */
+ static void streebog512_prefix( ak_uint8 type, const ak_uint8 *in, size_t size, ak_uint8 *out )
+{
+  size_t i;
+  struct hash ctx;
+  ak_uint8 *buffer = malloc( size + 64 );
+
+  memset( buffer, 0, 64 );
+  buffer[0] = type;
+  buffer[1] = ak_streebog_tree_fanout;
+  for( i = 0; i < 8; i++ ) buffer[8+i] = (ak_uint8)(( ak_uint64 ) leaf_size >> ( 8*i ));
+  if( size ) memcpy( buffer + 64, in, size );
+  ak_hash_context_create_streebog512( &ctx );
+  ak_hash_context_ptr( &ctx, buffer, size + 64, out, 64 );
+  ak_hash_context_destroy( &ctx );
+  free( buffer );
+}
+
+/* прямое построение дерева: уровни вычисляются один за другим */
+ static void tree_reference( const ak_uint8 *in, size_t size, ak_uint8 *out )
+{
+  size_t i, count = size ? ( size + leaf_size - 1 )/leaf_size : 1;
+  ak_uint8 *level = malloc( 64*count ), top[72];
+
+  for( i = 0; i < count; i++ )
+     streebog512_prefix( 0, in + i*leaf_size,
+                 i+1 < count ? leaf_size : size - i*leaf_size, level + 64*i );
+  while( count > 1 ) {
+     size_t next = ( count + ak_streebog_tree_fanout - 1 )/ak_streebog_tree_fanout;
+     for( i = 0; i < next; i++ )
+        streebog512_prefix( 1, level + 64*ak_streebog_tree_fanout*i,
+                  64*ak_min( ak_streebog_tree_fanout, count - ak_streebog_tree_fanout*i ),
+                                                                                level + 64*i );
+     count = next;
+  }
+  memcpy( top, level, 64 );
+  for( i = 0; i < 8; i++ ) top[64+i] = (ak_uint8)(( ak_uint64 ) size >> ( 8*i ));
+  streebog512_prefix( 2, top, 72, out );
+  free( level );
+}
+
+ int main( void )
+{
+  FILE *fp = NULL;
+  clock_t timea;
+  struct hash ctx;
+  size_t i, j, offset;
+  int result = EXIT_SUCCESS;
+  double one = 0, tree = 0;
+  ak_uint8 *in = NULL, out[64], ref[64];
+  size_t sizes[11] = { 0, 1, 1000, 1024, 1025, 16*1024, 16*1024+1, 17*1024,
+                                                  259*1024+7, 257*1024, 4097*1024+64 };
+  size_t chunks[3] = { 64, 960, 4096 };
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  in = malloc( speed_size );
+  for( i = 0; i < speed_size; i++ ) in[i] = (ak_uint8)( 7*i+3 );
+
+  ak_libakrypt_set_option( "streebog_tree_leaf_size", leaf_size );
+  ak_libakrypt_set_option( "hash_thread_count", 3 );
+  for( i = 0; i < 11; i++ ) {
+     bool_t equal = ak_true;
+     tree_reference( in, sizes[i], ref );
+     ak_hash_context_create_oid( &ctx, ak_oid_context_find_by_name( "streebog512-tree" ));
+
+    /* многопоточное хеширование области памяти */
+     ak_hash_context_ptr( &ctx, in, sizes[i], out, 64 );
+     if( !ak_ptr_is_equal( out, ref, 64 )) equal = ak_false;
+
+    /* последовательное хеширование фрагментами, кратными длине блока */
+     for( j = 0; j < 3; j++ ) {
+        ak_hash_context_clean( &ctx );
+        for( offset = 0; offset + chunks[j] <= sizes[i]; offset += chunks[j] )
+           ak_hash_context_update( &ctx, in + offset, chunks[j] );
+        ak_hash_context_finalize( &ctx, in + offset, sizes[i] - offset, out, 64 );
+        if( !ak_ptr_is_equal( out, ref, 64 )) equal = ak_false;
+     }
+
+    /* многопоточное хеширование файла */
+     if(( fp = fopen( file_name, "wb" )) != NULL ) {
+       fwrite( in, 1, sizes[i], fp );
+       fclose( fp );
+       ak_hash_context_file( &ctx, file_name, out, 64 );
+       if( !ak_ptr_is_equal( out, ref, 64 )) equal = ak_false;
+       remove( file_name );
+     }
+     ak_hash_context_destroy( &ctx );
+
+     printf("%8u bytes: %s\n", (unsigned int) sizes[i], equal ? "Ok" : "Wrong" );
+     if( !equal ) result = EXIT_FAILURE;
+  }
+
+ /* сравниваем скорость со скоростью функции Стрибог512 */
+  ak_libakrypt_set_option( "streebog_tree_leaf_size", 1048576 );
+  ak_libakrypt_set_option( "hash_thread_count", 0 );
+  ak_hash_context_create_streebog512( &ctx );
+  timea = clock();
+  ak_hash_context_ptr( &ctx, in, speed_size, out, 64 );
+  one = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  ak_hash_context_destroy( &ctx );
+
+  ak_hash_context_create_streebog512_tree( &ctx );
+  timea = clock();
+  ak_hash_context_ptr( &ctx, in, speed_size, out, 64 );
+  tree = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  ak_hash_context_destroy( &ctx );
+ /* функция clock() учитывает время работы всех потоков, поэтому выводится
+    суммарная скорость обработки данных одним процессорным ядром */
+  printf("streebog512: %.2f MBs, streebog512-tree: %.2f MBs (cpu time)\n",
+                                    speed_size/( 1024*1024*( one > 0 ? one : 1e-9 )),
+                                    speed_size/( 1024*1024*( tree > 0 ? tree : 1e-9 )));
+
+  free( in );
+  ak_libakrypt_destroy();
+ return result;
+}
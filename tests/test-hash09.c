@@ -0,0 +1,159 @@
+/* Тестовый пример проверяет копирование, сохранение и восстановление промежуточного состояния
+   функций хеширования Стрибог256, Стрибог512, режима streebog512-tree и алгоритма HMAC.
+   Вычисления, продолженные в копии контекста (функции ak_hash_context_clone(),
+   ak_hash_context_copy_state() и ak_hmac_context_clone()) или в контексте, восстановленном
+   из сохраненного состояния (функции ak_hash_context_export(), ak_hash_context_import(),
+   ak_hmac_context_export() и ak_hmac_context_import()), должны давать тот же результат,
+   что и однократное хеширование всего сообщения. Также проверяется, что поврежденное
+   состояние не принимается.
+   Внимание! Используются неэкспортируемые функции.
+
+   test-hash09.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_hmac.h>
+ #include <ak_tools.h>
+
+ #define message_size (5000)
+ #define state_size   (8192)
+
+/* хеширование сообщения, обработка которого продолжается в копиях и восстановленном контексте */
+ static bool_t test_hash( const char *name, ak_uint8 *in )
+{
+  struct hash one, two, three;
+  bool_t result = ak_true;
+  size_t i, j, size, prefixes[6] = { 0, 17, 64, 1024, 1100, 3072 };
+  ak_uint8 state[state_size], ref[64], out[64];
+
+  for( i = 0; i < 6; i++ ) {
+     ak_hash_context_create_oid( &one, ak_oid_context_find_by_name( name ));
+     ak_hash_context_ptr( &one, in, message_size, ref, sizeof( ref ));
+
+    /* обрабатываем префикс, фрагменты имеют длину, не кратную длине блока */
+     ak_hash_context_clean( &one );
+     for( j = 0; j + 13 <= prefixes[i]; j += 13 ) ak_hash_context_update( &one, in + j, 13 );
+     ak_hash_context_update( &one, in + j, prefixes[i] - j );
+
+    /* копия и восстановленный контекст */
+     ak_hash_context_clone( &two, &one );
+     size = sizeof( state );
+     if( ak_hash_context_export( &one, state, &size ) != ak_error_ok ) result = ak_false;
+     if( ak_hash_context_import( &three, state, size ) != ak_error_ok ) {
+       ak_hash_context_destroy( &one );
+       ak_hash_context_destroy( &two );
+       printf("%s: import is Wrong\n", name );
+       return ak_false;
+     }
+
+     ak_hash_context_update( &two, in + prefixes[i], message_size - prefixes[i] );
+     ak_hash_context_finalize( &two, NULL, 0, out, sizeof( out ));
+     if( !ak_ptr_is_equal( out, ref, ak_hash_context_get_tag_size( &one ))) result = ak_false;
+
+     ak_hash_context_update( &three, in + prefixes[i], message_size - prefixes[i] );
+     ak_hash_context_finalize( &three, NULL, 0, out, sizeof( out ));
+     if( !ak_ptr_is_equal( out, ref, ak_hash_context_get_tag_size( &one ))) result = ak_false;
+
+    /* повторное использование контекста: состояние копируется без выделения памяти */
+     ak_hash_context_clean( &three );
+     ak_hash_context_copy_state( &three, &one );
+     ak_hash_context_update( &three, in + prefixes[i], message_size - prefixes[i] );
+     ak_hash_context_finalize( &three, NULL, 0, out, sizeof( out ));
+     if( !ak_ptr_is_equal( out, ref, ak_hash_context_get_tag_size( &one ))) result = ak_false;
+
+    /* исходный контекст не изменился */
+     ak_hash_context_update( &one, in + prefixes[i], message_size - prefixes[i] );
+     ak_hash_context_finalize( &one, NULL, 0, out, sizeof( out ));
+     if( !ak_ptr_is_equal( out, ref, ak_hash_context_get_tag_size( &one ))) result = ak_false;
+
+    /* поврежденное или усеченное состояние не принимается */
+     ak_hash_context_destroy( &two );
+     if( ak_hash_context_import( &two, state, size-1 ) == ak_error_ok ) result = ak_false;
+     state[4] ^= 0x10;
+     if( ak_hash_context_import( &two, state, size ) == ak_error_ok ) result = ak_false;
+     ak_error_set_value( ak_error_ok );
+
+     ak_hash_context_destroy( &one );
+     ak_hash_context_destroy( &three );
+  }
+  printf("%s: %s\n", name, result ? "Ok" : "Wrong" );
+ return result;
+}
+
+/* выработка имитовставки, вычисление которой продолжается в копии и восстановленном контексте */
+ static bool_t test_hmac( ak_uint8 *in )
+{
+  struct hash hctx;
+  struct hmac one, two, three;
+  bool_t result = ak_true;
+  size_t size = 0, j = 0, prefix = 1111;
+  ak_uint8 key[32], state[state_size], ref[64], out[64];
+
+  for( j = 0; j < sizeof( key ); j++ ) key[j] = (ak_uint8)( 5*j+1 );
+  ak_hmac_context_create_streebog512( &one );
+  ak_hmac_context_set_key( &one, key, sizeof( key ));
+  ak_hmac_context_ptr( &one, in, message_size, ref, sizeof( ref ));
+
+  ak_hmac_context_clean( &one );
+  ak_hmac_context_update( &one, in, prefix );
+  if( ak_hmac_context_clone( &two, &one ) != ak_error_ok ) return ak_false;
+  ak_hmac_context_finalize( &two, in + prefix, message_size - prefix, out, sizeof( out ));
+  if( !ak_ptr_is_equal( out, ref, 64 )) result = ak_false;
+
+ /* маска ключа копии отличается от маски ключа исходного контекста */
+  if( ak_ptr_is_equal( one.key.key, two.key.key, one.key.key_size )) result = ak_false;
+
+ /* восстановление состояния в контексте с тем же значением ключа */
+  size = sizeof( state );
+  ak_hmac_context_export( &one, state, &size );
+  ak_hmac_context_create_streebog512( &three );
+  ak_hmac_context_set_key( &three, key, sizeof( key ));
+  if( ak_hmac_context_import( &three, state, size ) != ak_error_ok ) result = ak_false;
+  ak_hmac_context_finalize( &three, in + prefix, message_size - prefix, out, sizeof( out ));
+  if( !ak_ptr_is_equal( out, ref, 64 )) result = ak_false;
+
+ /* состояние алгоритма HMAC не является состоянием функции хеширования, и наоборот */
+  if( ak_hash_context_import( &hctx, state, size ) == ak_error_ok ) {
+    ak_hash_context_destroy( &hctx );
+    result = ak_false;
+  }
+  ak_hash_context_create_streebog512( &hctx );
+  ak_hash_context_update( &hctx, in, prefix );
+  size = sizeof( state );
+  ak_hash_context_export( &hctx, state, &size );
+  if( ak_hmac_context_import( &three, state, size ) == ak_error_ok ) result = ak_false;
+  ak_hash_context_destroy( &hctx );
+  ak_error_set_value( ak_error_ok );
+
+  ak_hmac_context_finalize( &one, in + prefix, message_size - prefix, out, sizeof( out ));
+  if( !ak_ptr_is_equal( out, ref, 64 )) result = ak_false;
+
+  ak_hmac_context_destroy( &one );
+  ak_hmac_context_destroy( &two );
+  ak_hmac_context_destroy( &three );
+  printf("hmac-streebog512: %s\n", result ? "Ok" : "Wrong" );
+ return result;
+}
+
+ int main( void )
+{
+  size_t i;
+  int result = EXIT_SUCCESS;
+  ak_uint8 in[message_size];
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+  for( i = 0; i < message_size; i++ ) in[i] = (ak_uint8)( 3*i+5 );
+
+  if( !test_hash( "streebog256", in )) result = EXIT_FAILURE;
+  if( !test_hash( "streebog512", in )) result = EXIT_FAILURE;
+ /* короткие листья, чтобы дерево содержало несколько уровней */
+  ak_libakrypt_set_option( "streebog_tree_leaf_size", 64 );
+  if( !test_hash( "streebog512-tree", in )) result = EXIT_FAILURE;
+  ak_libakrypt_set_option( "streebog_tree_leaf_size", 1048576 );
+  if( !test_hmac( in )) result = EXIT_FAILURE;
+
+  ak_libakrypt_destroy();
+ return result;
+}
@@ -0,0 +1,103 @@
+/* Тестовый пример проверяет функцию ak_hmac_context_pbkdf2_streebog512() для ключевых векторов
+   различной длины, в том числе превышающей длину хеш-кода, при различном количестве потоков
+   (опция библиотеки hash_thread_count). Результаты сравниваются с прямым вычислением
+   алгоритма PBKDF2 с помощью функции ak_hmac_context_ptr(). Также выводится время
+   выработки ключа в сравнении с прямым вычислением.
+   Внимание! Используются неэкспортируемые функции.
+
+   test-hmac03.c
+*/
+ #include <time.h>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_hmac.h>
+ #include <ak_tools.h>
+
+ #define max_dklen   (1000)
+ #define speed_count (20000)
+
+/* прямое вычисление: ключевой вектор длины не более 64 октетов образуют последние октеты
+   блока T1, вектор большей длины - первые октеты последовательности T1 || T2 || ... */
+ static void pbkdf2_reference( ak_uint8 *pass, size_t pass_size, ak_uint8 *salt,
+                                     size_t salt_size, size_t cnt, size_t dklen, ak_uint8 *out )
+{
+  struct hmac hctx;
+  size_t i, j, k, blocks = ( dklen + 63 )/64;
+  ak_uint8 counter[4] = { 0, 0, 0, 0 }, u[64], *t = malloc( 64*blocks );
+
+  ak_hmac_context_create_streebog512( &hctx );
+  ak_hmac_context_set_key( &hctx, pass, pass_size );
+  for( i = 0; i < blocks; i++ ) {
+     counter[3] = (ak_uint8)( i+1 );
+     ak_hmac_context_clean( &hctx );
+     ak_hmac_context_update( &hctx, salt, salt_size );
+     ak_hmac_context_finalize( &hctx, counter, 4, u, 64 );
+     memcpy( t + 64*i, u, 64 );
+     for( j = 1; j < cnt; j++ ) {
+        ak_hmac_context_ptr( &hctx, u, 64, u, 64 );
+        for( k = 0; k < 64; k++ ) t[64*i+k] ^= u[k];
+     }
+  }
+  if( dklen <= 64 ) memcpy( out, t + 64 - dklen, dklen );
+    else memcpy( out, t, dklen );
+  ak_hmac_context_destroy( &hctx );
+  free( t );
+}
+
+ int main( void )
+{
+  clock_t timea;
+  double ref = 0, fast = 0;
+  size_t i, j, t;
+  int result = EXIT_SUCCESS;
+  ak_uint8 out[max_dklen], out2[max_dklen];
+  ak_uint8 pass[8] = "password", salt[36] = "saltSALTsaltSALTsaltSALTsaltSALTsalt";
+  size_t lengths[8] = { 1, 32, 48, 64, 65, 100, 200, max_dklen };
+  size_t counts[4] = { 1, 2, 3, 100 };
+  ak_int64 threads[2] = { 1, 3 };
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  for( i = 0; i < 8; i++ ) {
+     bool_t equal = ak_true;
+     for( j = 0; j < 4; j++ ) {
+        pbkdf2_reference( pass, sizeof( pass ), salt, sizeof( salt ),
+                                                                  counts[j], lengths[i], out2 );
+        for( t = 0; t < 2; t++ ) {
+           ak_libakrypt_set_option( "hash_thread_count", threads[t] );
+           memset( out, 0, sizeof( out ));
+           if( ak_hmac_context_pbkdf2_streebog512( pass, sizeof( pass ), salt, sizeof( salt ),
+                                              counts[j], lengths[i], out ) != ak_error_ok )
+             equal = ak_false;
+           if( !ak_ptr_is_equal( out, out2, lengths[i] )) equal = ak_false;
+        }
+     }
+     printf("dklen %4u: %s\n", (unsigned int) lengths[i], equal ? "Ok" : "Wrong" );
+     if( !equal ) result = EXIT_FAILURE;
+  }
+  ak_libakrypt_set_option( "hash_thread_count", 0 );
+
+ /* недопустимая длина ключевого вектора */
+  if( ak_hmac_context_pbkdf2_streebog512( pass, sizeof( pass ),
+                                  salt, sizeof( salt ), 1, 0, out ) == ak_error_ok ) {
+    printf("zero dklen: Wrong\n");
+    result = EXIT_FAILURE;
+  }
+  ak_error_set_value( ak_error_ok );
+
+ /* сравниваем время выработки ключа с временем прямого вычисления */
+  timea = clock();
+  pbkdf2_reference( pass, sizeof( pass ), salt, sizeof( salt ), speed_count, 64, out2 );
+  ref = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  timea = clock();
+  ak_hmac_context_pbkdf2_streebog512( pass, sizeof( pass ),
+                                           salt, sizeof( salt ), speed_count, 64, out );
+  fast = (double)( clock() - timea )/(double) CLOCKS_PER_SEC;
+  if( !ak_ptr_is_equal( out, out2, 64 )) result = EXIT_FAILURE;
+  printf("%u iterations: reference %.3f sec, pbkdf2 %.3f sec\n",
+                                                       (unsigned int) speed_count, ref, fast );
+  ak_libakrypt_destroy();
+ return result;
+}
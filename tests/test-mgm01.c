@@ -0,0 +1,91 @@
+/* Тестовый пример проверяет, что зашифрование в режиме MGM однократным вызовом функции
+   ak_bckey_context_encrypt_mgm() и последовательностью вызовов функций
+   ak_mgm_context_clean()
+                 _authentication_update()
+                 _encryption_update()
+                 _finalize()
+   приводят к одинаковым результатам, а также корректность расшифрования на месте.
+   Внимание! Используются не экспортируемые функции.
+
+   test-mgm01.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_mgm.h>
+ #include <ak_tools.h>
+
+ #define size (16*3000+11)
+ #define asize (16*40+5)
+
+ static int test_one( ak_bckey bkey, ak_uint8 *adata, ak_uint8 *in, ak_uint8 *iv )
+{
+  size_t i;
+  struct mgm mctx;
+  int result = EXIT_SUCCESS;
+  ak_uint8 tag[16], tag2[16], *out = malloc( size ), *out2 = malloc( size );
+
+ /* однократный вызов */
+  ak_bckey_context_encrypt_mgm( bkey, adata, asize, in, out, size, iv, 16, tag, 16 );
+  printf("%s: ", bkey->key.oid->names[0] );
+  for( i = 0; i < bkey->bsize; i++ ) printf("%02x", tag[i] );
+  printf(" (single call)\n");
+
+ /* обработка фрагментами, длина которых кратна 32 октетам */
+  ak_mgm_context_clean( &mctx, bkey, iv, 16 );
+  for( i = 0; i < asize; i += 320 )
+     ak_mgm_context_authentication_update( &mctx, bkey, adata+i, ak_min( 320, asize-i ));
+  for( i = 0; i < size; i += 4096 )
+     ak_mgm_context_encryption_update( &mctx, bkey, in+i, out2+i, ak_min( 4096, size-i ));
+  ak_mgm_context_finalize( &mctx, bkey, tag2, 16 );
+  printf("%s: ", bkey->key.oid->names[0] );
+  for( i = 0; i < bkey->bsize; i++ ) printf("%02x", tag2[i] );
+  printf(" (update by 4096 octets)\n");
+
+  if( !ak_ptr_is_equal( out, out2, size )) result = EXIT_FAILURE;
+  if( !ak_ptr_is_equal( tag, tag2, bkey->bsize )) result = EXIT_FAILURE;
+
+ /* расшифрование на месте */
+  if( ak_bckey_context_decrypt_mgm( bkey, adata, asize, out, out, size,
+                                                       iv, 16, tag, bkey->bsize ) != ak_error_ok )
+    result = EXIT_FAILURE;
+  printf("%s: decryption is %s\n", bkey->key.oid->names[0],
+                                             ak_ptr_is_equal( in, out, size ) ? "Ok" : "Wrong" );
+  if( !ak_ptr_is_equal( in, out, size )) result = EXIT_FAILURE;
+
+  free( out );
+  free( out2 );
+ return result;
+}
+
+ int main( void )
+{
+  size_t i;
+  int result = EXIT_SUCCESS;
+  struct bckey bkey;
+  ak_uint8 key[32], iv[16], *in = NULL, *adata = NULL;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  in = malloc( size ); adata = malloc( asize );
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = (ak_uint8)( 13*i+5 );
+  for( i = 0; i < sizeof( iv ); i++ ) iv[i] = (ak_uint8)( 3*i+1 );
+  for( i = 0; i < size; i++ ) in[i] = (ak_uint8)( 29*i+11 );
+  for( i = 0; i < asize; i++ ) adata[i] = (ak_uint8)( 7*i+3 );
+
+  ak_bckey_context_create_kuznechik( &bkey );
+  ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+  if( test_one( &bkey, adata, in, iv ) != EXIT_SUCCESS ) result = EXIT_FAILURE;
+  ak_bckey_context_destroy( &bkey );
+
+  ak_bckey_context_create_magma( &bkey );
+  ak_bckey_context_set_key( &bkey, key, sizeof( key ));
+  if( test_one( &bkey, adata, in, iv ) != EXIT_SUCCESS ) result = EXIT_FAILURE;
+  ak_bckey_context_destroy( &bkey );
+
+  free( in );
+  free( adata );
+  ak_libakrypt_destroy();
+ return result;
+}
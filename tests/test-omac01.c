@@ -0,0 +1,101 @@
+/* Пример иллюстрирует эквивалентность вычисления имитовставки OMAC
+   функцией ak_bckey_context_omac(), функцией ak_omac_context_file(),
+   последовательностью вызовов ak_omac_context_clean()
+                                               _update()
+                                               _finalize(),
+   а также вычислением имитовставки с помощью дескриптора, созданного функцией ak_handle_new().
+   Внимание! Используются неэкспортируемые функции.
+
+   test-omac01.c
+*/
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ak_omac.h>
+ #include <ak_tools.h>
+
+ int main( int argc, char *argv[] )
+{
+  size_t i;
+  ssize_t len;
+  struct omac octx;
+  struct file fp;
+  ak_handle handle;
+  ak_uint8 out[16], out2[16], out3[16], out4[16], *data = NULL;
+  char *filename = NULL;
+  int exitcode = EXIT_SUCCESS;
+  ak_uint8 key[32] = {
+    0xef,0xcd,0xab,0x89,0x67,0x45,0x23,0x01,0x10,0x32,0x54,0x76,0x98,0xba,0xdc,0xfe,
+    0x77,0x66,0x55,0x44,0x33,0x22,0x11,0x00,0xff,0xee,0xdd,0xcc,0xbb,0xaa,0x99,0x88
+  };
+
+ /* выбираем имя файла */
+  if( argc > 1 ) filename = argv[1];
+   else filename = argv[0];
+  memset( out, 0, sizeof( out ));
+  memset( out2, 0, sizeof( out2 ));
+  memset( out3, 0, sizeof( out3 ));
+  memset( out4, 0, sizeof( out4 ));
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+ /* создаем и инициализируем контекст алгоритма omac */
+  ak_omac_context_create_kuznechik( &octx );
+  ak_omac_context_set_key( &octx, key, sizeof( key ));
+
+ /* вычисляем имитовставку от заданного файла */
+  ak_omac_context_file( &octx, filename, out, sizeof( out ));
+  printf("%s: ", octx.bkey.key.oid->names[0] );
+  for( i = 0; i < ak_omac_context_get_tag_size( &octx ); i++ ) printf("%02x", out[i] );
+  printf(" (%s)\n", filename );
+
+ /* теперь обрабатываем данные, считываемые из файла фрагментами, длина которых
+    не кратна длине блока */
+  ak_omac_context_clean( &octx );
+  ak_file_open_to_read( &fp, filename );
+  if(( data = malloc(( size_t )fp.size )) == NULL ) {
+    ak_file_close( &fp );
+    ak_omac_context_destroy( &octx );
+    return ak_libakrypt_destroy();
+  }
+  len = ak_file_read( &fp, data, ( size_t )fp.size );
+  ak_file_close( &fp );
+  for( i = 0; i < ( size_t )len; i += 1013 )
+     ak_omac_context_update( &octx, data+i, ak_min( 1013, ( size_t )len - i ));
+  ak_omac_context_finalize( &octx, NULL, 0, out2, sizeof( out2 ));
+
+  printf("%s: ", octx.bkey.key.oid->names[0] );
+  for( i = 0; i < ak_omac_context_get_tag_size( &octx ); i++ ) printf("%02x", out2[i] );
+  printf(" (update by 1013 octets)\n" );
+
+ /* вычисляем имитовставку однократным вызовом */
+  ak_bckey_context_omac( &octx.bkey, data, ( size_t )len, out3, sizeof( out3 ));
+  printf("%s: ", octx.bkey.key.oid->names[0] );
+  for( i = 0; i < ak_omac_context_get_tag_size( &octx ); i++ ) printf("%02x", out3[i] );
+  printf(" (single call)\n" );
+
+ /* вычисляем имитовставку с помощью дескриптора */
+  if(( handle = ak_handle_new( "omac-kuznechik", NULL )) == ak_error_wrong_handle ) {
+    exitcode = EXIT_FAILURE;
+  } else {
+      ak_handle_set_key_from_hexstr( handle,
+                   "efcdab89674523011032547698badcfe7766554433221100ffeeddccbbaa9988", ak_false );
+      ak_handle_mac_ptr( handle, data, ( size_t )len, out4, sizeof( out4 ));
+      printf("%s: ", octx.bkey.key.oid->names[0] );
+      for( i = 0; i < ak_handle_get_tag_size( handle ); i++ ) printf("%02x", out4[i] );
+      printf(" (handle)\n" );
+      if( ak_handle_get_tag_size( handle ) != 16 ) exitcode = EXIT_FAILURE;
+      ak_handle_delete( handle );
+    }
+
+  if( !ak_ptr_is_equal( out, out2, ak_omac_context_get_tag_size( &octx ))) exitcode = EXIT_FAILURE;
+  if( !ak_ptr_is_equal( out, out3, ak_omac_context_get_tag_size( &octx ))) exitcode = EXIT_FAILURE;
+  if( !ak_ptr_is_equal( out, out4, ak_omac_context_get_tag_size( &octx ))) exitcode = EXIT_FAILURE;
+
+ /* завершаем работу */
+  free( data );
+  ak_omac_context_destroy( &octx );
+  ak_libakrypt_destroy();
+ return exitcode;
+}